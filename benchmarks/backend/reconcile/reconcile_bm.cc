@@ -0,0 +1,437 @@
+// clang-format off
+#include <malloc.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "benchmarks/mock/fake_cluster.h"
+#include "spdlog/fmt/fmt.h"
+#include "src/backend/center_if.h"
+#include "src/backend/host_gw.h"
+#include "src/backend/vxlan.h"
+#include "src/cni/storage.h"
+#include "src/ipam/ipam.h"
+#include "src/log/logger.h"
+#include "src/net/nic.h"
+// clang-format on
+
+using namespace ohno;
+using namespace ohno::etcd;
+
+namespace {
+
+constexpr int64_t MAX_TICKS{16};         // 超过之后认为没有收敛
+constexpr int64_t LEAVE_PERCENT{10};     // leave 场景一次离开的节点比例
+constexpr int64_t FLAP_PERCENT{1};       // flap 场景每轮抖动的节点比例
+constexpr int64_t FLAP_ROUNDS{10};       // flap 场景的抖动轮数（一轮为离开一次、回来一次）
+constexpr uint32_t CHURN_SEED{20240501}; // 固定种子，每次运行选中相同的节点
+
+enum class Mode : int64_t { host_gw, vxlan };
+enum class Scenario : int64_t { join, leave, flap };
+
+std::atomic<int64_t> g_heap_bytes{0}; // 进程当前占用的堆内存
+
+} // namespace
+
+// 统计堆内存，用来计算每个对端节点在后端中常驻的内存
+auto operator new(size_t size) -> void * {
+  auto *ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc{};
+  }
+  g_heap_bytes += static_cast<int64_t>(malloc_usable_size(ptr));
+  return ptr;
+}
+
+auto operator delete(void *ptr) noexcept -> void {
+  if (ptr != nullptr) {
+    g_heap_bytes -= static_cast<int64_t>(malloc_usable_size(ptr));
+    std::free(ptr);
+  }
+}
+
+auto operator delete(void *ptr, size_t /*size*/) noexcept -> void { operator delete(ptr); }
+
+/**
+ * @brief 模拟的集群：api server 中的节点与调用次数、ETCD 中的数据（请求数由服务端统计）
+ *
+ */
+struct Cluster {
+  backend::FakeCenter::Nodes nodes_;
+  std::shared_ptr<EtcdServerMemory> etcd_{makeMemoryEtcdServer()};
+  uint64_t center_calls_{0};
+};
+
+/**
+ * @brief 只维护路由、ARP、FDB 表项的 netlink，记录查询与下发的次数
+ *
+ */
+class RecordingNetlink : public net::NetlinkIf {
+public:
+  auto linkDestory(std::string_view /*name*/, std::string_view /*netns*/) -> bool override {
+    return true;
+  }
+  auto linkExist(std::string_view /*name*/, std::string_view /*netns*/) -> bool override {
+    return true;
+  }
+  auto linkList(std::string_view /*prefix*/, std::string_view /*netns*/)
+      -> std::vector<std::string> override {
+    return {};
+  }
+  auto linkGetMaster(std::string_view /*name*/, std::string_view /*netns*/)
+      -> std::string override {
+    return {};
+  }
+  auto linkGetMac(std::string_view /*name*/, std::string_view /*netns*/) -> std::string override {
+    return {};
+  }
+  auto linkSetStatus(std::string_view /*name*/, net::LinkStatus /*status*/,
+                     std::string_view /*netns*/) -> bool override {
+    return true;
+  }
+  auto linkIsInNetns(std::string_view /*name*/, std::string_view /*netns*/) -> bool override {
+    return true;
+  }
+  auto linkToNetns(std::string_view /*name*/, std::string_view /*netns*/) -> bool override {
+    return true;
+  }
+  auto linkRename(std::string_view /*name*/, std::string_view /*new_name*/,
+                  std::string_view /*netns*/) -> bool override {
+    return true;
+  }
+  auto vethCreate(std::string_view /*name1*/, std::string_view /*name2*/) -> bool override {
+    return true;
+  }
+  auto bridgeCreate(std::string_view /*name*/) -> bool override { return true; }
+  auto vxlanCreate(std::string_view /*name*/, std::string_view /*underlay_addr*/,
+                   std::string_view /*underlay_dev*/) -> bool override {
+    return true;
+  }
+  auto vrfCreate(std::string_view /*name*/, uint32_t /*table*/) -> bool override { return true; }
+  auto bridgeSetStatus(std::string_view /*name*/, bool /*master*/, std::string_view /*bridge*/,
+                       net::BridgeAddrGenMode /*mode*/, std::string_view /*netns*/)
+      -> bool override {
+    return true;
+  }
+  auto vxlanSetSlave(std::string_view /*name*/, bool /*neigh_suppress*/, bool /*learning*/,
+                     std::string_view /*netns*/) -> bool override {
+    return true;
+  }
+  auto addressIsExist(std::string_view /*name*/, std::string_view /*addr*/,
+                      std::string_view /*netns*/) -> bool override {
+    return true;
+  }
+  auto addressSetEntry(std::string_view /*name*/, std::string_view /*addr*/, bool /*add*/,
+                       std::string_view /*netns*/) -> bool override {
+    return true;
+  }
+  auto routeIsExist(std::string_view dst, std::string_view via, std::string_view dev,
+                    std::string_view /*netns*/) const -> bool override {
+    ++queries_;
+    return routes_.count(fmt::format("{} {} {}", dst, via, dev)) > 0;
+  }
+  auto routeSetEntry(std::string_view dst, std::string_view via, bool add, std::string_view dev,
+                     std::string_view /*netns*/, RouteNHFlags /*nhflags*/) const
+      -> bool override {
+    return write(routes_, fmt::format("{} {} {}", dst, via, dev), add);
+  }
+  auto neighIsExist(std::string_view addr, std::string_view dev, std::string_view /*netns*/) const
+      -> bool override {
+    ++queries_;
+    return neighs_.count(fmt::format("{} {}", addr, dev)) > 0;
+  }
+  auto neighSetEntry(std::string_view addr, std::string_view /*mac*/, bool add,
+                     std::string_view dev, std::string_view /*netns*/) const -> bool override {
+    return write(neighs_, fmt::format("{} {}", addr, dev), add);
+  }
+  auto fdbIsExist(std::string_view mac, std::string_view underlay_addr, std::string_view dev,
+                  std::string_view /*netns*/) const -> bool override {
+    ++queries_;
+    return fdbs_.count(fmt::format("{} {} {}", mac, underlay_addr, dev)) > 0;
+  }
+  auto fdbSetEntry(std::string_view mac, std::string_view underlay_addr, std::string_view dev,
+                   bool add, std::string_view /*netns*/) const -> bool override {
+    return write(fdbs_, fmt::format("{} {} {}", mac, underlay_addr, dev), add);
+  }
+
+  auto getQueries() const noexcept -> uint64_t { return queries_; }
+  auto getWrites() const noexcept -> uint64_t { return writes_; }
+  auto getRoutes() const noexcept -> size_t { return routes_.size(); }
+  auto getNeighs() const noexcept -> size_t { return neighs_.size(); }
+  auto getFdbs() const noexcept -> size_t { return fdbs_.size(); }
+
+private:
+  // 与内核一致：重复添加、删除不存在的表项都会失败
+  auto write(std::unordered_set<std::string> &table, std::string key, bool add) const -> bool {
+    ++writes_;
+    return add ? table.emplace(std::move(key)).second : table.erase(key) > 0;
+  }
+
+  mutable uint64_t queries_{0};
+  mutable uint64_t writes_{0};
+  mutable std::unordered_set<std::string> routes_;
+  mutable std::unordered_set<std::string> neighs_;
+  mutable std::unordered_set<std::string> fdbs_;
+};
+
+// 公开每一轮的事件处理，由模拟器代替后端线程驱动
+class HostGwSim final : public backend::HostGw {
+public:
+  using HostGw::eventHandler;
+};
+
+class VxlanSim final : public backend::Vxlan {
+public:
+  using Vxlan::eventHandler;
+};
+
+static auto nodeName(size_t index) -> std::string { return fmt::format("node-{:05}", index); }
+
+/**
+ * @brief 节点加入集群：出现在 api server 中，并且 CNI 已经写入了子网与 VTEP
+ *
+ * @param cluster 模拟集群
+ * @param index 节点序号
+ */
+static void joinNode(Cluster &cluster, size_t index) {
+  auto name = nodeName(index);
+  auto pod_cidr = fmt::format("10.{}.{}.0/24", index >> 8U, index & 0xffU);
+  cluster.nodes_[name] = backend::NodeInfo{
+      name, fmt::format("172.16.{}.{}", index >> 8U, index & 0xffU), pod_cidr, {pod_cidr}};
+  cluster.etcd_->put(fmt::format("{}/{}", ipam::ETCD_KEY_SUBNET, name), pod_cidr);
+  cluster.etcd_->put(cni::Storage::getVtepKey(name),
+                     fmt::format("10.{}.{}.0{}02:00:00:00:{:02x}:{:02x}", index >> 8U,
+                                 index & 0xffU, cni::SEPARATOR, index >> 8U, index & 0xffU));
+}
+
+/**
+ * @brief 节点离开集群：从 api server 中删除，节点租约过期之后子网与 VTEP 随之删除
+ *
+ * @param cluster 模拟集群
+ * @param index 节点序号
+ */
+static void leaveNode(Cluster &cluster, size_t index) {
+  auto name = nodeName(index);
+  cluster.nodes_.erase(name);
+  cluster.etcd_->del(fmt::format("{}/{}", ipam::ETCD_KEY_SUBNET, name), false);
+  cluster.etcd_->del(cni::Storage::getVtepKey(name), false);
+}
+
+/**
+ * @brief 一个被模拟的节点：按生产环境的方式装配后端，ETCD、api server、netlink 换成模拟实现
+ *
+ */
+class Simulator final {
+public:
+  Simulator(Mode mode, Cluster &cluster) : mode_{mode} {
+    netlink_ = std::make_shared<RecordingNetlink>();
+    auto nic = std::make_unique<net::Nic>();
+    nic->setup(netlink_);
+
+    if (mode_ == Mode::host_gw) {
+      auto backend = std::make_unique<HostGwSim>();
+      auto ipam = std::make_unique<ipam::Ipam>();
+      ipam->init(std::make_unique<MemoryEtcdClient>(cluster.etcd_), false);
+      backend->setIpam(std::move(ipam));
+      host_gw_ = std::move(backend);
+    } else {
+      auto backend = std::make_unique<VxlanSim>();
+      auto storage = std::make_unique<cni::Storage>();
+      storage->init(std::make_unique<MemoryEtcdClient>(cluster.etcd_), false);
+      backend->setStorage(std::move(storage));
+      vxlan_ = std::move(backend);
+    }
+    getBackend().setCenter(
+        std::make_unique<backend::FakeCenter>(cluster.nodes_, &cluster.center_calls_));
+    getBackend().setNic(std::move(nic));
+  }
+
+  /**
+   * @brief 驱动后端直到某一轮不再下发任何表项
+   *
+   * @return int64_t 有下发的轮数，没有收敛返回 -1
+   */
+  auto converge() -> int64_t {
+    for (int64_t tick = 0; tick < MAX_TICKS; ++tick) {
+      auto writes = netlink_->getWrites();
+      if (mode_ == Mode::host_gw) {
+        host_gw_->eventHandler(nodeName(0));
+      } else {
+        vxlan_->eventHandler(nodeName(0));
+      }
+      if (netlink_->getWrites() == writes) {
+        return tick;
+      }
+    }
+    return -1;
+  }
+
+  /**
+   * @brief 校验内核表项与集群一致：每个存活的对端节点恰好一组表项
+   *
+   * @param peers 存活的对端节点数量
+   * @return true 一致
+   * @return false 有遗漏或者残留
+   */
+  auto isConsistent(size_t peers) const -> bool {
+    if (mode_ == Mode::host_gw) {
+      return netlink_->getRoutes() == peers;
+    }
+    return netlink_->getRoutes() == peers && netlink_->getNeighs() == peers &&
+           netlink_->getFdbs() == peers;
+  }
+
+  /**
+   * @brief 销毁后端（节点缓存、网卡对象等），返回释放的堆内存
+   *
+   * @return int64_t 释放的字节数
+   */
+  auto release() -> int64_t {
+    auto before = g_heap_bytes.load();
+    host_gw_.reset();
+    vxlan_.reset();
+    return before - g_heap_bytes.load();
+  }
+
+  auto getNetlink() const -> const RecordingNetlink & { return *netlink_; }
+
+private:
+  auto getBackend() -> backend::Backend & {
+    return mode_ == Mode::host_gw ? static_cast<backend::Backend &>(*host_gw_)
+                                  : static_cast<backend::Backend &>(*vxlan_);
+  }
+
+  Mode mode_;
+  std::shared_ptr<RecordingNetlink> netlink_; // 比后端活得更久，释放后端时不计入
+  std::unique_ptr<HostGwSim> host_gw_;
+  std::unique_ptr<VxlanSim> vxlan_;
+};
+
+/**
+ * @brief 驱动一个节点的后端经历一次集群变化，测量收敛耗时与代价
+ *
+ * @param state range(0) 集群节点数，range(1) 后端模式
+ * @param scenario join：全部对端同时加入（ohnod 冷启动）；
+ * leave：已收敛的集群中一部分节点离开；flap：每轮一小部分节点离开又回来
+ */
+static void runScenario(benchmark::State &state, Scenario scenario) {
+  const auto nodes = static_cast<size_t>(state.range(0));
+  const auto mode = static_cast<Mode>(state.range(1));
+
+  double ticks = 0;
+  double writes = 0;
+  double queries = 0;
+  double center_calls = 0;
+  double etcd_calls = 0;
+  double bytes_per_peer = 0;
+  for (auto _ : state) {
+    Cluster cluster{};
+    joinNode(cluster, 0); // 当前节点
+    Simulator sim{mode, cluster};
+    if (scenario != Scenario::join) {
+      for (size_t i = 1; i < nodes; ++i) {
+        joinNode(cluster, i);
+      }
+      sim.converge();
+    }
+
+    auto netlink_queries = sim.getNetlink().getQueries();
+    auto netlink_writes = sim.getNetlink().getWrites();
+    auto center = cluster.center_calls_;
+    auto etcd = cluster.etcd_->getRequests();
+    std::mt19937 random{CHURN_SEED};
+    std::vector<size_t> peers(nodes - 1);
+    for (size_t i = 0; i < peers.size(); ++i) {
+      peers[i] = i + 1;
+    }
+    std::shuffle(peers.begin(), peers.end(), random);
+
+    int64_t tick = 0;
+    auto start = std::chrono::steady_clock::now();
+    if (scenario == Scenario::join) {
+      for (auto peer : peers) {
+        joinNode(cluster, peer);
+      }
+      tick = sim.converge();
+    } else if (scenario == Scenario::leave) {
+      for (size_t i = 0; i < peers.size() * LEAVE_PERCENT / 100; ++i) {
+        leaveNode(cluster, peers[i]);
+      }
+      tick = sim.converge();
+    } else {
+      auto count = std::max<size_t>(peers.size() * FLAP_PERCENT / 100, 1);
+      for (int64_t round = 0; round < FLAP_ROUNDS && tick >= 0; ++round) {
+        auto begin = peers.begin() + static_cast<int64_t>(round * count % peers.size());
+        auto end = begin + static_cast<int64_t>(std::min<size_t>(count, peers.end() - begin));
+        std::for_each(begin, end, [&cluster](size_t peer) { leaveNode(cluster, peer); });
+        auto down = sim.converge();
+        std::for_each(begin, end, [&cluster](size_t peer) { joinNode(cluster, peer); });
+        auto up = sim.converge();
+        tick = down < 0 || up < 0 ? -1 : tick + down + up;
+      }
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+    state.SetIterationTime(elapsed.count());
+
+    if (tick < 0 || !sim.isConsistent(cluster.nodes_.size() - 1)) {
+      state.SkipWithError(tick < 0 ? "backend did not converge" : "kernel entries diverged");
+      return;
+    }
+    ticks += static_cast<double>(tick);
+    writes += static_cast<double>(sim.getNetlink().getWrites() - netlink_writes);
+    queries += static_cast<double>(sim.getNetlink().getQueries() - netlink_queries);
+    center_calls += static_cast<double>(cluster.center_calls_ - center);
+    etcd_calls += static_cast<double>(cluster.etcd_->getRequests() - etcd);
+    bytes_per_peer += static_cast<double>(sim.release()) /
+                      static_cast<double>(std::max<size_t>(cluster.nodes_.size() - 1, 1));
+  }
+
+  auto iterations = static_cast<double>(std::max<benchmark::IterationCount>(state.iterations(), 1));
+  state.counters["ticks"] = ticks / iterations;
+  state.counters["netlink_writes"] = writes / iterations;
+  state.counters["netlink_queries"] = queries / iterations;
+  state.counters["center_calls"] = center_calls / iterations;
+  state.counters["etcd_calls"] = etcd_calls / iterations;
+  state.counters["bytes_per_peer"] = bytes_per_peer / iterations;
+}
+
+static void clusterArgs(benchmark::internal::Benchmark *bm) {
+  for (int64_t nodes : {1000, 10000}) {
+    for (auto mode : {Mode::host_gw, Mode::vxlan}) {
+      bm->Args({nodes, static_cast<int64_t>(mode)});
+    }
+  }
+  bm->ArgNames({"nodes", "vxlan"})->Iterations(3)->UseManualTime()->Unit(benchmark::kMillisecond);
+}
+
+static void BM_Reconcile_Join(benchmark::State &state) { runScenario(state, Scenario::join); }
+BENCHMARK(BM_Reconcile_Join)->Apply(clusterArgs);
+
+static void BM_Reconcile_Leave(benchmark::State &state) { runScenario(state, Scenario::leave); }
+BENCHMARK(BM_Reconcile_Leave)->Apply(clusterArgs);
+
+static void BM_Reconcile_Flap(benchmark::State &state) { runScenario(state, Scenario::flap); }
+BENCHMARK(BM_Reconcile_Flap)->Apply(clusterArgs);
+
+auto main(int argc, char **argv) -> int {
+  // 每个对端节点都会打印 info 日志，只保留告警
+  log::LogConfig log_conf{};
+  log_conf.setLevel(log::Level::warn);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,256 @@
+// clang-format off
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mount.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include "gtest/gtest.h"
+#include "benchmark/benchmark.h"
+#include "benchmarks/mock/fake_cluster.h"
+#include "spdlog/fmt/fmt.h"
+#include "src/cni/cni.h"
+#include "src/cni/storage.h"
+#include "src/ipam/ipam.h"
+#include "src/log/logger.h"
+#include "src/net/netlink/netlink_ip_cmd.h"
+#include "src/util/shell_sync.h"
+// clang-format on
+
+using namespace ohno;
+using namespace ohno::etcd;
+
+namespace {
+
+constexpr std::string_view NODE_NAME{"bm-node"};
+constexpr std::string_view NODE_INTERNAL_IP{"192.168.100.10"};
+constexpr std::string_view UNDERLAY_DEV{"bm-underlay"};
+constexpr std::string_view UNDERLAY_ADDR{"192.168.100.10/24"};
+constexpr std::string_view POD_CIDR{"10.244.1.0/24"};
+constexpr std::string_view POD_NIC{"eth0"};
+constexpr int64_t PODS_PER_THREAD{16}; // 每个并发调用方依次创建并删除的 Pod 数量
+
+bool g_sandbox{false}; // 是否已进入隔离的 user + network namespace
+std::atomic<uint64_t> g_pod_id{0};
+
+// 所有线程的耗时（毫秒），全部线程汇总之后再计算分位数
+std::mutex g_latency_mutex;
+std::condition_variable g_latency_cond;
+int g_latency_threads{0};
+std::vector<double> g_add_latency;
+std::vector<double> g_del_latency;
+std::atomic<uint64_t> g_failures{0};
+
+} // namespace
+
+/**
+ * @brief 写入 /proc 下的映射文件
+ *
+ * @param path 文件路径
+ * @param content 内容
+ * @return true 写入成功
+ * @return false 写入失败
+ */
+static auto writeProc(const char *path, const std::string &content) -> bool {
+  std::ofstream file{path};
+  file << content;
+  return static_cast<bool>(file.flush());
+}
+
+/**
+ * @brief 进入新的 user + network + mount namespace：当前用户映射为 root，可以操作内核网络
+ * 而不影响宿主机；/var/run 换成私有 tmpfs，ohno 的状态文件与 ip netns 挂载点都留在沙箱内
+ *
+ * @note 必须在创建任何线程之前调用
+ *
+ * @return true 沙箱就绪
+ * @return false 内核或者容器不允许创建 namespace
+ */
+static auto enterSandbox() -> bool {
+  auto uid = ::getuid();
+  auto gid = ::getgid();
+  if (::unshare(CLONE_NEWUSER | CLONE_NEWNET | CLONE_NEWNS) != 0) {
+    return false;
+  }
+  if (!writeProc("/proc/self/setgroups", "deny") ||
+      !writeProc("/proc/self/uid_map", fmt::format("0 {} 1", uid)) ||
+      !writeProc("/proc/self/gid_map", fmt::format("0 {} 1", gid))) {
+    return false;
+  }
+  if (::mount(nullptr, "/", nullptr, MS_REC | MS_PRIVATE, nullptr) != 0 ||
+      ::mount("tmpfs", "/var/run", "tmpfs", 0, nullptr) != 0) {
+    return false;
+  }
+
+  // 模拟节点 underlay 网卡（veth 不依赖 dummy 内核模块）
+  util::ShellSync shell{};
+  std::string output{};
+  for (const auto &cmd :
+       {std::string{"ip link set lo up"},
+        fmt::format("ip link add {} type veth peer name {}-p", UNDERLAY_DEV, UNDERLAY_DEV),
+        fmt::format("ip addr add {} dev {}", UNDERLAY_ADDR, UNDERLAY_DEV),
+        fmt::format("ip link set {}-p up", UNDERLAY_DEV),
+        fmt::format("ip link set {} up", UNDERLAY_DEV)}) {
+    if (!shell.execute(cmd, output)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief 创建一个与 ohno 二进制相同装配方式的 CNI 插件，ETCD 与 api server 换成进程内实现
+ *
+ * @param server 进程内 ETCD 服务端
+ * @return std::unique_ptr<cni::Cni> CNI 插件
+ */
+static auto makeCni(const std::shared_ptr<EtcdServerMemory> &server)
+    -> std::unique_ptr<cni::Cni> {
+  cni::CniConfig config{};
+  config.ipam_.subnet_ = POD_CIDR;
+  config.ipam_.mode_ = cni::CniConfigIpam::Mode::host_gw;
+  config.node_idle_timeout_ = -1; // 节点网络设施一直保留，每次 ADD 只测量 Pod 本身
+
+  auto cni = std::make_unique<cni::Cni>(
+      std::make_shared<net::NetlinkIpCmd>(std::make_unique<util::ShellSync>()));
+  cni->parseConfig(config);
+
+  auto ipam = std::make_unique<ipam::Ipam>();
+  ipam->init(std::make_unique<MemoryEtcdClient>(server), false);
+  auto storage = std::make_unique<cni::Storage>();
+  storage->init(std::make_unique<MemoryEtcdClient>(server), false);
+  cni->setIpam(std::move(ipam));
+  cni->setStorage(std::move(storage));
+  cni->setCenter(
+      std::make_unique<backend::FakeCenter>(NODE_NAME, NODE_INTERNAL_IP, POD_CIDR));
+  cni->setNodeInfo(NODE_NAME, UNDERLAY_DEV, UNDERLAY_ADDR);
+  return cni;
+}
+
+static auto percentile(std::vector<double> values, double ratio) -> double {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  auto index = static_cast<size_t>(ratio * static_cast<double>(values.size() - 1));
+  return values[index];
+}
+
+static auto elapsedMs(std::chrono::steady_clock::time_point start) -> double {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+/**
+ * @brief 每个线程模拟一个 kubelet 调用方：依次对若干 Pod 执行 CNI ADD 与 DEL；
+ * Pod 的 netns 由 CRI 创建，所以在计时循环之前准备好
+ *
+ * @param state 线程数即并发调用数
+ */
+static void BM_Cni_AddDel(benchmark::State &state) {
+  if (!g_sandbox) {
+    state.SkipWithError("unprivileged user + network namespace is not available");
+    return;
+  }
+
+  static std::shared_ptr<EtcdServerMemory> server{};
+  if (state.thread_index() == 0) {
+    server = makeMemoryEtcdServer();
+    g_latency_threads = 0;
+    g_add_latency.clear();
+    g_del_latency.clear();
+    g_failures = 0;
+
+    // 第一次 ADD 会创建节点网络设施（bridge、网关地址），不计入结果
+    util::ShellSync shell{};
+    std::string output{};
+    shell.execute("ip netns add bm-warmup", output);
+    auto cni = makeCni(server);
+    cni->add("bm-warmup", "bm-warmup", POD_NIC);
+    makeCni(server)->del("bm-warmup", POD_NIC);
+    shell.execute("ip netns del bm-warmup", output);
+  }
+
+  util::ShellSync shell{};
+  std::string output{};
+  std::vector<std::string> pods{};
+  for (int64_t i = 0; i < PODS_PER_THREAD; ++i) {
+    pods.emplace_back(fmt::format("bm-pod-{}", g_pod_id++));
+    shell.execute(fmt::format("ip netns add {}", pods.back()), output);
+  }
+
+  size_t next = 0;
+  std::vector<double> add_latency{};
+  std::vector<double> del_latency{};
+  for (auto _ : state) {
+    const auto &pod = pods[next++ % pods.size()];
+    auto start = std::chrono::steady_clock::now();
+    try {
+      makeCni(server)->add(pod, pod, POD_NIC);
+    } catch (...) {
+      ++g_failures;
+    }
+    add_latency.emplace_back(elapsedMs(start));
+
+    start = std::chrono::steady_clock::now();
+    makeCni(server)->del(pod, POD_NIC);
+    del_latency.emplace_back(elapsedMs(start));
+  }
+
+  for (const auto &pod : pods) {
+    shell.execute(fmt::format("ip netns del {}", pod), output);
+  }
+  {
+    std::unique_lock<std::mutex> lock{g_latency_mutex};
+    g_add_latency.insert(g_add_latency.end(), add_latency.begin(), add_latency.end());
+    g_del_latency.insert(g_del_latency.end(), del_latency.begin(), del_latency.end());
+    ++g_latency_threads;
+    g_latency_cond.notify_all();
+    g_latency_cond.wait(lock, [&state]() { return g_latency_threads == state.threads(); });
+  }
+
+  // 吞吐量按所有线程累加；每个线程都给出整体分位数，按线程求平均之后不变
+  state.counters["pods_per_sec"] =
+      benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+  for (const auto &[name, latency, ratio] :
+       {std::make_tuple("add_p50_ms", &g_add_latency, 0.5),
+        std::make_tuple("add_p99_ms", &g_add_latency, 0.99),
+        std::make_tuple("del_p50_ms", &g_del_latency, 0.5),
+        std::make_tuple("del_p99_ms", &g_del_latency, 0.99)}) {
+    state.counters[name] =
+        benchmark::Counter(percentile(*latency, ratio), benchmark::Counter::kAvgThreads);
+  }
+  state.counters["failures"] = benchmark::Counter(
+      static_cast<double>(state.thread_index() == 0 ? g_failures.load() : 0));
+}
+BENCHMARK(BM_Cni_AddDel)
+    ->Threads(1)
+    ->Threads(8)
+    ->Threads(32)
+    ->Iterations(PODS_PER_THREAD)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+auto main(int argc, char **argv) -> int {
+  g_sandbox = enterSandbox();
+
+  log::LogConfig log_conf{};
+  log_conf.setLevel(log::Level::warn);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,472 @@
+// clang-format off
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "gtest/gtest.h"
+#include "benchmark/benchmark.h"
+#include "benchmarks/mock/fake_cluster.h"
+#include "nlohmann/json.hpp"
+#include "spdlog/fmt/fmt.h"
+#include "src/cni/cni.h"
+#include "src/cni/cni_config.h"
+#include "src/cni/cni_env.h"
+#include "src/cni/cni_result.h"
+#include "src/cni/storage.h"
+#include "src/common/assert.h"
+#include "src/etcd/change_log.h"
+#include "src/etcd/etcd_client_cache.h"
+#include "src/etcd/etcd_client_shell.h"
+#include "src/etcd/etcd_server_memory.h"
+#include "src/ipam/ipam.h"
+#include "src/log/logger.h"
+#include "src/metrics/metrics.h"
+#include "src/net/netlink/netlink_ip_cmd.h"
+#include "src/net/netlink/netlink_memory.h"
+#include "src/util/env_std.h"
+#include "src/util/shell_sync.h"
+// clang-format on
+
+using namespace ohno;
+
+namespace {
+
+constexpr std::string_view FLAG_OHNO{"--storm_ohno="};     // ohno 二进制路径，指定时使用真实后端
+constexpr std::string_view FLAG_CONFIG{"--storm_config="}; // 真实后端时通过 stdin 传入的 CNI 配置
+constexpr std::string_view NODE_NAME{"storm-node"};
+constexpr std::string_view NODE_INTERNAL_IP{"192.168.100.10"};
+constexpr std::string_view UNDERLAY_DEV{"storm-underlay"};
+constexpr std::string_view UNDERLAY_PEER{"storm-peer"};
+constexpr std::string_view UNDERLAY_ADDR{"192.168.100.10/24"};
+constexpr std::string_view POD_CIDR{"10.244.0.0/20"};
+constexpr std::string_view POD_NIC{"eth0"};
+constexpr std::string_view NETNS_DIR{"/var/run/netns"};
+constexpr size_t JOURNAL_SIZE{8};
+constexpr uint64_t SEED{20240701};
+
+// 内存 ETCD 的请求延迟，相当于同机房的 ETCD 集群
+constexpr std::chrono::microseconds ETCD_MEDIAN{1000};
+constexpr double ETCD_SIGMA{0.5};
+
+std::string g_ohno{};
+std::string g_config{};
+std::atomic<uint64_t> g_storm_id{0};
+
+} // namespace
+
+/**
+ * @brief 一次风暴的对象：kubelet 看到的 CNI 插件，以及事后检查用到的 ETCD 与内核
+ *
+ */
+class StormTarget {
+public:
+  virtual ~StormTarget() = default;
+
+  virtual auto prepare(const std::string &pod) -> bool = 0; // CRI 创建 Pod 的 netns
+  virtual auto add(const std::string &pod) -> std::optional<std::string> = 0;
+  virtual auto del(const std::string &pod) -> bool = 0;
+  virtual auto cleanup(const std::string &pod) -> void = 0; // CRI 删除 Pod 的 netns
+  virtual auto dump() -> std::unordered_map<std::string, std::string> = 0;
+  virtual auto nicExist(const std::string &pod) -> bool = 0;
+};
+
+/**
+ * @brief 进程内的 CNI 插件，与 ohno 二进制相同的装配方式，内核、ETCD 与 api server
+ * 换成模型；每次调用各自创建插件与 ETCD 客户端，与独立的 ohno 进程一样不共享状态
+ *
+ */
+class InProcessTarget final : public StormTarget {
+public:
+  explicit InProcessTarget(size_t block_size)
+      : block_size_{block_size}, kernel_{std::make_shared<net::NetlinkMemory>()},
+        server_{std::make_shared<etcd::EtcdServerMemory>(SEED)},
+        state_dir_{fmt::format("/tmp/ohno-storm-{}-{}", ::getpid(), g_storm_id.load())} {
+    server_->setLatency({}, etcd::EtcdLatency{ETCD_MEDIAN, ETCD_SIGMA});
+    auto ok = kernel_->vethCreate(UNDERLAY_DEV, UNDERLAY_PEER) &&
+              kernel_->addressSetEntry(UNDERLAY_DEV, UNDERLAY_ADDR, true) &&
+              kernel_->linkSetStatus(UNDERLAY_PEER, net::LinkStatus::UP) &&
+              kernel_->linkSetStatus(UNDERLAY_DEV, net::LinkStatus::UP);
+    OHNO_ASSERT(ok);
+  }
+  ~InProcessTarget() override {
+    std::error_code code{};
+    std::filesystem::remove_all(state_dir_, code);
+  }
+  InProcessTarget(const InProcessTarget &) = delete;
+  InProcessTarget(InProcessTarget &&) = delete;
+  auto operator=(const InProcessTarget &) -> InProcessTarget & = delete;
+  auto operator=(InProcessTarget &&) -> InProcessTarget & = delete;
+
+  auto prepare(const std::string &pod) -> bool override { return kernel_->netnsAdd(pod); }
+  auto add(const std::string &pod) -> std::optional<std::string> override {
+    try {
+      return makeCni()->add(pod, fmt::format("{}/{}", NETNS_DIR, pod), POD_NIC);
+    } catch (...) {
+      return std::nullopt;
+    }
+  }
+  auto del(const std::string &pod) -> bool override {
+    try {
+      makeCni()->del(pod, POD_NIC);
+      return true;
+    } catch (...) {
+      return false;
+    }
+  }
+  auto cleanup(const std::string &pod) -> void override { kernel_->netnsDel(pod); }
+  auto dump() -> std::unordered_map<std::string, std::string> override {
+    int64_t revision{0};
+    std::unordered_map<std::string, std::string> values{};
+    for (auto &[key, kv] : server_->range(ipam::ETCD_KEY_CACHE, true, revision)) {
+      values.emplace(key, std::move(kv.value_));
+    }
+    return values;
+  }
+  auto nicExist(const std::string &pod) -> bool override {
+    return kernel_->linkExist(POD_NIC, pod);
+  }
+
+private:
+  auto makeEtcdClient(const std::shared_ptr<etcd::ChangeLog> &change_log)
+      -> std::unique_ptr<etcd::EtcdClientIf> {
+    auto client = std::make_unique<etcd::EtcdClientCache>(
+        std::make_unique<etcd::EtcdClientShell>(etcd::EtcdData{},
+                                                std::make_unique<etcd::EtcdctlMemory>(server_),
+                                                std::make_unique<util::EnvStd>()),
+        ipam::ETCD_KEY_CACHE);
+    client->setChangeLog(change_log);
+    return client;
+  }
+
+  auto makeCni() -> std::unique_ptr<cni::Cni> {
+    cni::CniConfig config{};
+    config.ipam_.subnet_ = POD_CIDR;
+    config.ipam_.mode_ = cni::CniConfigIpam::Mode::host_gw;
+    config.ipam_.block_size_ = block_size_;
+    config.ipam_.journal_size_ = JOURNAL_SIZE;
+
+    auto cni = std::make_unique<cni::Cni>(kernel_);
+    cni->parseConfig(config);
+    auto change_log = std::make_shared<etcd::ChangeLog>();
+    auto ipam = std::make_unique<ipam::Ipam>();
+    ipam->init(makeEtcdClient(change_log), false);
+    ipam->setStateDir(state_dir_);
+    if (block_size_ > 0) {
+      ipam->enableBlockLease(block_size_, JOURNAL_SIZE, state_dir_);
+    }
+    auto storage = std::make_unique<cni::Storage>();
+    storage->init(makeEtcdClient(change_log), false);
+    cni->setIpam(std::move(ipam));
+    cni->setStorage(std::move(storage));
+    cni->setChangeLog(change_log);
+    cni->setCenter(
+        std::make_unique<backend::FakeCenter>(NODE_NAME, NODE_INTERNAL_IP, POD_CIDR));
+    cni->setNodeInfo(NODE_NAME, UNDERLAY_DEV, UNDERLAY_ADDR);
+    cni->setNodeIdlePath(fmt::format("{}/node_idle", state_dir_));
+    return cni;
+  }
+
+  size_t block_size_;
+  std::shared_ptr<net::NetlinkMemory> kernel_;
+  std::shared_ptr<etcd::EtcdServerMemory> server_;
+  std::string state_dir_; // IPAM 与节点空闲标记的本地状态，每次风暴独立
+};
+
+/**
+ * @brief 执行真实的 ohno 二进制：与 kubelet 一样通过环境变量传入 CNI 参数、stdin 传入配置，
+ * 使用节点上真实的内核、ETCD 与 api server（需要 root 权限）
+ *
+ */
+class ExecTarget final : public StormTarget {
+public:
+  explicit ExecTarget(size_t block_size) {
+    nlohmann::json config{};
+    if (!g_config.empty()) {
+      std::ifstream file{g_config};
+      config = nlohmann::json::parse(file);
+    } else {
+      config = cni::CniConfig{};
+    }
+    if (block_size > 0) {
+      config[cni::JKEY_CNI_CC_IPAM][cni::JKEY_CNI_CCI_BLOCKSIZE] = block_size;
+    }
+    config_ = config.dump();
+  }
+
+  auto prepare(const std::string &pod) -> bool override {
+    std::string out{};
+    return shell_.execute(fmt::format("ip netns add {}", pod), out);
+  }
+  auto add(const std::string &pod) -> std::optional<std::string> override {
+    std::string out{};
+    std::string err{};
+    if (shell_.execute(getCommand("ADD", pod), out, err) != 0) {
+      return std::nullopt;
+    }
+    return out;
+  }
+  auto del(const std::string &pod) -> bool override {
+    std::string out{};
+    std::string err{};
+    return shell_.execute(getCommand("DEL", pod), out, err) == 0;
+  }
+  auto cleanup(const std::string &pod) -> void override {
+    std::string out{};
+    shell_.execute(fmt::format("ip netns del {}", pod), out);
+  }
+  auto dump() -> std::unordered_map<std::string, std::string> override {
+    std::unordered_map<std::string, std::string> values{};
+    etcd::EtcdClientShell client{etcd::EtcdData{}, std::make_unique<util::ShellSync>(),
+                                 std::make_unique<util::EnvStd>()};
+    client.get(ipam::ETCD_KEY_CACHE, values);
+    return values;
+  }
+  auto nicExist(const std::string &pod) -> bool override {
+    return netlink_.linkExist(POD_NIC, pod);
+  }
+
+private:
+  auto getCommand(std::string_view command, const std::string &pod) const -> std::string {
+    return fmt::format("printf '%s' '{}' | {}={} {}={} {}={}/{} {}={} {}", config_,
+                       cni::JKEY_CNI_CE_COMMAND, command, cni::JKEY_CNI_CE_CONTAINERID, pod,
+                       cni::JKEY_CNI_CE_NETNS, NETNS_DIR, pod, cni::JKEY_CNI_CE_IFNAME, POD_NIC,
+                       g_ohno);
+  }
+
+  std::string config_;
+  util::ShellSync shell_;
+  net::NetlinkIpCmd netlink_{std::make_unique<util::ShellSync>()};
+};
+
+static auto percentile(std::vector<double> values, double ratio) -> double {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  return values[static_cast<size_t>(ratio * static_cast<double>(values.size() - 1))];
+}
+
+/**
+ * @brief 用若干个工作线程并发处理所有 Pod，相当于 kubelet 的并发 CNI 调用
+ *
+ * @return double 墙钟时间，单位秒
+ */
+template <typename Fn>
+static auto runConcurrently(size_t pods, size_t concurrency, const Fn &func) -> double {
+  std::atomic<size_t> next{0};
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers{};
+  for (size_t i = 0; i < concurrency; ++i) {
+    workers.emplace_back([&]() {
+      for (auto index = next++; index < pods; index = next++) {
+        func(index);
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief 从 CNI ADD 的结果中取出 Pod 的地址（不含前缀长度）
+ *
+ */
+static auto getAddresses(std::string_view result) -> std::vector<std::string> {
+  std::vector<std::string> addrs{};
+  auto json = nlohmann::json::parse(result, nullptr, false);
+  if (json.is_discarded()) {
+    return addrs;
+  }
+  for (const auto &ip : json.value(cni::JKEY_CNI_CR_IPS, nlohmann::json::array())) {
+    auto addr = ip.value(cni::JKEY_CNI_CRIPS_ADDRESS, std::string{});
+    addrs.emplace_back(addr.substr(0, addr.find('/')));
+  }
+  return addrs;
+}
+
+/**
+ * @brief 读取 CNI 进程内文件锁的争用次数与等待时间（只有进程内的风暴能统计到）
+ *
+ */
+static auto getLockContention() -> std::pair<uint64_t, double> {
+  auto &registry = metrics::Registry::instance();
+  uint64_t contended{0};
+  double wait{0};
+  for (const auto *lock : {"node_idle", "ip_block"}) {
+    metrics::Labels labels{{"lock", lock}};
+    contended +=
+        registry.counter("ohno_lock_contended_total", "File lock acquisitions that had to wait",
+                         labels)
+            .get();
+    wait += registry
+                .histogram("ohno_lock_wait_seconds", "File lock wait time",
+                           metrics::Buckets::latency, labels)
+                .getSum();
+  }
+  return {contended, wait};
+}
+
+/**
+ * @brief 节点恢复之后 kubelet 同时为所有 Pod 发起 CNI ADD，之后再同时 DEL；
+ * 检查地址冲突、DEL 之后残留的 ETCD 记录与网卡，以及文件锁的争用
+ *
+ * @param state range(0) 为 Pod 数量，range(1) 为并发数，range(2) 为地址块大小（0 表示不租用）
+ */
+static void BM_Storm(benchmark::State &state) {
+  auto pods = static_cast<size_t>(state.range(0));
+  auto concurrency = static_cast<size_t>(state.range(1));
+  auto block_size = static_cast<size_t>(state.range(2));
+
+  std::vector<double> add_ms(pods);
+  std::vector<double> del_ms(pods);
+  std::vector<std::vector<std::string>> addrs(pods);
+  std::atomic<uint64_t> add_failures{0};
+  std::atomic<uint64_t> del_failures{0};
+  double add_wall{0};
+  double del_wall{0};
+  uint64_t collisions{0};
+  uint64_t leaked_records{0};
+  uint64_t leaked_addrs{0};
+  uint64_t leaked_nics{0};
+  auto [contended_before, wait_before] = getLockContention();
+
+  for (auto _ : state) {
+    auto storm_id = g_storm_id++;
+    std::unique_ptr<StormTarget> target{};
+    if (g_ohno.empty()) {
+      target = std::make_unique<InProcessTarget>(block_size);
+    } else {
+      target = std::make_unique<ExecTarget>(block_size);
+    }
+    std::vector<std::string> names{}; // veth 名称由 Pod 名称得到，不能超过 15 个字符
+    for (size_t i = 0; i < pods; ++i) {
+      names.emplace_back(fmt::format("s{}-{:05d}", storm_id, i));
+      if (!target->prepare(names.back())) {
+        state.SkipWithError("Failed to create pod netns");
+        return;
+      }
+    }
+
+    auto timed = [](std::vector<double> &latency, size_t index, const auto &call) {
+      auto start = std::chrono::steady_clock::now();
+      call();
+      latency[index] = std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+    };
+    add_wall = runConcurrently(pods, concurrency, [&](size_t index) {
+      timed(add_ms, index, [&]() {
+        auto result = target->add(names[index]);
+        if (result.has_value()) {
+          addrs[index] = getAddresses(result.value());
+        } else {
+          ++add_failures;
+        }
+      });
+    });
+    del_wall = runConcurrently(pods, concurrency, [&](size_t index) {
+      timed(del_ms, index, [&]() { del_failures += target->del(names[index]) ? 0 : 1; });
+    });
+    state.SetIterationTime(add_wall + del_wall);
+
+    // 同一个地址分给了多个 Pod
+    std::map<std::string, size_t> owners{};
+    for (const auto &pod_addrs : addrs) {
+      for (const auto &addr : pod_addrs) {
+        collisions += owners[addr]++ > 0 ? 1 : 0;
+      }
+    }
+
+    // 所有 Pod 都已经 DEL，任何提到 Pod 名称的记录、仍被占用的 Pod 地址、Pod 内的网卡都是泄漏
+    for (const auto &[key, value] : target->dump()) {
+      auto mentioned = std::any_of(names.begin(), names.end(), [&](const std::string &name) {
+        return key.find(name) != std::string::npos || value.find(name) != std::string::npos;
+      });
+      leaked_records += mentioned ? 1 : 0;
+      if (key.compare(0, ipam::ETCD_KEY_ADDRESS.size(), ipam::ETCD_KEY_ADDRESS) == 0) {
+        auto addr = key.substr(key.rfind('/') + 1);
+        leaked_addrs += owners.count(addr);
+      }
+    }
+    for (const auto &name : names) {
+      leaked_nics += target->nicExist(name) ? 1 : 0;
+      target->cleanup(name);
+    }
+  }
+
+  auto [contended_after, wait_after] = getLockContention();
+  std::vector<double> all_add{};
+  std::vector<double> all_del{};
+  for (size_t i = 0; i < pods; ++i) {
+    all_add.emplace_back(add_ms[i]);
+    all_del.emplace_back(del_ms[i]);
+  }
+  auto iterations = static_cast<double>(state.iterations());
+  for (const auto &[name, value] : {
+           std::make_tuple("adds_per_sec", static_cast<double>(pods) / add_wall),
+           std::make_tuple("dels_per_sec", static_cast<double>(pods) / del_wall),
+           std::make_tuple("add_p50_ms", percentile(all_add, 0.5)),
+           std::make_tuple("add_p99_ms", percentile(all_add, 0.99)),
+           std::make_tuple("del_p50_ms", percentile(all_del, 0.5)),
+           std::make_tuple("del_p99_ms", percentile(all_del, 0.99)),
+           std::make_tuple("add_failures", static_cast<double>(add_failures) / iterations),
+           std::make_tuple("del_failures", static_cast<double>(del_failures) / iterations),
+           std::make_tuple("ip_collisions", static_cast<double>(collisions) / iterations),
+           std::make_tuple("leaked_records", static_cast<double>(leaked_records) / iterations),
+           std::make_tuple("leaked_addrs", static_cast<double>(leaked_addrs) / iterations),
+           std::make_tuple("leaked_nics", static_cast<double>(leaked_nics) / iterations),
+           std::make_tuple("lock_contended",
+                           static_cast<double>(contended_after - contended_before) / iterations),
+           std::make_tuple("lock_wait_ms", (wait_after - wait_before) * 1000 / iterations)}) {
+    state.counters[name] = value;
+  }
+}
+BENCHMARK(BM_Storm)
+    ->ArgNames({"pods", "concurrency", "block"})
+    ->Args({64, 1, 0})
+    ->Args({64, 16, 0})
+    ->Args({64, 64, 0})
+    ->Args({64, 16, 16})
+    ->Iterations(1)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+auto main(int argc, char **argv) -> int {
+  // 去掉自己的参数，剩下的交给 benchmark
+  int kept = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg{argv[i]};
+    if (arg.substr(0, FLAG_OHNO.size()) == FLAG_OHNO) {
+      g_ohno = arg.substr(FLAG_OHNO.size());
+    } else if (arg.substr(0, FLAG_CONFIG.size()) == FLAG_CONFIG) {
+      g_config = arg.substr(FLAG_CONFIG.size());
+    } else {
+      argv[kept++] = argv[i];
+    }
+  }
+  argc = kept;
+
+  log::LogConfig log_conf{};
+  log_conf.setLevel(log::Level::warn);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
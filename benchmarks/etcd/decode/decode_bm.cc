@@ -0,0 +1,236 @@
+// clang-format off
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "gtest/gtest.h"
+#include "benchmark/benchmark.h"
+#include "spdlog/fmt/fmt.h"
+#include "src/cni/storage.h"
+#include "src/etcd/etcd_client_shell.h"
+#include "src/helper/string.h"
+#include "src/log/logger.h"
+#include "src/net/route.h"
+#include "src/util/env_std.h"
+#include "src/util/shell_if.h"
+// clang-format on
+
+using namespace ohno;
+
+namespace {
+
+constexpr std::string_view NODE_NAME{"node-0001"};
+constexpr std::string_view POD_NAME{"pod-0001"};
+constexpr std::string_view NIC_NAME{"eth0"};
+constexpr int64_t MB{1 << 20};
+
+} // namespace
+
+/**
+ * @brief 不论什么命令都返回同一份输出的 shell，相当于 etcdctl 的输出已经读入内存
+ *
+ */
+class CannedShell final : public util::ShellIf {
+public:
+  explicit CannedShell(std::string output) : output_{std::move(output)} {}
+
+  auto execute(std::string_view /*command*/, std::string &out) const -> bool override {
+    out = output_;
+    return true;
+  }
+  auto execute(std::string_view /*command*/, std::string &out, std::string & /*err*/) const
+      -> int override {
+    out = output_;
+    return 0;
+  }
+  auto stream(std::string_view /*command*/,
+              const std::function<bool(std::string_view line)> & /*callback*/) const
+      -> int override {
+    return 0;
+  }
+
+private:
+  std::string output_;
+};
+
+/**
+ * @brief 改动之前的切分实现：复制到 istringstream，再逐个复制 token
+ *
+ */
+static auto splitLegacy(std::string_view str, char delim) -> std::vector<std::string> {
+  std::vector<std::string> tokens{};
+  std::string token{};
+  std::istringstream stream(std::string{str});
+  while (std::getline(stream, token, delim)) {
+    tokens.push_back(token);
+  }
+  return tokens;
+}
+
+/**
+ * @brief 生成 etcdctl get /ohno/ --prefix 的输出：每个 Pod 有 netns、网卡、地址、路由等记录，
+ * key 与 value 交替各占一行，直到输出达到指定大小
+ *
+ * @param size 输出的大小（字节）
+ */
+static auto makePrefixDump(int64_t size) -> std::string {
+  std::string dump{};
+  for (int64_t pod = 0; static_cast<int64_t>(dump.size()) < size; ++pod) {
+    auto node = pod / 110; // 每个节点默认最多 110 个 Pod
+    auto prefix = fmt::format("/ohno/node/node-{:04d}/pod/{:064x}", node, pod * 0x9e3779b97f4a7c15);
+    auto addr = fmt::format("10.{}.{}.{}", 244 + node / 256, node % 256, pod % 110 + 2);
+    dump += fmt::format("{}/netns\n/var/run/netns/cni-{:08x}\n", prefix, pod);
+    dump += fmt::format("{}/nic\n{}\n", prefix, NIC_NAME);
+    dump += fmt::format("{}/nic/{}/addr\n{}/24-{:012x}\n", prefix, NIC_NAME, addr, pod);
+    dump += fmt::format("{}/nic/{}/route\n0.0.0.0/0-10.{}.{}.1-{}\n", prefix, NIC_NAME,
+                        244 + node / 256, node % 256, NIC_NAME);
+  }
+  return dump;
+}
+
+/**
+ * @brief 生成一个网卡的路由列表 value（dest-via-dev，以 ',' 分割）
+ *
+ * @param routes 路由条数
+ */
+static auto makeRouteValue(int64_t routes) -> std::string {
+  std::string value{};
+  for (int64_t i = 0; i < routes; ++i) {
+    if (i > 0) {
+      value += ',';
+    }
+    value += fmt::format("10.{}.{}.0/24-192.168.{}.{}-eth0", 244 + i / 65536, i / 256 % 256,
+                         i / 256 % 256, i % 256);
+  }
+  return value;
+}
+
+static auto makeClient(std::string output) -> std::unique_ptr<etcd::EtcdClientShell> {
+  return std::make_unique<etcd::EtcdClientShell>(etcd::EtcdData{},
+                                                 std::make_unique<CannedShell>(std::move(output)),
+                                                 std::make_unique<util::EnvStd>());
+}
+
+/**
+ * @brief 按行切分前缀输出：旧实现、新的 split（仍然复制 token）、splitView 与 Tokenizer
+ *
+ * @param state range(0) 为输出大小（MB）
+ */
+static void BM_Decode_SplitLegacy(benchmark::State &state) {
+  auto dump = makePrefixDump(state.range(0) * MB);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(splitLegacy(dump, '\n'));
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(dump.size()));
+}
+BENCHMARK(BM_Decode_SplitLegacy)->Arg(1)->Arg(8)->Unit(benchmark::kMillisecond);
+
+static void BM_Decode_Split(benchmark::State &state) {
+  auto dump = makePrefixDump(state.range(0) * MB);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(helper::split(dump, '\n'));
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(dump.size()));
+}
+BENCHMARK(BM_Decode_Split)->Arg(1)->Arg(8)->Unit(benchmark::kMillisecond);
+
+static void BM_Decode_SplitView(benchmark::State &state) {
+  auto dump = makePrefixDump(state.range(0) * MB);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(helper::splitView(dump, '\n'));
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(dump.size()));
+}
+BENCHMARK(BM_Decode_SplitView)->Arg(1)->Arg(8)->Unit(benchmark::kMillisecond);
+
+static void BM_Decode_Tokenizer(benchmark::State &state) {
+  auto dump = makePrefixDump(state.range(0) * MB);
+  for (auto _ : state) {
+    helper::Tokenizer lines{dump, '\n'};
+    std::string_view line{};
+    size_t count{0};
+    while (lines.next(line)) {
+      count += line.size();
+    }
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(dump.size()));
+}
+BENCHMARK(BM_Decode_Tokenizer)->Arg(1)->Arg(8)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief 前缀输出解码为 key-value：旧实现与 EtcdClientShell::get(prefix, map)
+ *
+ * @param state range(0) 为输出大小（MB）
+ */
+static void BM_Decode_PrefixMapLegacy(benchmark::State &state) {
+  auto dump = makePrefixDump(state.range(0) * MB);
+  for (auto _ : state) {
+    auto out = dump; // 与 EtcdClientShell 一样先得到一份 etcdctl 的输出
+    std::unordered_map<std::string, std::string> values{};
+    auto map = splitLegacy(out, '\n');
+    for (size_t i = 0; i < map.size(); i += 2) {
+      values[map[i]] = map[i + 1];
+    }
+    benchmark::DoNotOptimize(values);
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(dump.size()));
+}
+BENCHMARK(BM_Decode_PrefixMapLegacy)->Arg(1)->Arg(8)->Unit(benchmark::kMillisecond);
+
+static void BM_Decode_PrefixMap(benchmark::State &state) {
+  auto dump = makePrefixDump(state.range(0) * MB);
+  auto client = makeClient(dump);
+  for (auto _ : state) {
+    std::unordered_map<std::string, std::string> values{};
+    client->get("/ohno/", values);
+    benchmark::DoNotOptimize(values);
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(dump.size()));
+}
+BENCHMARK(BM_Decode_PrefixMap)->Arg(1)->Arg(8)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief 网卡的路由列表解码为路由对象：旧实现（先切成字符串列表再逐条切分）与 Storage::getAllRoutes
+ *
+ * @param state range(0) 为路由条数
+ */
+static void BM_Decode_RoutesLegacy(benchmark::State &state) {
+  auto value = makeRouteValue(state.range(0));
+  for (auto _ : state) {
+    std::vector<std::unique_ptr<net::RouteIf>> routes{};
+    for (const auto &item : splitLegacy(value, ',')) {
+      auto route = splitLegacy(item, cni::SEPARATOR);
+      routes.emplace_back(std::make_unique<net::Route>(route[0], route[1], route[2]));
+    }
+    benchmark::DoNotOptimize(routes);
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(value.size()));
+}
+BENCHMARK(BM_Decode_RoutesLegacy)->Arg(1000)->Arg(50000)->Unit(benchmark::kMicrosecond);
+
+static void BM_Decode_Routes(benchmark::State &state) {
+  auto value = makeRouteValue(state.range(0));
+  cni::Storage storage{};
+  storage.init(makeClient(value), false);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(storage.getAllRoutes(NODE_NAME, POD_NAME, NIC_NAME));
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(value.size()));
+}
+BENCHMARK(BM_Decode_Routes)->Arg(1000)->Arg(50000)->Unit(benchmark::kMicrosecond);
+
+auto main(int argc, char **argv) -> int {
+  log::LogConfig log_conf{};
+  log_conf.setLevel(log::Level::warn);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,150 @@
+// clang-format off
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "gtest/gtest.h"
+#include "benchmark/benchmark.h"
+#include "spdlog/fmt/fmt.h"
+#include "src/etcd/etcd_client_shell.h"
+#include "src/etcd/etcd_server_memory.h"
+#include "src/log/logger.h"
+#include "src/util/env_std.h"
+// clang-format on
+
+using namespace ohno;
+using namespace ohno::etcd;
+
+namespace {
+
+constexpr std::string_view ENDPOINTS{
+    "https://10.0.0.1:2379,https://10.0.0.2:2379,https://10.0.0.3:2379"};
+constexpr std::string_view SLOW_ENDPOINT{"https://10.0.0.1:2379"};
+constexpr std::string_view KEY_PREFIX{"/ohno/bm/"};
+constexpr int64_t KEYS{1000};
+constexpr uint64_t SEED{20240601};
+
+} // namespace
+
+static auto makeClient(const std::shared_ptr<EtcdServerMemory> &server, bool hedge_reads)
+    -> std::unique_ptr<EtcdClientShell> {
+  EtcdData data{ENDPOINTS};
+  data.hedge_reads_ = hedge_reads;
+  return std::make_unique<EtcdClientShell>(data, std::make_unique<EtcdctlMemory>(server),
+                                           std::make_unique<util::EnvStd>());
+}
+
+static auto percentile(std::vector<double> values, double ratio) -> double {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  return values[static_cast<size_t>(ratio * static_cast<double>(values.size() - 1))];
+}
+
+/**
+ * @brief 没有延迟与故障时一次 get 的开销，即命令拼接、解析与输出处理本身
+ *
+ * @param state range(0) 为前缀下的 key 数量，0 表示读取单个 key
+ */
+static void BM_EtcdShell_Get(benchmark::State &state) {
+  auto server = std::make_shared<EtcdServerMemory>(SEED);
+  auto client = makeClient(server, false);
+  for (int64_t i = 0; i < std::max<int64_t>(state.range(0), 1); ++i) {
+    auto value = fmt::format("10.244.{}.{}/24", i / 256, i % 256);
+    client->put(fmt::format("{}{:06d}", KEY_PREFIX, i), value);
+  }
+
+  std::string value{};
+  std::unordered_map<std::string, std::string> values{};
+  for (auto _ : state) {
+    if (state.range(0) == 0) {
+      client->get(fmt::format("{}{:06d}", KEY_PREFIX, 0), value);
+      benchmark::DoNotOptimize(value);
+    } else {
+      values.clear();
+      client->get(KEY_PREFIX, values);
+      benchmark::DoNotOptimize(values);
+    }
+  }
+}
+BENCHMARK(BM_EtcdShell_Get)->Arg(0)->Arg(KEYS)->Arg(KEYS * 10)->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief 读延迟有长尾（对数正态分布，中位数 5ms，p99 约 80ms）时，对冲读对 p50 / p99 的影响
+ *
+ * @param state range(0) 是否开启对冲读
+ */
+static void BM_EtcdShell_HedgedRead(benchmark::State &state) {
+  auto server = std::make_shared<EtcdServerMemory>(SEED);
+  auto client = makeClient(server, state.range(0) != 0);
+  client->put(KEY_PREFIX, "value");
+  server->setLatency("get", EtcdLatency{std::chrono::milliseconds{5}, 1.2});
+
+  std::vector<double> latency{};
+  std::string value{};
+  for (auto _ : state) {
+    auto start = std::chrono::steady_clock::now();
+    client->get(KEY_PREFIX, value);
+    latency.emplace_back(
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+            .count());
+  }
+  state.counters["p50_ms"] = percentile(latency, 0.5);
+  state.counters["p99_ms"] = percentile(latency, 0.99);
+  state.counters["requests"] = static_cast<double>(server->getRequests("get")) /
+                               static_cast<double>(state.iterations());
+}
+BENCHMARK(BM_EtcdShell_HedgedRead)
+    ->Arg(0)
+    ->Arg(1)
+    ->Iterations(300)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief 一个端点按比例拒绝连接时，事务提交的成功率与重试开销
+ *
+ * @param state range(0) 为故障概率（百分比）
+ */
+static void BM_EtcdShell_CommitFault(benchmark::State &state) {
+  auto server = std::make_shared<EtcdServerMemory>(SEED);
+  auto client = makeClient(server, false);
+  server->setLatency({}, EtcdLatency{std::chrono::microseconds{100}, 0});
+  server->setFault(SLOW_ENDPOINT, EtcdFault{static_cast<double>(state.range(0)) / 100, 0, 0});
+
+  int64_t index{0};
+  uint64_t failures{0};
+  for (auto _ : state) {
+    EtcdTxn txn{};
+    txn.put(fmt::format("{}{:06d}", KEY_PREFIX, index % KEYS), "10.244.1.2")
+        .del(fmt::format("{}{:06d}", KEY_PREFIX, (index + 1) % KEYS));
+    ++index;
+    failures += client->commit(txn) == TxnResult::committed ? 0 : 1;
+  }
+  auto iterations = static_cast<double>(state.iterations());
+  state.counters["failures"] = static_cast<double>(failures);
+  state.counters["requests"] = static_cast<double>(server->getRequests("txn")) / iterations;
+}
+BENCHMARK(BM_EtcdShell_CommitFault)
+    ->Arg(0)
+    ->Arg(5)
+    ->Arg(50)
+    ->Iterations(500)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+auto main(int argc, char **argv) -> int {
+  log::LogConfig log_conf{};
+  log_conf.setLevel(log::Level::error);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
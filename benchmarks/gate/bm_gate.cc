@@ -0,0 +1,366 @@
+/**
+ * @brief 基准测试回归门禁：对比本次结果与提交在仓库中的基线，输出汇总报告
+ *
+ * 结果与基线都是 google benchmark 的 JSON 输出（--benchmark_out_format=json），
+ * 每个基准测试程序一个文件，文件名为 <程序名>.json；基线目录另有 tolerance.json
+ * 配置每个基准测试允许的耗时增长比例：
+ *
+ *   {"default": 0.15, "benchmarks": {"BM_Ipam_AllocateRelease": 0.1, "BM_Storm": -1}}
+ *
+ * 按最长前缀匹配基准测试名称，负数表示只报告不拦截（依赖宿主机环境的基准测试）；
+ * 有重复运行（--benchmark_repetitions）时使用中位数对比，减少单次运行的抖动
+ *
+ * 用法：bm_gate --baseline=<dir> --result=<dir> [--report=<file>] [--update]
+ *   --update 用本次结果覆盖基线，不做对比；基线只保留运行环境与每个基准测试的耗时，便于审查
+ */
+
+// clang-format off
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "nlohmann/json.hpp"
+#include "spdlog/fmt/fmt.h"
+// clang-format on
+
+namespace {
+
+constexpr std::string_view FLAG_BASELINE{"--baseline="};
+constexpr std::string_view FLAG_RESULT{"--result="};
+constexpr std::string_view FLAG_REPORT{"--report="};
+constexpr std::string_view FLAG_UPDATE{"--update"};
+constexpr std::string_view TOLERANCE_FILE{"tolerance.json"};
+constexpr double DEFAULT_TOLERANCE{0.15};
+
+enum class Verdict { pass, regression, improvement, report_only, added, missing, skipped };
+
+struct Run {
+  double time_ns_{0}; // 单次迭代的真实时间（UseManualTime 时为手动计时）
+  bool error_{false}; // SkipWithError
+};
+
+struct Row {
+  std::string program_;
+  std::string name_;
+  std::optional<Run> baseline_;
+  std::optional<Run> result_;
+  double tolerance_{DEFAULT_TOLERANCE};
+  Verdict verdict_{Verdict::pass};
+};
+
+struct Tolerance {
+  double default_{DEFAULT_TOLERANCE};
+  std::map<std::string, double> benchmarks_;
+};
+
+} // namespace
+
+static auto toNanoseconds(double value, std::string_view unit) -> double {
+  if (unit == "us") {
+    return value * 1e3;
+  }
+  if (unit == "ms") {
+    return value * 1e6;
+  }
+  if (unit == "s") {
+    return value * 1e9;
+  }
+  return value;
+}
+
+/**
+ * @brief 读取 JSON 文件
+ *
+ * @note google benchmark 对计数器的标准差等聚合结果会输出 NaN / Infinity，
+ * 这不是合法的 JSON，先替换成 null
+ */
+static auto readJson(const std::filesystem::path &path) -> std::optional<nlohmann::json> {
+  std::ifstream file{path};
+  if (!file) {
+    return std::nullopt;
+  }
+  std::string text{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+  text = std::regex_replace(text, std::regex{R"(:\s*-?(NaN|Infinity))"}, ": null");
+  auto json = nlohmann::json::parse(text, nullptr, false);
+  if (json.is_discarded()) {
+    std::cerr << fmt::format("Invalid JSON: {}\n", path.string());
+    return std::nullopt;
+  }
+  return json;
+}
+
+/**
+ * @brief 读取一个基准测试程序的输出，有重复运行（--benchmark_repetitions）时取中位数
+ *
+ * @param path JSON 文件
+ * @return std::map<std::string, Run> key 为基准测试名称（不含聚合后缀）
+ */
+static auto readRuns(const std::filesystem::path &path) -> std::map<std::string, Run> {
+  std::map<std::string, Run> runs{};
+  auto json = readJson(path);
+  if (!json.has_value()) {
+    return runs;
+  }
+
+  std::map<std::string, Run> medians{};
+  auto benchmarks = json->value("benchmarks", nlohmann::json::array());
+  for (const auto &bm : benchmarks) {
+    auto aggregate = bm.value("run_type", "iteration") == "aggregate";
+    if (aggregate && bm.value("aggregate_name", "") != "median") {
+      continue; // 平均值、标准差等其他聚合结果
+    }
+    auto name = bm.value("run_name", bm.value("name", std::string{}));
+    auto time = bm.contains("real_time") && bm.at("real_time").is_number()
+                    ? bm.at("real_time").get<double>()
+                    : 0;
+    Run run{toNanoseconds(time, bm.value("time_unit", "ns")), bm.value("error_occurred", false)};
+    if (aggregate) {
+      medians[name] = run;
+    } else if (runs.count(name) == 0) {
+      runs[name] = run;
+    }
+  }
+  for (const auto &[name, run] : medians) {
+    runs[name] = run;
+  }
+  return runs;
+}
+
+static auto readTolerance(const std::filesystem::path &path) -> Tolerance {
+  Tolerance tolerance{};
+  auto json = readJson(path);
+  if (!json.has_value()) {
+    return tolerance;
+  }
+  tolerance.default_ = json->value("default", DEFAULT_TOLERANCE);
+  auto benchmarks = json->value("benchmarks", nlohmann::json::object());
+  for (const auto &[name, value] : benchmarks.items()) {
+    tolerance.benchmarks_[name] = value.get<double>();
+  }
+  return tolerance;
+}
+
+// 最长前缀匹配，例如 "BM_Storm" 匹配所有 "BM_Storm/pods:64/..."
+static auto getTolerance(const Tolerance &tolerance, std::string_view name) -> double {
+  double ret = tolerance.default_;
+  size_t matched{0};
+  for (const auto &[prefix, value] : tolerance.benchmarks_) {
+    if (prefix.size() >= matched && name.substr(0, prefix.size()) == prefix) {
+      ret = value;
+      matched = prefix.size();
+    }
+  }
+  return ret;
+}
+
+static auto judge(Row &row) -> void {
+  if (!row.result_.has_value()) {
+    row.verdict_ = Verdict::missing;
+  } else if (!row.baseline_.has_value()) {
+    row.verdict_ = Verdict::added;
+  } else if (row.result_->error_ || row.baseline_->error_ || row.baseline_->time_ns_ <= 0) {
+    row.verdict_ = Verdict::skipped;
+  } else if (row.tolerance_ < 0) {
+    row.verdict_ = Verdict::report_only;
+  } else {
+    auto ratio = row.result_->time_ns_ / row.baseline_->time_ns_;
+    if (ratio > 1 + row.tolerance_) {
+      row.verdict_ = Verdict::regression;
+    } else if (ratio < 1 - row.tolerance_) {
+      row.verdict_ = Verdict::improvement;
+    } else {
+      row.verdict_ = Verdict::pass;
+    }
+  }
+}
+
+static auto getVerdictName(Verdict verdict) -> std::string_view {
+  switch (verdict) {
+  case Verdict::pass:
+    return "ok";
+  case Verdict::regression:
+    return "REGRESSION";
+  case Verdict::improvement:
+    return "improved";
+  case Verdict::report_only:
+    return "report only";
+  case Verdict::added:
+    return "new";
+  case Verdict::missing:
+    return "missing";
+  case Verdict::skipped:
+    return "skipped";
+  }
+  return "";
+}
+
+static auto formatTime(const std::optional<Run> &run) -> std::string {
+  if (!run.has_value()) {
+    return "-";
+  }
+  if (run->error_) {
+    return "error";
+  }
+  auto ns = run->time_ns_;
+  if (ns >= 1e6) {
+    return fmt::format("{:.3f} ms", ns / 1e6);
+  }
+  if (ns >= 1e3) {
+    return fmt::format("{:.3f} us", ns / 1e3);
+  }
+  return fmt::format("{:.1f} ns", ns);
+}
+
+/**
+ * @brief 生成 Markdown 格式的汇总报告：回归的基准测试排在最前面
+ *
+ */
+static auto getReport(std::vector<Row> rows) -> std::string {
+  std::stable_sort(rows.begin(), rows.end(), [](const Row &lhs, const Row &rhs) {
+    return (lhs.verdict_ == Verdict::regression) > (rhs.verdict_ == Verdict::regression);
+  });
+
+  std::map<Verdict, size_t> total{};
+  for (const auto &row : rows) {
+    ++total[row.verdict_];
+  }
+  std::string report{"# Benchmark regression report\n\n"};
+  for (const auto &[verdict, count] : total) {
+    report += fmt::format("- {}: {}\n", getVerdictName(verdict), count);
+  }
+  report += "\n| program | benchmark | baseline | result | change | tolerance | verdict |\n"
+            "|---|---|---|---|---|---|---|\n";
+  for (const auto &row : rows) {
+    std::string change{"-"};
+    if (row.baseline_.has_value() && row.result_.has_value() && row.baseline_->time_ns_ > 0) {
+      change = fmt::format("{:+.1f}%",
+                           (row.result_->time_ns_ / row.baseline_->time_ns_ - 1) * 100);
+    }
+    auto tolerance = row.tolerance_ < 0 ? std::string{"-"}
+                                        : fmt::format("{:.0f}%", row.tolerance_ * 100);
+    report += fmt::format("| {} | {} | {} | {} | {} | {} | {} |\n", row.program_, row.name_,
+                          formatTime(row.baseline_), formatTime(row.result_), change, tolerance,
+                          getVerdictName(row.verdict_));
+  }
+  return report;
+}
+
+static auto listPrograms(const std::filesystem::path &dir) -> std::vector<std::string> {
+  std::vector<std::string> programs{};
+  std::error_code code{};
+  for (const auto &entry : std::filesystem::directory_iterator{dir, code}) {
+    if (entry.path().extension() == ".json" && entry.path().filename() != TOLERANCE_FILE) {
+      programs.emplace_back(entry.path().stem().string());
+    }
+  }
+  return programs;
+}
+
+// 用本次结果覆盖基线
+static auto update(const std::filesystem::path &baseline_dir,
+                   const std::filesystem::path &result_dir) -> int {
+  std::filesystem::create_directories(baseline_dir);
+  for (const auto &program : listPrograms(result_dir)) {
+    auto file = program + ".json";
+    auto result = readJson(result_dir / file);
+    if (!result.has_value()) {
+      return 1;
+    }
+
+    nlohmann::json baseline{};
+    baseline["context"] = result->value("context", nlohmann::json::object());
+    baseline["benchmarks"] = nlohmann::json::array();
+    for (const auto &[name, run] : readRuns(result_dir / file)) {
+      baseline["benchmarks"].push_back({{"name", name},
+                                        {"real_time", std::round(run.time_ns_)},
+                                        {"time_unit", "ns"},
+                                        {"error_occurred", run.error_}});
+    }
+    std::ofstream out{baseline_dir / file};
+    if (!(out << baseline.dump(2) << "\n")) {
+      std::cerr << fmt::format("Failed to update baseline {}\n", file);
+      return 1;
+    }
+    std::cout << fmt::format("Updated baseline {}\n", (baseline_dir / file).string());
+  }
+  return 0;
+}
+
+auto main(int argc, char **argv) -> int {
+  std::filesystem::path baseline_dir{};
+  std::filesystem::path result_dir{};
+  std::filesystem::path report_file{};
+  bool need_update{false};
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg{argv[i]};
+    if (arg.substr(0, FLAG_BASELINE.size()) == FLAG_BASELINE) {
+      baseline_dir = arg.substr(FLAG_BASELINE.size());
+    } else if (arg.substr(0, FLAG_RESULT.size()) == FLAG_RESULT) {
+      result_dir = arg.substr(FLAG_RESULT.size());
+    } else if (arg.substr(0, FLAG_REPORT.size()) == FLAG_REPORT) {
+      report_file = arg.substr(FLAG_REPORT.size());
+    } else if (arg == FLAG_UPDATE) {
+      need_update = true;
+    } else {
+      std::cerr << fmt::format("Unknown argument: {}\n", arg);
+      return 2;
+    }
+  }
+  if (baseline_dir.empty() || result_dir.empty()) {
+    std::cerr << "Usage: bm_gate --baseline=<dir> --result=<dir> [--report=<file>] [--update]\n";
+    return 2;
+  }
+  if (need_update) {
+    return update(baseline_dir, result_dir);
+  }
+
+  // 只对比本次运行过的程序，没有运行的程序（例如被过滤掉）不算缺失
+  auto tolerance = readTolerance(baseline_dir / TOLERANCE_FILE);
+  std::vector<Row> rows{};
+  for (const auto &program : listPrograms(result_dir)) {
+    auto results = readRuns(result_dir / (program + ".json"));
+    auto baselines = readRuns(baseline_dir / (program + ".json"));
+    for (const auto &[name, run] : baselines) {
+      rows.emplace_back(Row{program, name, run, std::nullopt});
+    }
+    for (const auto &[name, run] : results) {
+      auto iter = std::find_if(rows.begin(), rows.end(), [&](const Row &row) {
+        return row.program_ == program && row.name_ == name;
+      });
+      if (iter == rows.end()) {
+        rows.emplace_back(Row{program, name, std::nullopt, run});
+      } else {
+        iter->result_ = run;
+      }
+    }
+  }
+  for (auto &row : rows) {
+    row.tolerance_ = getTolerance(tolerance, row.name_);
+    judge(row);
+  }
+
+  auto report = getReport(rows);
+  std::cout << report;
+  if (!report_file.empty()) {
+    std::ofstream file{report_file};
+    file << report;
+  }
+
+  auto regressions = std::count_if(rows.begin(), rows.end(), [](const Row &row) {
+    return row.verdict_ == Verdict::regression;
+  });
+  if (regressions > 0) {
+    std::cerr << fmt::format("{} benchmark(s) regressed beyond tolerance\n", regressions);
+    return 1;
+  }
+  return 0;
+}
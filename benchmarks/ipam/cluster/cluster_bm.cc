@@ -0,0 +1,130 @@
+// clang-format off
+#include <memory>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "benchmark/benchmark.h"
+#include "spdlog/fmt/fmt.h"
+#include "src/ipam/arena.h"
+#include "src/ipam/cluster.h"
+#include "src/ipam/netns.h"
+#include "src/ipam/node.h"
+#include "src/log/logger.h"
+#include "src/net/addr.h"
+#include "src/net/nic.h"
+#include "src/net/route.h"
+#include "src/net/netlink/netlink_memory.h"
+// clang-format on
+
+using namespace ohno;
+
+namespace {
+
+constexpr std::string_view NODE_NAME{"node-0001"};
+constexpr std::string_view GATEWAY{"10.244.0.1"};
+
+/**
+ * @brief 从 ETCD 读出的一个 Pod 的记录
+ *
+ */
+struct PodRecord {
+  std::string netns_;
+  std::string nic_;
+  std::string addr_;
+};
+
+} // namespace
+
+/**
+ * @brief 生成 Pod 记录，并在内存 Netlink 中创建对应的网卡，相当于节点上已经运行着这些 Pod
+ *
+ * @note 网卡都留在 root 网络空间，模型只需要找到网卡、地址与路由
+ *
+ * @param pods Pod 数量
+ * @param netlink 内存 Netlink
+ */
+static auto makeRecords(int64_t pods, net::NetlinkMemory &netlink) -> std::vector<PodRecord> {
+  std::vector<PodRecord> records{};
+  for (int64_t i = 0; i < pods; ++i) {
+    records.push_back(PodRecord{fmt::format("/var/run/netns/cni-{:016x}", i * 0x9e3779b97f4a7c15),
+                                fmt::format("veth{:05d}", i),
+                                fmt::format("10.244.{}.{}/16", i / 250, i % 250 + 2)});
+    netlink.vethCreate(records.back().nic_, fmt::format("peer{:05d}", i));
+  }
+  return records;
+}
+
+/**
+ * @brief 按 Cni::getKubernetesCluster 的方式构建一个节点的集群模型
+ *
+ * @param records Pod 记录
+ * @param netlink Netlink 对象
+ * @param arena 内存区域，为空时对象都在堆上分配
+ */
+static auto buildCluster(const std::vector<PodRecord> &records,
+                         const std::weak_ptr<net::NetlinkIf> &netlink,
+                         const std::shared_ptr<ipam::Arena> &arena)
+    -> std::unique_ptr<ipam::ClusterIf> {
+  auto cluster = arena ? std::make_unique<ipam::Cluster>(arena) : std::make_unique<ipam::Cluster>();
+  std::shared_ptr<ipam::NodeIf> node{};
+  if (arena) {
+    node = arena->make<ipam::Node>(arena->getResource());
+  } else {
+    node = std::make_shared<ipam::Node>();
+  }
+  node->setName(NODE_NAME);
+  for (const auto &record : records) {
+    std::shared_ptr<ipam::NetnsIf> pod{};
+    std::shared_ptr<net::NicIf> nic{};
+    if (arena) {
+      pod = arena->make<ipam::Netns>(arena->getResource());
+      nic = arena->make<net::Nic>();
+    } else {
+      pod = std::make_shared<ipam::Netns>();
+      nic = std::make_shared<net::Nic>();
+    }
+    pod->setName(record.netns_);
+    nic->setName(record.nic_);
+    nic->setup(netlink);
+    nic->addAddr(std::make_unique<net::Addr>(record.addr_));
+    nic->addRoute(std::make_unique<net::Route>("0.0.0.0/0", GATEWAY, record.nic_),
+                  net::NetlinkIf::RouteNHFlags::NONE);
+    pod->addNic(nic);
+    node->addNetns(record.netns_, pod);
+  }
+  cluster->addNode(NODE_NAME, node);
+  return cluster;
+}
+
+/**
+ * @brief 构建并释放集群模型，即一次 CNI 调用中模型的全部开销
+ *
+ * @param state range(0) 为 Pod 数量；range(1) 为是否使用内存区域
+ */
+static void BM_Cluster_Build(benchmark::State &state) {
+  auto netlink = std::make_shared<net::NetlinkMemory>();
+  auto records = makeRecords(state.range(0), *netlink);
+  for (auto _ : state) {
+    auto arena = state.range(1) != 0 ? std::make_shared<ipam::Arena>() : nullptr;
+    auto cluster = buildCluster(records, netlink, arena);
+    benchmark::DoNotOptimize(cluster);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Cluster_Build)
+    ->ArgsProduct({{110, 500}, {0, 1}})
+    ->ArgNames({"pods", "arena"})
+    ->Unit(benchmark::kMicrosecond);
+
+auto main(int argc, char **argv) -> int {
+  log::LogConfig log_conf{};
+  log_conf.setLevel(log::Level::warn);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,115 @@
+// clang-format off
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "gtest/gtest.h"
+#include "benchmark/benchmark.h"
+#include "benchmarks/mock/fake_cluster.h"
+#include "spdlog/fmt/fmt.h"
+#include "src/ipam/ipam.h"
+#include "src/net/ip.h"
+// clang-format on
+
+using namespace ohno::etcd;
+using namespace ohno::ipam;
+
+namespace {
+
+constexpr std::string_view NODE_NAME{"bm-node"};
+// 逐个地址写 key：读子网 + 读已分配地址 + 写 + 删，旧布局列表只在第一次归还时读取
+constexpr double CYCLE_CALLS_BUDGET{4};
+constexpr double CYCLE_CALLS_BUDGET_BLOCK{2}; // 租用地址块：分配与归还在 journal 中相互抵消
+
+} // namespace
+
+/**
+ * @brief 准备一个子网已按比例占满的节点
+ *
+ * @param etcd 内存 ETCD 服务端
+ * @param prefix 子网前缀长度
+ * @param fill 占用比例（百分比）
+ */
+static void fillSubnet(EtcdServerMemory &etcd, int64_t prefix, int64_t fill) {
+  auto subnet = fmt::format("10.0.0.0/{}", prefix);
+  etcd.put(fmt::format("{}/{}", ETCD_KEY_SUBNET, NODE_NAME), subnet);
+
+  auto hosts = (uint32_t{1} << (32 - prefix)) - 2; // 不含网络地址与广播地址
+  auto used = static_cast<uint32_t>(hosts * fill / 100);
+  auto network = ohno::net::IpPrefix::parse(subnet).value();
+  for (uint32_t i = 1; i <= used; ++i) {
+    auto addr = network.hostAt(i).toString();
+    etcd.put(fmt::format("{}/{}/{}", ETCD_KEY_ADDRESS, NODE_NAME, addr),
+             fmt::format("{}/{}", addr, prefix));
+  }
+}
+
+/**
+ * @brief 分配并立即归还一个地址，子网占用比例保持不变
+ *
+ * @param state range(0) 子网前缀长度，range(1) 占用比例，range(2) 每次 ETCD 调用注入的时延（微秒）
+ * @param block_size 地址块大小，0 表示逐个地址写 key
+ * @param budget 每轮分配加归还允许的 ETCD 调用次数
+ */
+static void runAllocateRelease(benchmark::State &state, size_t block_size, double budget) {
+  auto server = makeMemoryEtcdServer(std::chrono::microseconds{state.range(2)});
+  fillSubnet(*server, state.range(0), state.range(1));
+
+  auto state_dir = fmt::format("{}ohno-ipam-bm", testing::TempDir());
+  std::filesystem::remove_all(state_dir);
+  Ipam ipam{};
+  ipam.init(std::make_unique<MemoryEtcdClient>(server), false);
+  ipam.setStateDir(state_dir);
+  if (block_size > 0) {
+    ipam.enableBlockLease(block_size, block_size, state_dir);
+  }
+
+  // 先完成一轮，租用地址块等一次性开销不计入每轮的调用次数
+  std::string ip{};
+  if (!ipam.allocateIp(NODE_NAME, ip) || !ipam.releaseIp(NODE_NAME, ip)) {
+    state.SkipWithError("allocation failed");
+    return;
+  }
+  auto calls = server->getRequests();
+  for (auto _ : state) {
+    if (!ipam.allocateIp(NODE_NAME, ip)) {
+      state.SkipWithError("allocation failed");
+      break;
+    }
+    ipam.releaseIp(NODE_NAME, ip);
+  }
+
+  auto per_cycle = static_cast<double>(server->getRequests() - calls) /
+                   static_cast<double>(std::max<benchmark::IterationCount>(state.iterations(), 1));
+  state.counters["etcd_calls"] = per_cycle;
+  if (per_cycle > budget) {
+    state.SkipWithError(fmt::format("{:.2f} etcd calls per cycle exceed the budget of {}",
+                                    per_cycle, budget)
+                            .c_str());
+  }
+  std::filesystem::remove_all(state_dir);
+}
+
+static void sweepArgs(benchmark::internal::Benchmark *bm) {
+  for (int64_t prefix : {28, 24, 20}) {
+    for (int64_t fill : {0, 50, 90, 99}) {
+      for (int64_t latency : {0, 200}) {
+        bm->Args({prefix, fill, latency});
+      }
+    }
+  }
+  bm->ArgNames({"prefix", "fill", "latency_us"})->UseRealTime()->Unit(benchmark::kMicrosecond);
+}
+
+static void BM_Ipam_AllocateRelease(benchmark::State &state) {
+  runAllocateRelease(state, 0, CYCLE_CALLS_BUDGET);
+}
+BENCHMARK(BM_Ipam_AllocateRelease)->Apply(sweepArgs);
+
+static void BM_Ipam_AllocateRelease_BlockLease(benchmark::State &state) {
+  runAllocateRelease(state, 16, CYCLE_CALLS_BUDGET_BLOCK);
+}
+BENCHMARK(BM_Ipam_AllocateRelease_BlockLease)->Apply(sweepArgs);
+
+BENCHMARK_MAIN();
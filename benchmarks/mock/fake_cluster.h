@@ -0,0 +1,265 @@
+#pragma once
+
+// clang-format off
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "spdlog/fmt/fmt.h"
+#include "src/backend/center_if.h"
+#include "src/etcd/etcd_client_if.h"
+#include "src/etcd/etcd_server_memory.h"
+#include "src/helper/string.h"
+// clang-format on
+
+namespace ohno {
+namespace etcd {
+
+// 基准测试不 watch，只保留最近的历史事件，长时间运行时内存不增长
+constexpr int64_t MEMORY_ETCD_RETENTION{1024};
+
+/**
+ * @brief 创建基准测试使用的内存 ETCD 服务端
+ *
+ * @param latency 每个请求注入的固定时延，模拟一次 etcdctl 往返
+ * @return std::shared_ptr<EtcdServerMemory> 服务端，多个 MemoryEtcdClient 共享时相当于同一个集群
+ */
+inline auto makeMemoryEtcdServer(std::chrono::microseconds latency = {})
+    -> std::shared_ptr<EtcdServerMemory> {
+  auto server = std::make_shared<EtcdServerMemory>();
+  server->setAutoCompaction(MEMORY_ETCD_RETENTION);
+  if (latency.count() > 0) {
+    server->setLatency({}, EtcdLatency{latency, 0});
+  }
+  return server;
+}
+
+/**
+ * @brief 所有基准测试共用的进程内 ETCD 客户端，直接调用 EtcdServerMemory，不经过 etcdctl 解析
+ *
+ * 与 ETCD 一样维护 revision 并检查事务的比较条件，并发的 CNI 调用之间能看到真实的冲突；
+ * 每个方法是一次请求，按 etcdctl 子命令计入 EtcdServerMemory::getRequests()，
+ * 服务端配置的时延与故障同样生效
+ *
+ */
+class MemoryEtcdClient final : public EtcdClientIf {
+public:
+  explicit MemoryEtcdClient(std::shared_ptr<EtcdServerMemory> server)
+      : server_{std::move(server)} {}
+
+  auto test() const -> bool override {
+    return call("endpoint", [] { return true; });
+  }
+  auto put(std::string_view key, std::string_view value) const -> bool override {
+    return put(key, value, {});
+  }
+  auto put(std::string_view key, std::string_view value, std::string_view lease_id) const
+      -> bool override {
+    return call("put", [&] { return server_->put(key, value, lease_id); });
+  }
+  auto append(std::string_view key, std::string_view value) const -> bool override {
+    return call("put", [&] {
+      auto old = read(key);
+      return server_->put(key, old.empty() ? std::string{value} : fmt::format("{},{}", old, value));
+    });
+  }
+  auto get(std::string_view key, std::string &value) const -> bool override {
+    return call("get", [&] {
+      value = read(key);
+      return true;
+    });
+  }
+  auto get(std::string_view key, std::string &value, int64_t &revision) const
+      -> bool override {
+    return call("get", [&] {
+      auto kvs = server_->range(key, false, revision);
+      value = kvs.empty() ? std::string{} : std::move(kvs.front().second.value_);
+      revision = kvs.empty() ? 0 : kvs.front().second.mod_revision_;
+      return true;
+    });
+  }
+  auto get(std::string_view key, std::unordered_map<std::string, std::string> &value) const
+      -> bool override {
+    return call("get", [&] {
+      int64_t revision{0};
+      for (auto &[name, kv] : server_->range(key, true, revision)) {
+        value.insert_or_assign(std::move(name), std::move(kv.value_));
+      }
+      return true;
+    });
+  }
+  auto del(std::string_view key) const -> bool override {
+    return call("del", [&] {
+      server_->del(key, false);
+      return true;
+    });
+  }
+  auto del(std::string_view key, std::string_view value) const -> bool override {
+    return call("put", [&] {
+      auto values = helper::split(read(key), ',');
+      values.erase(std::remove(values.begin(), values.end(), value), values.end());
+      std::string to_put{};
+      for (const auto &item : values) {
+        to_put += to_put.empty() ? item : fmt::format(",{}", item);
+      }
+      if (to_put.empty()) {
+        server_->del(key, false);
+        return true;
+      }
+      return server_->put(key, to_put);
+    });
+  }
+  auto delPrefix(std::string_view prefix) const -> bool override {
+    return call("del", [&] {
+      server_->del(prefix, true);
+      return true;
+    });
+  }
+  auto list(std::string_view key, std::vector<std::string> &results) const -> bool override {
+    return call("get", [&] {
+      results = helper::split(read(key), ',');
+      return true;
+    });
+  }
+  auto dump(std::string_view key) const -> std::string override {
+    std::unordered_map<std::string, std::string> values{};
+    std::string result{};
+    if (get(key, values)) {
+      for (const auto &[name, value] : values) {
+        result += fmt::format("{} -> {}\n", name, value);
+      }
+    }
+    return result;
+  }
+  auto grantLease(int64_t ttl, std::string &lease_id) const -> bool override {
+    return call("lease", [&] {
+      lease_id = server_->grantLease(ttl);
+      return true;
+    });
+  }
+  auto keepAliveLease(std::string_view lease_id) const -> bool override {
+    return call("lease", [&] { return server_->keepAliveLease(lease_id).has_value(); });
+  }
+  auto snapshot(std::string_view prefix, std::unordered_map<std::string, std::string> &values,
+                int64_t &revision) const -> bool override {
+    values.clear();
+    return call("get", [&] {
+      for (auto &[name, kv] : server_->range(prefix, true, revision)) {
+        values.emplace(std::move(name), std::move(kv.value_));
+      }
+      return true;
+    });
+  }
+  auto watch(std::string_view /*prefix*/, int64_t /*revision*/,
+             const WatchCallback & /*callback*/) const -> WatchResult override {
+    return WatchResult::stopped;
+  }
+  auto commit(const EtcdTxn &txn) const -> TxnResult override {
+    auto result = TxnResult::failed;
+    call("txn", [&] {
+      result = server_->commit(txn.getCmps(), txn.getOps());
+      return true;
+    });
+    return result;
+  }
+
+private:
+  /**
+   * @brief 执行一次请求：先按服务端的配置等待时延、抽样故障，再执行操作
+   *
+   * @param op etcdctl 子命令，用于统计请求数与选择时延
+   * @param func 请求的操作
+   * @return true 请求成功
+   * @return false 请求失败，或者请求已经执行但客户端看到超时
+   */
+  template <typename Func>
+  auto call(std::string_view op, Func &&func) const -> bool {
+    auto fault = server_->inject({}, op);
+    if (fault == EtcdServerMemory::Fault::unavailable ||
+        fault == EtcdServerMemory::Fault::rejected) {
+      return false;
+    }
+    auto ret = func();
+    return ret && fault == EtcdServerMemory::Fault::none;
+  }
+
+  auto read(std::string_view key) const -> std::string {
+    int64_t revision{0};
+    auto kvs = server_->range(key, false, revision);
+    return kvs.empty() ? std::string{} : std::move(kvs.front().second.value_);
+  }
+
+  std::shared_ptr<EtcdServerMemory> server_;
+};
+
+} // namespace etcd
+
+namespace backend {
+
+/**
+ * @brief 所有基准测试共用的 api server，与真实实现一样每次都复制节点信息，并统计调用次数
+ *
+ */
+class FakeCenter final : public CenterIf {
+public:
+  using Nodes = std::unordered_map<std::string, NodeInfo>;
+
+  /**
+   * @brief 只有一个节点的集群
+   *
+   * @param name 节点名称
+   * @param internal_ip 节点 IP
+   * @param pod_cidr 节点的 Pod 子网
+   */
+  FakeCenter(std::string_view name, std::string_view internal_ip, std::string_view pod_cidr)
+      : own_{{std::string{name},
+              NodeInfo{std::string{name},
+                       std::string{internal_ip},
+                       std::string{pod_cidr},
+                       {std::string{pod_cidr}}}}},
+        nodes_{&own_} {}
+
+  /**
+   * @brief 节点由调用者维护的集群，节点可以随时加入、离开
+   *
+   * @param nodes 集群中的节点，生命周期长于 FakeCenter
+   * @param calls 调用次数（返回值），可以为空
+   */
+  FakeCenter(const Nodes &nodes, uint64_t *calls) : nodes_{&nodes}, calls_{calls} {}
+
+  ~FakeCenter() override = default;
+  FakeCenter(const FakeCenter &) = delete;
+  FakeCenter(FakeCenter &&) = delete;
+  auto operator=(const FakeCenter &) -> FakeCenter & = delete;
+  auto operator=(FakeCenter &&) -> FakeCenter & = delete;
+
+  auto test() const -> bool override { return true; }
+  auto getKubernetesData(std::string_view node_name) const -> NodeInfo override {
+    count();
+    auto iter = nodes_->find(std::string{node_name});
+    return iter == nodes_->end() ? NodeInfo{} : iter->second;
+  }
+  auto getKubernetesData() const -> Nodes override {
+    count();
+    return *nodes_;
+  }
+
+private:
+  auto count() const -> void {
+    if (calls_ != nullptr) {
+      ++*calls_;
+    }
+  }
+
+  Nodes own_;
+  const Nodes *nodes_;
+  uint64_t *calls_{nullptr};
+};
+
+} // namespace backend
+} // namespace ohno
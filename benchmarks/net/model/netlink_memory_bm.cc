@@ -0,0 +1,176 @@
+// clang-format off
+#include <unistd.h>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "gtest/gtest.h"
+#include "benchmark/benchmark.h"
+#include "benchmarks/mock/fake_cluster.h"
+#include "spdlog/fmt/fmt.h"
+#include "src/cni/cni.h"
+#include "src/cni/storage.h"
+#include "src/common/assert.h"
+#include "src/ipam/ipam.h"
+#include "src/log/logger.h"
+#include "src/net/addr.h"
+#include "src/net/bridge.h"
+#include "src/net/netlink/netlink_memory.h"
+#include "src/net/route.h"
+// clang-format on
+
+using namespace ohno;
+using namespace ohno::etcd;
+
+namespace {
+
+constexpr std::string_view NODE_NAME{"bm-node"};
+constexpr std::string_view NODE_INTERNAL_IP{"192.168.100.10"};
+constexpr std::string_view UNDERLAY_DEV{"bm-underlay"};
+constexpr std::string_view UNDERLAY_PEER{"bm-underlay-p"};
+constexpr std::string_view UNDERLAY_ADDR{"192.168.100.10/24"};
+constexpr std::string_view POD_CIDR{"10.244.0.0/20"}; // 容纳 4000 个以上的 Pod
+constexpr std::string_view POD_NIC{"eth0"};
+
+} // namespace
+
+/**
+ * @brief 创建内核模型，准备好节点的 underlay 网卡
+ *
+ * @return std::shared_ptr<net::NetlinkMemory> 内核模型
+ */
+static auto makeKernel() -> std::shared_ptr<net::NetlinkMemory> {
+  auto kernel = std::make_shared<net::NetlinkMemory>();
+  auto ok = kernel->vethCreate(UNDERLAY_DEV, UNDERLAY_PEER) &&
+            kernel->addressSetEntry(UNDERLAY_DEV, UNDERLAY_ADDR, true) &&
+            kernel->linkSetStatus(UNDERLAY_PEER, net::LinkStatus::UP) &&
+            kernel->linkSetStatus(UNDERLAY_DEV, net::LinkStatus::UP);
+  OHNO_ASSERT(ok);
+  return kernel;
+}
+
+/**
+ * @brief 与 ohno 二进制相同的装配方式，内核、ETCD 与 api server 全部换成进程内实现
+ *
+ * @param kernel 内核模型
+ * @param server 进程内 ETCD 服务端
+ * @param state_dir IPAM 状态与节点空闲标记所在目录，不与本机的 ohno 共用
+ * @return std::unique_ptr<cni::Cni> CNI 插件
+ */
+static auto makeCni(const std::shared_ptr<net::NetlinkMemory> &kernel,
+                    const std::shared_ptr<EtcdServerMemory> &server, std::string_view state_dir)
+    -> std::unique_ptr<cni::Cni> {
+  cni::CniConfig config{};
+  config.ipam_.subnet_ = POD_CIDR;
+  config.ipam_.mode_ = cni::CniConfigIpam::Mode::host_gw;
+  config.node_idle_timeout_ = -1;
+
+  auto cni = std::make_unique<cni::Cni>(kernel);
+  cni->parseConfig(config);
+
+  auto ipam = std::make_unique<ipam::Ipam>();
+  ipam->init(std::make_unique<MemoryEtcdClient>(server), false);
+  ipam->setStateDir(state_dir);
+  auto storage = std::make_unique<cni::Storage>();
+  storage->init(std::make_unique<MemoryEtcdClient>(server), false);
+  cni->setIpam(std::move(ipam));
+  cni->setStorage(std::move(storage));
+  cni->setCenter(
+      std::make_unique<backend::FakeCenter>(NODE_NAME, NODE_INTERNAL_IP, POD_CIDR));
+  cni->setNodeInfo(NODE_NAME, UNDERLAY_DEV, UNDERLAY_ADDR);
+  cni->setNodeIdlePath(fmt::format("{}/node_idle", state_dir));
+  return cni;
+}
+
+/**
+ * @brief 节点上已有若干 Pod 时，一个 Pod 的 CNI ADD + DEL；不需要 root，也不受内核速度影响，
+ * 只测量 ohno 自身的开销与 netlink 调用次数
+ *
+ * @param state range(0) 为已有的 Pod 数量
+ */
+static void BM_Model_CniAddDel(benchmark::State &state) {
+  auto kernel = makeKernel();
+  auto server = makeMemoryEtcdServer();
+  auto state_dir = fmt::format("/tmp/ohno-model-{}", ::getpid());
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    auto pod = fmt::format("bm-pod-{}", i);
+    kernel->netnsAdd(pod);
+    makeCni(kernel, server, state_dir)->add(pod, pod, POD_NIC);
+  }
+
+  std::string_view pod{"bm-pod"};
+  uint64_t calls{0};
+  uint64_t failures{0};
+  for (auto _ : state) {
+    state.PauseTiming();
+    kernel->netnsAdd(pod);
+    auto before = kernel->getCalls();
+    state.ResumeTiming();
+
+    try {
+      makeCni(kernel, server, state_dir)->add(pod, pod, POD_NIC);
+    } catch (...) {
+      ++failures;
+    }
+    makeCni(kernel, server, state_dir)->del(pod, POD_NIC);
+
+    state.PauseTiming();
+    calls += kernel->getCalls() - before;
+    kernel->netnsDel(pod);
+    state.ResumeTiming();
+  }
+
+  auto iterations = static_cast<double>(state.iterations());
+  state.counters["netlink_calls"] = static_cast<double>(calls) / iterations;
+  state.counters["failures"] = static_cast<double>(failures);
+  state.counters["routes"] = static_cast<double>(kernel->routeCount());
+
+  std::error_code code{};
+  std::filesystem::remove_all(state_dir, code);
+}
+BENCHMARK(BM_Model_CniAddDel)
+    ->Arg(0)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief 网卡上已有若干路由时，通过 Nic 添加并删除一条路由；对应 host-gw 后端在大集群中的开销
+ *
+ * @param state range(0) 为已有的路由数量
+ */
+static void BM_Model_NicRoute(benchmark::State &state) {
+  auto kernel = makeKernel();
+  net::Bridge bridge{};
+  bridge.setName("ohno0");
+  auto ok = bridge.setup(kernel) && bridge.setStatus(net::LinkStatus::UP) &&
+            bridge.addAddr(std::make_unique<net::Addr>("10.0.0.1/8"));
+  OHNO_ASSERT(ok);
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    auto dst = fmt::format("172.{}.{}.0/24", 16 + i / 256, i % 256);
+    auto via = fmt::format("10.{}.{}.1", i / 256, i % 256);
+    bridge.addRoute(std::make_unique<net::Route>(dst, via, "ohno0"),
+                    net::NetlinkIf::RouteNHFlags::NONE);
+  }
+
+  for (auto _ : state) {
+    bridge.addRoute(std::make_unique<net::Route>("192.168.0.0/24", "10.255.0.1", "ohno0"),
+                    net::NetlinkIf::RouteNHFlags::NONE);
+    bridge.delRoute("192.168.0.0/24", "10.255.0.1", "ohno0");
+  }
+  state.counters["routes"] = static_cast<double>(kernel->routeCount());
+}
+BENCHMARK(BM_Model_NicRoute)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+auto main(int argc, char **argv) -> int {
+  log::LogConfig log_conf{};
+  log_conf.setLevel(log::Level::warn);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
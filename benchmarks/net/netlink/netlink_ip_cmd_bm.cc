@@ -1,4 +1,5 @@
 // clang-format off
+#include <functional>
 #include <map>
 #include <string>
 #include <string_view>
@@ -21,6 +22,9 @@ public:
   MOCK_METHOD(bool, execute, (std::string_view command, std::string &output), (const, override));
   MOCK_METHOD(int, execute, (std::string_view command, std::string &output, std::string &error),
               (const, override));
+  MOCK_METHOD(int, stream,
+              (std::string_view command, (const std::function<bool(std::string_view)> &callback)),
+              (const, override));
 
   // 默认行为
   void setBehavior() {
@@ -3,15 +3,20 @@
 #include <exception>
 #include <fstream>
 #include <iostream>
+#include <optional>
+#include <string>
 #include <string_view>
 #include "ohno_version.h"
+#include "src/backend/bootstrap.h"
 #include "src/backend/center.h"
+#include "src/backend/lazy_center.h"
 #include "src/common/except.h"
 #include "src/cni/cni.h"
 #include "src/cni/cni_config.h"
 #include "src/cni/cni_env.h"
 #include "src/cni/cni_error.h"
 #include "src/cni/storage.h"
+#include "src/etcd/etcd_client_cache.h"
 #include "src/etcd/etcd_client_shell.h"
 #include "src/ipam/ipam.h"
 #include "src/log/logger.h"
@@ -100,41 +105,146 @@ auto determineType(std::string_view command) -> Type {
 }
 
 /**
- * @brief 获取 CNI 插件对象
+ * @brief CNI 插件的依赖：每一项在第一次用到时才创建，不同命令只初始化自己需要的部分
+ *
+ * 启动快照 → ETCD 地址、api server 地址 → IPAM、Storage、Center。ETCD 不再预先执行
+ * endpoint health，由第一次访问 ETCD 时发现故障；api server 在真正需要访问时才检查
+ */
+class Dependencies final {
+public:
+  explicit Dependencies(const ohno::cni::CniConfig &config)
+      : config_{config}, change_log_{std::make_shared<ohno::etcd::ChangeLog>()} {}
+
+  /**
+   * @brief 获取 ohnod 发布的启动快照，只有足够新时才使用
+   *
+   * @return const std::optional<ohno::backend::Bootstrap>& 启动快照
+   */
+  auto getBootstrap() -> const std::optional<ohno::backend::Bootstrap> & {
+    if (!bootstrap_loaded_) {
+      bootstrap_loaded_ = true;
+      bootstrap_ = ohno::backend::Bootstrap::load();
+      if (bootstrap_.has_value() && !bootstrap_->isFresh()) {
+        bootstrap_.reset();
+      }
+    }
+    return bootstrap_;
+  }
+
+  auto getEtcdServer() -> const std::string & {
+    if (etcd_server_.empty()) {
+      const auto &bootstrap = getBootstrap();
+      etcd_server_ = bootstrap.has_value() ? bootstrap->etcd_endpoints_
+                                           : ohno::backend::Center::getEtcdClusters();
+    }
+    return etcd_server_;
+  }
+
+  auto makeIpam() -> std::unique_ptr<ohno::ipam::Ipam> {
+    using namespace ohno;
+    auto ipam = std::make_unique<ipam::Ipam>();
+    if (!ipam->init(makeEtcdClient(), false)) {
+      throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO,
+                        "Failed to initialize IPAM, please check in ETCD cluster");
+    }
+    if (config_.ipam_.block_size_ > 0 &&
+        !ipam->enableBlockLease(config_.ipam_.block_size_, config_.ipam_.journal_size_)) {
+      throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO,
+                        "CNI configuration has invalid entry(ipam.blockSize)");
+    }
+    return ipam;
+  }
+
+  auto makeStorage() -> std::unique_ptr<ohno::cni::Storage> {
+    using namespace ohno;
+    auto storage = std::make_unique<cni::Storage>();
+    if (!storage->init(makeEtcdClient(), false)) {
+      throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO,
+                        "Failed to initialize storage, please check in ETCD cluster");
+    }
+    return storage;
+  }
+
+  /**
+   * @brief 创建延迟的 Center，只有节点还没有分配子网时才会真正创建并访问 api server
+   *
+   * @return std::unique_ptr<ohno::backend::CenterIf> Center 对象
+   */
+  auto makeCenter() -> std::unique_ptr<ohno::backend::CenterIf> {
+    using namespace ohno;
+    // ohnod 只在 api server 健康时刷新快照，快照足够新时不用再检查
+    const auto &bootstrap = getBootstrap();
+    auto api_server = bootstrap.has_value() ? bootstrap->api_server_ : std::string{};
+    return std::make_unique<backend::LazyCenter>(
+        [api_server, insecure = config_.ssl_]() -> std::unique_ptr<backend::CenterIf> {
+          auto env = std::make_unique<util::EnvStd>();
+          return std::make_unique<backend::Center>(
+              api_server.empty() ? backend::Center::getApiServer(backend::Center::Type::HOST,
+                                                                  env.get())
+                                 : api_server,
+              insecure, backend::Center::Type::HOST);
+        },
+        !bootstrap.has_value());
+  }
+
+  auto getChangeLog() const -> std::shared_ptr<ohno::etcd::ChangeLog> { return change_log_; }
+
+private:
+  // CNI 插件生命周期很短，只做进程内读缓存（同一次调用中重复读取的 key 只访问一次 ETCD），
+  // 写操作记录到共享的修改记录中；IPAM 与 Storage 共享一个端点选择器，端点延迟与对冲读预算
+  // 保存在节点本地的状态文件中，下一次调用接着使用
+  auto makeEtcdClient() -> std::unique_ptr<ohno::etcd::EtcdClientIf> {
+    using namespace ohno;
+    if (selector_ == nullptr) {
+      selector_ =
+          std::make_shared<etcd::EndpointSelector>(getEtcdServer(), etcd::PATH_ENDPOINT_STATE);
+    }
+    auto etcd_client = std::make_unique<etcd::EtcdClientCache>(
+        std::make_unique<etcd::EtcdClientShell>(etcd::EtcdData{getEtcdServer()},
+                                                std::make_unique<util::ShellSync>(),
+                                                std::make_unique<util::EnvStd>(), selector_),
+        ipam::ETCD_KEY_CACHE);
+    etcd_client->setChangeLog(change_log_);
+    return etcd_client;
+  }
+
+  const ohno::cni::CniConfig &config_;
+  bool bootstrap_loaded_{false};
+  std::optional<ohno::backend::Bootstrap> bootstrap_;
+  std::string etcd_server_;
+  std::shared_ptr<ohno::etcd::ChangeLog> change_log_;
+  std::shared_ptr<ohno::etcd::EndpointSelector> selector_;
+};
+
+/**
+ * @brief 获取 CNI 插件对象，只初始化该命令用到的依赖：VERSION 只需要配置，DEL 不访问
+ * api server
  *
  * @param config CNI 配置
+ * @param type 命令类型
  * @return std::unique_ptr<ohno::cni::Cni> CNI 插件对象
  */
-auto getCniPlugin(const ohno::cni::CniConfig &config) -> std::unique_ptr<ohno::cni::Cni> {
+auto getCniPlugin(const ohno::cni::CniConfig &config, Type type)
+    -> std::unique_ptr<ohno::cni::Cni> {
   using namespace ohno;
-  auto env = std::make_unique<util::EnvStd>();
-  auto api_server = backend::Center::getApiServer(backend::Center::Type::HOST, env.get());
-  auto center =
-      std::make_unique<backend::Center>(api_server, config.ssl_, backend::Center::Type::HOST);
-  if (!center->test()) {
-    throw OHNO_CNIERR(7, "Kubernetes api server is unhealthy");
-  }
-  auto etcd_server = backend::Center::getEtcdClusters();
-  auto ipam = std::make_unique<ipam::Ipam>();
-  if (!ipam->init(std::make_unique<etcd::EtcdClientShell>(
-          etcd::EtcdData{etcd_server}, std::make_unique<util::ShellSync>(), std::move(env)))) {
-    throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO,
-                      "Failed to initialize IPAM, please check in ETCD cluster");
-  }
-  auto storage = std::make_unique<cni::Storage>();
-  if (!storage->init(std::make_unique<etcd::EtcdClientShell>(etcd::EtcdData{etcd_server},
-                                                             std::make_unique<util::ShellSync>(),
-                                                             std::make_unique<util::EnvStd>()))) {
-    throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO,
-                      "Failed to initialize storage, please check in ETCD cluster");
-  }
-
   auto cni = std::make_unique<cni::Cni>(
       std::make_shared<net::NetlinkIpCmd>(std::make_unique<util::ShellSync>()));
   cni->parseConfig(config);
-  if (!cni->setIpam(std::move(ipam)) || !cni->setStorage(std::move(storage)) ||
-      !cni->setCenter(std::move(center))) {
-    throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO, "Failed to set IPAM, Storage or Center");
+  if (type != Type::ADD && type != Type::DEL) {
+    return cni;
+  }
+
+  Dependencies deps{config};
+  if (!cni->setIpam(deps.makeIpam()) || !cni->setStorage(deps.makeStorage())) {
+    throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO, "Failed to set IPAM or Storage");
+  }
+  cni->setChangeLog(deps.getChangeLog());
+  if (type == Type::ADD && !cni->setCenter(deps.makeCenter())) {
+    throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO, "Failed to set Center");
+  }
+  const auto &bootstrap = deps.getBootstrap();
+  if (bootstrap.has_value()) {
+    cni->setNodeInfo(bootstrap->node_name_, bootstrap->underlay_dev_, bootstrap->underlay_addr_);
   }
   return cni;
 }
@@ -167,7 +277,7 @@ auto main(int argc, char **argv) -> int {
     }
 
     // 创建 CNI 插件
-    auto cni = getCniPlugin(config);
+    auto cni = getCniPlugin(config, type);
     std::string output{};
     switch (type) {
     case Type::ADD:
@@ -2,6 +2,7 @@
 #include "backend.h"
 #include "src/common/assert.h"
 #include "src/common/except.h"
+#include "src/metrics/metrics.h"
 // clang-format on
 
 namespace ohno {
@@ -68,9 +69,15 @@ auto Backend::startImpl(std::string_view node_name, std::string_view thread_name
                           interv = interval, name = thread_name]() {
     try {
       pthread_setname_np(pthread_self(), name.data());
+      auto &duration = metrics::Registry::instance().histogram(
+          "ohno_reconcile_tick_duration_seconds", "Duration of one reconcile tick",
+          metrics::Buckets::latency, {{"backend", std::string{name}}});
 
       while (running.load()) {
-        callback();
+        {
+          metrics::ScopedTimer timer{duration};
+          callback();
+        }
         std::this_thread::sleep_for(std::chrono::seconds(interv));
       }
     } catch (const ohno::except::Exception &exc) {
@@ -81,6 +88,28 @@ auto Backend::startImpl(std::string_view node_name, std::string_view thread_name
   }};
 }
 
+/**
+ * @brief 记录一次对端节点的变化：新增节点下发了转发表项，或者删除了已不存在节点的残留表项
+ *
+ * @param backend 后端模式
+ * @param programmed true 为下发，false 为修复残留
+ */
+auto Backend::countPeer(std::string_view backend, bool programmed) -> void {
+  auto &registry = metrics::Registry::instance();
+  metrics::Labels labels{{"backend", std::string{backend}}};
+  if (programmed) {
+    registry
+        .counter("ohno_reconcile_peers_programmed_total",
+                 "Peers whose forwarding entries were programmed", labels)
+        .inc();
+  } else {
+    registry
+        .counter("ohno_reconcile_drift_repairs_total",
+                 "Stale peer entries removed after the peer left the cluster", labels)
+        .inc();
+  }
+}
+
 /**
  * @brief 触发事件（由派生类实现）
  *
@@ -23,6 +23,7 @@ public:
 protected:
   auto startImpl(std::string_view node_name, std::string_view thread_name) -> void;
   virtual auto eventHandler(std::string_view current_node) -> void;
+  static auto countPeer(std::string_view backend, bool programmed) -> void;
 
   std::atomic<bool> running_;
   std::thread monitor_;
@@ -0,0 +1,224 @@
+// clang-format off
+#include "bootstrap.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "spdlog/fmt/fmt.h"
+#include "center.h"
+#include "src/common/assert.h"
+#include "src/common/except.h"
+// clang-format on
+
+namespace ohno {
+namespace backend {
+
+void from_json(const nlohmann::json &json, Bootstrap &bootstrap) {
+  bootstrap.version_ = json.at(JKEY_BOOTSTRAP_VERSION).get<uint32_t>();
+  bootstrap.updated_ = json.at(JKEY_BOOTSTRAP_UPDATED).get<int64_t>();
+  bootstrap.node_name_ = json.at(JKEY_BOOTSTRAP_NODENAME).get<std::string>();
+  bootstrap.underlay_dev_ = json.at(JKEY_BOOTSTRAP_UNDERLAYDEV).get<std::string>();
+  bootstrap.underlay_addr_ = json.at(JKEY_BOOTSTRAP_UNDERLAYADDR).get<std::string>();
+  bootstrap.etcd_endpoints_ = json.at(JKEY_BOOTSTRAP_ETCD).get<std::string>();
+  bootstrap.api_server_ = json.at(JKEY_BOOTSTRAP_APISERVER).get<std::string>();
+}
+
+void to_json(nlohmann::json &json, const Bootstrap &bootstrap) {
+  json = nlohmann::json{{JKEY_BOOTSTRAP_VERSION, bootstrap.version_},
+                        {JKEY_BOOTSTRAP_UPDATED, bootstrap.updated_},
+                        {JKEY_BOOTSTRAP_NODENAME, bootstrap.node_name_},
+                        {JKEY_BOOTSTRAP_UNDERLAYDEV, bootstrap.underlay_dev_},
+                        {JKEY_BOOTSTRAP_UNDERLAYADDR, bootstrap.underlay_addr_},
+                        {JKEY_BOOTSTRAP_ETCD, bootstrap.etcd_endpoints_},
+                        {JKEY_BOOTSTRAP_APISERVER, bootstrap.api_server_}};
+}
+
+/**
+ * @brief 探测当前节点的启动信息（即 CNI 插件原本每次调用都要做的探测）
+ *
+ * @param shell Shell 对象
+ * @return std::optional<Bootstrap> 启动快照，任意一项探测失败时为空
+ */
+auto Bootstrap::collect(const util::ShellIf *shell) -> std::optional<Bootstrap> {
+  OHNO_ASSERT(shell != nullptr);
+
+  Bootstrap bootstrap{};
+  if (!Center::getNodeInfo(shell, bootstrap.node_name_, bootstrap.underlay_dev_,
+                           bootstrap.underlay_addr_)) {
+    return std::nullopt;
+  }
+  bootstrap.etcd_endpoints_ = Center::getEtcdClusters();
+  bootstrap.api_server_ = Center::getApiServer(Center::Type::HOST, nullptr);
+  if (bootstrap.etcd_endpoints_.empty() || bootstrap.api_server_.empty()) {
+    return std::nullopt;
+  }
+  bootstrap.updated_ = std::chrono::duration_cast<std::chrono::seconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+  return bootstrap;
+}
+
+/**
+ * @brief 读取启动快照（mmap 之后直接解析，不经过 iostream）
+ *
+ * @param path 快照文件路径
+ * @return std::optional<Bootstrap> 启动快照，文件不存在、损坏或者版本不一致时为空
+ */
+auto Bootstrap::load(std::string_view path) -> std::optional<Bootstrap> {
+  auto fd = ::open(std::string{path}.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return std::nullopt;
+  }
+  struct stat info {};
+  if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+    ::close(fd);
+    return std::nullopt;
+  }
+  auto size = static_cast<size_t>(info.st_size);
+  auto *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return std::nullopt;
+  }
+
+  std::optional<Bootstrap> bootstrap{};
+  try {
+    const auto *begin = static_cast<const char *>(data);
+    bootstrap = nlohmann::json::parse(begin, begin + size).get<Bootstrap>();
+    if (bootstrap->version_ != BOOTSTRAP_VERSION) {
+      OHNO_GLOBAL_LOG(warn, "Ignore bootstrap snapshot {} of version {}", path,
+                      bootstrap->version_);
+      bootstrap.reset();
+    }
+  } catch (const std::exception &exc) {
+    OHNO_GLOBAL_LOG(warn, "Failed to parse bootstrap snapshot {}: {}", path, exc.what());
+    bootstrap.reset();
+  }
+  ::munmap(data, size);
+  return bootstrap;
+}
+
+/**
+ * @brief 保存启动快照，先写临时文件再 rename，读者不会读到半个文件
+ *
+ * @param path 快照文件路径
+ * @return true 保存成功
+ * @return false 保存失败
+ */
+auto Bootstrap::save(std::string_view path) const -> bool {
+  std::error_code code{};
+  std::filesystem::create_directories(std::filesystem::path{path}.parent_path(), code);
+
+  auto tmp_path = fmt::format("{}.tmp", path);
+  {
+    std::ofstream file{tmp_path, std::ios::trunc};
+    if (!file.is_open()) {
+      OHNO_GLOBAL_LOG(warn, "Failed to open bootstrap snapshot {}", tmp_path);
+      return false;
+    }
+    file << nlohmann::json(*this).dump();
+    if (!file.flush()) {
+      OHNO_GLOBAL_LOG(warn, "Failed to write bootstrap snapshot {}", tmp_path);
+      return false;
+    }
+  }
+
+  if (std::rename(tmp_path.c_str(), std::string{path}.c_str()) != 0) {
+    OHNO_GLOBAL_LOG(warn, "Failed to replace bootstrap snapshot {}", path);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief 快照是否足够新
+ *
+ * @param ttl 有效期
+ * @return true 在有效期内，可以直接使用
+ * @return false 已经过期（ohnod 没有运行或者 api server 不健康）
+ */
+auto Bootstrap::isFresh(std::chrono::seconds ttl) const -> bool {
+  auto now = std::chrono::duration_cast<std::chrono::seconds>(
+      std::chrono::system_clock::now().time_since_epoch());
+  auto age = now - std::chrono::seconds{updated_};
+  return age >= std::chrono::seconds{0} && age <= ttl;
+}
+
+BootstrapPublisher::BootstrapPublisher(std::unique_ptr<CenterIf> center,
+                                       std::unique_ptr<util::ShellIf> shell, std::string_view path)
+    : center_{std::move(center)}, shell_{std::move(shell)}, path_{path} {
+  OHNO_ASSERT(center_);
+  OHNO_ASSERT(shell_);
+  OHNO_ASSERT(!path_.empty());
+}
+
+BootstrapPublisher::~BootstrapPublisher() { stop(); }
+
+/**
+ * @brief 启动发布线程，每 BOOTSTRAP_REFRESH 发布一次
+ *
+ */
+auto BootstrapPublisher::start() -> void {
+  if (running_) {
+    return;
+  }
+  running_ = true;
+
+  publisher_ = std::thread{[this]() {
+    try {
+      pthread_setname_np(pthread_self(), "bootstrap");
+      std::unique_lock<std::mutex> lock{mutex_};
+      while (running_) {
+        lock.unlock();
+        publish();
+        lock.lock();
+        cond_.wait_for(lock, BOOTSTRAP_REFRESH, [this]() { return !running_; });
+      }
+    } catch (const ohno::except::Exception &exc) {
+      std::cerr << "[error] Ohnod bootstrap thread terminated!" << exc.getMsg() << "\n";
+    } catch (const std::exception &exc) {
+      std::cerr << "[error] Ohnod bootstrap thread terminated!" << exc.what() << "\n";
+    }
+  }};
+}
+
+/**
+ * @brief 停止发布线程（快照保留，过期之后 CNI 插件自动回退到自己探测）
+ *
+ */
+auto BootstrapPublisher::stop() -> void {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    running_ = false;
+  }
+  cond_.notify_all();
+  if (publisher_.joinable()) {
+    publisher_.join();
+  }
+}
+
+/**
+ * @brief 探测并发布一次快照，api server 不健康时不刷新，让快照自然过期
+ *
+ * @return true 发布成功
+ * @return false 探测或者写入失败
+ */
+auto BootstrapPublisher::publish() -> bool {
+  if (!center_->test()) {
+    OHNO_LOG(warn, "Api server is unhealthy, bootstrap snapshot is not refreshed");
+    return false;
+  }
+  auto bootstrap = Bootstrap::collect(shell_.get());
+  if (!bootstrap.has_value()) {
+    OHNO_LOG(warn, "Failed to collect bootstrap snapshot");
+    return false;
+  }
+  return bootstrap->save(path_);
+}
+
+} // namespace backend
+} // namespace ohno
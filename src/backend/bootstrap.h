@@ -0,0 +1,91 @@
+#pragma once
+
+// clang-format off
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "nlohmann/json.hpp"
+#include "center_if.h"
+#include "src/log/logger.h"
+#include "src/util/shell_if.h"
+// clang-format on
+
+namespace ohno {
+namespace backend {
+
+constexpr std::string_view PATH_BOOTSTRAP{"/var/run/ohno/bootstrap.json"};
+constexpr uint32_t BOOTSTRAP_VERSION{1};
+constexpr std::chrono::seconds BOOTSTRAP_TTL{60};     // 超过该时长没有刷新则不再信任
+constexpr std::chrono::seconds BOOTSTRAP_REFRESH{20}; // ohnod 刷新间隔
+
+constexpr std::string_view JKEY_BOOTSTRAP_VERSION{"version"};
+constexpr std::string_view JKEY_BOOTSTRAP_UPDATED{"updated"};
+constexpr std::string_view JKEY_BOOTSTRAP_NODENAME{"nodeName"};
+constexpr std::string_view JKEY_BOOTSTRAP_UNDERLAYDEV{"underlayDev"};
+constexpr std::string_view JKEY_BOOTSTRAP_UNDERLAYADDR{"underlayAddr"};
+constexpr std::string_view JKEY_BOOTSTRAP_ETCD{"etcdEndpoints"};
+constexpr std::string_view JKEY_BOOTSTRAP_APISERVER{"apiServer"};
+
+/**
+ * @brief 启动快照：CNI 插件每次调用都要探测的节点信息（节点名称、underlay 网卡与地址）、
+ * ETCD 地址和 api server 地址，由 ohnod 定期探测并发布到节点本地文件
+ *
+ * CNI 插件读到版本一致且足够新的快照时直接使用，不再执行 hostname / ip 命令、解析 kubelet
+ * 配置和检查 api server 健康（ohnod 只在 api server 健康时刷新快照）
+ */
+class Bootstrap final {
+public:
+  friend void from_json(const nlohmann::json &json, Bootstrap &bootstrap);
+  friend void to_json(nlohmann::json &json, const Bootstrap &bootstrap);
+
+  static auto collect(const util::ShellIf *shell) -> std::optional<Bootstrap>;
+  static auto load(std::string_view path = PATH_BOOTSTRAP) -> std::optional<Bootstrap>;
+  auto save(std::string_view path = PATH_BOOTSTRAP) const -> bool;
+  auto isFresh(std::chrono::seconds ttl = BOOTSTRAP_TTL) const -> bool;
+
+  uint32_t version_{BOOTSTRAP_VERSION};
+  int64_t updated_{0}; // 发布时间，unix 时间戳（秒）
+  std::string node_name_;
+  std::string underlay_dev_;
+  std::string underlay_addr_;
+  std::string etcd_endpoints_;
+  std::string api_server_; // 宿主机视角的 api server 地址（CNI 插件运行在宿主机上）
+};
+
+/**
+ * @brief 启动快照发布线程（ohnod）
+ *
+ */
+class BootstrapPublisher final : public log::Loggable<log::Id::backend> {
+public:
+  BootstrapPublisher(std::unique_ptr<CenterIf> center, std::unique_ptr<util::ShellIf> shell,
+                     std::string_view path = PATH_BOOTSTRAP);
+  ~BootstrapPublisher() override;
+  BootstrapPublisher(const BootstrapPublisher &) = delete;
+  BootstrapPublisher(BootstrapPublisher &&) = delete;
+  auto operator=(const BootstrapPublisher &) -> BootstrapPublisher & = delete;
+  auto operator=(BootstrapPublisher &&) -> BootstrapPublisher & = delete;
+
+  auto start() -> void;
+  auto stop() -> void;
+  auto publish() -> bool;
+
+private:
+  std::unique_ptr<CenterIf> center_; // 用来确认 api server 健康
+  std::unique_ptr<util::ShellIf> shell_;
+  std::string path_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::atomic<bool> running_{false};
+  std::thread publisher_;
+};
+
+} // namespace backend
+} // namespace ohno
@@ -9,6 +9,7 @@
 #include "src/common/except.h"
 #include "src/kube/kube_apiv1_nodes.h"
 #include "src/net/http_client/http_client.h"
+#include "src/util/env_std.h"
 // clang-format on
 
 namespace ohno {
@@ -97,12 +98,17 @@ auto Center::getKubernetesData() const -> std::unordered_map<std::string, NodeIn
 }
 
 /**
- * @brief 从 kubelet 配置中获取 ETCD 集群地址
+ * @brief 获取 ETCD 集群地址：优先使用环境变量 ETCDCTL_ENDPOINTS（可以列出所有成员），
+ * 否则从 kubelet 配置中推导
  *
- * @return std::string 返回地址字符串，如果没有配置则返回空
+ * @return std::string 返回地址字符串（逗号分割），如果没有配置则返回空
  */
 auto Center::getEtcdClusters() -> std::string {
-  std::string etcd_cluster{};
+  util::EnvStd env{};
+  std::string etcd_cluster = env.get("ETCDCTL_ENDPOINTS");
+  if (!etcd_cluster.empty()) {
+    return etcd_cluster;
+  }
 
   try {
     std::string uri = Center::getServerUrl(HOST_FILE);
@@ -318,6 +324,7 @@ auto Center::getNodes(const net::HttpClientIf *http_client, bool is_all, NodeInf
       NodeInfo info{};
       info.name_ = item.metadata_.name_;
       info.pod_cidr_ = item.spec_.pod_cidr_;
+      info.pod_cidrs_ = item.spec_.pod_cidrs_;
 
       if (!is_all && single.name_ != info.name_) {
         continue;
@@ -4,6 +4,7 @@
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 // clang-format on
 
 namespace ohno {
@@ -13,6 +14,7 @@ struct NodeInfo {
   std::string name_;
   std::string internal_ip_;
   std::string pod_cidr_;
+  std::vector<std::string> pod_cidrs_; // 双栈节点同时包含 IPv4 与 IPv6 子网
 };
 
 constexpr std::string_view PATH_CA_POD{"/var/run/secrets/kubernetes.io/serviceaccount"};
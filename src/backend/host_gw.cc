@@ -63,6 +63,7 @@ auto HostGw::eventHandler(std::string_view current_node) -> void {
                    info.pod_cidr_, info.internal_ip_);
         } else {
           node_cache_.emplace(name, info);
+          countPeer(enumName(cni::CniConfigIpam::Mode::host_gw), true);
           OHNO_LOG(info, "Host-gw static route(dest:{}, via:{}) existed", info.pod_cidr_,
                    info.internal_ip_);
         }
@@ -83,9 +84,10 @@ auto HostGw::eventHandler(std::string_view current_node) -> void {
         OHNO_LOG(warn, "Host-gw mode failed to delete static route(dest:{}, via:{})",
                  info.pod_cidr_, info.internal_ip_);
       } else {
-        it = node_cache_.erase(it);
         OHNO_LOG(info, "Host-gw static route(dest:{}, via:{}) has been erased", info.pod_cidr_,
                  info.internal_ip_);
+        it = node_cache_.erase(it);
+        countPeer(enumName(cni::CniConfigIpam::Mode::host_gw), false);
         continue; // 下一轮迭代直接使用当前迭代器
       }
     }
@@ -0,0 +1,65 @@
+// clang-format off
+#include "lazy_center.h"
+#include "src/common/assert.h"
+#include "src/common/except.h"
+// clang-format on
+
+namespace ohno {
+namespace backend {
+
+/**
+ * @brief 构造时只保存工厂函数，不读取证书、不访问 api server
+ *
+ * @param factory Center 工厂函数
+ * @param check_health 创建之后是否检查 api server 健康
+ */
+LazyCenter::LazyCenter(CenterFactory factory, bool check_health)
+    : factory_{std::move(factory)}, check_health_{check_health} {
+  OHNO_ASSERT(factory_);
+}
+
+/**
+ * @brief 测试 api server 是否健康（会触发创建）
+ *
+ * @return true 健康
+ * @return false 不健康或者创建失败
+ */
+auto LazyCenter::test() const -> bool {
+  try {
+    return getCenter().test();
+  } catch (const except::Exception &exc) {
+    OHNO_LOG(warn, "Failed to create center: {}", exc.getMsg());
+    return false;
+  }
+}
+
+auto LazyCenter::getKubernetesData(std::string_view node_name) const -> NodeInfo {
+  return getCenter().getKubernetesData(node_name);
+}
+
+auto LazyCenter::getKubernetesData() const -> std::unordered_map<std::string, NodeInfo> {
+  return getCenter().getKubernetesData();
+}
+
+/**
+ * @brief 获取 Center，第一次调用时创建并检查 api server 健康
+ *
+ * @return const CenterIf& Center 对象
+ */
+auto LazyCenter::getCenter() const -> const CenterIf & {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (center_ == nullptr) {
+    auto center = factory_();
+    if (center == nullptr) {
+      throw OHNO_EXCEPT("Failed to create center", false);
+    }
+    if (check_health_ && !center->test()) {
+      throw OHNO_EXCEPT("Kubernetes api server is unhealthy", false);
+    }
+    center_ = std::move(center);
+  }
+  return *center_;
+}
+
+} // namespace backend
+} // namespace ohno
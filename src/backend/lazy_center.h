@@ -0,0 +1,45 @@
+#pragma once
+
+// clang-format off
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "center_if.h"
+#include "src/log/logger.h"
+// clang-format on
+
+namespace ohno {
+namespace backend {
+
+/**
+ * @brief 延迟创建的 Center：第一次访问时才通过工厂函数创建并检查 api server 健康
+ *
+ * CNI 插件只有在节点还没有分配子网时才需要访问 api server，大部分 ADD 和全部 DEL、VERSION
+ * 都不会触发创建
+ */
+class LazyCenter final : public CenterIf, public log::Loggable<log::Id::backend> {
+public:
+  using CenterFactory = std::function<std::unique_ptr<CenterIf>()>;
+
+  explicit LazyCenter(CenterFactory factory, bool check_health = true);
+  ~LazyCenter() override = default;
+  LazyCenter(const LazyCenter &) = delete;
+  LazyCenter(LazyCenter &&) = delete;
+  auto operator=(const LazyCenter &) -> LazyCenter & = delete;
+  auto operator=(LazyCenter &&) -> LazyCenter & = delete;
+
+  auto test() const -> bool override;
+  auto getKubernetesData(std::string_view node_name) const -> NodeInfo override;
+  auto getKubernetesData() const -> std::unordered_map<std::string, NodeInfo> override;
+
+private:
+  auto getCenter() const -> const CenterIf &;
+
+  CenterFactory factory_;
+  bool check_health_;
+  mutable std::mutex mutex_;
+  mutable std::unique_ptr<CenterIf> center_;
+};
+
+} // namespace backend
+} // namespace ohno
@@ -0,0 +1,83 @@
+// clang-format off
+#include "node_reclaimer.h"
+#include <iostream>
+#include "src/cni/node_idle.h"
+#include "src/common/assert.h"
+#include "src/common/except.h"
+// clang-format on
+
+namespace ohno {
+namespace backend {
+
+NodeReclaimer::NodeReclaimer(std::chrono::seconds timeout, CniFactory factory)
+    : timeout_{timeout}, factory_{std::move(factory)} {
+  OHNO_ASSERT(timeout_.count() > 0);
+  OHNO_ASSERT(factory_);
+}
+
+NodeReclaimer::~NodeReclaimer() { stop(); }
+
+/**
+ * @brief 启动检查线程
+ *
+ */
+auto NodeReclaimer::start() -> void {
+  if (running_) {
+    return;
+  }
+  running_ = true;
+
+  reclaimer_ = std::thread{[this]() {
+    try {
+      pthread_setname_np(pthread_self(), "reclaim");
+      std::unique_lock<std::mutex> lock{mutex_};
+      while (running_) {
+        lock.unlock();
+        check();
+        lock.lock();
+        cond_.wait_for(lock, NODE_RECLAIM_INTERVAL, [this]() { return !running_; });
+      }
+    } catch (const ohno::except::Exception &exc) {
+      std::cerr << "[error] Ohnod reclaim thread terminated!" << exc.getMsg() << "\n";
+    } catch (const std::exception &exc) {
+      std::cerr << "[error] Ohnod reclaim thread terminated!" << exc.what() << "\n";
+    }
+  }};
+}
+
+/**
+ * @brief 停止检查线程
+ *
+ */
+auto NodeReclaimer::stop() -> void {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    running_ = false;
+  }
+  cond_.notify_all();
+  if (reclaimer_.joinable()) {
+    reclaimer_.join();
+  }
+}
+
+/**
+ * @brief 检查一次，节点空闲超过宽限期时回收节点网络设施
+ *
+ * @return true 已回收
+ * @return false 不需要回收或者回收失败
+ */
+auto NodeReclaimer::check() -> bool {
+  if (!cni::NodeIdle::isExpired(timeout_)) {
+    return false;
+  }
+
+  auto cni = factory_();
+  if (!cni) {
+    OHNO_LOG(warn, "Failed to create CNI object for node reclaim");
+    return false;
+  }
+  return cni->reclaim();
+}
+
+} // namespace backend
+} // namespace ohno
@@ -0,0 +1,52 @@
+#pragma once
+
+// clang-format off
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "src/cni/cni.h"
+#include "src/log/logger.h"
+// clang-format on
+
+namespace ohno {
+namespace backend {
+
+constexpr std::chrono::seconds NODE_RECLAIM_INTERVAL{10};
+
+/**
+ * @brief 节点回收器：CNI DEL 删除最后一个 Pod 之后只标记节点空闲，由 ohnod 定期检查，
+ * 空闲超过宽限期时才删除 bridge、VTEP 并归还子网
+ *
+ * 每次检查只读取一个本地文件，超过宽限期时才通过工厂函数创建 CNI 对象（需要访问 ETCD）
+ */
+class NodeReclaimer final : public log::Loggable<log::Id::backend> {
+public:
+  using CniFactory = std::function<std::unique_ptr<cni::Cni>()>;
+
+  NodeReclaimer(std::chrono::seconds timeout, CniFactory factory);
+  ~NodeReclaimer() override;
+  NodeReclaimer(const NodeReclaimer &) = delete;
+  NodeReclaimer(NodeReclaimer &&) = delete;
+  auto operator=(const NodeReclaimer &) -> NodeReclaimer & = delete;
+  auto operator=(NodeReclaimer &&) -> NodeReclaimer & = delete;
+
+  auto start() -> void;
+  auto stop() -> void;
+  auto check() -> bool;
+
+private:
+  std::chrono::seconds timeout_;
+  CniFactory factory_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::atomic<bool> running_{false};
+  std::thread reclaimer_;
+};
+
+} // namespace backend
+} // namespace ohno
@@ -11,8 +11,13 @@
 #include "src/cni/cni_config.h"
 #include "src/cni/storage.h"
 #include "src/common/except.h"
+#include "src/etcd/etcd_client_cache.h"
 #include "src/etcd/etcd_client_shell.h"
 #include "src/ipam/ipam.h"
+#include "src/ipam/macro.h"
+#include "src/net/addr.h"
+#include "src/net/ip.h"
+#include "src/net/macro.h"
 #include "src/net/nic.h"
 #include "src/util/shell_sync.h"
 #include "src/util/env_std.h"
@@ -54,6 +59,14 @@ auto StrategyClient::executeStrategy(std::string_view node_name) -> void {
   nlohmann::json json{};
   ifile >> json;
   cni::CniConfig cni_conf = json;
+  // ohnod 的所有 ETCD 客户端共享端点延迟与对冲读预算
+  selector_ = std::make_shared<etcd::EndpointSelector>(Center::getEtcdClusters());
+  migrateIpam(node_name);
+  startNodeLease(node_name, cni_conf);
+  startVethPool(cni_conf.bridge_);
+  startNodeReclaimer(cni_conf);
+  startBootstrap();
+  startTraceCollector(cni_conf);
 
   scheduler_.reset(new Scheduler{});
   OHNO_ASSERT(scheduler_ != nullptr);
@@ -70,6 +83,21 @@ auto StrategyClient::stopStrategy() -> void {
   if (scheduler_ != nullptr) {
     scheduler_->stop();
   }
+  if (lease_ != nullptr) {
+    lease_->stop();
+  }
+  if (veth_pool_ != nullptr) {
+    veth_pool_->stop();
+  }
+  if (reclaimer_ != nullptr) {
+    reclaimer_->stop();
+  }
+  if (bootstrap_ != nullptr) {
+    bootstrap_->stop();
+  }
+  if (trace_collector_ != nullptr) {
+    trace_collector_->stop();
+  }
 }
 
 /**
@@ -118,6 +146,190 @@ auto StrategyClient::getStrategy(cni::CniConfigIpam::Mode mode, std::string_view
   return strategy;
 }
 
+/**
+ * @brief 将本节点的 IPAM 数据迁移到新的 ETCD 布局，失败不影响后端策略，下次启动时重试
+ *
+ * @param node_name 节点名称
+ */
+auto StrategyClient::migrateIpam(std::string_view node_name) const -> void {
+  auto ipam = std::make_unique<ipam::Ipam>();
+  if (!ipam->init(getEtcdClient()) ||
+      !ipam->migrate(node_name)) {
+    OHNO_LOG(warn, "Failed to migrate IPAM data of {} to per-entry keys", node_name);
+  }
+}
+
+/**
+ * @brief 启动节点租约，子网与 VTEP 绑定到该租约上，节点宕机后由 ETCD 自动删除
+ *
+ * @param node_name 节点名称
+ * @param cni_conf CNI 配置
+ */
+auto StrategyClient::startNodeLease(std::string_view node_name, const cni::CniConfig &cni_conf)
+    -> void {
+  std::vector<std::string> keys{fmt::format("{}/{}", ipam::ETCD_KEY_SUBNET, node_name),
+                                cni::Storage::getVtepKey(node_name)};
+  lease_ = std::make_unique<etcd::NodeLease>(getEtcdClient(), node_name, std::move(keys));
+  lease_->setRestorer([this, node = std::string{node_name}, cni_conf]() {
+    return restoreNodeKeys(node, cni_conf);
+  });
+  lease_->start();
+}
+
+/**
+ * @brief 从持久化状态重建绑定租约的 key，ohnod 停止超过租约 TTL 之后重启时使用
+ *
+ * @note 子网来自 bridge 的网关地址（双栈节点每个地址族一个，与分配子网时的顺序相同），
+ * VTEP 来自 vxlan 的地址与本机 vxlan 网卡的 MAC。这些记录没有绑定租约；
+ * 节点 bridge 已经不存在（节点已被回收）时不重建
+ *
+ * @param node_name 节点名称
+ * @param cni_conf CNI 配置
+ * @return std::unordered_map<std::string, std::string> key 与值
+ */
+auto StrategyClient::restoreNodeKeys(std::string_view node_name,
+                                     const cni::CniConfig &cni_conf) const
+    -> std::unordered_map<std::string, std::string> {
+  OHNO_ASSERT(netlink_ != nullptr);
+  std::unordered_map<std::string, std::string> values{};
+  if (!netlink_->linkExist(cni_conf.bridge_)) {
+    return values;
+  }
+  cni::Storage storage{};
+  if (!storage.init(getEtcdClient())) {
+    OHNO_LOG(warn, "Failed to read durable state of {} to restore its subnet", node_name);
+    return values;
+  }
+
+  std::string subnets{};
+  for (const auto &gateway : storage.getAllAddrs(node_name, ipam::HOST, cni_conf.bridge_)) {
+    auto prefix = net::IpPrefix::parse(gateway);
+    if (prefix) {
+      auto subnet = prefix->network().toString();
+      subnets += subnets.empty() ? subnet : fmt::format(",{}", subnet);
+    }
+  }
+  if (subnets.empty()) {
+    return values;
+  }
+  values.emplace(fmt::format("{}/{}", ipam::ETCD_KEY_SUBNET, node_name), subnets);
+
+  if (cni_conf.ipam_.mode_ == cni::CniConfigIpam::Mode::vxlan &&
+      netlink_->linkExist(net::NAME_VXLAN)) {
+    auto addrs = storage.getAllAddrs(node_name, ipam::HOST, net::NAME_VXLAN);
+    auto mac = netlink_->linkGetMac(net::NAME_VXLAN);
+    if (!addrs.empty() && !mac.empty()) {
+      values.emplace(cni::Storage::getVtepKey(node_name),
+                     cni::Storage::getVtepValue(net::Addr{addrs.front()}.getAddr(), mac));
+    }
+  }
+  return values;
+}
+
+/**
+ * @brief 启动 veth pair 池，CNI ADD 领取预先创建好的 veth pair，不再现场创建并插入 bridge
+ *
+ * @param bridge 节点 Linux bridge 名称
+ */
+auto StrategyClient::startVethPool(std::string_view bridge) -> void {
+  OHNO_ASSERT(netlink_ != nullptr);
+  veth_pool_ = std::make_unique<net::VethPool>(netlink_, bridge);
+  veth_pool_->start();
+}
+
+/**
+ * @brief 启动节点回收器，节点空闲超过 CNI 配置的宽限期之后回收节点网络设施
+ *
+ * @param cni_conf CNI 配置
+ */
+auto StrategyClient::startNodeReclaimer(const cni::CniConfig &cni_conf) -> void {
+  if (cni_conf.node_idle_timeout_ <= 0) {
+    return; // CNI DEL 立即删除，或者一直保留
+  }
+  OHNO_ASSERT(netlink_ != nullptr);
+
+  auto factory = [netlink = netlink_, selector = selector_,
+                  cni_conf]() -> std::unique_ptr<cni::Cni> {
+    auto getEtcdClient = [&selector]() {
+      return std::make_unique<etcd::EtcdClientShell>(etcd::EtcdData{Center::getEtcdClusters()},
+                                                     std::make_unique<util::ShellSync>(),
+                                                     std::make_unique<util::EnvStd>(), selector);
+    };
+    auto ipam = std::make_unique<ipam::Ipam>();
+    if (!ipam->init(getEtcdClient()) ||
+        (cni_conf.ipam_.block_size_ > 0 &&
+         !ipam->enableBlockLease(cni_conf.ipam_.block_size_, cni_conf.ipam_.journal_size_))) {
+      return nullptr;
+    }
+    auto storage = std::make_unique<cni::Storage>();
+    if (!storage->init(getEtcdClient())) {
+      return nullptr;
+    }
+
+    // 回收只删除已有的节点，不分配子网，不需要 Center
+    auto cni = std::make_unique<cni::Cni>(netlink);
+    cni->parseConfig(cni_conf);
+    if (!cni->setIpam(std::move(ipam)) || !cni->setStorage(std::move(storage))) {
+      return nullptr;
+    }
+    return cni;
+  };
+  reclaimer_ = std::make_unique<NodeReclaimer>(std::chrono::seconds{cni_conf.node_idle_timeout_},
+                                               std::move(factory));
+  reclaimer_->start();
+}
+
+/**
+ * @brief 启动启动快照发布线程，CNI 插件读取快照之后不再重复探测节点信息与集群地址
+ *
+ */
+auto StrategyClient::startBootstrap() -> void {
+  OHNO_ASSERT(!bkinfo_.api_server_.empty());
+  bootstrap_ = std::make_unique<BootstrapPublisher>(
+      std::make_unique<Center>(bkinfo_.api_server_, bkinfo_.ssl_, Center::Type::POD),
+      std::make_unique<util::ShellSync>());
+  bootstrap_->start();
+}
+
+/**
+ * @brief 启动 CNI 调用耗时收集线程，CNI 配置开启追踪时才启动
+ *
+ * @param cni_conf CNI 配置
+ */
+auto StrategyClient::startTraceCollector(const cni::CniConfig &cni_conf) -> void {
+  if (!cni_conf.trace_) {
+    return;
+  }
+  trace_collector_ = std::make_unique<TraceCollector>();
+  trace_collector_->start();
+}
+
+/**
+ * @brief 获取 ETCD 客户端，与其他客户端共享端点选择器
+ *
+ * @return std::unique_ptr<etcd::EtcdClientShell> ETCD 客户端
+ */
+auto StrategyClient::getEtcdClient() const -> std::unique_ptr<etcd::EtcdClientShell> {
+  OHNO_ASSERT(selector_ != nullptr);
+  return std::make_unique<etcd::EtcdClientShell>(etcd::EtcdData{Center::getEtcdClusters()},
+                                                 std::make_unique<util::ShellSync>(),
+                                                 std::make_unique<util::EnvStd>(), selector_);
+}
+
+/**
+ * @brief 获取由 watch 保持一致的缓存 ETCD 客户端，后端每个周期的读操作不再访问 ETCD
+ *
+ * @return std::unique_ptr<etcd::EtcdClientIf> ETCD 客户端，watch 启动失败时返回不带缓存的客户端
+ */
+auto StrategyClient::getCachedEtcdClient() const -> std::unique_ptr<etcd::EtcdClientIf> {
+  auto cache = std::make_unique<etcd::EtcdClientCache>(getEtcdClient(), ipam::ETCD_KEY_CACHE);
+  if (cache->start()) {
+    return cache;
+  }
+  OHNO_LOG(warn, "Failed to start ETCD cache, falling back to uncached client");
+  return getEtcdClient();
+}
+
 /**
  * @brief 获取 host-gw 对象
  *
@@ -125,9 +337,7 @@ auto StrategyClient::getStrategy(cni::CniConfigIpam::Mode mode, std::string_view
  */
 auto StrategyClient::getHostgw() const -> std::unique_ptr<BackendIf> {
   auto ipam = std::make_unique<ipam::Ipam>();
-  if (!ipam->init(std::make_unique<etcd::EtcdClientShell>(etcd::EtcdData{Center::getEtcdClusters()},
-                                                          std::make_unique<util::ShellSync>(),
-                                                          std::make_unique<util::EnvStd>()))) {
+  if (!ipam->init(getCachedEtcdClient())) {
     throw OHNO_EXCEPT("Failed to initialize IPAM, please check in ETCD cluster", false);
   }
 
@@ -143,9 +353,7 @@ auto StrategyClient::getHostgw() const -> std::unique_ptr<BackendIf> {
  */
 auto StrategyClient::getVxlan() const -> std::unique_ptr<BackendIf> {
   auto storage = std::make_unique<cni::Storage>();
-  if (!storage->init(std::make_unique<etcd::EtcdClientShell>(
-          etcd::EtcdData{Center::getEtcdClusters()}, std::make_unique<util::ShellSync>(),
-          std::make_unique<util::EnvStd>()))) {
+  if (!storage->init(getCachedEtcdClient())) {
     throw OHNO_EXCEPT("Failed to initialize storage, please check in ETCD cluster", false);
   }
   auto vxlan = std::make_unique<Vxlan>();
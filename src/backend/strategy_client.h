@@ -1,12 +1,20 @@
 #pragma once
 
 // clang-format off
+#include <string>
 #include <string_view>
+#include <unordered_map>
+#include "bootstrap.h"
+#include "node_reclaimer.h"
+#include "trace_collector.h"
 #include "scheduler_if.h"
 #include "src/backend/backend_info.h"
 #include "src/cni/cni_config.h"
+#include "src/etcd/etcd_client_shell.h"
+#include "src/etcd/node_lease.h"
 #include "src/log/logger.h"
 #include "src/net/netlink/netlink_if.h"
+#include "src/net/veth_pool.h"
 // clang-format on
 
 namespace ohno {
@@ -29,8 +37,24 @@ private:
   auto getHostgw() const -> std::unique_ptr<BackendIf>;
   auto getVxlan() const -> std::unique_ptr<BackendIf>;
   auto getEvpn(std::string_view l2svi) const -> std::unique_ptr<BackendIf>;
+  auto migrateIpam(std::string_view node_name) const -> void;
+  auto startNodeLease(std::string_view node_name, const cni::CniConfig &cni_conf) -> void;
+  auto restoreNodeKeys(std::string_view node_name, const cni::CniConfig &cni_conf) const
+      -> std::unordered_map<std::string, std::string>;
+  auto startVethPool(std::string_view bridge) -> void;
+  auto startNodeReclaimer(const cni::CniConfig &cni_conf) -> void;
+  auto startBootstrap() -> void;
+  auto startTraceCollector(const cni::CniConfig &cni_conf) -> void;
+  auto getEtcdClient() const -> std::unique_ptr<etcd::EtcdClientShell>;
+  auto getCachedEtcdClient() const -> std::unique_ptr<etcd::EtcdClientIf>;
 
   std::unique_ptr<SchedulerIf> scheduler_;
+  std::unique_ptr<etcd::NodeLease> lease_;
+  std::unique_ptr<net::VethPool> veth_pool_;
+  std::unique_ptr<NodeReclaimer> reclaimer_;
+  std::unique_ptr<BootstrapPublisher> bootstrap_;
+  std::unique_ptr<TraceCollector> trace_collector_;
+  std::shared_ptr<etcd::EndpointSelector> selector_;
   std::shared_ptr<net::NetlinkIf> netlink_; // TODO: 外部对象必须一直存在, 但实际可能不会
   BackendInfo bkinfo_;
 };
@@ -0,0 +1,104 @@
+// clang-format off
+#include "trace_collector.h"
+#include <iostream>
+#include "src/common/assert.h"
+#include "src/common/except.h"
+#include "src/metrics/metrics.h"
+// clang-format on
+
+namespace ohno {
+namespace backend {
+
+TraceCollector::TraceCollector(std::string_view path) : path_{path} {
+  OHNO_ASSERT(!path_.empty());
+}
+
+TraceCollector::~TraceCollector() { stop(); }
+
+/**
+ * @brief 启动收集线程，每 CNI_TRACE_INTERVAL 收集一次
+ *
+ */
+auto TraceCollector::start() -> void {
+  if (running_) {
+    return;
+  }
+  running_ = true;
+
+  collector_ = std::thread{[this]() {
+    try {
+      pthread_setname_np(pthread_self(), "cnitrace");
+      std::unique_lock<std::mutex> lock{mutex_};
+      while (running_) {
+        cond_.wait_for(lock, CNI_TRACE_INTERVAL, [this]() { return !running_; });
+        lock.unlock();
+        collect();
+        lock.lock();
+      }
+    } catch (const ohno::except::Exception &exc) {
+      std::cerr << "[error] Ohnod CNI trace thread terminated!" << exc.getMsg() << "\n";
+    } catch (const std::exception &exc) {
+      std::cerr << "[error] Ohnod CNI trace thread terminated!" << exc.what() << "\n";
+    }
+  }};
+}
+
+/**
+ * @brief 停止收集线程（退出前收集最后一次）
+ *
+ */
+auto TraceCollector::stop() -> void {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    running_ = false;
+  }
+  cond_.notify_all();
+  if (collector_.joinable()) {
+    collector_.join();
+  }
+}
+
+/**
+ * @brief 取走 CNI 插件追加的记录，输出本周期的汇总
+ *
+ * @return size_t 本周期的记录数量
+ */
+auto TraceCollector::collect() -> size_t {
+  auto traces = cni::CniTrace::drain(path_);
+  if (traces.empty()) {
+    return 0;
+  }
+
+  cni::CniTraceStats period{};
+  for (const auto &trace : traces) {
+    period.add(trace);
+  }
+  OHNO_LOG(info, "CNI latency of last {}s:\n{}", CNI_TRACE_INTERVAL.count(), period.toString());
+
+  auto &registry = metrics::Registry::instance();
+  for (const auto &trace : traces) {
+    registry
+        .histogram("ohno_cni_duration_seconds", "Duration of CNI plugin calls",
+                   metrics::Buckets::latency, {{"command", trace.command_}})
+        .observe(static_cast<double>(trace.total_) / 1e6);
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  for (const auto &trace : traces) {
+    stats_.add(trace);
+  }
+  return traces.size();
+}
+
+/**
+ * @brief 获取 ohnod 启动以来的汇总
+ *
+ * @return cni::CniTraceStats 汇总
+ */
+auto TraceCollector::getStats() const -> cni::CniTraceStats {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return stats_;
+}
+
+} // namespace backend
+} // namespace ohno
@@ -0,0 +1,49 @@
+#pragma once
+
+// clang-format off
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "src/cni/cni_trace.h"
+#include "src/log/logger.h"
+// clang-format on
+
+namespace ohno {
+namespace backend {
+
+constexpr std::chrono::seconds CNI_TRACE_INTERVAL{60};
+
+/**
+ * @brief CNI 调用耗时收集线程（ohnod）：定期取走 CNI 插件追加的分阶段耗时记录，
+ * 输出本周期的汇总并累计到进程生命周期的汇总中
+ */
+class TraceCollector final : public log::Loggable<log::Id::backend> {
+public:
+  explicit TraceCollector(std::string_view path = cni::PATH_CNI_TRACE);
+  ~TraceCollector() override;
+  TraceCollector(const TraceCollector &) = delete;
+  TraceCollector(TraceCollector &&) = delete;
+  auto operator=(const TraceCollector &) -> TraceCollector & = delete;
+  auto operator=(TraceCollector &&) -> TraceCollector & = delete;
+
+  auto start() -> void;
+  auto stop() -> void;
+  auto collect() -> size_t;
+  auto getStats() const -> cni::CniTraceStats;
+
+private:
+  std::string path_;
+  cni::CniTraceStats stats_; // ohnod 启动以来的汇总
+
+  mutable std::mutex mutex_;
+  std::condition_variable cond_;
+  std::atomic<bool> running_{false};
+  std::thread collector_;
+};
+
+} // namespace backend
+} // namespace ohno
@@ -88,7 +88,8 @@ auto Vxlan::eventHandler(std::string_view current_node) -> void {
           continue;
         }
 
-        node_cache_.emplace(name, info);
+        node_cache_.emplace(name, Peer{info, vtep_addr, vtep_mac});
+        countPeer(enumName(cni::CniConfigIpam::Mode::vxlan), true);
         OHNO_LOG(info,
                  "Vxlan static route(dest:{}, via:{}), ARP cache(addr:{}, mac:{}), FDB(mac:{}, "
                  "underlay:{}) existed",
@@ -99,14 +100,19 @@ auto Vxlan::eventHandler(std::string_view current_node) -> void {
 
   // 检查节点删除
   for (auto it = node_cache_.begin(); it != node_cache_.end();) {
-    const auto &[name, info] = *it;
+    const auto &[name, peer] = *it;
+    const auto &info = peer.info_;
+    const auto &vtep_addr = peer.vtep_addr_;
+    const auto &vtep_mac = peer.vtep_mac_;
 
     // 只有两种情况：
     // 1. 当前节点已被删除，则节点内所有静态路由、ARP 缓存、FDB 表项都要删掉
     // 2. 其他节点被删除了，则节点只需要删除对应的静态路由、ARP 缓存、FDB 表项
-    std::string vtep_addr{}, vtep_mac{};
-    storage_->getVtep(name, vtep_addr, vtep_mac);
-    if (current_vtep_addr.empty() || vtep_addr.empty()) {
+    // 对端节点删除最后一个 Pod 或者租约过期时，VTEP 已经从持久化中删除，
+    // 删除表项只能使用下发时缓存的 VTEP
+    std::string exist_addr{}, exist_mac{};
+    storage_->getVtep(name, exist_addr, exist_mac);
+    if (current_vtep_addr.empty() || exist_addr.empty()) {
       if (!nic_->delRoute(info.pod_cidr_, vtep_addr, net::NAME_VXLAN)) {
         OHNO_LOG(warn, "Vxlan failed to delete static route(dest:{}, via:{}, dev:{})",
                  info.pod_cidr_, vtep_addr, net::NAME_VXLAN);
@@ -122,11 +128,12 @@ auto Vxlan::eventHandler(std::string_view current_node) -> void {
                  info.internal_ip_);
       }
 
-      it = node_cache_.erase(it);
       OHNO_LOG(info,
                "Vxlan static route(dest:{}, via:{}), ARP cache(addr:{}, mac:{}), FDB(mac:{}, "
                "underlay:{}) has been erased",
                info.pod_cidr_, vtep_addr, vtep_addr, vtep_mac, vtep_mac, info.internal_ip_);
+      it = node_cache_.erase(it);
+      countPeer(enumName(cni::CniConfigIpam::Mode::vxlan), false);
       continue;
     } // end if()
     ++it;
@@ -19,7 +19,13 @@ protected:
   auto eventHandler(std::string_view current_node) -> void override;
 
 private:
-  std::unordered_map<std::string, backend::NodeInfo> node_cache_;
+  struct Peer {
+    backend::NodeInfo info_;
+    std::string vtep_addr_; // 下发表项时的 VTEP，对端节点删除后持久化中已经读不到
+    std::string vtep_mac_;
+  };
+
+  std::unordered_map<std::string, Peer> node_cache_;
   std::unique_ptr<cni::StorageIf> storage_;
 };
 
@@ -1,28 +1,30 @@
 // clang-format off
 #include "cni.h"
 #include <net/if.h>
+#include <algorithm>
 #include <iostream>
 #include "cni_result.h"
 #include "cni_error.h"
+#include "node_idle.h"
 #include "storage.h"
 #include "spdlog/fmt/fmt.h"
 #include "src/backend/center.h"
 #include "src/common/assert.h"
 #include "src/helper/hash.h"
+#include "src/ipam/arena.h"
 #include "src/ipam/cluster.h"
 #include "src/ipam/macro.h"
 #include "src/ipam/netns.h"
 #include "src/ipam/node.h"
 #include "src/net/addr.h"
 #include "src/net/bridge.h"
-#include "src/net/mac.h"
 #include "src/net/macro.h"
 #include "src/net/route.h"
 #include "src/net/subnet.h"
 #include "src/net/underlay.hpp"
 #include "src/net/veth.h"
+#include "src/net/veth_pool.h"
 #include "src/net/vxlan.h"
-#include "src/net/netlink/netlink_ip_cmd.h"
 #include "src/util/shell_sync.h"
 // clang-format on
 
@@ -54,6 +56,7 @@ auto Cni::parseConfig(const CniConfig &conf) -> void {
       throw OHNO_CNIERR(7, "Invalid IPAM mode");
     }
   }
+  trace_ = conf_.trace_ ? std::make_unique<CniTrace>() : nullptr;
 }
 
 /**
@@ -141,6 +144,39 @@ auto Cni::setCenter(std::unique_ptr<backend::CenterIf> center) -> bool {
   return true;
 }
 
+/**
+ * @brief 设置当前节点信息（来自 ohnod 发布的启动快照），设置之后不再探测
+ *
+ * @param node_name 节点名称
+ * @param underlay_dev Underlay 网络设备
+ * @param underlay_addr Underlay 网络地址
+ */
+auto Cni::setNodeInfo(std::string_view node_name, std::string_view underlay_dev,
+                      std::string_view underlay_addr) -> void {
+  node_name_ = node_name;
+  node_underlay_dev_ = underlay_dev;
+  node_underlay_addr_ = underlay_addr;
+}
+
+/**
+ * @brief 设置本次请求的 ETCD 修改记录（与 IPAM、Storage 的 ETCD 客户端共享）
+ *
+ * @param change_log 修改记录
+ */
+auto Cni::setChangeLog(std::shared_ptr<etcd::ChangeLog> change_log) -> void {
+  change_log_ = std::move(change_log);
+}
+
+/**
+ * @brief 设置节点空闲标记文件路径（同一台机器上模拟多个节点时各自独立）
+ *
+ * @param path 标记文件路径，锁文件为 "<path>.lock"
+ */
+auto Cni::setNodeIdlePath(std::string_view path) -> void {
+  OHNO_ASSERT(!path.empty());
+  node_idle_path_ = path;
+}
+
 /**
  * @brief CNI ADD
  *
@@ -155,92 +191,130 @@ auto Cni::add(std::string_view container_id, std::string_view netns, std::string
   OHNO_ASSERT(!netns.empty());
   OHNO_ASSERT(!nic_name.empty());
   OHNO_ASSERT(ipam_);
+  OHNO_ASSERT(storage_);
   OHNO_LOG(debug, "CNI ADD parameters: container_id:\"{}\", netns:\"{}\", nic_name:\"{}\"",
            container_id, netns, nic_name);
+  TraceScope trace{trace_.get(), "ADD", container_id};
 
-  auto ipam_start = ipam_->dump();
-  auto netlink = std::dynamic_pointer_cast<net::NetlinkIpCmd>(netlink_);
+  auto netlink = netlink_;
   if (!netlink) {
     throw OHNO_CNIERR(7, "Failed to create netlink interface");
   }
 
-  util::ShellSync shell{};
-  if (!backend::Center::getNodeInfo(&shell, node_name_, node_underlay_dev_, node_underlay_addr_)) {
-    throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO, "Failed to get current node info");
+  {
+    PhaseTimer timer{trace_.get(), CniTrace::Phase::discovery};
+    initNodeInfo();
   }
-  cluster_ = getKubernetesCluster(netlink);
-  OHNO_ASSERT(cluster_);
 
-  // 获取 Kubernetes 节点
-  auto node = getKubernetesNode(true, netlink);
-  if (!node) {
-    throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO,
-                      fmt::format("Failed to get Kubernetes node:{}", node_name_));
+  {
+    PhaseTimer timer{trace_.get(), CniTrace::Phase::cluster};
+    // 节点重新有了 Pod，取消回收；必须在读取集群之前清除，保证不会与 ohnod 的回收交错
+    if (!NodeIdle{node_idle_path_}.clear()) {
+      OHNO_LOG(warn, "Failed to clear idle mark of node:{}", node_name_);
+    }
+    cluster_ = getKubernetesCluster(netlink);
+    OHNO_ASSERT(cluster_);
   }
 
-  // 获取 Kubernetes Pod
-  // 因为 container_id 是 pause 容器的标识，所以可以用来唯一标识一个 Pod
-  auto pod = Cni::getKubernetesPod(node, container_id, true);
-  if (!pod) {
-    throw OHNO_CNIERR(
-        cni::CNI_ERRCODE_OHNO,
-        fmt::format("Failed to get Kubernetes pod:{} of node:{}", container_id, node_name_));
-  }
+  // 本次 ADD 产生的持久化记录最后在一个 ETCD 事务中一次性提交，中途失败不会留下不完整的记录，
+  // 本次分配的地址也一起归还；已经创建的网卡由 kubelet 随后的 DEL 或者重试的 ADD 处理
+  beginStorage();
 
   // 获取 Pod 网卡（Veth）
   // pod 一端使用 $CNI_IFNAME 名称，宿主机一端使用 veth_$CNI_CONTAINERID 名称
   auto veth_host = fmt::format("veth_{}", helper::getShortHash(container_id));
   auto veth_pod = nic_name;
-  std::string pod_addr{};
-
-  auto nic =
-      getKubernetesNic(pod, veth_pod, false); // 每个 Pod 只保留一张网卡，因为 pod 网络是共享的
-  if (nic) {
-    // TODO:
-    // 如果 CNI 配置给出的子网和 gateway 与 Pod 已生效的网络配置不一样时，此时怎么做？
-    // 所有 Pod 都要删除？但 CNI ADD 只是增加一个 Pod，则已删除的其他 Pod 由 CRI
-    // 负责重新向 CNI 发命令创建吗？
-    net::Subnet subnet_veth{};
-    const auto *addr_obj = nic->getAddr();
-    if (addr_obj == nullptr) {
-      throw OHNO_CNIERR(7, fmt::format("Failed to get veth address:{}", veth_pod));
-    }
-    subnet_veth.init(addr_obj->getAddrCidr());
-    if (!subnet_veth.isSubnetOf(conf_.ipam_.subnet_)) {
-      throw OHNO_CNIERR(
-          7, fmt::format("CNI interfaces subnet:{} is not CNI configuration subnet of {}",
-                         addr_obj->getAddrCidr(), conf_.ipam_.subnet_));
+  std::shared_ptr<net::NicIf> nic{};
+  try {
+    // 获取 Kubernetes 节点
+    std::shared_ptr<ipam::NodeIf> node{};
+    {
+      PhaseTimer timer{trace_.get(), CniTrace::Phase::node};
+      node = getKubernetesNode(true, netlink);
+    }
+    if (!node) {
+      throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO,
+                        fmt::format("Failed to get Kubernetes node:{}", node_name_));
     }
 
-    // 一个 Pod 只支持一个 NIC，所以网卡名称不存在时直接重命名已存在的网卡
-    if (!nic->isExist() && !nic->rename(veth_pod)) {
+    // 获取 Kubernetes Pod
+    // 因为 container_id 是 pause 容器的标识，所以可以用来唯一标识一个 Pod
+    auto pod = Cni::getKubernetesPod(node, container_id, true);
+    if (!pod) {
       throw OHNO_CNIERR(
-          7, fmt::format("Failed to rename veth:{} to veth:{}", nic->getName(), veth_pod));
+          cni::CNI_ERRCODE_OHNO,
+          fmt::format("Failed to get Kubernetes pod:{} of node:{}", container_id, node_name_));
     }
-  } else {
-    // 这个 Pod 第一次创建网卡
-    nic = getKubernetesNic(pod, veth_pod, true, netlink, veth_host, netns);
-    if (!nic) {
-      throw OHNO_CNIERR(7, fmt::format("Failed to get Kubernetes veth pair on pod:{} of node:{}",
-                                       container_id, node_name_));
+
+    // 每个 Pod 只保留一张网卡，因为 pod 网络是共享的
+    nic = getKubernetesNic(pod, veth_pod, false);
+    if (nic) {
+      // TODO:
+      // 如果 CNI 配置给出的子网和 gateway 与 Pod 已生效的网络配置不一样时，此时怎么做？
+      // 所有 Pod 都要删除？但 CNI ADD 只是增加一个 Pod，则已删除的其他 Pod 由 CRI
+      // 负责重新向 CNI 发命令创建吗？
+      net::Subnet subnet_veth{};
+      const auto *addr_obj = nic->getAddr();
+      if (addr_obj == nullptr) {
+        throw OHNO_CNIERR(7, fmt::format("Failed to get veth address:{}", veth_pod));
+      }
+      subnet_veth.init(addr_obj->getAddrCidr());
+      if (!subnet_veth.isSubnetOf(conf_.ipam_.subnet_)) {
+        throw OHNO_CNIERR(
+            7, fmt::format("CNI interfaces subnet:{} is not CNI configuration subnet of {}",
+                           addr_obj->getAddrCidr(), conf_.ipam_.subnet_));
+      }
+
+      // 一个 Pod 只支持一个 NIC，所以网卡名称不存在时直接重命名已存在的网卡
+      if (!nic->isExist() && !nic->rename(veth_pod)) {
+        throw OHNO_CNIERR(
+            7, fmt::format("Failed to rename veth:{} to veth:{}", nic->getName(), veth_pod));
+      }
+    } else {
+      // 这个 Pod 第一次创建网卡
+      nic = getKubernetesNic(pod, veth_pod, true, netlink, veth_host, netns);
+      if (!nic) {
+        throw OHNO_CNIERR(7, fmt::format("Failed to get Kubernetes veth pair on pod:{} of node:{}",
+                                         container_id, node_name_));
+      }
+    }
+  } catch (...) {
+    rollbackIpam();
+    throw;
+  }
+  {
+    PhaseTimer timer{trace_.get(), CniTrace::Phase::storage};
+    if (!commitStorage()) {
+      throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO,
+                        fmt::format("Failed to store pod:{} of node:{}", container_id, node_name_));
     }
   }
-  auto ipam_end = ipam_->dump();
-  OHNO_LOG(debug, "\nIPAM start\n{}IPAM end\n{}", ipam_start, ipam_end);
+  logChanges("ADD");
+
+  PhaseTimer timer{trace_.get(), CniTrace::Phase::encode};
 
   // 输出
-  const auto *addr_obj =
-      nic->getAddr(); // 根据 CNI spec：
-                      // https://github.com/containernetworking/cni.dev/blob/main/content/docs/spec.md#add-success,
-                      // 一个网卡目前只有一个地址
-  pod_addr = addr_obj != nullptr ? addr_obj->getAddrCidr() : std::string{UNKNOWN_ADDR_V4};
-  OHNO_ASSERT(gateway_);
+  // 根据 CNI spec：
+  // https://github.com/containernetworking/cni.dev/blob/main/content/docs/spec.md#add-success,
+  // 双栈 Pod 的每个地址都是 ips 中的一项
+  OHNO_ASSERT(!gateways_.empty());
   CniResult result{.cniversion_ = conf_.cni_version_,
-                   .ips_ = std::vector<CniResultIps>{CniResultIps{.address_ = pod_addr,
-                                                                  .gateway_ = gateway_->getAddr()}},
+                   .ips_ = std::vector<CniResultIps>{},
                    .interfaces_ = std::vector<CniResultInterfaces>{
                        CniResultInterfaces{.name_ = veth_pod.data(), .sandbox_ = netns.data()}}};
-  return nlohmann::json(result).dump(4);
+  for (const auto *addr_obj : nic->getAllAddrs()) {
+    const auto *gateway = getGateway(addr_obj->ipVersion());
+    result.ips_.emplace_back(
+        CniResultIps{.address_ = addr_obj->getAddrCidr(),
+                     .gateway_ = gateway != nullptr ? gateway->getAddr() : std::string{}});
+  }
+  if (result.ips_.empty()) {
+    result.ips_.emplace_back(CniResultIps{.address_ = std::string{UNKNOWN_ADDR_V4},
+                                          .gateway_ = gateways_.front()->getAddr()});
+  }
+  auto output = nlohmann::json(result).dump(4);
+  trace.succeed();
+  return output;
 }
 
 /**
@@ -254,25 +328,30 @@ auto Cni::del(std::string_view container_id, std::string_view nic_name) noexcept
     OHNO_ASSERT(!container_id.empty());
     OHNO_ASSERT(!nic_name.empty());
     OHNO_ASSERT(ipam_);
+    OHNO_ASSERT(storage_);
 
     OHNO_LOG(debug, "CNI DEL parameters: container_id:\"{}\", nic_name:\"{}\"", container_id,
              nic_name);
+    TraceScope trace{trace_.get(), "DEL", container_id};
 
-    auto netlink = std::dynamic_pointer_cast<net::NetlinkIpCmd>(netlink_);
+    auto netlink = netlink_;
     if (!netlink) {
       throw OHNO_CNIERR(7, "Failed to create netlink interface");
     }
 
-    util::ShellSync shell{};
-    if (!backend::Center::getNodeInfo(&shell, node_name_, node_underlay_dev_,
-                                      node_underlay_addr_)) {
-      throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO, "Failed to get current node info");
+    {
+      PhaseTimer timer{trace_.get(), CniTrace::Phase::discovery};
+      initNodeInfo();
     }
 
-    cluster_ = getKubernetesCluster(netlink);
-    if (!cluster_) {
-      throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO, "Failed to get kubernetes cluster");
+    {
+      PhaseTimer timer{trace_.get(), CniTrace::Phase::cluster};
+      cluster_ = getKubernetesCluster(netlink);
+      if (!cluster_) {
+        throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO, "Failed to get kubernetes cluster");
+      }
     }
+    beginStorage();
 
     // 删除 Pod 网络接口
     auto node = getKubernetesNode(false);
@@ -285,29 +364,41 @@ auto Cni::del(std::string_view container_id, std::string_view nic_name) noexcept
     if (!pod) {
       OHNO_LOG(warn, "CNI DEL: Pod had been deleted");
     } else {
+      PhaseTimer timer{trace_.get(), CniTrace::Phase::veth};
       delKubernetesNic(pod, nic_name);
       delKubernetesPod(node, container_id);
     }
 
-    // 删除节点静态路由
-    if (node->getNetnsSize() == 1) {
-      // 算上宿主机的 root namespace，数量为 1 说明节点刚才删除了最后一个 pod
+    // 算上宿主机的 root namespace，数量为 1 说明节点刚才删除了最后一个 pod
+    auto idle = node->getNetnsSize() == 1 && conf_.node_idle_timeout_ != 0;
+    if (node->getNetnsSize() == 1 && !idle) {
+      PhaseTimer timer{trace_.get(), CniTrace::Phase::node};
+      delKubernetesNode(node);
+    }
 
-      // 删除节点 root namespace
-      auto host = Cni::getKubernetesPod(node, ipam::HOST);
-      if (host) {
-        delKubernetesNic(host, conf_.bridge_);
-        delKubernetesNic(host, net::NAME_VXLAN);
-        delKubernetesNic(host, node_underlay_dev_);
-        delKubernetesPod(node, ipam::HOST);
+    {
+      PhaseTimer timer{trace_.get(), CniTrace::Phase::storage};
+      if (!commitStorage()) {
+        throw OHNO_CNIERR(
+            cni::CNI_ERRCODE_OHNO,
+            fmt::format("Failed to delete pod:{} of node:{}", container_id, node_name_));
       }
+    }
 
-      // 归还节点子网
-      auto node_subnet = node->getSubnet();
-      if (!node_subnet.empty() && !ipam_->releaseSubnet(node_name_, node_subnet)) {
-        OHNO_LOG(error, "Failed to release node subnet");
+    // 节点网络设施暂时保留，下一个 Pod 直接复用，超过宽限期仍然空闲时由 ohnod 回收
+    if (idle) {
+      if (!NodeIdle{node_idle_path_}.mark()) {
+        OHNO_LOG(warn, "Failed to mark node:{} idle", node_name_);
       }
+      // 只有网关还占用地址，其余地址块归还，回收节点时 releaseSubnet() 归还剩下的
+      if (!ipam_->releaseEmptyBlocks(node_name_)) {
+        OHNO_LOG(warn, "Failed to release empty IPAM blocks of node:{}", node_name_);
+      }
+      OHNO_LOG(info, "Node:{} has no pod, keep its infrastructure for {}s", node_name_,
+               conf_.node_idle_timeout_);
     }
+    logChanges("DEL");
+    trace.succeed();
   } catch (const cni::CniError &cni_err) {
     OHNO_LOG(error, "CNI DEL failed:\n{}", nlohmann::json(cni_err).dump());
   } catch (const std::exception &err) {
@@ -315,6 +406,58 @@ auto Cni::del(std::string_view container_id, std::string_view nic_name) noexcept
   }
 }
 
+/**
+ * @brief 回收空闲超过宽限期的节点网络设施（由 ohnod 定期调用）
+ *
+ * @return true 已回收
+ * @return false 节点没有空闲、仍在宽限期内、期间又有 Pod 加入，或者回收失败
+ */
+auto Cni::reclaim() noexcept -> bool {
+  try {
+    OHNO_ASSERT(ipam_);
+    OHNO_ASSERT(storage_);
+    if (conf_.node_idle_timeout_ <= 0) {
+      return false;
+    }
+
+    // 持锁期间 CNI ADD 无法清除标记，所以回收过程中不会有 Pod 加入
+    NodeIdle idle{node_idle_path_};
+    auto idle_time = idle.getIdleTime();
+    if (!idle.isLocked() || !idle_time.has_value() ||
+        idle_time.value() < std::chrono::seconds{conf_.node_idle_timeout_}) {
+      return false;
+    }
+
+    auto netlink = netlink_;
+    if (!netlink) {
+      throw OHNO_CNIERR(7, "Failed to create netlink interface");
+    }
+    initNodeInfo();
+    cluster_ = getKubernetesCluster(netlink);
+    OHNO_ASSERT(cluster_);
+    beginStorage();
+
+    auto node = getKubernetesNode(false);
+    if (!node || node->getNetnsSize() != 1) {
+      idle.clear(); // 节点网络设施已经不存在，或者 DEL 标记之后又有 Pod 加入
+      return false;
+    }
+    delKubernetesNode(node);
+    if (!commitStorage()) {
+      throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO, fmt::format("Failed to delete node:{}", node_name_));
+    }
+    idle.clear();
+    OHNO_LOG(info, "Node:{} idle for {}s, infrastructure reclaimed", node_name_,
+             idle_time.value().count());
+    return true;
+  } catch (const cni::CniError &cni_err) {
+    OHNO_LOG(error, "Node reclaim failed:\n{}", nlohmann::json(cni_err).dump());
+  } catch (const std::exception &err) {
+    OHNO_LOG(error, "Node reclaim failed: {}", err.what());
+  }
+  return false;
+}
+
 /**
  * @brief CNI VERSION
  *
@@ -326,25 +469,118 @@ auto Cni::version() const -> std::string {
   return nlohmann::json(ver).dump(4);
 }
 
+/**
+ * @brief 进入持久化批量模式，并清空上一次调用残留的 IPAM 改动
+ *
+ */
+auto Cni::beginStorage() -> void {
+  OHNO_ASSERT(storage_);
+  storage_->beginBatch();
+  allocated_ips_.clear();
+  released_ips_.clear();
+  released_subnet_.clear();
+}
+
+/**
+ * @brief 提交本次调用的持久化记录，IPAM 的改动随之生效或撤销
+ *
+ * 地址与子网在 IPAM 中单独分配与归还，不在持久化事务中：提交失败时归还本次分配的地址，
+ * 使 IPAM 与没有生效的记录一致；删除记录引用的地址与子网提交成功之后才归还，
+ * 提交失败时记录仍然引用它们，kubelet 重试 DEL 时再归还
+ *
+ * @note 提交成功之后归还之前进程退出时地址会泄漏，但不会被两个 Pod 同时使用
+ *
+ * @return true 提交成功
+ * @return false 提交失败
+ */
+auto Cni::commitStorage() -> bool {
+  OHNO_ASSERT(ipam_);
+  OHNO_ASSERT(storage_);
+  if (!storage_->commitBatch()) {
+    rollbackIpam();
+    return false;
+  }
+
+  for (const auto &addr : released_ips_) {
+    if (!ipam_->releaseIp(node_name_, addr)) {
+      OHNO_LOG(warn, "Failed to release pod address:{} to IPAM", addr);
+    }
+  }
+  if (!released_subnet_.empty() && !ipam_->releaseSubnet(node_name_, released_subnet_)) {
+    OHNO_LOG(error, "Failed to release node subnet");
+  }
+  allocated_ips_.clear();
+  released_ips_.clear();
+  released_subnet_.clear();
+  return true;
+}
+
+/**
+ * @brief 撤销本次调用对 IPAM 的改动：归还新分配的地址，放弃待归还的地址与子网
+ *
+ */
+auto Cni::rollbackIpam() -> void {
+  OHNO_ASSERT(ipam_);
+  for (const auto &addr : allocated_ips_) {
+    if (!ipam_->releaseIp(node_name_, addr)) {
+      OHNO_LOG(warn, "Failed to roll back address:{} allocated on node:{}", addr, node_name_);
+    }
+  }
+  if (!allocated_ips_.empty()) {
+    OHNO_LOG(info, "Rolled back {} addresses allocated on node:{}", allocated_ips_.size(),
+             node_name_);
+  }
+  allocated_ips_.clear();
+  released_ips_.clear();
+  released_subnet_.clear();
+}
+
+/**
+ * @brief 输出本次请求修改过的 ETCD key，只有开启 debug 日志时才生成
+ *
+ * @param command CNI 命令
+ */
+auto Cni::logChanges(std::string_view command) const -> void {
+  if (change_log_ != nullptr && log::Logger::getLevel() <= log::Level::debug) {
+    OHNO_LOG(debug, "ETCD changes of CNI {}:\n{}", command, change_log_->toString());
+  }
+}
+
+/**
+ * @brief 获取当前节点信息，已经通过 setNodeInfo() 设置时不再执行命令探测
+ *
+ */
+auto Cni::initNodeInfo() -> void {
+  if (!node_name_.empty() && !node_underlay_dev_.empty() && !node_underlay_addr_.empty()) {
+    return;
+  }
+
+  util::ShellSync shell{};
+  if (!backend::Center::getNodeInfo(&shell, node_name_, node_underlay_dev_, node_underlay_addr_)) {
+    throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO, "Failed to get current node info");
+  }
+}
+
 /**
  * @brief 根据持久化配置生成网卡对象
  *
  * @param pod Kubernetes Pod
  * @param nic 网卡名称
  * @param netlink Netlink 对象
+ * @param arena 网卡对象所在的内存区域
  * @return std::shared_ptr<net::NicIf> 网卡对象
  */
 auto Cni::getStorageNic(std::string_view pod, std::string_view nic,
-                        const std::weak_ptr<net::NetlinkIf> &netlink)
-    -> std::shared_ptr<net::NicIf> {
+                        const std::weak_ptr<net::NetlinkIf> &netlink,
+                        const std::shared_ptr<ipam::Arena> &arena) -> std::shared_ptr<net::NicIf> {
   std::shared_ptr<net::NicIf> nic_obj{};
   if (pod == ipam::HOST && nic == node_underlay_dev_) {
-    nic_obj.reset(new net::Underlay{}); // underlay 网卡在删除时有一些限制
+    nic_obj = arena->make<net::Underlay>(); // underlay 网卡在删除时有一些限制
   } else {
     if (nic == conf_.bridge_) {
-      nic_obj.reset(new net::Bridge{});
+      nic_obj = arena->make<net::Bridge>();
     } else {
-      nic_obj.reset(new net::Nic{});
+      nic_obj = arena->make<net::Nic>();
     }
   }
   nic_obj->setName(nic);
@@ -383,7 +619,10 @@ auto Cni::getKubernetesCluster(const std::weak_ptr<net::NetlinkIf> &netlink)
   OHNO_ASSERT(!node_underlay_addr_.empty());
   OHNO_ASSERT(storage_);
 
-  auto cluster = std::make_unique<ipam::Cluster>();
+  // 模型只在这次调用中使用，对象都从同一块区域分配，替换 cluster_ 时整块释放
+  auto arena = std::make_shared<ipam::Arena>();
+  auto cluster = std::make_unique<ipam::Cluster>(arena);
+  gateways_.clear();
 
   std::string subnet{};
   if (!ipam_->getSubnet(node_name_, subnet)) {
@@ -391,31 +630,45 @@ auto Cni::getKubernetesCluster(const std::weak_ptr<net::NetlinkIf> &netlink)
     return cluster;
   }
 
-  auto node = std::make_shared<ipam::Node>();
+  auto node = arena->make<ipam::Node>(arena->getResource());
   initKubernetesNode(node, subnet);
 
   std::vector<std::string> pod_names = storage_->getAllPods(node_name_);
+  if (std::find(pod_names.begin(), pod_names.end(), ipam::HOST) == pod_names.end()) {
+    // 子网已经分配，但创建节点的 CNI ADD 还没有提交宿主机的记录，当作节点不存在，
+    // 由本次调用再创建一次：子网分配是幂等的，重复追加的列表值在提交时合并
+    return cluster;
+  }
   for (const auto &pod : pod_names) {
-    auto pod_obj = std::make_shared<ipam::Netns>();
+    std::string netns{};
+    if (pod != ipam::HOST) {
+      netns = storage_->getNetns(node_name_, pod);
+      if (netns.empty() && !storage_->hasPod(node_name_, pod)) {
+        // 模型由多次读取组成，不是同一时刻的快照：读取 Pod 列表之后，并发的 CNI DEL 已经
+        // 在同一个事务中删除了这个 Pod 与它的 namespace
+        continue;
+      }
+      OHNO_ASSERT(!netns.empty()); // CNI ADD 与 Pod 列表在同一个事务中保存 namespace
+    }
+
+    auto pod_obj = arena->make<ipam::Netns>(arena->getResource());
     pod_obj->setName(pod);
 
     auto nics = storage_->getAllNic(node_name_, pod);
     for (const auto &nic : nics) {
-      auto nic_obj = getStorageNic(pod, nic, netlink);
+      auto nic_obj = getStorageNic(pod, nic, netlink, arena);
       if (nic_obj == nullptr) {
         continue;
       }
       if (pod != ipam::HOST) {
-        auto netns = storage_->getNetns(node_name_, pod);
-        OHNO_ASSERT(!netns.empty()); // CNI ADD 会保证所有 pod 都保存 namespace
         nic_obj->setNetns(netns);
       }
 
       // 网卡添加 IP 地址
       auto addrs = storage_->getAllAddrs(node_name_, pod, nic);
       for (const auto &addr : addrs) {
-        if (gateway_ == nullptr && nic == conf_.bridge_) {
-          gateway_.reset(new net::Addr{addr});
+        if (nic == conf_.bridge_) {
+          gateways_.emplace_back(std::make_unique<net::Addr>(addr));
         }
         nic_obj->addAddr(std::make_unique<net::Addr>(addr));
       }
@@ -442,11 +695,11 @@ auto Cni::getKubernetesCluster(const std::weak_ptr<net::NetlinkIf> &netlink)
  * @brief 获取 Linux bridge
  *
  * @param netlink Netlink 对象
- * @param bridge_addr IP 地址
+ * @param bridge_addrs IP 地址（双栈节点每个地址族各一个）
  * @return std::shared_ptr<net::NicIf> 网卡对象
  */
-auto Cni::getBridge(const std::weak_ptr<net::NetlinkIf> &netlink, std::string_view bridge_addr)
-    -> std::shared_ptr<net::NicIf> {
+auto Cni::getBridge(const std::weak_ptr<net::NetlinkIf> &netlink,
+                    const std::vector<std::string> &bridge_addrs) -> std::shared_ptr<net::NicIf> {
 
   // 为节点 root namespace 创建 Linux bridge，它的地址是节点所有 pod 的网关
   auto bridge = std::make_shared<net::Bridge>();
@@ -460,12 +713,14 @@ auto Cni::getBridge(const std::weak_ptr<net::NetlinkIf> &netlink, std::string_vi
                       fmt::format("Failed to create Kubernetes node:{} bridge object", node_name_));
   }
 
-  if (bridge->addAddr(std::make_unique<net::Addr>(bridge_addr))) {
-    if (!storage_->addAddr(node_name_, ipam::HOST, conf_.bridge_,
-                           std::make_unique<net::Addr>(bridge_addr))) {
-      throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO,
-                        fmt::format("Failed to store bridge:{} gateway:{} on node:{}",
-                                    conf_.bridge_, bridge_addr, node_name_));
+  for (const auto &bridge_addr : bridge_addrs) {
+    if (bridge->addAddr(std::make_unique<net::Addr>(bridge_addr))) {
+      if (!storage_->addAddr(node_name_, ipam::HOST, conf_.bridge_,
+                             std::make_unique<net::Addr>(bridge_addr))) {
+        throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO,
+                          fmt::format("Failed to store bridge:{} gateway:{} on node:{}",
+                                      conf_.bridge_, bridge_addr, node_name_));
+      }
     }
   }
   if (!bridge->setStatus(net::LinkStatus::UP)) {
@@ -508,8 +763,8 @@ auto Cni::getVxlan(const std::weak_ptr<net::NetlinkIf> &netlink, std::string_vie
   if (!vxlan->setStatus(net::LinkStatus::UP)) {
     OHNO_LOG(warn, "Failed to open vxlan:{} in root namespace", net::NAME_VXLAN);
   }
-  net::Mac vxlan_nic{net::NAME_VXLAN};
-  auto vxlan_mac = vxlan_nic.getMac();
+  auto netlink_ptr = netlink.lock();
+  auto vxlan_mac = netlink_ptr ? netlink_ptr->linkGetMac(net::NAME_VXLAN) : std::string{};
   if (vxlan_mac.empty()) {
     throw OHNO_CNIERR(
         7, fmt::format("Failed to get vxlan:{} mac on node:{}", net::NAME_VXLAN, node_name_));
@@ -566,28 +821,32 @@ auto Cni::getKubernetesNode(bool get_and_create, const std::weak_ptr<net::Netlin
   OHNO_ASSERT(!node_underlay_addr_.empty());
   OHNO_ASSERT(cluster_);
   OHNO_ASSERT(ipam_);
-  OHNO_ASSERT(center_);
 
   auto node = cluster_->getNode(node_name_);
   if (!node && get_and_create) {
     if (netlink.lock()) {
       node.reset(new ipam::Node{});
 
-      // 为节点分配子网
+      // 为节点分配子网，只有 CNI ADD 创建节点时才需要访问 api server
+      OHNO_ASSERT(center_);
       std::string node_subnet{};
       if (!ipam_->allocateSubnet(node_name_, center_.get(), node_subnet)) {
         throw OHNO_CNIERR(7, fmt::format("Failed to allocate subnet for node:{}", node_name_));
       }
 
-      // 创建 bridge
-      std::string gateway{};
-      if (!ipam_->allocateIp(node_name_, gateway)) {
+      // 创建 bridge，双栈节点每个子网各分配一个网关
+      std::vector<std::string> gateways{};
+      if (!ipam_->allocateIps(node_name_, gateways)) {
         throw OHNO_CNIERR(
-            7, fmt::format("Failed to reserve gateway:{} for node:{}, the gateway had been used",
-                           gateway, node_name_));
+            7, fmt::format("Failed to reserve gateway for node:{}, the gateway had been used",
+                           node_name_));
+      }
+      allocated_ips_.insert(allocated_ips_.end(), gateways.begin(), gateways.end());
+      gateways_.clear();
+      for (const auto &gateway : gateways) {
+        gateways_.emplace_back(std::make_unique<net::Addr>(gateway));
       }
-      gateway_.reset(new net::Addr{gateway});
-      auto bridge = getBridge(netlink, gateway);
+      auto bridge = getBridge(netlink, gateways);
 
       // 创建 vxlan
       std::shared_ptr<net::NicIf> vxlan{};
@@ -664,6 +923,39 @@ auto Cni::delKubernetesPod(const std::shared_ptr<ipam::NodeIf> &node, std::strin
   node->delNetns(pod_name);
 }
 
+/**
+ * @brief 删除节点网络设施：root namespace 中的 bridge、VTEP、underlay 记录，并归还节点子网
+ *
+ * @param node 节点对象（已经没有 Pod）
+ */
+auto Cni::delKubernetesNode(const std::shared_ptr<ipam::NodeIf> &node) -> void {
+  OHNO_ASSERT(node);
+  OHNO_ASSERT(ipam_);
+
+  // 删除节点 root namespace
+  auto host = Cni::getKubernetesPod(node, ipam::HOST);
+  if (host) {
+    delKubernetesNic(host, conf_.bridge_);
+    delKubernetesNic(host, net::NAME_VXLAN);
+    delKubernetesNic(host, node_underlay_dev_);
+    delKubernetesPod(node, ipam::HOST);
+  }
+
+  // VTEP 跟随节点：空闲保留期间对端还要通过它把流量送到本节点，只在删除节点时删除
+  if (ipam_mode_ == cni::CniConfigIpam::Mode::vxlan && !storage_->delVtep(node_name_)) {
+    throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO,
+                      fmt::format("Failed to delete vtep on node:{}", node_name_));
+  }
+
+  // veth pair 池插在刚删除的 bridge 上，已经不能使用
+  for (const auto &name : netlink_->linkList(net::VETH_POOL_PREFIX)) {
+    netlink_->linkDestory(name);
+  }
+
+  // 节点子网在删除记录提交之后归还
+  released_subnet_ = node->getSubnet();
+}
+
 /**
  * @brief 将 NIC 插入节点 root namespace bridge
  *
@@ -710,40 +1002,69 @@ auto Cni::configPodNetwork(const std::shared_ptr<net::NicIf> &nic, std::string_v
   OHNO_ASSERT(!node_name_.empty());
   OHNO_ASSERT(ipam_);
   OHNO_ASSERT(storage_);
-  OHNO_ASSERT(gateway_);
+  OHNO_ASSERT(!gateways_.empty());
 
-  std::string pod_addr{};
-  if (!ipam_->allocateIp(node_name_, pod_addr)) {
-    throw OHNO_CNIERR(7, fmt::format("Failed to allocate IP address on node:{}", node_name_));
-  }
-  if (!nic->addAddr(std::make_unique<net::Addr>(pod_addr))) {
-    throw OHNO_CNIERR(
-        7, fmt::format("Failed to add IP address:{} to veth on node:{}", pod_addr, node_name_));
-  }
-  if (!storage_->addAddr(node_name_, container_id, nic_name,
-                         std::make_unique<net::Addr>(pod_addr))) {
-    throw OHNO_CNIERR(
-        cni::CNI_ERRCODE_OHNO,
-        fmt::format("Failed to store nic:{} addr:{} on node:{}", nic_name, pod_addr, node_name_));
+  std::vector<std::string> pod_addrs{};
+  {
+    PhaseTimer timer{trace_.get(), CniTrace::Phase::ipam};
+    if (!ipam_->allocateIps(node_name_, pod_addrs)) {
+      throw OHNO_CNIERR(7, fmt::format("Failed to allocate IP address on node:{}", node_name_));
+    }
+    allocated_ips_.insert(allocated_ips_.end(), pod_addrs.begin(), pod_addrs.end());
   }
 
-  auto route_via = gateway_->getAddr();
-  if (!nic->addRoute(std::make_unique<net::Route>(std::string_view{}, route_via, nic_name),
-                     net::NetlinkIf::RouteNHFlags::NONE)) {
-    throw OHNO_CNIERR(
-        7,
-        fmt::format("Failed to add default route:{dest:default, via:{}, dev:{}} to veth on node:{}",
-                    route_via, nic_name, node_name_));
-  }
-  if (!storage_->addRoute(node_name_, container_id, nic_name,
-                          std::make_unique<net::Route>(std::string_view{}, route_via, nic_name))) {
-    throw OHNO_CNIERR(
-        cni::CNI_ERRCODE_OHNO,
-        fmt::format("Failed to store nic:{} route:{dest:{}, via:{}, dev:{}} on node:{}", nic_name,
-                    std::string_view{}, route_via, nic_name, node_name_));
+  PhaseTimer timer{trace_.get(), CniTrace::Phase::config};
+  for (const auto &pod_addr : pod_addrs) {
+    auto addr = std::make_unique<net::Addr>(pod_addr);
+    const auto *gateway = getGateway(addr->ipVersion());
+    if (gateway == nullptr) {
+      throw OHNO_CNIERR(7, fmt::format("No gateway for IP address:{} on node:{}", pod_addr,
+                                       node_name_));
+    }
+
+    if (!nic->addAddr(std::move(addr))) {
+      throw OHNO_CNIERR(
+          7, fmt::format("Failed to add IP address:{} to veth on node:{}", pod_addr, node_name_));
+    }
+    if (!storage_->addAddr(node_name_, container_id, nic_name,
+                           std::make_unique<net::Addr>(pod_addr))) {
+      throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO,
+                        fmt::format("Failed to store nic:{} addr:{} on node:{}", nic_name,
+                                    pod_addr, node_name_));
+    }
+
+    auto route_via = gateway->getAddr();
+    if (!nic->addRoute(std::make_unique<net::Route>(std::string_view{}, route_via, nic_name),
+                       net::NetlinkIf::RouteNHFlags::NONE)) {
+      throw OHNO_CNIERR(
+          7, fmt::format(
+                 "Failed to add default route:{dest:default, via:{}, dev:{}} to veth on node:{}",
+                 route_via, nic_name, node_name_));
+    }
+    if (!storage_->addRoute(node_name_, container_id, nic_name,
+                            std::make_unique<net::Route>(std::string_view{}, route_via,
+                                                         nic_name))) {
+      throw OHNO_CNIERR(
+          cni::CNI_ERRCODE_OHNO,
+          fmt::format("Failed to store nic:{} route:{dest:{}, via:{}, dev:{}} on node:{}",
+                      nic_name, std::string_view{}, route_via, nic_name, node_name_));
+    }
   }
 }
 
+/**
+ * @brief 获取指定地址族的网关
+ *
+ * @param version IP 版本
+ * @return const net::AddrIf * 网关，不存在时返回 nullptr
+ */
+auto Cni::getGateway(net::IpVersion version) const -> const net::AddrIf * {
+  auto iter = std::find_if(gateways_.begin(), gateways_.end(), [version](const auto &gateway) {
+    return gateway->ipVersion() == version;
+  });
+  return iter != gateways_.end() ? iter->get() : nullptr;
+}
+
 /**
  * @brief 获取 Kubernetes Pod 网卡
  *
@@ -787,25 +1108,33 @@ auto Cni::getKubernetesNic(const std::shared_ptr<ipam::NetnsIf> &pod, std::strin
                           fmt::format("Failed to add namespace:{} to pod:{}", netns, container_id));
       }
 
-      iface.reset(new net::Veth{veth_peer});
+      auto veth = std::make_shared<net::Veth>(veth_peer);
+      iface = veth;
       if (!storage_->addNic(node_name_, container_id, nic_name)) {
         throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO,
                           fmt::format("Failed to store nic:{} on node:{}", nic_name, node_name_));
       }
       iface->setName(fmt::format("ohno_{}", helper::getShortHash(helper::getUniqueId(
                                                 IFNAMSIZ)))); // 创建 Pod 网卡时先使用一个临时网卡名
-      if (!iface->setup(netlink)) {
-        throw OHNO_CNIERR(7,
-                          fmt::format("Failed to create iface pair {}--{}", nic_name, veth_peer));
-      }
-      if (!iface->setNetns(netns)) {
-        throw OHNO_CNIERR(7, fmt::format("Failed to set iface {} netns", nic_name));
-      }
-      iface->rename(nic_name); // 创建完成并加入 Pod 之后再改名
-      iface->setStatus(net::LinkStatus::UP);
+      {
+        PhaseTimer timer{trace_.get(), CniTrace::Phase::veth};
+        // 优先领取 ohnod 预先创建并已插入 bridge 的 veth pair，池为空时再自己创建
+        auto pooled = veth->claim(netlink, conf_.bridge_);
+        if (!pooled && !iface->setup(netlink)) {
+          throw OHNO_CNIERR(
+              7, fmt::format("Failed to create iface pair {}--{}", nic_name, veth_peer));
+        }
+        if (!iface->setNetns(netns)) {
+          throw OHNO_CNIERR(7, fmt::format("Failed to set iface {} netns", nic_name));
+        }
+        iface->rename(nic_name); // 创建完成并加入 Pod 之后再改名
+        iface->setStatus(net::LinkStatus::UP);
 
-      // 获取节点 Linux bridge，将 veth 宿主机一端插入 bridge
-      nicPluginBridge(veth_peer);
+        // 获取节点 Linux bridge，将 veth 宿主机一端插入 bridge
+        if (!pooled) {
+          nicPluginBridge(veth_peer);
+        }
+      }
 
       // 配置 Pod 网络
       configPodNetwork(iface, nic_name, container_id);
@@ -833,15 +1162,15 @@ auto Cni::delKubernetesNic(const std::shared_ptr<ipam::NetnsIf> &pod, std::strin
 
   auto iface = getKubernetesNic(pod, nic_name, false);
   if (iface) {
-    const auto *addr_obj = iface->getAddr();
-    std::string pod_addr = addr_obj != nullptr ? addr_obj->getAddrCidr() : std::string{};
+    std::vector<std::string> pod_addrs{};
+    for (const auto *addr_obj : iface->getAllAddrs()) {
+      pod_addrs.emplace_back(addr_obj->getAddrCidr());
+    }
     iface->cleanup();
     auto pod_name = pod->getName();
     OHNO_ASSERT(!pod_name.empty()); // 从持久化还原集群对象的时候保证会设置 pod 名称
     if (!(pod_name == ipam::HOST && iface->getName() == node_underlay_dev_)) {
-      if (!ipam_->releaseIp(node_name_, pod_addr)) {
-        OHNO_LOG(warn, "Failed to release pod address:{} to IPAM", pod_addr);
-      }
+      released_ips_.insert(released_ips_.end(), pod_addrs.begin(), pod_addrs.end());
     }
     if (!storage_->delAddr(node_name_, pod_name, nic_name)) {
       throw OHNO_CNIERR(
@@ -857,12 +1186,6 @@ auto Cni::delKubernetesNic(const std::shared_ptr<ipam::NetnsIf> &pod, std::strin
       throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO,
                         fmt::format("Failed to delete nic:{} on node:{}", nic_name, node_name_));
     }
-    if (ipam_mode_ == cni::CniConfigIpam::Mode::vxlan) {
-      if (!storage_->delVtep(node_name_)) {
-        throw OHNO_CNIERR(cni::CNI_ERRCODE_OHNO,
-                          fmt::format("Failed to delete vtep on node:{}", node_name_));
-      }
-    }
     pod->delNic(nic_name);
   }
 }
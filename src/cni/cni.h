@@ -4,8 +4,12 @@
 #include <memory>
 #include "cni_config.h"
 #include "cni_if.h"
+#include "cni_trace.h"
+#include "node_idle.h"
 #include "storage_if.h"
 #include "src/backend/center_if.h"
+#include "src/etcd/change_log.h"
+#include "src/ipam/arena.h"
 #include "src/ipam/cluster_if.h"
 #include "src/ipam/ipam_if.h"
 #include "src/log/logger.h"
@@ -28,21 +32,33 @@ public:
   auto setIpam(std::unique_ptr<ipam::IpamIf> ipam) -> bool;
   auto setStorage(std::unique_ptr<StorageIf> storage) -> bool;
   auto setCenter(std::unique_ptr<backend::CenterIf> center) -> bool;
+  auto setNodeInfo(std::string_view node_name, std::string_view underlay_dev,
+                   std::string_view underlay_addr) -> void;
+  auto setChangeLog(std::shared_ptr<etcd::ChangeLog> change_log) -> void;
+  auto setNodeIdlePath(std::string_view path) -> void;
 
   auto add(std::string_view container_id, std::string_view netns, std::string_view nic_name)
       -> std::string override;
   auto del(std::string_view container_id, std::string_view nic_name) noexcept -> void override;
   auto version() const -> std::string override;
+  auto reclaim() noexcept -> bool;
 
 private:
+  auto initNodeInfo() -> void;
+  auto beginStorage() -> void;
+  auto commitStorage() -> bool;
+  auto rollbackIpam() -> void;
+  auto logChanges(std::string_view command) const -> void;
   auto getStorageNic(std::string_view pod, std::string_view nic,
-                     const std::weak_ptr<net::NetlinkIf> &netlink) -> std::shared_ptr<net::NicIf>;
+                     const std::weak_ptr<net::NetlinkIf> &netlink,
+                     const std::shared_ptr<ipam::Arena> &arena) -> std::shared_ptr<net::NicIf>;
   auto initKubernetesNode(const std::shared_ptr<ipam::NodeIf> &node, std::string_view node_subnet)
       -> void;
   auto getKubernetesCluster(const std::weak_ptr<net::NetlinkIf> &netlink)
       -> std::unique_ptr<ipam::ClusterIf>;
-  auto getBridge(const std::weak_ptr<net::NetlinkIf> &netlink, std::string_view bridge_addr)
-      -> std::shared_ptr<net::NicIf>;
+  auto getBridge(const std::weak_ptr<net::NetlinkIf> &netlink,
+                 const std::vector<std::string> &bridge_addrs) -> std::shared_ptr<net::NicIf>;
+  auto getGateway(net::IpVersion version) const -> const net::AddrIf *;
   auto getVxlan(const std::weak_ptr<net::NetlinkIf> &netlink, std::string_view node_subnet)
       -> std::shared_ptr<net::NicIf>;
   auto getRootPod(const std::shared_ptr<ipam::NodeIf> &node,
@@ -55,6 +71,7 @@ private:
                                bool create = false) -> std::shared_ptr<ipam::NetnsIf>;
   auto delKubernetesPod(const std::shared_ptr<ipam::NodeIf> &node, std::string_view pod_name)
       -> void;
+  auto delKubernetesNode(const std::shared_ptr<ipam::NodeIf> &node) -> void;
   auto nicPluginBridge(std::string_view nic_name) -> void;
   auto configPodNetwork(const std::shared_ptr<net::NicIf> &nic, std::string_view nic_name,
                         std::string_view container_id) -> void;
@@ -73,9 +90,18 @@ private:
   std::string node_name_;
   std::string node_underlay_dev_;
   std::string node_underlay_addr_;
-  std::unique_ptr<net::AddrIf> gateway_;
+  std::vector<std::unique_ptr<net::AddrIf>> gateways_; // 双栈节点每个地址族各一个网关
   CniConfigIpam::Mode ipam_mode_;
   std::unique_ptr<backend::CenterIf> center_;
+  std::unique_ptr<CniTrace> trace_; // 未开启追踪时为空，计时器不读时钟
+  std::shared_ptr<etcd::ChangeLog> change_log_; // IPAM 与 Storage 的 ETCD 客户端共享
+  std::string node_idle_path_{PATH_NODE_IDLE};
+
+  // 本次调用对 IPAM 的改动，随持久化事务一起生效：提交失败时归还新分配的地址，
+  // 删除记录引用的地址与子网在提交成功之后才归还
+  std::vector<std::string> allocated_ips_;
+  std::vector<std::string> released_ips_;
+  std::string released_subnet_;
 };
 
 } // namespace cni
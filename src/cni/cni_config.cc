@@ -14,11 +14,19 @@ void from_json(const nlohmann::json &json, CniConfigIpam &ipam) {
     auto mode = stringEnum<CniConfigIpam::Mode>(json.at(JKEY_CNI_CCI_MODE).get<std::string>());
     ipam.mode_ = mode.has_value() ? mode.value() : CniConfigIpam::Mode::host_gw;
   }
+  if (json.contains(JKEY_CNI_CCI_BLOCKSIZE)) {
+    ipam.block_size_ = json.at(JKEY_CNI_CCI_BLOCKSIZE).get<size_t>();
+  }
+  if (json.contains(JKEY_CNI_CCI_JOURNALSIZE)) {
+    ipam.journal_size_ = json.at(JKEY_CNI_CCI_JOURNALSIZE).get<size_t>();
+  }
 }
 
 void to_json(nlohmann::json &json, const CniConfigIpam &ipam) {
   json = nlohmann::json{{JKEY_CNI_CCI_SUBNET, ipam.subnet_},
-                        {JKEY_CNI_CCI_MODE, enumName(ipam.mode_)}};
+                        {JKEY_CNI_CCI_MODE, enumName(ipam.mode_)},
+                        {JKEY_CNI_CCI_BLOCKSIZE, ipam.block_size_},
+                        {JKEY_CNI_CCI_JOURNALSIZE, ipam.journal_size_}};
 }
 
 void from_json(const nlohmann::json &json, CniConfig &conf) {
@@ -44,6 +52,12 @@ void from_json(const nlohmann::json &json, CniConfig &conf) {
   if (json.contains(JKEY_CNI_CC_SSL)) {
     conf.ssl_ = json.at(JKEY_CNI_CC_SSL).get<bool>();
   }
+  if (json.contains(JKEY_CNI_CC_NODEIDLETIMEOUT)) {
+    conf.node_idle_timeout_ = json.at(JKEY_CNI_CC_NODEIDLETIMEOUT).get<int64_t>();
+  }
+  if (json.contains(JKEY_CNI_CC_TRACE)) {
+    conf.trace_ = json.at(JKEY_CNI_CC_TRACE).get<bool>();
+  }
   if (json.contains(JKEY_CNI_CC_IPAM)) {
     conf.ipam_ = json.at(JKEY_CNI_CC_IPAM).get<CniConfigIpam>();
   }
@@ -57,6 +71,8 @@ void to_json(nlohmann::json &json, const CniConfig &conf) {
                         {JKEY_CNI_CC_LOG, conf.log_},
                         {JKEY_CNI_CC_LOGLEVEL, enumName(conf.loglevel_)},
                         {JKEY_CNI_CC_SSL, conf.ssl_},
+                        {JKEY_CNI_CC_NODEIDLETIMEOUT, conf.node_idle_timeout_},
+                        {JKEY_CNI_CC_TRACE, conf.trace_},
                         {JKEY_CNI_CC_IPAM, conf.ipam_}};
 }
 
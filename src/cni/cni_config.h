@@ -13,6 +13,8 @@ namespace cni {
 
 constexpr std::string_view JKEY_CNI_CCI_SUBNET{"subnet"};
 constexpr std::string_view JKEY_CNI_CCI_MODE{"mode"};
+constexpr std::string_view JKEY_CNI_CCI_BLOCKSIZE{"blockSize"};
+constexpr std::string_view JKEY_CNI_CCI_JOURNALSIZE{"journalSize"};
 constexpr std::string_view JKEY_CNI_CC_VERSION{"cniVersion"};
 constexpr std::string_view JKEY_CNI_CC_NAME{"name"};
 constexpr std::string_view JKEY_CNI_CC_TYPE{"type"};
@@ -20,6 +22,8 @@ constexpr std::string_view JKEY_CNI_CC_BRIDGE{"bridge"};
 constexpr std::string_view JKEY_CNI_CC_LOG{"log"};
 constexpr std::string_view JKEY_CNI_CC_LOGLEVEL{"logLevel"};
 constexpr std::string_view JKEY_CNI_CC_SSL{"ssl"};
+constexpr std::string_view JKEY_CNI_CC_NODEIDLETIMEOUT{"nodeIdleTimeout"};
+constexpr std::string_view JKEY_CNI_CC_TRACE{"trace"};
 constexpr std::string_view JKEY_CNI_CC_IPAM{"ipam"};
 
 constexpr std::string_view DEFAULT_CONF_VERSION{"0.3.1"};
@@ -27,6 +31,8 @@ constexpr std::string_view DEFAULT_CONF_NETNAME{"mynet"};
 constexpr std::string_view DEFAULT_CONF_PLUGINS_NAME{"ohno"};
 constexpr std::string_view DEFAULT_CONF_PLUGINS_BRIDGE{"ohnobr"};
 constexpr std::string_view DEFAULT_CONF_IPAM_SUBNET{"10.244.0.0/16"};
+constexpr size_t DEFAULT_CONF_IPAM_JOURNALSIZE{16};
+constexpr int64_t DEFAULT_CONF_NODE_IDLE_TIMEOUT{300};
 
 class CniConfigIpam final {
 public:
@@ -36,6 +42,8 @@ public:
 
   std::string subnet_{std::string{DEFAULT_CONF_IPAM_SUBNET}};
   Mode mode_{Mode::evpn};
+  size_t block_size_{0}; // 节点每次租用的地址数量（2 的幂），0 表示每次分配都直接写 ETCD
+  size_t journal_size_{DEFAULT_CONF_IPAM_JOURNALSIZE}; // 攒够多少条分配/归还记录后写回 ETCD
 };
 
 class CniConfig final {
@@ -50,6 +58,9 @@ public:
   std::string log_{log::LOGFILE_DEFAULT};  // 没错，我非常需要日志
   log::Level loglevel_{log::Level::debug}; // 还有日志等级
   bool ssl_{true};                         // 是否需要加密通信
+  // 最后一个 Pod 删除之后节点网络设施保留多少秒，0 表示立即删除，负数表示一直保留
+  int64_t node_idle_timeout_{DEFAULT_CONF_NODE_IDLE_TIMEOUT};
+  bool trace_{false}; // 是否记录每次调用的分阶段耗时，由 ohnod 汇总
   CniConfigIpam ipam_;
 };
 
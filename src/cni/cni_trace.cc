@@ -0,0 +1,212 @@
+// clang-format off
+#include "cni_trace.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include "spdlog/fmt/fmt.h"
+#include "src/common/enum_name.hpp"
+// clang-format on
+
+namespace ohno {
+namespace cni {
+
+void from_json(const nlohmann::json &json, CniTrace &trace) {
+  trace.command_ = json.at(JKEY_CNI_TRACE_COMMAND).get<std::string>();
+  trace.container_id_ = json.at(JKEY_CNI_TRACE_CONTAINER).get<std::string>();
+  trace.ok_ = json.at(JKEY_CNI_TRACE_OK).get<bool>();
+  trace.time_ = json.at(JKEY_CNI_TRACE_TIME).get<int64_t>();
+  trace.total_ = json.at(JKEY_CNI_TRACE_TOTAL).get<int64_t>();
+  trace.phases_.fill(0);
+  for (const auto &[name, elapsed] : json.at(JKEY_CNI_TRACE_PHASES).items()) {
+    auto phase = stringEnum<CniTrace::Phase>(name);
+    if (phase.has_value() && phase.value() != CniTrace::Phase::MAXSIZE) {
+      trace.phases_[static_cast<size_t>(phase.value())] = elapsed.get<int64_t>();
+    }
+  }
+}
+
+void to_json(nlohmann::json &json, const CniTrace &trace) {
+  auto phases = nlohmann::json::object();
+  for (size_t i = 0; i < trace.phases_.size(); ++i) {
+    if (trace.phases_[i] > 0) {
+      phases[std::string{enumName(static_cast<CniTrace::Phase>(i))}] = trace.phases_[i];
+    }
+  }
+  json = nlohmann::json{{JKEY_CNI_TRACE_COMMAND, trace.command_},
+                        {JKEY_CNI_TRACE_CONTAINER, trace.container_id_},
+                        {JKEY_CNI_TRACE_OK, trace.ok_},
+                        {JKEY_CNI_TRACE_TIME, trace.time_},
+                        {JKEY_CNI_TRACE_TOTAL, trace.total_},
+                        {JKEY_CNI_TRACE_PHASES, phases}};
+}
+
+/**
+ * @brief 累加阶段耗时（同一阶段可以分多段计时）
+ *
+ * @param phase 阶段
+ * @param elapsed 耗时
+ */
+auto CniTrace::add(Phase phase, std::chrono::microseconds elapsed) noexcept -> void {
+  if (phase != Phase::MAXSIZE) {
+    phases_[static_cast<size_t>(phase)] += elapsed.count();
+  }
+}
+
+/**
+ * @brief 在文件末尾追加一行记录；一行只有一次 write()，并发的 CNI 进程不会互相穿插
+ *
+ * @param path 记录文件路径
+ * @return true 追加成功
+ * @return false 打开失败、文件超过上限（ohnod 没有运行）或者写入失败
+ */
+auto CniTrace::save(std::string_view path) const -> bool {
+  std::error_code code{};
+  std::filesystem::create_directories(std::filesystem::path{path}.parent_path(), code);
+
+  auto fd = ::open(std::string{path}.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info {};
+  if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) >= CNI_TRACE_MAX_SIZE) {
+    ::close(fd);
+    return false;
+  }
+  auto line = fmt::format("{}\n", nlohmann::json(*this).dump());
+  auto ret = ::write(fd, line.data(), line.size());
+  ::close(fd);
+  return ret == static_cast<ssize_t>(line.size());
+}
+
+/**
+ * @brief 取走文件中的全部记录：先改名再读取，之后的 CNI 调用写入新的文件
+ *
+ * @param path 记录文件路径
+ * @return std::vector<CniTrace> 记录，损坏的行被忽略
+ */
+auto CniTrace::drain(std::string_view path) -> std::vector<CniTrace> {
+  std::vector<CniTrace> traces{};
+  auto drain_path = fmt::format("{}.drain", path);
+  if (std::rename(std::string{path}.c_str(), drain_path.c_str()) != 0) {
+    return traces; // 文件不存在，上个周期没有 CNI 调用
+  }
+
+  std::ifstream file{drain_path};
+  std::string line{};
+  while (std::getline(file, line)) {
+    try {
+      traces.emplace_back(nlohmann::json::parse(line).get<CniTrace>());
+    } catch (const std::exception &exc) {
+      OHNO_GLOBAL_LOG(warn, "Ignore broken CNI trace record \"{}\": {}", line, exc.what());
+    }
+  }
+  file.close();
+
+  std::error_code code{};
+  std::filesystem::remove(drain_path, code);
+  return traces;
+}
+
+PhaseTimer::PhaseTimer(CniTrace *trace, CniTrace::Phase phase) noexcept
+    : trace_{trace}, phase_{phase} {
+  if (trace_ != nullptr) {
+    start_ = std::chrono::steady_clock::now();
+  }
+}
+
+PhaseTimer::~PhaseTimer() {
+  if (trace_ != nullptr) {
+    trace_->add(phase_, std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - start_));
+  }
+}
+
+TraceScope::TraceScope(CniTrace *trace, std::string_view command,
+                       std::string_view container_id) noexcept
+    : trace_{trace} {
+  if (trace_ != nullptr) {
+    start_ = std::chrono::steady_clock::now();
+    trace_->command_ = command;
+    trace_->container_id_ = container_id;
+    trace_->time_ = std::chrono::duration_cast<std::chrono::seconds>(
+                        std::chrono::system_clock::now().time_since_epoch())
+                        .count();
+  }
+}
+
+TraceScope::~TraceScope() {
+  if (trace_ == nullptr) {
+    return;
+  }
+  trace_->total_ = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start_)
+                       .count();
+  if (!trace_->save()) {
+    OHNO_LOG(debug, "CNI trace record of {} is dropped", trace_->container_id_);
+  }
+}
+
+/**
+ * @brief 标记本次调用成功
+ *
+ */
+auto TraceScope::succeed() noexcept -> void {
+  if (trace_ != nullptr) {
+    trace_->ok_ = true;
+  }
+}
+
+/**
+ * @brief 汇总一条记录
+ *
+ * @param trace 记录
+ */
+auto CniTraceStats::add(const CniTrace &trace) -> void {
+  auto &stat = stats_[trace.command_];
+  ++stat.count_;
+  if (!trace.ok_) {
+    ++stat.failures_;
+  }
+  stat.total_sum_ += trace.total_;
+  stat.total_max_ = std::max(stat.total_max_, trace.total_);
+  for (size_t i = 0; i < trace.phases_.size(); ++i) {
+    stat.phase_sum_[i] += trace.phases_[i];
+    stat.phase_max_[i] = std::max(stat.phase_max_[i], trace.phases_[i]);
+  }
+}
+
+auto CniTraceStats::getStats() const noexcept -> const std::unordered_map<std::string, Stat> & {
+  return stats_;
+}
+
+/**
+ * @brief 输出每个命令的平均与最大耗时（毫秒），没有耗时的阶段不输出
+ *
+ * @return std::string 汇总文本，每个命令一行
+ */
+auto CniTraceStats::toString() const -> std::string {
+  auto toMs = [](int64_t us) { return static_cast<double>(us) / 1000; };
+
+  std::string out{};
+  for (const auto &[command, stat] : stats_) {
+    auto count = static_cast<int64_t>(std::max<uint64_t>(stat.count_, 1));
+    out += fmt::format("{} count:{} failures:{} total(avg/max):{:.1f}/{:.1f}ms", command,
+                       stat.count_, stat.failures_, toMs(stat.total_sum_ / count),
+                       toMs(stat.total_max_));
+    for (size_t i = 0; i < stat.phase_sum_.size(); ++i) {
+      if (stat.phase_max_[i] > 0) {
+        out += fmt::format(" {}:{:.1f}/{:.1f}ms", enumName(static_cast<CniTrace::Phase>(i)),
+                           toMs(stat.phase_sum_[i] / count), toMs(stat.phase_max_[i]));
+      }
+    }
+    out += "\n";
+  }
+  return out;
+}
+
+} // namespace cni
+} // namespace ohno
@@ -0,0 +1,122 @@
+#pragma once
+
+// clang-format off
+#include <array>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "nlohmann/json.hpp"
+#include "src/log/logger.h"
+// clang-format on
+
+namespace ohno {
+namespace cni {
+
+constexpr std::string_view PATH_CNI_TRACE{"/var/run/ohno/cni_trace.log"};
+constexpr size_t CNI_TRACE_MAX_SIZE{1 << 20}; // ohnod 没有及时取走时不再追加
+
+constexpr std::string_view JKEY_CNI_TRACE_COMMAND{"command"};
+constexpr std::string_view JKEY_CNI_TRACE_CONTAINER{"container"};
+constexpr std::string_view JKEY_CNI_TRACE_OK{"ok"};
+constexpr std::string_view JKEY_CNI_TRACE_TIME{"time"};
+constexpr std::string_view JKEY_CNI_TRACE_TOTAL{"total"};
+constexpr std::string_view JKEY_CNI_TRACE_PHASES{"phases"};
+
+/**
+ * @brief 一次 CNI 调用的分阶段耗时记录（微秒），每次调用在节点本地文件中追加一行 json，
+ * 由 ohnod 取走并汇总
+ */
+class CniTrace final {
+public:
+  enum class Phase : uint8_t {
+    discovery, // 探测节点信息
+    cluster,   // 从 ETCD 读取集群
+    node,      // 获取或创建节点网络设施
+    ipam,      // 分配 Pod 地址
+    veth,      // 创建或领取 veth pair，移入 netns 并插入 bridge（DEL 时为删除网卡）
+    config,    // 配置 Pod 地址与路由
+    storage,   // 提交 ETCD 事务
+    encode,    // 生成 CNI 结果
+    MAXSIZE
+  };
+  friend void from_json(const nlohmann::json &json, CniTrace &trace);
+  friend void to_json(nlohmann::json &json, const CniTrace &trace);
+
+  auto add(Phase phase, std::chrono::microseconds elapsed) noexcept -> void;
+  auto save(std::string_view path = PATH_CNI_TRACE) const -> bool;
+  static auto drain(std::string_view path = PATH_CNI_TRACE) -> std::vector<CniTrace>;
+
+  std::string command_;
+  std::string container_id_;
+  bool ok_{false};
+  int64_t time_{0};  // 调用开始时间，unix 时间戳（秒）
+  int64_t total_{0}; // 整个调用的耗时
+  std::array<int64_t, static_cast<size_t>(Phase::MAXSIZE)> phases_{};
+};
+
+/**
+ * @brief 阶段计时器，析构时把经过的时间累加到记录中；记录为空（未开启追踪）时不读时钟
+ *
+ */
+class PhaseTimer final {
+public:
+  PhaseTimer(CniTrace *trace, CniTrace::Phase phase) noexcept;
+  ~PhaseTimer();
+  PhaseTimer(const PhaseTimer &) = delete;
+  PhaseTimer(PhaseTimer &&) = delete;
+  auto operator=(const PhaseTimer &) -> PhaseTimer & = delete;
+  auto operator=(PhaseTimer &&) -> PhaseTimer & = delete;
+
+private:
+  CniTrace *trace_;
+  CniTrace::Phase phase_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief 一次 CNI 调用的追踪范围：构造时开始计时，析构时写入记录（无论调用成功与否）
+ *
+ */
+class TraceScope final : public log::Loggable<log::Id::cni> {
+public:
+  TraceScope(CniTrace *trace, std::string_view command, std::string_view container_id) noexcept;
+  ~TraceScope() override;
+  TraceScope(const TraceScope &) = delete;
+  TraceScope(TraceScope &&) = delete;
+  auto operator=(const TraceScope &) -> TraceScope & = delete;
+  auto operator=(TraceScope &&) -> TraceScope & = delete;
+
+  auto succeed() noexcept -> void;
+
+private:
+  CniTrace *trace_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief CNI 调用耗时的汇总（ohnod），按命令分别统计次数、失败次数以及每个阶段的总耗时与最大耗时
+ *
+ */
+class CniTraceStats final {
+public:
+  struct Stat {
+    uint64_t count_{0};
+    uint64_t failures_{0};
+    int64_t total_sum_{0};
+    int64_t total_max_{0};
+    std::array<int64_t, static_cast<size_t>(CniTrace::Phase::MAXSIZE)> phase_sum_{};
+    std::array<int64_t, static_cast<size_t>(CniTrace::Phase::MAXSIZE)> phase_max_{};
+  };
+
+  auto add(const CniTrace &trace) -> void;
+  auto getStats() const noexcept -> const std::unordered_map<std::string, Stat> &;
+  auto toString() const -> std::string;
+
+private:
+  std::unordered_map<std::string, Stat> stats_; // key 为 CNI 命令
+};
+
+} // namespace cni
+} // namespace ohno
@@ -0,0 +1,103 @@
+// clang-format off
+#include "node_idle.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include "spdlog/fmt/fmt.h"
+// clang-format on
+
+namespace ohno {
+namespace cni {
+
+/**
+ * @brief 对 "<path>.lock" 加排他锁（阻塞直到其他进程释放）
+ *
+ * @param path 标记文件路径
+ */
+NodeIdle::NodeIdle(std::string_view path)
+    : path_{path}, lock_{fmt::format("{}.lock", path), "node_idle"} {}
+
+/**
+ * @brief 是否已经持有锁
+ *
+ * @return true 已加锁
+ * @return false 加锁失败
+ */
+auto NodeIdle::isLocked() const noexcept -> bool { return lock_.isLocked(); }
+
+/**
+ * @brief 标记节点开始空闲（已经标记过时保留原来的时间）
+ *
+ * @return true 标记成功
+ * @return false 写入失败
+ */
+auto NodeIdle::mark() const -> bool {
+  if (getIdleTime().has_value()) {
+    return true;
+  }
+
+  auto now = std::chrono::duration_cast<std::chrono::seconds>(
+      std::chrono::system_clock::now().time_since_epoch());
+  std::ofstream file{path_, std::ios::trunc};
+  if (!file.is_open()) {
+    OHNO_LOG(warn, "Failed to open node idle file {}", path_);
+    return false;
+  }
+  file << now.count();
+  return static_cast<bool>(file.flush());
+}
+
+/**
+ * @brief 清除空闲标记
+ *
+ * @return true 清除成功或标记不存在
+ * @return false 清除失败
+ */
+auto NodeIdle::clear() const -> bool {
+  std::error_code code{};
+  std::filesystem::remove(path_, code);
+  return !code;
+}
+
+/**
+ * @brief 获取节点已经空闲的时长
+ *
+ * @return std::optional<std::chrono::seconds> 空闲时长，节点没有空闲时为空
+ */
+auto NodeIdle::getIdleTime() const -> std::optional<std::chrono::seconds> {
+  return readIdleTime(path_);
+}
+
+/**
+ * @brief 不加锁判断节点空闲是否已经超过宽限期（用于 ohnod 轮询，回收前需要加锁重新确认）
+ *
+ * @param timeout 宽限期
+ * @param path 标记文件路径
+ * @return true 已经超过宽限期
+ * @return false 节点没有空闲或者仍在宽限期内
+ */
+auto NodeIdle::isExpired(std::chrono::seconds timeout, std::string_view path) -> bool {
+  auto idle = readIdleTime(std::string{path});
+  return idle.has_value() && idle.value() >= timeout;
+}
+
+/**
+ * @brief 读取标记文件，计算已经空闲的时长
+ *
+ * @param path 标记文件路径
+ * @return std::optional<std::chrono::seconds> 空闲时长，文件不存在或损坏时为空
+ */
+auto NodeIdle::readIdleTime(const std::string &path) -> std::optional<std::chrono::seconds> {
+  std::ifstream file{path};
+  int64_t since = 0;
+  if (!file.is_open() || !(file >> since)) {
+    return std::nullopt;
+  }
+
+  auto now = std::chrono::duration_cast<std::chrono::seconds>(
+      std::chrono::system_clock::now().time_since_epoch());
+  return std::max(now - std::chrono::seconds{since}, std::chrono::seconds{0});
+}
+
+} // namespace cni
+} // namespace ohno
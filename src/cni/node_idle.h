@@ -0,0 +1,49 @@
+#pragma once
+
+// clang-format off
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "src/log/logger.h"
+#include "src/util/file_lock.h"
+// clang-format on
+
+namespace ohno {
+namespace cni {
+
+constexpr std::string_view PATH_NODE_IDLE{"/var/run/ohno/node_idle"};
+
+/**
+ * @brief 节点空闲标记：最后一个 Pod 删除之后，节点级别的网络设施（bridge、VTEP、子网）暂不
+ * 删除，只记录开始空闲的时间，超过宽限期仍然没有 Pod 时再由 ohnod 回收
+ *
+ * 构造时对 "<path>.lock" 加排他锁，CNI ADD 在读取集群之前清除标记，回收在持锁期间重新确认
+ * 标记仍然存在，两者不会交错
+ */
+class NodeIdle final : public log::Loggable<log::Id::cni> {
+public:
+  explicit NodeIdle(std::string_view path = PATH_NODE_IDLE);
+  ~NodeIdle() override = default;
+  NodeIdle(const NodeIdle &) = delete;
+  NodeIdle(NodeIdle &&) = delete;
+  auto operator=(const NodeIdle &) -> NodeIdle & = delete;
+  auto operator=(NodeIdle &&) -> NodeIdle & = delete;
+
+  auto isLocked() const noexcept -> bool;
+  auto mark() const -> bool;
+  auto clear() const -> bool;
+  auto getIdleTime() const -> std::optional<std::chrono::seconds>;
+
+  static auto isExpired(std::chrono::seconds timeout, std::string_view path = PATH_NODE_IDLE)
+      -> bool;
+
+private:
+  static auto readIdleTime(const std::string &path) -> std::optional<std::chrono::seconds>;
+
+  std::string path_;
+  util::FileLock lock_;
+};
+
+} // namespace cni
+} // namespace ohno
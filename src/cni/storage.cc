@@ -1,7 +1,10 @@
 // clang-format off
 #include "storage.h"
+#include <algorithm>
+#include <thread>
 #include "spdlog/fmt/fmt.h"
 #include "src/common/assert.h"
+#include "src/etcd/node_lease.h"
 #include "src/net/addr.h"
 #include "src/net/nic.h"
 #include "src/net/route.h"
@@ -16,12 +19,13 @@ namespace cni {
  * @brief 持久化初始化
  *
  * @param etcd_client Etcd 客户端
+ * @param check_health 是否立即检查 ETCD 健康，不检查时由第一次访问 ETCD 时发现故障
  * @return true 初始化成功
  * @return false 初始化失败
  */
-auto Storage::init(std::unique_ptr<etcd::EtcdClientIf> etcd_client) -> bool {
+auto Storage::init(std::unique_ptr<etcd::EtcdClientIf> etcd_client, bool check_health) -> bool {
   etcd_client_ = std::move(etcd_client);
-  if (etcd_client_ == nullptr || !etcd_client_->test()) {
+  if (etcd_client_ == nullptr || (check_health && !etcd_client_->test())) {
     OHNO_LOG(warn, "ETCD client initialization failed");
     return false;
   }
@@ -38,6 +42,56 @@ auto Storage::dump() const -> std::string {
   return etcd_client_->dump(ETCD_KEY_PREFIX_NODE);
 }
 
+/**
+ * @brief 进入批量模式，之后的写操作先缓存起来，直到 commitBatch() 一次性原子提交，
+ * 避免 CNI 进程中途退出时留下不完整的 Pod 记录；批量模式下的读操作能读到尚未提交的写入
+ *
+ */
+auto Storage::beginBatch() -> void { batch_.emplace(); }
+
+/**
+ * @brief 提交批量模式下缓存的写操作并退出批量模式
+ *
+ * 列表 key（Pod、网卡、地址、路由列表）在提交时读取 ETCD 当前值与 mod_revision，展开追加与
+ * 删除之后写入，事务比较 mod_revision 没有变化；同一节点上并发的 ADD/DEL 修改了同一个列表时
+ * 事务不生效，重新读取之后再提交，不会互相覆盖
+ *
+ * @return true 提交成功（不在批量模式或者没有写操作时也返回成功）
+ * @return false 提交失败，所有写操作都没有生效
+ */
+auto Storage::commitBatch() -> bool {
+  OHNO_ASSERT(etcd_client_);
+  if (!batch_.has_value()) {
+    return true;
+  }
+
+  auto result = etcd::TxnResult::failed;
+  etcd::EtcdTxn txn{};
+  for (int attempt = 1; attempt <= STORAGE_COMMIT_ATTEMPTS; ++attempt) {
+    txn.clear();
+    if (!buildTxn(txn)) {
+      result = etcd::TxnResult::failed;
+      break;
+    }
+    result = etcd_client_->commit(txn);
+    if (result != etcd::TxnResult::conflicted) {
+      break;
+    }
+    OHNO_LOG(debug, "Storage transaction conflicted on attempt {}, retrying", attempt);
+    std::this_thread::sleep_for(etcd::getTxnBackoff(attempt));
+  }
+  auto ops = batch_->size();
+  batch_.reset();
+
+  if (result != etcd::TxnResult::committed) {
+    OHNO_LOG(warn, "Storage failed to commit {} operations{}", ops,
+             result == etcd::TxnResult::conflicted ? " after repeated conflicts" : "");
+    return false;
+  }
+  OHNO_LOG(trace, "Storage committed {} operations", txn.size());
+  return true;
+}
+
 /**
  * @brief 将 Pod 对应的 namespace 信息持久化
  *
@@ -55,7 +109,7 @@ auto Storage::addNetns(std::string_view node_name, std::string_view pod_name,
   OHNO_ASSERT(etcd_client_);
 
   auto key = Storage::getNetnsKey(node_name, pod_name);
-  if (etcd_client_->put(key, netns_name)) { // 一个 Pod 容器只对应一个 namespace，用 put
+  if (putValue(key, netns_name)) { // 一个 Pod 容器只对应一个 namespace，用 put
     OHNO_LOG(trace, "Storage add namespace:{} for Pod:{} of Kubernetes node:{}", netns_name,
              pod_name, node_name);
     return true;
@@ -75,7 +129,7 @@ auto Storage::delNetns(std::string_view node_name, std::string_view pod_name) ->
   OHNO_ASSERT(!node_name.empty());
   OHNO_ASSERT(!pod_name.empty());
   OHNO_ASSERT(etcd_client_);
-  if (etcd_client_->del(Storage::getNetnsKey(node_name, pod_name))) {
+  if (delValue(Storage::getNetnsKey(node_name, pod_name))) {
     OHNO_LOG(trace, "Storage del namespace for Pod:{} of Kubernetes node:{}", pod_name, node_name);
     return true;
   }
@@ -96,7 +150,7 @@ auto Storage::getNetns(std::string_view node_name, std::string_view pod_name) co
 
   std::string ret{};
   auto key = Storage::getNetnsKey(node_name, pod_name);
-  etcd_client_->get(key, ret); // 一个 Pod 容器只对应一个 namespace，用 get
+  getValue(key, ret); // 一个 Pod 容器只对应一个 namespace，用 get
   return ret;
 }
 
@@ -117,9 +171,9 @@ auto Storage::addPod(std::string_view node_name, std::string_view netns_name,
   OHNO_ASSERT(etcd_client_);
 
   auto key = Storage::getSinglePodKey(node_name, netns_name);
-  if (etcd_client_->put(key, pod_name)) { // 一个 namespace 只对应一个 Pod 容器，用 put
+  if (putValue(key, pod_name)) { // 一个 namespace 只对应一个 Pod 容器，用 put
     key = Storage::getAllPodsKey(node_name);
-    if (etcd_client_->append(key, pod_name)) {
+    if (appendValue(key, pod_name)) {
       OHNO_LOG(trace, "Storage add Pod:{} for namespace:{} of Kubernetes node:{}", pod_name,
                netns_name, node_name);
       return true;
@@ -143,10 +197,10 @@ auto Storage::delPod(std::string_view node_name, std::string_view netns_name) ->
 
   auto key = Storage::getSinglePodKey(node_name, netns_name);
   std::string pod_name{};
-  if (etcd_client_->get(key, pod_name)) {
-    if (etcd_client_->del(key)) {
+  if (getValue(key, pod_name)) {
+    if (delValue(key)) {
       key = Storage::getAllPodsKey(node_name);
-      if (etcd_client_->del(key, pod_name)) {
+      if (delValue(key, pod_name)) {
         OHNO_LOG(trace, "Storage del namespace:{} of Kubernetes node:{}", netns_name, node_name);
         return true;
       }
@@ -169,7 +223,7 @@ auto Storage::getPod(std::string_view node_name, std::string_view netns_name) ->
 
   std::string ret{};
   auto key = Storage::getSinglePodKey(node_name, netns_name);
-  etcd_client_->get(key, ret); // 一个 namespace 只对应一个 Pod 容器，用 get
+  getValue(key, ret); // 一个 namespace 只对应一个 Pod 容器，用 get
   return ret;
 }
 
@@ -183,10 +237,32 @@ auto Storage::getAllPods(std::string_view node_name) const -> std::vector<std::s
   OHNO_ASSERT(!node_name.empty());
   OHNO_ASSERT(etcd_client_);
 
-  std::vector<std::string> vec{};
-  auto key = Storage::getAllPodsKey(node_name);
-  etcd_client_->list(key, vec);
-  return vec;
+  return listValue(Storage::getAllPodsKey(node_name));
+}
+
+/**
+ * @brief 检查 Pod 当前是否仍然持久化
+ *
+ * @note 总是读取 ETCD 的当前值，不经过读缓存，也不叠加批量模式下尚未提交的写操作；
+ * 用于确认之前读到的 Pod 列表是否已经被并发的 CNI DEL 修改
+ *
+ * @param node_name Kubernetes 节点名称
+ * @param pod_name Pod 名称
+ * @return true Pod 仍在列表中，或者读取失败（无法确认已经删除）
+ * @return false Pod 已经不在列表中
+ */
+auto Storage::hasPod(std::string_view node_name, std::string_view pod_name) const -> bool {
+  OHNO_ASSERT(!node_name.empty());
+  OHNO_ASSERT(!pod_name.empty());
+  OHNO_ASSERT(etcd_client_);
+
+  std::string pods{};
+  int64_t revision{0};
+  if (!etcd_client_->get(Storage::getAllPodsKey(node_name), pods, revision)) {
+    return true;
+  }
+  auto names = helper::split(pods, ',');
+  return std::find(names.begin(), names.end(), pod_name) != names.end();
 }
 
 /**
@@ -206,7 +282,7 @@ auto Storage::addNic(std::string_view node_name, std::string_view pod_name,
   OHNO_ASSERT(etcd_client_);
 
   auto key = Storage::getNicKey(node_name, pod_name);
-  if (etcd_client_->append(key, nic_name)) {
+  if (appendValue(key, nic_name)) {
     OHNO_LOG(trace, "Storage add NIC:{} for Pod:{} of Kubernetes node:{}", nic_name, pod_name,
              node_name);
     return true;
@@ -229,7 +305,7 @@ auto Storage::delNic(std::string_view node_name, std::string_view pod_name,
   OHNO_ASSERT(!pod_name.empty());
   OHNO_ASSERT(!nic_name.empty());
   OHNO_ASSERT(etcd_client_);
-  if (etcd_client_->del(Storage::getNicKey(node_name, pod_name), nic_name)) {
+  if (delValue(Storage::getNicKey(node_name, pod_name), nic_name)) {
     OHNO_LOG(trace, "Storage del NIC:{} for Pod:{} of Kubernetes node:{}", nic_name, pod_name,
              node_name);
     return true;
@@ -250,10 +326,7 @@ auto Storage::getAllNic(std::string_view node_name, std::string_view pod_name) c
   OHNO_ASSERT(!pod_name.empty());
   OHNO_ASSERT(etcd_client_);
 
-  std::vector<std::string> vec{};
-  auto key = Storage::getNicKey(node_name, pod_name);
-  etcd_client_->list(key, vec);
-  return vec;
+  return listValue(Storage::getNicKey(node_name, pod_name));
 }
 
 /**
@@ -278,7 +351,7 @@ auto Storage::addAddr(std::string_view node_name, std::string_view pod_name,
 
   auto key = Storage::getAddrKey(node_name, pod_name, nic_name);
   auto addr_str = addr->getAddrCidr();
-  if (etcd_client_->append(key, addr_str)) {
+  if (appendValue(key, addr_str)) {
     OHNO_LOG(trace, "Storage add Addr:{} for NIC:{} for Pod:{} of Kubernetes node:{}", addr_str,
              nic_name, pod_name, node_name);
     return true;
@@ -301,7 +374,7 @@ auto Storage::delAddr(std::string_view node_name, std::string_view pod_name,
   OHNO_ASSERT(!pod_name.empty());
   OHNO_ASSERT(!nic_name.empty());
   OHNO_ASSERT(etcd_client_);
-  if (etcd_client_->del(Storage::getAddrKey(node_name, pod_name, nic_name))) {
+  if (delValue(Storage::getAddrKey(node_name, pod_name, nic_name))) {
     OHNO_LOG(trace, "Storage del Addr for NIC:{} for Pod:{} of Kubernetes node:{}", nic_name,
              pod_name, node_name);
     return true;
@@ -324,10 +397,7 @@ auto Storage::getAllAddrs(std::string_view node_name, std::string_view pod_name,
   OHNO_ASSERT(!nic_name.empty());
   OHNO_ASSERT(etcd_client_);
 
-  auto key = Storage::getAddrKey(node_name, pod_name, nic_name);
-  std::vector<std::string> vec{};
-  etcd_client_->list(key, vec);
-  return vec;
+  return listValue(Storage::getAddrKey(node_name, pod_name, nic_name));
 }
 
 /**
@@ -355,7 +425,7 @@ auto Storage::addRoute(std::string_view node_name, std::string_view pod_name,
   auto via = route->getVia();
   auto dev = route->getDev();
   auto value = Storage::getRouteValue(dest, via, dev);
-  if (etcd_client_->append(key, value)) {
+  if (appendValue(key, value)) {
     OHNO_LOG(
         trace,
         "Storage add Route:(dest:{}, via:{}, dev:{}) for NIC:{} for Pod:{} of Kubernetes node:{}",
@@ -380,7 +450,7 @@ auto Storage::delRoute(std::string_view node_name, std::string_view pod_name,
   OHNO_ASSERT(!pod_name.empty());
   OHNO_ASSERT(!nic_name.empty());
   OHNO_ASSERT(etcd_client_);
-  if (etcd_client_->del(Storage::getRouteKey(node_name, pod_name, nic_name))) {
+  if (delValue(Storage::getRouteKey(node_name, pod_name, nic_name))) {
     OHNO_LOG(trace, "Storage del Route for NIC:{} for Pod:{} of Kubernetes node:{}", nic_name,
              pod_name, node_name);
     return true;
@@ -404,16 +474,25 @@ auto Storage::getAllRoutes(std::string_view node_name, std::string_view pod_name
   OHNO_ASSERT(!nic_name.empty());
   OHNO_ASSERT(etcd_client_);
 
-  auto key = Storage::getRouteKey(node_name, pod_name, nic_name);
-  std::vector<std::string> vec{};
-  etcd_client_->list(key, vec);
-
+  std::string out{};
   std::vector<std::unique_ptr<net::RouteIf>> ret{};
-  for (const auto &item : vec) {
+  if (!getValue(Storage::getRouteKey(node_name, pod_name, nic_name), out)) {
+    return ret;
+  }
+
+  // 直接在 value 上切分，不为每条路由与每个字段分配字符串
+  helper::Tokenizer items{out, ','};
+  std::string_view item{};
+  while (items.next(item)) {
     // TODO: 单元测试验证下 空-空-空 会怎样
-    auto route = helper::split(item, SEPARATOR); // 0:dest, 1:via, 2:dev
-    OHNO_ASSERT(route.size() == 3);
-    ret.emplace_back(std::make_unique<net::Route>(route[0], route[1], route[2]));
+    helper::Tokenizer fields{item, SEPARATOR};
+    std::string_view dest{};
+    std::string_view via{};
+    std::string_view dev{};
+    std::string_view extra{};
+    auto parsed = fields.next(dest) && fields.next(via) && fields.next(dev) && !fields.next(extra);
+    OHNO_ASSERT(parsed); // dest-via-dev
+    ret.emplace_back(std::make_unique<net::Route>(dest, via, dev));
   }
   return ret;
 }
@@ -434,9 +513,10 @@ auto Storage::addVtep(std::string_view node_name, std::string_view vtep_addr,
   OHNO_ASSERT(!vtep_mac.empty());
   OHNO_ASSERT(etcd_client_);
 
+  // VTEP 绑定节点租约，节点宕机后自动删除，其他节点随之删除隧道表项
   auto key = Storage::getVtepKey(node_name);
   auto value = Storage::getVtepValue(vtep_addr, vtep_mac);
-  if (etcd_client_->put(key, value)) {
+  if (putValue(key, value, etcd::NodeLease::getLeaseId(*etcd_client_, node_name))) {
     OHNO_LOG(trace, "Storage add VTEP:{} of Kubernetes node:{}", value, node_name);
     return true;
   }
@@ -453,7 +533,7 @@ auto Storage::addVtep(std::string_view node_name, std::string_view vtep_addr,
 auto Storage::delVtep(std::string_view node_name) -> bool {
   OHNO_ASSERT(!node_name.empty());
   OHNO_ASSERT(etcd_client_);
-  if (etcd_client_->del(Storage::getVtepKey(node_name))) {
+  if (delValue(Storage::getVtepKey(node_name))) {
     OHNO_LOG(trace, "Storage del VTEP of Kubernetes node:{}", node_name);
     return true;
   }
@@ -477,8 +557,8 @@ auto Storage::getVtep(std::string_view node_name, std::string &vtep_addr,
 
   std::string ret{};
   auto key = Storage::getVtepKey(node_name);
-  if (etcd_client_->get(key, ret)) {
-    auto array = helper::split(ret, SEPARATOR); // 0:addr, 1:mac
+  if (getValue(key, ret)) {
+    auto array = helper::splitView(ret, SEPARATOR); // 0:addr, 1:mac
     if (!array.empty()) {
       OHNO_ASSERT(array.size() == 2);
       vtep_addr = array[0];
@@ -487,6 +567,198 @@ auto Storage::getVtep(std::string_view node_name, std::string &vtep_addr,
   }
 }
 
+/**
+ * @brief 设置一个 key-value，批量模式下只记录操作
+ *
+ * @param key ETCD key
+ * @param value ETCD value
+ * @param lease_id 租约 ID（为空时不绑定租约）
+ * @return true 成功
+ * @return false 失败
+ */
+auto Storage::putValue(std::string_view key, std::string_view value, std::string_view lease_id)
+    -> bool {
+  if (batch_.has_value()) {
+    batch_->emplace_back(BatchOp{BatchOp::Type::put, std::string{key}, std::string{value},
+                                 std::string{lease_id}});
+    return true;
+  }
+  return etcd_client_->put(key, value, lease_id);
+}
+
+/**
+ * @brief 在以 ',' 分割的 value 列表末尾追加一个值，批量模式下只记录操作，提交时再读取列表
+ *
+ * @param key ETCD key
+ * @param value 追加的值
+ * @return true 成功
+ * @return false 失败
+ */
+auto Storage::appendValue(std::string_view key, std::string_view value) -> bool {
+  if (!batch_.has_value()) {
+    return etcd_client_->append(key, value);
+  }
+  batch_->emplace_back(BatchOp{BatchOp::Type::append, std::string{key}, std::string{value}, {}});
+  return true;
+}
+
+/**
+ * @brief 获取一个 value，批量模式下在 ETCD 的值上叠加尚未提交的写操作
+ *
+ * @param key ETCD key
+ * @param value ETCD value（返回值，key 不存在时为空）
+ * @return true 成功
+ * @return false 失败
+ */
+auto Storage::getValue(std::string_view key, std::string &value) const -> bool {
+  if (!batch_.has_value()) {
+    return etcd_client_->get(key, value);
+  }
+  auto last = findLastWrite(key);
+  if (!last.has_value() && !etcd_client_->get(key, value)) {
+    return false;
+  }
+  mergeBatch(key, last, value);
+  return true;
+}
+
+/**
+ * @brief 获取以 ',' 分割的 value 列表
+ *
+ * @param key ETCD key
+ * @return std::vector<std::string> value 列表
+ */
+auto Storage::listValue(std::string_view key) const -> std::vector<std::string> {
+  std::string out{};
+  if (!getValue(key, out)) {
+    return {};
+  }
+  return helper::split(out, ',');
+}
+
+/**
+ * @brief 删除一个 key，批量模式下只记录操作
+ *
+ * @param key ETCD key
+ * @return true 成功
+ * @return false 失败
+ */
+auto Storage::delValue(std::string_view key) -> bool {
+  if (batch_.has_value()) {
+    batch_->emplace_back(BatchOp{BatchOp::Type::del, std::string{key}, {}, {}});
+    return true;
+  }
+  return etcd_client_->del(key);
+}
+
+/**
+ * @brief 从以 ',' 分割的 value 列表中删除一个值，列表为空时删除 key；批量模式下只记录操作，
+ * 提交时再读取列表
+ *
+ * @param key ETCD key
+ * @param value 待删除的值
+ * @return true 成功
+ * @return false 失败
+ */
+auto Storage::delValue(std::string_view key, std::string_view value) -> bool {
+  if (!batch_.has_value()) {
+    return etcd_client_->del(key, value);
+  }
+  batch_->emplace_back(BatchOp{BatchOp::Type::remove, std::string{key}, std::string{value}, {}});
+  return true;
+}
+
+/**
+ * @brief 查找批量模式下 key 最后一次 put 或 del，之前的操作都被它覆盖
+ *
+ * @param key ETCD key
+ * @return std::optional<size_t> 操作的下标，没有时为空（需要以 ETCD 的当前值为基础）
+ */
+auto Storage::findLastWrite(std::string_view key) const -> std::optional<size_t> {
+  OHNO_ASSERT(batch_.has_value());
+  for (size_t i = batch_->size(); i > 0; --i) {
+    const auto &op = batch_->at(i - 1);
+    if (op.key_ == key && (op.type_ == BatchOp::Type::put || op.type_ == BatchOp::Type::del)) {
+      return i - 1;
+    }
+  }
+  return std::nullopt;
+}
+
+/**
+ * @brief 在 key 的基础值上依次展开批量模式下的操作
+ *
+ * @param key ETCD key
+ * @param last 最后一次 put 或 del 的下标，为空时 value 是 ETCD 的当前值
+ * @param value 基础值，返回展开之后的值（为空表示 key 应该被删除）
+ */
+auto Storage::mergeBatch(std::string_view key, std::optional<size_t> last,
+                         std::string &value) const -> void {
+  OHNO_ASSERT(batch_.has_value());
+  size_t begin{0};
+  if (last.has_value()) {
+    const auto &op = batch_->at(last.value());
+    value = op.type_ == BatchOp::Type::put ? op.value_ : std::string{};
+    begin = last.value() + 1;
+  }
+
+  for (size_t i = begin; i < batch_->size(); ++i) {
+    const auto &op = batch_->at(i);
+    if (op.key_ != key) {
+      continue;
+    }
+    if (op.type_ == BatchOp::Type::append) {
+      // 列表都是集合，已经存在的值不再追加：并发的 ADD 可能基于同一个旧模型追加同一个值
+      auto items = helper::split(value, ',');
+      if (std::find(items.begin(), items.end(), op.value_) == items.end()) {
+        value = value.empty() ? op.value_ : fmt::format("{},{}", value, op.value_);
+      }
+    } else if (op.type_ == BatchOp::Type::remove) {
+      std::string rest{};
+      for (const auto &item : helper::split(value, ',')) {
+        if (item != op.value_) {
+          rest += rest.empty() ? item : fmt::format(",{}", item);
+        }
+      }
+      value = std::move(rest);
+    }
+  }
+}
+
+/**
+ * @brief 将批量模式下的操作展开成一个 ETCD 事务，每个 key 只写一次；需要读取 ETCD 当前值
+ * 的列表 key 同时加上 mod_revision 比较条件
+ *
+ * @param txn 事务（返回值）
+ * @return true 成功
+ * @return false 读取列表失败
+ */
+auto Storage::buildTxn(etcd::EtcdTxn &txn) const -> bool {
+  OHNO_ASSERT(batch_.has_value());
+  for (const auto &op : *batch_) {
+    if (txn.find(op.key_).has_value()) {
+      continue; // 同一个 key 已经展开过
+    }
+    std::string value{};
+    auto last = findLastWrite(op.key_);
+    if (!last.has_value()) {
+      int64_t revision{0};
+      if (!etcd_client_->get(op.key_, value, revision)) {
+        OHNO_LOG(warn, "Storage failed to read {} before commit", op.key_);
+        return false;
+      }
+      txn.compare(etcd::TxnCmpTarget::mod, op.key_, revision);
+    }
+    mergeBatch(op.key_, last, value);
+    if (value.empty()) {
+      txn.del(op.key_);
+    } else {
+      txn.put(op.key_, value, last.has_value() ? batch_->at(last.value()).lease_id_ : "");
+    }
+  }
+  return true;
+}
+
 /**
  * @brief 获取持久化网络空间 key
  *
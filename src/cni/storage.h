@@ -1,6 +1,10 @@
 #pragma once
 
 // clang-format off
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
 #include "storage_if.h"
 #include "src/etcd/etcd_client_if.h"
 #include "src/log/logger.h"
@@ -12,11 +16,14 @@ namespace cni {
 constexpr std::string_view ETCD_KEY_PREFIX_NODE{"/ohno/node"};
 constexpr std::string_view ETCD_KEY_PREFIX_CLUSTER{"/ohno/cluster"};
 constexpr char SEPARATOR{'-'};
+constexpr int STORAGE_COMMIT_ATTEMPTS{16}; // 列表 key 被并发修改时重新读取并提交的次数
 
 class Storage : public StorageIf, public log::Loggable<log::Id::cni> {
 public:
-  auto init(std::unique_ptr<etcd::EtcdClientIf> etcd_client) -> bool;
+  auto init(std::unique_ptr<etcd::EtcdClientIf> etcd_client, bool check_health = true) -> bool;
   auto dump() const -> std::string override;
+  auto beginBatch() -> void override;
+  auto commitBatch() -> bool override;
   auto addNetns(std::string_view node_name, std::string_view pod_name, std::string_view netns_name)
       -> bool override;
   auto delNetns(std::string_view node_name, std::string_view pod_name) -> bool override;
@@ -27,6 +34,7 @@ public:
   auto delPod(std::string_view node_name, std::string_view netns_name) -> bool override;
   auto getPod(std::string_view node_name, std::string_view netns_name) -> std::string override;
   auto getAllPods(std::string_view node_name) const -> std::vector<std::string> override;
+  auto hasPod(std::string_view node_name, std::string_view pod_name) const -> bool override;
   auto addNic(std::string_view node_name, std::string_view pod_name, std::string_view nic_name)
       -> bool override;
   auto delNic(std::string_view node_name, std::string_view pod_name, std::string_view nic_name)
@@ -52,7 +60,21 @@ public:
   auto getVtep(std::string_view node_name, std::string &vtep_addr, std::string &vtep_mac) const
       -> void override;
 
+  static auto getVtepKey(std::string_view node_name) -> std::string;
+  static auto getVtepValue(std::string_view vtep_addr, std::string_view vtep_mac) -> std::string;
+
 private:
+  auto putValue(std::string_view key, std::string_view value, std::string_view lease_id = {})
+      -> bool;
+  auto appendValue(std::string_view key, std::string_view value) -> bool;
+  auto getValue(std::string_view key, std::string &value) const -> bool;
+  auto listValue(std::string_view key) const -> std::vector<std::string>;
+  auto delValue(std::string_view key) -> bool;
+  auto delValue(std::string_view key, std::string_view value) -> bool;
+  auto findLastWrite(std::string_view key) const -> std::optional<size_t>;
+  auto mergeBatch(std::string_view key, std::optional<size_t> last, std::string &value) const
+      -> void;
+  auto buildTxn(etcd::EtcdTxn &txn) const -> bool;
   static auto getNetnsKey(std::string_view node_name, std::string_view pod_name) -> std::string;
   static auto getSinglePodKey(std::string_view node_name, std::string_view netns_name)
       -> std::string;
@@ -64,10 +86,21 @@ private:
                           std::string_view nic_name) -> std::string;
   static auto getRouteValue(std::string_view dest, std::string_view via, std::string_view dev)
       -> std::string;
-  static auto getVtepKey(std::string_view node_name) -> std::string;
-  static auto getVtepValue(std::string_view vtep_addr, std::string_view vtep_mac) -> std::string;
+
+  /**
+   * @brief 批量模式下的一次写操作，列表的追加与删除在提交时才基于 ETCD 的当前值展开
+   *
+   */
+  struct BatchOp {
+    enum class Type : uint8_t { put, del, append, remove };
+    Type type_{Type::put};
+    std::string key_;
+    std::string value_;
+    std::string lease_id_;
+  };
 
   std::unique_ptr<etcd::EtcdClientIf> etcd_client_;
+  std::optional<std::vector<BatchOp>> batch_; // 批量模式下尚未提交的写操作，按调用顺序排列
 };
 
 } // namespace cni
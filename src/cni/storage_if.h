@@ -16,6 +16,8 @@ class StorageIf {
 public:
   virtual ~StorageIf() = default;
   virtual auto dump() const -> std::string = 0;
+  virtual auto beginBatch() -> void = 0;
+  virtual auto commitBatch() -> bool = 0;
   virtual auto addNetns(std::string_view node_name, std::string_view pod_name,
                         std::string_view netns_name) -> bool = 0;
   virtual auto delNetns(std::string_view node_name, std::string_view pod_name) -> bool = 0;
@@ -26,6 +28,7 @@ public:
   virtual auto delPod(std::string_view node_name, std::string_view netns_name) -> bool = 0;
   virtual auto getPod(std::string_view node_name, std::string_view netns_name) -> std::string = 0;
   virtual auto getAllPods(std::string_view node_name) const -> std::vector<std::string> = 0;
+  virtual auto hasPod(std::string_view node_name, std::string_view pod_name) const -> bool = 0;
   virtual auto addNic(std::string_view node_name, std::string_view pod_name,
                       std::string_view nic_name) -> bool = 0;
   virtual auto delNic(std::string_view node_name, std::string_view pod_name,
@@ -0,0 +1,62 @@
+// clang-format off
+#include "change_log.h"
+#include "spdlog/fmt/fmt.h"
+#include "src/common/enum_name.hpp"
+// clang-format on
+
+namespace ohno {
+namespace etcd {
+
+/**
+ * @brief 记录一次修改
+ *
+ * @param op 操作类型
+ * @param key ETCD key（del_prefix 时为前缀）
+ * @param value 写入或者删除的 value（可以为空）
+ */
+auto ChangeLog::record(Op op, std::string_view key, std::string_view value) -> void {
+  std::lock_guard<std::mutex> lock{mutex_};
+  changes_.emplace_back(Change{op, std::string{key}, std::string{value}});
+}
+
+/**
+ * @brief 记录一个已提交事务中的全部操作
+ *
+ * @param txn ETCD 事务
+ */
+auto ChangeLog::record(const EtcdTxn &txn) -> void {
+  std::lock_guard<std::mutex> lock{mutex_};
+  for (const auto &op : txn.getOps()) {
+    changes_.emplace_back(
+        Change{op.type_ == TxnOpType::put ? Op::put : Op::del, op.key_, op.value_});
+  }
+}
+
+auto ChangeLog::size() const -> size_t {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return changes_.size();
+}
+
+/**
+ * @brief 按发生顺序输出修改记录，每条一行
+ *
+ * @return std::string 修改记录
+ */
+auto ChangeLog::toString() const -> std::string {
+  std::lock_guard<std::mutex> lock{mutex_};
+  std::string out{};
+  for (const auto &change : changes_) {
+    out += change.value_.empty()
+               ? fmt::format("{} {}\n", enumName(change.op_), change.key_)
+               : fmt::format("{} {} {}\n", enumName(change.op_), change.key_, change.value_);
+  }
+  return out;
+}
+
+auto ChangeLog::clear() -> void {
+  std::lock_guard<std::mutex> lock{mutex_};
+  changes_.clear();
+}
+
+} // namespace etcd
+} // namespace ohno
@@ -0,0 +1,41 @@
+#pragma once
+
+// clang-format off
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "etcd_txn.h"
+// clang-format on
+
+namespace ohno {
+namespace etcd {
+
+/**
+ * @brief 请求级别的 ETCD 修改记录：只记录本次请求成功写入的 key，代替前后两次全量 dump
+ *
+ * 由 EtcdClientCache 在写操作成功之后记录，多个客户端可以共享同一个记录
+ */
+class ChangeLog final {
+public:
+  enum class Op : uint8_t { put, append, del, del_prefix };
+
+  auto record(Op op, std::string_view key, std::string_view value = {}) -> void;
+  auto record(const EtcdTxn &txn) -> void;
+  auto size() const -> size_t;
+  auto toString() const -> std::string;
+  auto clear() -> void;
+
+private:
+  struct Change {
+    Op op_;
+    std::string key_;
+    std::string value_;
+  };
+
+  mutable std::mutex mutex_;
+  std::vector<Change> changes_;
+};
+
+} // namespace etcd
+} // namespace ohno
@@ -0,0 +1,261 @@
+// clang-format off
+#include "endpoint_selector.h"
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include "nlohmann/json.hpp"
+#include "spdlog/fmt/fmt.h"
+#include "src/common/assert.h"
+#include "src/helper/string.h"
+#include "src/log/logger.h"
+// clang-format on
+
+namespace ohno {
+namespace etcd {
+
+/**
+ * @brief 构造选择器
+ *
+ * @param endpoints 逗号分割的端点列表（与 etcdctl --endpoints 格式相同）
+ * @param state_path 状态文件，非空时构造时读取、析构时保存
+ */
+EndpointSelector::EndpointSelector(std::string_view endpoints, std::string_view state_path)
+    : state_path_{state_path} {
+  for (auto &endpoint : helper::split(endpoints, ',')) {
+    if (!endpoint.empty()) {
+      endpoints_.emplace_back(EndpointState{std::move(endpoint)});
+    }
+  }
+  OHNO_ASSERT(!endpoints_.empty());
+  if (!state_path_.empty()) {
+    load(state_path_);
+  }
+}
+
+EndpointSelector::~EndpointSelector() {
+  if (!state_path_.empty()) {
+    save(state_path_);
+  }
+}
+
+auto EndpointSelector::size() const noexcept -> size_t { return endpoints_.size(); }
+
+auto EndpointSelector::getEndpoint(size_t index) const -> const std::string & {
+  OHNO_ASSERT(index < endpoints_.size());
+  return endpoints_[index].endpoint_;
+}
+
+/**
+ * @brief 获取端点的尝试顺序
+ *
+ * 健康的端点排在前面：还没有测量过的端点优先（让每个端点都有机会被测量），其次按 EWMA
+ * 延迟从低到高；冷却中的端点排在最后，按恢复时间从早到晚
+ *
+ * @return std::vector<size_t> 端点下标
+ */
+auto EndpointSelector::getOrder() const -> std::vector<size_t> {
+  std::vector<size_t> order(endpoints_.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock{mutex_};
+  std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+    const auto &left = endpoints_[lhs];
+    const auto &right = endpoints_[rhs];
+    auto left_down = left.down_until_ > now;
+    auto right_down = right.down_until_ > now;
+    if (left_down || right_down) {
+      return left_down != right_down ? right_down : left.down_until_ < right.down_until_;
+    }
+    if (left.measured_ != right.measured_) {
+      return !left.measured_;
+    }
+    return left.ewma_ < right.ewma_;
+  });
+  return order;
+}
+
+/**
+ * @brief 记录一次请求结果
+ *
+ * @param index 端点下标
+ * @param latency 请求耗时
+ * @param success 是否成功，失败的端点进入冷却
+ */
+auto EndpointSelector::record(size_t index, std::chrono::microseconds latency, bool success)
+    -> void {
+  OHNO_ASSERT(index < endpoints_.size());
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto &state = endpoints_[index];
+  if (!success) {
+    state.down_until_ = std::chrono::steady_clock::now() + ENDPOINT_COOLDOWN;
+    return;
+  }
+
+  auto sample = static_cast<double>(latency.count());
+  state.ewma_ = state.measured_ ? EWMA_ALPHA * sample + (1 - EWMA_ALPHA) * state.ewma_ : sample;
+  state.measured_ = true;
+  state.down_until_ = {};
+}
+
+/**
+ * @brief 记录一次成功的读请求延迟，用于计算对冲读的等待预算
+ *
+ * @param latency 请求耗时
+ */
+auto EndpointSelector::recordRead(std::chrono::microseconds latency) -> void {
+  std::lock_guard<std::mutex> lock{mutex_};
+  reads_.emplace_back(latency.count());
+  if (reads_.size() > LATENCY_WINDOW) {
+    reads_.pop_front();
+  }
+}
+
+/**
+ * @brief 获取对冲读的等待预算：第一个读请求超过预算仍未返回时，向另一个端点再发一次
+ *
+ * @return std::chrono::microseconds 最近读请求延迟的 p95，样本不足时为默认值
+ */
+auto EndpointSelector::getHedgeBudget() const -> std::chrono::microseconds {
+  std::vector<int64_t> samples{};
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (reads_.size() < MIN_LATENCY_SAMPLES) {
+      return DEFAULT_HEDGE_BUDGET;
+    }
+    samples.assign(reads_.begin(), reads_.end());
+  }
+
+  auto rank = static_cast<size_t>(
+      std::ceil(HEDGE_PERCENTILE * static_cast<double>(samples.size())) - 1);
+  std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+  return std::max(std::chrono::microseconds{samples[rank]},
+                  std::chrono::microseconds{MIN_HEDGE_BUDGET});
+}
+
+/**
+ * @brief 获取端点的 EWMA 延迟
+ *
+ * @param index 端点下标
+ * @return double 延迟，单位微秒，未测量时为 0
+ */
+auto EndpointSelector::getLatency(size_t index) const -> double {
+  OHNO_ASSERT(index < endpoints_.size());
+  std::lock_guard<std::mutex> lock{mutex_};
+  return endpoints_[index].ewma_;
+}
+
+/**
+ * @brief 读取上一个进程保存的状态，只恢复当前端点列表中存在的端点
+ *
+ * @param path 状态文件路径
+ * @return true 读取成功
+ * @return false 文件不存在、损坏或者版本不一致
+ */
+auto EndpointSelector::load(std::string_view path) -> bool {
+  std::ifstream file{std::string{path}};
+  if (!file.is_open()) {
+    return false;
+  }
+
+  try {
+    auto json = nlohmann::json::parse(file);
+    if (json.at(JKEY_ENDPOINT_VERSION).get<uint32_t>() != ENDPOINT_STATE_VERSION) {
+      return false;
+    }
+    // 冷却截止时间按墙上时间保存，换算回当前进程的 steady_clock
+    auto steady_now = std::chrono::steady_clock::now();
+    auto system_now = std::chrono::system_clock::now();
+    const auto &saved = json.at(JKEY_ENDPOINT_ENDPOINTS);
+    std::lock_guard<std::mutex> lock{mutex_};
+    for (auto &state : endpoints_) {
+      auto iter = saved.find(state.endpoint_);
+      if (iter == saved.end()) {
+        continue;
+      }
+      state.ewma_ = iter->at(JKEY_ENDPOINT_EWMA).get<double>();
+      state.measured_ = state.ewma_ > 0;
+      auto down_until = std::chrono::system_clock::time_point{
+          std::chrono::milliseconds{iter->at(JKEY_ENDPOINT_DOWNUNTIL).get<int64_t>()}};
+      if (down_until > system_now) {
+        state.down_until_ = steady_now + std::chrono::duration_cast<std::chrono::milliseconds>(
+                                             down_until - system_now);
+      }
+    }
+    auto reads = json.at(JKEY_ENDPOINT_READS).get<std::vector<int64_t>>();
+    reads_.assign(reads.begin(), reads.end());
+    while (reads_.size() > LATENCY_WINDOW) {
+      reads_.pop_front();
+    }
+  } catch (const std::exception &exc) {
+    OHNO_GLOBAL_LOG(warn, "Failed to parse ETCD endpoint state {}: {}", path, exc.what());
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief 保存状态，先写临时文件再 rename；临时文件带上进程号，并发的 CNI 调用互不干扰
+ *
+ * @param path 状态文件路径
+ * @return true 保存成功
+ * @return false 保存失败
+ */
+auto EndpointSelector::save(std::string_view path) const -> bool {
+  nlohmann::json json{};
+  {
+    auto steady_now = std::chrono::steady_clock::now();
+    auto system_now = std::chrono::system_clock::now();
+    auto endpoints = nlohmann::json::object();
+    std::lock_guard<std::mutex> lock{mutex_};
+    for (const auto &state : endpoints_) {
+      auto down_until = state.down_until_ > steady_now
+                            ? system_now + (state.down_until_ - steady_now)
+                            : std::chrono::system_clock::time_point{};
+      endpoints[state.endpoint_] = {
+          {JKEY_ENDPOINT_EWMA, state.measured_ ? state.ewma_ : 0},
+          {JKEY_ENDPOINT_DOWNUNTIL, std::chrono::duration_cast<std::chrono::milliseconds>(
+                                        down_until.time_since_epoch())
+                                        .count()}};
+    }
+    json = nlohmann::json{{JKEY_ENDPOINT_VERSION, ENDPOINT_STATE_VERSION},
+                          {JKEY_ENDPOINT_ENDPOINTS, std::move(endpoints)},
+                          {JKEY_ENDPOINT_READS, reads_}};
+  }
+
+  std::error_code code{};
+  std::filesystem::create_directories(std::filesystem::path{path}.parent_path(), code);
+  auto tmp_path = fmt::format("{}.{}.tmp", path, ::getpid());
+  try {
+    std::ofstream file{tmp_path, std::ios::trunc};
+    if (!file.is_open()) {
+      OHNO_GLOBAL_LOG(warn, "Failed to open ETCD endpoint state {}", tmp_path);
+      return false;
+    }
+    file << json.dump();
+    if (!file.flush()) {
+      OHNO_GLOBAL_LOG(warn, "Failed to write ETCD endpoint state {}", tmp_path);
+      std::filesystem::remove(tmp_path, code);
+      return false;
+    }
+  } catch (const std::exception &exc) {
+    OHNO_GLOBAL_LOG(warn, "Failed to write ETCD endpoint state {}: {}", tmp_path, exc.what());
+    std::filesystem::remove(tmp_path, code);
+    return false;
+  }
+
+  if (std::rename(tmp_path.c_str(), std::string{path}.c_str()) != 0) {
+    OHNO_GLOBAL_LOG(warn, "Failed to replace ETCD endpoint state {}", path);
+    std::filesystem::remove(tmp_path, code);
+    return false;
+  }
+  return true;
+}
+
+} // namespace etcd
+} // namespace ohno
@@ -0,0 +1,80 @@
+#pragma once
+
+// clang-format off
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+// clang-format on
+
+namespace ohno {
+namespace etcd {
+
+constexpr double EWMA_ALPHA{0.3}; // 新样本权重
+constexpr std::chrono::seconds ENDPOINT_COOLDOWN{10};
+constexpr std::chrono::milliseconds DEFAULT_HEDGE_BUDGET{200};
+constexpr std::chrono::milliseconds MIN_HEDGE_BUDGET{20};
+constexpr size_t LATENCY_WINDOW{64};
+constexpr size_t MIN_LATENCY_SAMPLES{8};
+constexpr double HEDGE_PERCENTILE{0.95};
+constexpr std::string_view PATH_ENDPOINT_STATE{"/var/run/ohno/etcd_endpoints.json"};
+constexpr uint32_t ENDPOINT_STATE_VERSION{1};
+
+constexpr std::string_view JKEY_ENDPOINT_VERSION{"version"};
+constexpr std::string_view JKEY_ENDPOINT_ENDPOINTS{"endpoints"};
+constexpr std::string_view JKEY_ENDPOINT_EWMA{"ewma"};
+constexpr std::string_view JKEY_ENDPOINT_DOWNUNTIL{"downUntil"};
+constexpr std::string_view JKEY_ENDPOINT_READS{"reads"};
+
+class EndpointState final {
+public:
+  std::string endpoint_;
+  double ewma_{0};     // 延迟的指数加权移动平均，单位微秒
+  bool measured_{false};
+  std::chrono::steady_clock::time_point down_until_{}; // 失败之后在此之前不优先选择
+};
+
+/**
+ * @brief ETCD 端点选择器
+ *
+ * 每个端点维护一个 EWMA 延迟，健康的端点按延迟从低到高排序，请求失败的端点冷却一段时间后
+ * 才重新参与排序；同时维护最近若干次读请求的延迟，用 p95 作为对冲读的等待预算
+ *
+ * 同一个进程中的 ETCD 客户端应该共享一个选择器（CNI 插件的 IPAM 与 Storage 各有一个客户端）；
+ * CNI 插件每次调用都是新进程，指定状态文件之后构造时读取上一次调用留下的延迟，析构时写回，
+ * 这样第一个请求就能避开慢端点并使用已有的 p95 预算。多个 CNI 调用并发时后写的覆盖先写的，
+ * 丢掉的只是一部分样本
+ *
+ * @note 线程安全，对冲读的后台线程会并发调用 record()
+ */
+class EndpointSelector final {
+public:
+  explicit EndpointSelector(std::string_view endpoints, std::string_view state_path = {});
+  ~EndpointSelector();
+  EndpointSelector(const EndpointSelector &) = delete;
+  EndpointSelector(EndpointSelector &&) = delete;
+  auto operator=(const EndpointSelector &) -> EndpointSelector & = delete;
+  auto operator=(EndpointSelector &&) -> EndpointSelector & = delete;
+
+  auto size() const noexcept -> size_t;
+  auto getEndpoint(size_t index) const -> const std::string &;
+  auto getOrder() const -> std::vector<size_t>;
+  auto record(size_t index, std::chrono::microseconds latency, bool success) -> void;
+  auto recordRead(std::chrono::microseconds latency) -> void;
+  auto getHedgeBudget() const -> std::chrono::microseconds;
+  auto getLatency(size_t index) const -> double;
+  auto load(std::string_view path) -> bool;
+  auto save(std::string_view path) const -> bool;
+
+private:
+  std::string state_path_; // 为空时不持久化
+  mutable std::mutex mutex_;
+  std::vector<EndpointState> endpoints_; // 构造之后数量不再变化
+  std::deque<int64_t> reads_;            // 最近的读请求延迟，单位微秒
+};
+
+} // namespace etcd
+} // namespace ohno
@@ -0,0 +1,452 @@
+// clang-format off
+#include "etcd_client_cache.h"
+#include <algorithm>
+#include <iostream>
+#include "src/common/assert.h"
+#include "src/common/except.h"
+#include "src/helper/string.h"
+// clang-format on
+
+namespace ohno {
+namespace etcd {
+
+EtcdClientCache::EtcdClientCache(std::unique_ptr<EtcdClientIf> etcd_client,
+                                 std::string_view prefix)
+    : etcd_client_{std::move(etcd_client)}, prefix_{prefix} {
+  OHNO_ASSERT(etcd_client_);
+  OHNO_ASSERT(!prefix_.empty());
+}
+
+EtcdClientCache::~EtcdClientCache() { stop(); }
+
+/**
+ * @brief 读取全量数据并启动 watch 线程，之后前缀下的读操作全部由缓存提供
+ *
+ * @return true 启动成功
+ * @return false 读取全量数据失败（此时依然是进程内读缓存）
+ */
+auto EtcdClientCache::start() -> bool {
+  if (running_) {
+    return true;
+  }
+  if (!resync()) {
+    OHNO_LOG(warn, "Failed to load {} into cache", prefix_);
+    return false;
+  }
+  running_ = true;
+
+  watcher_ = std::thread{[this]() {
+    try {
+      pthread_setname_np(pthread_self(), "watch");
+      while (running_) {
+        auto result = etcd_client_->watch(
+            prefix_, getRevision() + 1, [this](const std::vector<WatchEvent> &events) -> bool {
+              apply(events);
+              return running_;
+            });
+        if (!running_) {
+          break;
+        }
+
+        // revision 被压缩或者 watch 出错，丢弃缓存之后重新读取全量数据
+        OHNO_LOG(warn, "Watch on {} ended({}), resyncing", prefix_,
+                 result == WatchResult::compacted ? "compacted" : "failed");
+        {
+          std::unique_lock<std::shared_mutex> lock{mutex_};
+          synced_ = false;
+          cache_.clear();
+          dirty_.clear();
+        }
+        while (running_ && !resync()) {
+          std::this_thread::sleep_for(WATCH_RETRY_INTERVAL);
+        }
+      }
+    } catch (const ohno::except::Exception &exc) {
+      std::cerr << "[error] Ohnod watch thread terminated!" << exc.getMsg() << "\n";
+    } catch (const std::exception &exc) {
+      std::cerr << "[error] Ohnod watch thread terminated!" << exc.what() << "\n";
+    }
+  }};
+  return true;
+}
+
+/**
+ * @brief 停止 watch 线程，缓存退化为进程内读缓存
+ *
+ */
+auto EtcdClientCache::stop() -> void {
+  running_ = false;
+  if (watcher_.joinable()) {
+    watcher_.join();
+  }
+  std::unique_lock<std::shared_mutex> lock{mutex_};
+  if (synced_) {
+    synced_ = false;
+    cache_.clear();
+    dirty_.clear();
+  }
+}
+
+/**
+ * @brief 缓存是否与 ETCD 保持一致（watch 正在运行）
+ *
+ * @return true 一致
+ * @return false 不一致
+ */
+auto EtcdClientCache::isSynced() const noexcept -> bool { return synced_; }
+
+/**
+ * @brief 获取缓存已经同步到的 revision
+ *
+ * @return int64_t revision
+ */
+auto EtcdClientCache::getRevision() const -> int64_t {
+  std::shared_lock<std::shared_mutex> lock{mutex_};
+  return revision_;
+}
+
+auto EtcdClientCache::test() const -> bool { return etcd_client_->test(); }
+
+auto EtcdClientCache::put(std::string_view key, std::string_view value) const -> bool {
+  auto marked = markDirty(key, false);
+  auto ret = etcd_client_->put(key, value);
+  finishWrite(key, false, ret, marked);
+  return record(ret, ChangeLog::Op::put, key, value);
+}
+
+auto EtcdClientCache::put(std::string_view key, std::string_view value,
+                          std::string_view lease_id) const -> bool {
+  auto marked = markDirty(key, false);
+  auto ret = etcd_client_->put(key, value, lease_id);
+  finishWrite(key, false, ret, marked);
+  return record(ret, ChangeLog::Op::put, key, value);
+}
+
+auto EtcdClientCache::append(std::string_view key, std::string_view value) const -> bool {
+  auto marked = markDirty(key, false);
+  auto ret = etcd_client_->append(key, value);
+  finishWrite(key, false, ret, marked);
+  return record(ret, ChangeLog::Op::append, key, value);
+}
+
+/**
+ * @brief 获取一个 ETCD value，前缀下的 key 优先从缓存读取
+ *
+ * @param key ETCD key
+ * @param value ETCD value（返回值）
+ * @return true 获取成功
+ * @return false 获取失败
+ */
+auto EtcdClientCache::get(std::string_view key, std::string &value) const -> bool {
+  if (!isCovered(key)) {
+    return etcd_client_->get(key, value);
+  }
+
+  {
+    std::shared_lock<std::shared_mutex> lock{mutex_};
+    std::string key_str{key};
+    if (dirty_.count(key_str) == 0) {
+      auto iter = cache_.find(key_str);
+      if (iter != cache_.end()) {
+        value = iter->second;
+        return true;
+      }
+      if (synced_) {
+        value.clear(); // 全量缓存中不存在说明 key 不存在
+        return true;
+      }
+    }
+  }
+
+  if (!etcd_client_->get(key, value)) {
+    return false;
+  }
+  std::unique_lock<std::shared_mutex> lock{mutex_};
+  if (!synced_) {
+    cache_[std::string{key}] = value;
+  }
+  return true;
+}
+
+/**
+ * @brief 获取一个 ETCD value 以及它的 mod_revision，总是直接读取 ETCD
+ *
+ * @note revision 用于事务中的比较条件，必须是 ETCD 当前的值，不能来自可能落后的缓存
+ *
+ * @param key ETCD key
+ * @param value ETCD value（返回值）
+ * @param revision key 最后一次修改时的 revision（返回值，key 不存在时为 0）
+ * @return true 获取成功
+ * @return false 获取失败
+ */
+auto EtcdClientCache::get(std::string_view key, std::string &value, int64_t &revision) const
+    -> bool {
+  return etcd_client_->get(key, value, revision);
+}
+
+/**
+ * @brief 获取所有以 key 为前缀的 ETCD key-value，缓存与 ETCD 一致时直接从缓存读取
+ *
+ * @param key ETCD key 前缀
+ * @param value ETCD key-value（返回值）
+ * @return true 获取成功
+ * @return false 获取失败
+ */
+auto EtcdClientCache::get(std::string_view key,
+                          std::unordered_map<std::string, std::string> &value) const -> bool {
+  if (isCovered(key)) {
+    std::shared_lock<std::shared_mutex> lock{mutex_};
+    std::string key_str{key};
+    auto dirty = dirty_.lower_bound(key_str);
+    if (synced_ && (dirty == dirty_.end() || dirty->compare(0, key.size(), key) != 0)) {
+      for (auto iter = cache_.lower_bound(key_str);
+           iter != cache_.end() && iter->first.compare(0, key.size(), key) == 0; ++iter) {
+        value[iter->first] = iter->second;
+      }
+      return true;
+    }
+  }
+  return etcd_client_->get(key, value);
+}
+
+auto EtcdClientCache::del(std::string_view key) const -> bool {
+  auto marked = markDirty(key, false);
+  auto ret = etcd_client_->del(key);
+  finishWrite(key, false, ret, marked);
+  return record(ret, ChangeLog::Op::del, key);
+}
+
+auto EtcdClientCache::del(std::string_view key, std::string_view value) const -> bool {
+  auto marked = markDirty(key, false);
+  auto ret = etcd_client_->del(key, value);
+  finishWrite(key, false, ret, marked);
+  return record(ret, ChangeLog::Op::del, key, value);
+}
+
+auto EtcdClientCache::delPrefix(std::string_view prefix) const -> bool {
+  auto marked = markDirty(prefix, true);
+  auto ret = etcd_client_->delPrefix(prefix);
+  finishWrite(prefix, true, ret, marked);
+  return record(ret, ChangeLog::Op::del_prefix, prefix);
+}
+
+/**
+ * @brief 获取 ETCD value 列表，与 EtcdClientShell::list 语义相同，但读取经过缓存
+ *
+ * @param key ETCD key
+ * @param results ETCD value 列表（返回值）
+ * @return true 获取成功
+ * @return false 获取失败
+ */
+auto EtcdClientCache::list(std::string_view key, std::vector<std::string> &results) const
+    -> bool {
+  std::string output{};
+  if (!get(key, output)) {
+    return false;
+  }
+  results = helper::split(output, ',');
+  return true;
+}
+
+auto EtcdClientCache::dump(std::string_view key) const -> std::string {
+  return etcd_client_->dump(key);
+}
+
+auto EtcdClientCache::grantLease(int64_t ttl, std::string &lease_id) const -> bool {
+  return etcd_client_->grantLease(ttl, lease_id);
+}
+
+auto EtcdClientCache::keepAliveLease(std::string_view lease_id) const -> bool {
+  return etcd_client_->keepAliveLease(lease_id);
+}
+
+auto EtcdClientCache::snapshot(std::string_view prefix,
+                               std::unordered_map<std::string, std::string> &values,
+                               int64_t &revision) const -> bool {
+  return etcd_client_->snapshot(prefix, values, revision);
+}
+
+auto EtcdClientCache::watch(std::string_view prefix, int64_t revision,
+                            const WatchCallback &callback) const -> WatchResult {
+  return etcd_client_->watch(prefix, revision, callback);
+}
+
+/**
+ * @brief 提交事务，事务中的 key 与单独写入一样使缓存失效
+ *
+ * @param txn 事务
+ * @return TxnResult 提交结果，只有提交成功时记录修改
+ */
+auto EtcdClientCache::commit(const EtcdTxn &txn) const -> TxnResult {
+  std::vector<std::string> marked{};
+  for (const auto &op : txn.getOps()) {
+    auto keys = markDirty(op.key_, false);
+    marked.insert(marked.end(), std::make_move_iterator(keys.begin()),
+                  std::make_move_iterator(keys.end()));
+  }
+  auto ret = etcd_client_->commit(txn);
+  for (const auto &op : txn.getOps()) {
+    finishWrite(op.key_, false, ret == TxnResult::committed, {});
+  }
+  if (ret != TxnResult::committed) {
+    finishWrite({}, false, false, marked); // 比较失败或者出错时事务中的写都没有生效
+  }
+  if (ret == TxnResult::committed && change_log_ != nullptr) {
+    change_log_->record(txn);
+  }
+  return ret;
+}
+
+/**
+ * @brief 设置修改记录，之后成功的写操作都会记录下来（多个客户端可以共享同一个记录）
+ *
+ * @param change_log 修改记录
+ */
+auto EtcdClientCache::setChangeLog(std::shared_ptr<ChangeLog> change_log) -> void {
+  change_log_ = std::move(change_log);
+}
+
+/**
+ * @brief 写操作成功时记录修改
+ *
+ * @param ret 写操作结果
+ * @param op 操作类型
+ * @param key ETCD key
+ * @param value ETCD value
+ * @return bool 原样返回写操作结果
+ */
+auto EtcdClientCache::record(bool ret, ChangeLog::Op op, std::string_view key,
+                             std::string_view value) const -> bool {
+  if (ret && change_log_ != nullptr) {
+    change_log_->record(op, key, value);
+  }
+  return ret;
+}
+
+/**
+ * @brief key 是否在缓存的前缀下
+ *
+ * @param key ETCD key
+ * @return true 是
+ * @return false 否
+ */
+auto EtcdClientCache::isCovered(std::string_view key) const noexcept -> bool {
+  return key.compare(0, prefix_.size(), prefix_) == 0;
+}
+
+/**
+ * @brief 写操作发出之前，全量缓存把要写的 key 标记为 dirty，直到 watch 收到对应事件之前都从
+ * ETCD 读取，保证读到自己的写入；必须在写之前标记，否则写入之后、标记之前到达的事件
+ * 会被之后的标记覆盖，key 一直穿透到 ETCD
+ *
+ * @param key ETCD key 或前缀
+ * @param prefix key 是否是前缀（前缀删除会为缓存中每个 key 产生一个删除事件）
+ * @return std::vector<std::string> 本次新加的标记，写失败时由 finishWrite() 撤销
+ */
+auto EtcdClientCache::markDirty(std::string_view key, bool prefix) const
+    -> std::vector<std::string> {
+  std::vector<std::string> marked{};
+  if (!isCovered(key)) {
+    return marked;
+  }
+  std::unique_lock<std::shared_mutex> lock{mutex_};
+  if (!synced_) {
+    return marked;
+  }
+  if (!prefix) {
+    if (dirty_.emplace(key).second) {
+      marked.emplace_back(key);
+    }
+    return marked;
+  }
+  for (auto iter = cache_.lower_bound(std::string{key});
+       iter != cache_.end() && iter->first.compare(0, key.size(), key) == 0; ++iter) {
+    if (dirty_.emplace(iter->first).second) {
+      marked.emplace_back(iter->first);
+    }
+  }
+  return marked;
+}
+
+/**
+ * @brief 写操作返回之后：写失败时撤销本次的 dirty 标记（万一已经生效，watch 事件照样会更新
+ * 缓存）；进程内读缓存没有 watch，直接删除写过的 key
+ *
+ * @param key ETCD key 或前缀
+ * @param prefix key 是否是前缀
+ * @param ret 写操作是否成功
+ * @param marked markDirty() 返回的标记
+ */
+auto EtcdClientCache::finishWrite(std::string_view key, bool prefix, bool ret,
+                                  const std::vector<std::string> &marked) const -> void {
+  std::unique_lock<std::shared_mutex> lock{mutex_};
+  if (!ret) {
+    for (const auto &item : marked) {
+      dirty_.erase(item);
+    }
+  }
+  if (synced_ || key.empty() || !isCovered(key)) {
+    return;
+  }
+
+  std::string key_str{key};
+  if (!prefix) {
+    cache_.erase(key_str);
+    return;
+  }
+  auto iter = cache_.lower_bound(key_str);
+  while (iter != cache_.end() && iter->first.compare(0, key.size(), key) == 0) {
+    iter = cache_.erase(iter);
+  }
+}
+
+/**
+ * @brief 读取前缀下的全量数据
+ *
+ * @return true 读取成功
+ * @return false 读取失败
+ */
+auto EtcdClientCache::resync() -> bool {
+  std::unordered_map<std::string, std::string> values{};
+  int64_t revision = 0;
+  if (!etcd_client_->snapshot(prefix_, values, revision)) {
+    return false;
+  }
+
+  std::unique_lock<std::shared_mutex> lock{mutex_};
+  cache_.clear();
+  cache_.insert(values.begin(), values.end());
+  dirty_.clear();
+  revision_ = revision;
+  synced_ = true;
+  OHNO_LOG(debug, "Cache of {} synced at revision {} with {} keys", prefix_, revision,
+           cache_.size());
+  return true;
+}
+
+/**
+ * @brief 将 watch 事件应用到缓存
+ *
+ * @param events watch 事件
+ */
+auto EtcdClientCache::apply(const std::vector<WatchEvent> &events) -> void {
+  if (events.empty()) {
+    return;
+  }
+  std::unique_lock<std::shared_mutex> lock{mutex_};
+  for (const auto &event : events) {
+    if (event.revision_ > 0 && event.revision_ <= revision_) {
+      continue; // 全量数据中已经包含
+    }
+    if (event.type_ == WatchEventType::put) {
+      cache_[event.key_] = event.value_;
+    } else {
+      cache_.erase(event.key_);
+    }
+    dirty_.erase(event.key_);
+    revision_ = std::max(revision_, event.revision_);
+  }
+}
+
+} // namespace etcd
+} // namespace ohno
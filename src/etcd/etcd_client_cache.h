@@ -0,0 +1,87 @@
+#pragma once
+
+// clang-format off
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+#include "change_log.h"
+#include "etcd_client_if.h"
+#include "src/log/logger.h"
+// clang-format on
+
+namespace ohno {
+namespace etcd {
+
+constexpr std::chrono::seconds WATCH_RETRY_INTERVAL{1};
+
+/**
+ * @brief 带读缓存的 ETCD 客户端装饰器，对 Ipam、Storage 透明
+ *
+ * 未调用 start() 时只做进程内读缓存：读过的 key 缓存起来，自己的写操作使对应 key 失效，
+ * 适合短生命周期的 CNI 插件；调用 start() 之后先读取前缀下的全量数据，再从下一个 revision 开始
+ * watch，缓存与 ETCD 保持一致，revision 被压缩或 watch 出错时重新读取全量数据，适合 ohnod
+ */
+class EtcdClientCache final : public EtcdClientIf, public log::Loggable<log::Id::etcd> {
+public:
+  EtcdClientCache(std::unique_ptr<EtcdClientIf> etcd_client, std::string_view prefix);
+  ~EtcdClientCache() override;
+
+  auto start() -> bool;
+  auto stop() -> void;
+  auto isSynced() const noexcept -> bool;
+  auto getRevision() const -> int64_t;
+  auto setChangeLog(std::shared_ptr<ChangeLog> change_log) -> void;
+
+  auto test() const -> bool override;
+  auto put(std::string_view key, std::string_view value) const -> bool override;
+  auto put(std::string_view key, std::string_view value, std::string_view lease_id) const
+      -> bool override;
+  auto append(std::string_view key, std::string_view value) const -> bool override;
+  auto get(std::string_view key, std::string &value) const -> bool override;
+  auto get(std::string_view key, std::string &value, int64_t &revision) const -> bool override;
+  auto get(std::string_view key, std::unordered_map<std::string, std::string> &value) const
+      -> bool override;
+  auto del(std::string_view key) const -> bool override;
+  auto del(std::string_view key, std::string_view value) const -> bool override;
+  auto delPrefix(std::string_view prefix) const -> bool override;
+  auto list(std::string_view key, std::vector<std::string> &results) const -> bool override;
+  auto dump(std::string_view key) const -> std::string override;
+  auto grantLease(int64_t ttl, std::string &lease_id) const -> bool override;
+  auto keepAliveLease(std::string_view lease_id) const -> bool override;
+  auto snapshot(std::string_view prefix, std::unordered_map<std::string, std::string> &values,
+                int64_t &revision) const -> bool override;
+  auto watch(std::string_view prefix, int64_t revision, const WatchCallback &callback) const
+      -> WatchResult override;
+  auto commit(const EtcdTxn &txn) const -> TxnResult override;
+
+private:
+  auto isCovered(std::string_view key) const noexcept -> bool;
+  auto markDirty(std::string_view key, bool prefix) const -> std::vector<std::string>;
+  auto finishWrite(std::string_view key, bool prefix, bool ret,
+                   const std::vector<std::string> &marked) const -> void;
+  auto resync() -> bool;
+  auto apply(const std::vector<WatchEvent> &events) -> void;
+  auto record(bool ret, ChangeLog::Op op, std::string_view key, std::string_view value = {}) const
+      -> bool;
+
+  std::unique_ptr<EtcdClientIf> etcd_client_;
+  std::string prefix_;
+  std::shared_ptr<ChangeLog> change_log_; // 为空时不记录
+
+  mutable std::shared_mutex mutex_;
+  mutable std::map<std::string, std::string> cache_; // 有序，便于前缀读取
+  mutable std::set<std::string> dirty_; // 自己写过但 watch 还没确认的 key，读取时穿透到 ETCD
+  int64_t revision_{0};
+  std::atomic<bool> synced_{false};
+  std::atomic<bool> running_{false};
+  std::thread watcher_;
+};
+
+} // namespace etcd
+} // namespace ohno
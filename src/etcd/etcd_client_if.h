@@ -1,28 +1,57 @@
 #pragma once
 
 // clang-format off
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <unordered_map>
+#include "etcd_txn.h"
 // clang-format on
 
 namespace ohno {
 namespace etcd {
 
+enum class WatchEventType : uint8_t { put, del };
+enum class WatchResult : uint8_t { stopped, compacted, failed };
+
+class WatchEvent final {
+public:
+  WatchEventType type_{WatchEventType::put};
+  std::string key_;
+  std::string value_;
+  int64_t revision_{0}; // 事件发生时的 ETCD revision
+};
+
+using WatchCallback = std::function<bool(const std::vector<WatchEvent> &events)>;
+
 class EtcdClientIf {
 public:
   virtual ~EtcdClientIf() = default;
   virtual auto test() const -> bool = 0;
   virtual auto put(std::string_view key, std::string_view value) const -> bool = 0;
+  virtual auto put(std::string_view key, std::string_view value, std::string_view lease_id) const
+      -> bool = 0;
   virtual auto append(std::string_view key, std::string_view value) const -> bool = 0;
   virtual auto get(std::string_view key, std::string &value) const -> bool = 0;
+  virtual auto get(std::string_view key, std::string &value, int64_t &revision) const
+      -> bool = 0;
   virtual auto get(std::string_view key, std::unordered_map<std::string, std::string> &value) const
       -> bool = 0;
   virtual auto del(std::string_view key) const -> bool = 0;
   virtual auto del(std::string_view key, std::string_view value) const -> bool = 0;
+  virtual auto delPrefix(std::string_view prefix) const -> bool = 0;
   virtual auto list(std::string_view key, std::vector<std::string> &results) const -> bool = 0;
   virtual auto dump(std::string_view key) const -> std::string = 0;
+  virtual auto grantLease(int64_t ttl, std::string &lease_id) const -> bool = 0;
+  virtual auto keepAliveLease(std::string_view lease_id) const -> bool = 0;
+  virtual auto snapshot(std::string_view prefix,
+                        std::unordered_map<std::string, std::string> &values,
+                        int64_t &revision) const -> bool = 0;
+  virtual auto watch(std::string_view prefix, int64_t revision, const WatchCallback &callback) const
+      -> WatchResult = 0;
+  virtual auto commit(const EtcdTxn &txn) const -> TxnResult = 0;
 };
 
 } // namespace etcd
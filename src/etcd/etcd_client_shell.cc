@@ -1,26 +1,45 @@
 // clang-format off
 #include "etcd_client_shell.h"
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include "nlohmann/json.hpp"
 #include "spdlog/fmt/fmt.h"
 #include "src/common/assert.h"
 #include "src/common/except.h"
 #include "src/helper/string.h"
+#include "src/metrics/metrics.h"
 // clang-format on
 
 namespace ohno {
 namespace etcd {
 
+/**
+ * @brief 构造 ETCD 客户端
+ *
+ * @param etcd_data ETCD 集群信息
+ * @param shell Shell 对象
+ * @param env 环境变量对象
+ * @param selector 端点选择器，同一进程中的客户端共享一个才能共享延迟统计；为空时单独创建，
+ * 必须由同一个端点列表构造
+ */
 EtcdClientShell::EtcdClientShell(const EtcdData &etcd_data, std::unique_ptr<util::ShellIf> shell,
-                                 std::unique_ptr<util::EnvIf> env)
-    : etcd_data_{etcd_data}, shell_{std::move(shell)}, env_{std::move(env)} {
+                                 std::unique_ptr<util::EnvIf> env,
+                                 std::shared_ptr<EndpointSelector> selector)
+    : etcd_data_{etcd_data}, shell_{std::move(shell)}, selector_{std::move(selector)},
+      env_{std::move(env)} {
   if (!env_->exist(ETCDCTL_VERSION)) {
     // TODO: 判断返回值之后可以怎么做？如果没有办法设置
     // ETCDCTL_API=3，只能使用默认值了，这时候命令会报错的
     env_->set(ETCDCTL_VERSION, ETCDCTL_VERSION_VALUE);
   }
-  command_prefix_ =
-      fmt::format("etcdctl --endpoints={} --cacert={} --cert={} --key={} ", etcd_data_.endpoints_,
-                  etcd_data_.ca_cert_, etcd_data_.cert_, etcd_data_.key_);
+  command_prefix_ = getCommand(etcd_data_.endpoints_);
+  if (selector_ == nullptr) {
+    selector_ = std::make_shared<EndpointSelector>(etcd_data_.endpoints_);
+  }
 }
 
 EtcdClientShell::~EtcdClientShell() {
@@ -31,7 +50,7 @@ EtcdClientShell::~EtcdClientShell() {
 }
 
 /**
- * @brief 测试 ETCD 集群是否能通信
+ * @brief 测试 ETCD 集群是否能通信（多个端点时只要有一个端点健康即可）
  *
  * @return true 能
  * @return false 不能
@@ -41,16 +60,13 @@ auto EtcdClientShell::test() const -> bool {
   OHNO_ASSERT(shell_);
 
   std::string out{};
-  auto ret = shell_->execute(fmt::format("{} -w table endpoint health", command_prefix_), out);
+  used_ = true; // 已经主动检查过，不需要第一次访问时再检测
+  auto ret = execute(selector_->getOrder(), true, "-w table endpoint health", out);
   if (ret) {
     OHNO_LOG(info, "ETCD cluster init successfully, addr:{}, ca_cert:{}, cert:{}, key:{}",
              etcd_data_.endpoints_, etcd_data_.ca_cert_, etcd_data_.cert_, etcd_data_.key_);
   } else {
-    OHNO_LOG(warn,
-             "ETCD cluster init failed, addr:\"{}\", ca_cert:\"{}\", cert:\"{}\", key:\"{}\", "
-             "please check out env var ETCDCTL_ENDPOINTS, ETCDCTL_CACERT, ETCDCTL_CERT and "
-             "ETCDCTL_KEY separately",
-             etcd_data_.endpoints_, etcd_data_.ca_cert_, etcd_data_.cert_, etcd_data_.key_);
+    logUnreachable("init");
   }
   return ret;
 }
@@ -70,7 +86,30 @@ auto EtcdClientShell::put(std::string_view key, std::string_view value) const ->
   OHNO_ASSERT(shell_);
 
   std::string out{};
-  return shell_->execute(fmt::format("{} put -- {} {}", command_prefix_, key, value), out);
+  return execute(fmt::format("put -- {} {}", key, value), out);
+}
+
+/**
+ * @brief 设置一个绑定租约的 ETCD key-value，租约过期后 key 被自动删除
+ *
+ * @param key ETCD key
+ * @param value ETCD value
+ * @param lease_id 租约 ID（十六进制，为空时等同于不绑定租约）
+ * @return true 设置成功
+ * @return false 设置失败
+ */
+auto EtcdClientShell::put(std::string_view key, std::string_view value,
+                          std::string_view lease_id) const -> bool {
+  if (lease_id.empty()) {
+    return put(key, value);
+  }
+  OHNO_ASSERT(!key.empty());
+  OHNO_ASSERT(!value.empty());
+  OHNO_ASSERT(!command_prefix_.empty());
+  OHNO_ASSERT(shell_);
+
+  std::string out{};
+  return execute(fmt::format("put --lease={} -- {} {}", lease_id, key, value), out);
 }
 
 /**
@@ -107,8 +146,7 @@ auto EtcdClientShell::get(std::string_view key, std::string &value) const -> boo
   OHNO_ASSERT(!command_prefix_.empty());
   OHNO_ASSERT(shell_);
 
-  auto ret =
-      shell_->execute(fmt::format("{} get {} --print-value-only", command_prefix_, key), value);
+  auto ret = read(fmt::format("get {} --print-value-only", key), value);
   if (ret) {
     if (!value.empty()) {
       // etcdctl get 输出会包含换行符
@@ -118,6 +156,49 @@ auto EtcdClientShell::get(std::string_view key, std::string &value) const -> boo
   return ret;
 }
 
+/**
+ * @brief 获取一个 ETCD value 以及它的 mod_revision，用于之后在事务中比较 key 是否被修改过
+ *
+ * @param key ETCD key
+ * @param value ETCD value（返回值，key 不存在时为空）
+ * @param revision key 最后一次修改时的 revision（返回值，key 不存在时为 0）
+ * @return true 获取成功
+ * @return false 获取失败
+ */
+auto EtcdClientShell::get(std::string_view key, std::string &value, int64_t &revision) const
+    -> bool {
+  OHNO_ASSERT(!key.empty());
+  OHNO_ASSERT(!command_prefix_.empty());
+  OHNO_ASSERT(shell_);
+
+  std::string out{};
+  if (!read(fmt::format("get {} -w json", key), out)) {
+    return false;
+  }
+
+  // value 是 Base64 编码的，key 不存在时没有 kvs
+  try {
+    auto json = nlohmann::json::parse(out);
+    auto kvs = json.value("kvs", nlohmann::json::array());
+    if (kvs.empty()) {
+      value.clear();
+      revision = 0;
+      return true;
+    }
+    auto decoded = helper::base64Decode(kvs.front().value("value", std::string{}));
+    if (!decoded.has_value()) {
+      OHNO_LOG(warn, "Failed to decode value of {}", key);
+      return false;
+    }
+    value = std::move(decoded.value());
+    revision = kvs.front().at("mod_revision").get<int64_t>();
+  } catch (const std::exception &exc) {
+    OHNO_LOG(warn, "Failed to parse {}: {}", key, exc.what());
+    return false;
+  }
+  return true;
+}
+
 /**
  * @brief 获取所有 ETCD value
  *
@@ -133,14 +214,17 @@ auto EtcdClientShell::get(std::string_view key,
   OHNO_ASSERT(shell_);
 
   std::string out{};
-  auto ret = shell_->execute(fmt::format("{} get {} --prefix", command_prefix_, key), out);
+  auto ret = read(fmt::format("get {} --prefix", key), out);
   if (ret) {
-    if (!out.empty()) {
-      auto map = helper::split(out, '\n');
-      OHNO_ASSERT(map.size() % 2 == 0);
-      for (size_t i = 0; i < map.size(); i += 2) {
-        value[map[i]] = map[i + 1];
-      }
+    // etcdctl 按 key、value 交替逐行输出，直接在输出上切分，每个 key / value 只复制一次
+    value.reserve(value.size() + std::count(out.begin(), out.end(), '\n') / 2);
+    helper::Tokenizer lines{out, '\n'};
+    std::string_view line_key{};
+    std::string_view line_value{};
+    while (lines.next(line_key)) {
+      auto paired = lines.next(line_value);
+      OHNO_ASSERT(paired);
+      value.insert_or_assign(std::string{line_key}, line_value);
     }
   }
   return ret;
@@ -159,7 +243,7 @@ auto EtcdClientShell::del(std::string_view key) const -> bool {
   OHNO_ASSERT(shell_);
 
   std::string out{};
-  return shell_->execute(fmt::format("{} del {}", command_prefix_, key), out);
+  return execute(fmt::format("del {}", key), out);
 }
 
 /**
@@ -189,6 +273,22 @@ auto EtcdClientShell::del(std::string_view key, std::string_view value) const ->
   return to_put.empty() ? del(key) : put(key, to_put);
 }
 
+/**
+ * @brief 删除所有以指定前缀开头的 ETCD key-value
+ *
+ * @param prefix ETCD key 前缀
+ * @return true 删除成功
+ * @return false 删除失败
+ */
+auto EtcdClientShell::delPrefix(std::string_view prefix) const -> bool {
+  OHNO_ASSERT(!prefix.empty());
+  OHNO_ASSERT(!command_prefix_.empty());
+  OHNO_ASSERT(shell_);
+
+  std::string out{};
+  return execute(fmt::format("del {} --prefix", prefix), out);
+}
+
 /**
  * @brief 获取 ETCD value 列表，适用于 ETCD value 是以 ',' 分割的多个值的情况（如 foo -> bar,qux）
  *
@@ -231,5 +331,570 @@ auto EtcdClientShell::dump(std::string_view key) const -> std::string {
   return std::string{};
 }
 
+/**
+ * @brief 申请一个租约
+ *
+ * @param ttl 租约有效期，单位秒
+ * @param lease_id 租约 ID（返回值，十六进制）
+ * @return true 申请成功
+ * @return false 申请失败
+ */
+auto EtcdClientShell::grantLease(int64_t ttl, std::string &lease_id) const -> bool {
+  OHNO_ASSERT(ttl > 0);
+  OHNO_ASSERT(!command_prefix_.empty());
+  OHNO_ASSERT(shell_);
+
+  // 输出形如 "lease 694d7a5d2d1c2b0b granted with TTL(60s)"
+  lease_id.clear();
+  std::string out{};
+  if (!execute(fmt::format("lease grant {}", ttl), out)) {
+    return false;
+  }
+  auto words = helper::split(out, ' ');
+  if (words.size() < 3 || words[0] != "lease" || words[2] != "granted") {
+    OHNO_LOG(warn, "Unexpected output of etcdctl lease grant: {}", out);
+    return false;
+  }
+  lease_id = words[1];
+  return true;
+}
+
+/**
+ * @brief 续约一次
+ *
+ * @param lease_id 租约 ID（十六进制）
+ * @return true 续约成功
+ * @return false 续约失败，租约可能已经过期
+ */
+auto EtcdClientShell::keepAliveLease(std::string_view lease_id) const -> bool {
+  OHNO_ASSERT(!lease_id.empty());
+  OHNO_ASSERT(!command_prefix_.empty());
+  OHNO_ASSERT(shell_);
+
+  // 输出形如 "lease 694d7a5d2d1c2b0b keepalived with TTL(60)"，过期时为 "... expired or revoked."
+  std::string out{};
+  return execute(fmt::format("lease keep-alive --once {}", lease_id), out) &&
+         out.find("keepalived") != std::string::npos;
+}
+
+/**
+ * @brief 读取指定前缀下的所有 key-value，以及读取时的 revision
+ *
+ * @param prefix ETCD key 前缀
+ * @param values key-value（返回值）
+ * @param revision 读取时的 revision（返回值），之后的 watch 从 revision + 1 开始
+ * @return true 读取成功
+ * @return false 读取失败
+ */
+auto EtcdClientShell::snapshot(std::string_view prefix,
+                               std::unordered_map<std::string, std::string> &values,
+                               int64_t &revision) const -> bool {
+  OHNO_ASSERT(!prefix.empty());
+  OHNO_ASSERT(!command_prefix_.empty());
+  OHNO_ASSERT(shell_);
+
+  values.clear();
+  std::string out{};
+  if (!read(fmt::format("get {} --prefix -w json", prefix), out)) {
+    return false;
+  }
+
+  // key 与 value 都是 Base64 编码的
+  try {
+    auto json = nlohmann::json::parse(out);
+    revision = json.at("header").at("revision").get<int64_t>();
+    for (const auto &kv : json.value("kvs", nlohmann::json::array())) {
+      auto key = helper::base64Decode(kv.at("key").get<std::string>());
+      auto value = helper::base64Decode(kv.value("value", std::string{}));
+      if (key.has_value() && value.has_value()) {
+        values.emplace(std::move(key.value()), std::move(value.value()));
+      }
+    }
+  } catch (const std::exception &exc) {
+    OHNO_LOG(warn, "Failed to parse snapshot of {}: {}", prefix, exc.what());
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief 监听指定前缀下的变化，阻塞直到回调要求停止、revision 被压缩或者 watch 出错
+ *
+ * @param prefix ETCD key 前缀
+ * @param revision 从哪个 revision 开始监听（包含）
+ * @param callback 每批事件调用一次，空闲时以空数组调用，返回 false 时停止监听
+ * @return WatchResult 结束原因，compacted 与 failed 时调用方需要重新读取全量数据
+ */
+auto EtcdClientShell::watch(std::string_view prefix, int64_t revision,
+                            const WatchCallback &callback) const -> WatchResult {
+  OHNO_ASSERT(!prefix.empty());
+  OHNO_ASSERT(!command_prefix_.empty());
+  OHNO_ASSERT(shell_);
+
+  auto result = WatchResult::failed;
+  std::vector<WatchEvent> events{};
+  auto on_line = [&](std::string_view line) -> bool {
+    events.clear();
+    if (!line.empty()) {
+      auto json = nlohmann::json::parse(line, nullptr, false);
+      if (json.is_discarded() || !json.is_object()) {
+        return true; // 忽略非 JSON 输出
+      }
+      if (json.value("CompactRevision", int64_t{0}) > 0) {
+        result = WatchResult::compacted;
+        return false;
+      }
+      for (const auto &item : json.value("Events", nlohmann::json::array())) {
+        const auto &kv = item.at("kv");
+        WatchEvent event{};
+        event.type_ = item.value("type", 0) == 1 ? WatchEventType::del : WatchEventType::put;
+        event.key_ = helper::base64Decode(kv.value("key", std::string{})).value_or(std::string{});
+        event.value_ =
+            helper::base64Decode(kv.value("value", std::string{})).value_or(std::string{});
+        event.revision_ = kv.value("mod_revision", int64_t{0});
+        events.emplace_back(std::move(event));
+      }
+    }
+    if (!callback(events)) {
+      result = WatchResult::stopped;
+      return false;
+    }
+    return true;
+  };
+
+  // exec 让 etcdctl 直接替换 sh，停止监听时才能结束 etcdctl 本身
+  shell_->stream(fmt::format("exec {} watch {} --prefix --rev={} -w json", command_prefix_,
+                             prefix, revision),
+                 on_line);
+  return result;
+}
+
+namespace {
+
+/**
+ * @brief 判断 key 能否写入 etcdctl txn 的一行：etcdctl 解析比较条件时 key 不支持转义，
+ * 含有引号、反斜杠、空白或控制字符的 key 只能拒绝
+ *
+ * @param key ETCD key
+ * @return true 可以写入
+ * @return false 不能写入
+ */
+auto isTxnKey(std::string_view key) -> bool {
+  return !key.empty() && std::none_of(key.begin(), key.end(), [](char chr) {
+    return chr == '"' || chr == '\'' || chr == '\\' || static_cast<unsigned char>(chr) <= ' ' ||
+           chr == '\x7f';
+  });
+}
+
+/**
+ * @brief 把 value 写成 etcdctl txn 的双引号字符串，etcdctl 按 Go 字符串字面量解析并还原
+ *
+ * @param value ETCD value
+ * @return std::string 带双引号的字符串
+ */
+auto quoteTxnValue(std::string_view value) -> std::string {
+  std::string result{"\""};
+  for (auto chr : value) {
+    switch (chr) {
+    case '"':
+      result += "\\\"";
+      break;
+    case '\\':
+      result += "\\\\";
+      break;
+    case '\n':
+      result += "\\n";
+      break;
+    case '\r':
+      result += "\\r";
+      break;
+    case '\t':
+      result += "\\t";
+      break;
+    default:
+      result += chr;
+    }
+  }
+  result += '"';
+  return result;
+}
+
+/**
+ * @brief 把一行写成 shell 单引号参数，行内的单引号写成 '\''
+ *
+ * @param line 一行内容
+ * @return std::string shell 参数
+ */
+auto quoteShell(std::string_view line) -> std::string {
+  std::string result{" '"};
+  for (auto chr : line) {
+    if (chr == '\'') {
+      result += "'\\''";
+    } else {
+      result += chr;
+    }
+  }
+  result += '\'';
+  return result;
+}
+
+} // namespace
+
+/**
+ * @brief 原子提交一个事务，比较条件全部成立时所有操作一起生效，否则都不生效
+ *
+ * @param txn 事务
+ * @return TxnResult committed 提交成功（空事务直接成功）；conflicted 比较条件不成立；
+ * failed 提交失败
+ */
+auto EtcdClientShell::commit(const EtcdTxn &txn) const -> TxnResult {
+  OHNO_ASSERT(!command_prefix_.empty());
+  OHNO_ASSERT(shell_);
+
+  if (txn.empty()) {
+    return TxnResult::committed;
+  }
+  if (txn.size() > MAX_TXN_OPS || txn.getCmps().size() > MAX_TXN_OPS) {
+    OHNO_LOG(warn, "Too many operations in one ETCD transaction: {}", txn.size());
+    return TxnResult::failed;
+  }
+
+  // etcdctl txn 从 stdin 依次读取：比较条件、空行、成功时的操作、空行、失败时的操作、空行，
+  // 比较条件不成立时不执行任何操作，输出 FAILURE。value 按 etcdctl 的规则转义，
+  // 每一行再按 shell 的规则转义，value 中的引号、换行不会破坏命令
+  std::string lines{};
+  for (const auto &cmp : txn.getCmps()) {
+    if (!isTxnKey(cmp.key_)) {
+      OHNO_LOG(warn, "Invalid key in ETCD transaction: {}", cmp.key_);
+      return TxnResult::failed;
+    }
+    lines += quoteShell(fmt::format("{}(\"{}\") = \"{}\"",
+                                    cmp.target_ == TxnCmpTarget::mod ? "mod" : "create", cmp.key_,
+                                    cmp.revision_));
+  }
+  lines += " ''";
+  for (const auto &op : txn.getOps()) {
+    if (!isTxnKey(op.key_)) {
+      OHNO_LOG(warn, "Invalid key in ETCD transaction: {}", op.key_);
+      return TxnResult::failed;
+    }
+    std::string line{};
+    if (op.type_ == TxnOpType::del) {
+      line = fmt::format("del {}", op.key_);
+    } else if (op.lease_id_.empty()) {
+      line = fmt::format("put {} {}", op.key_, quoteTxnValue(op.value_));
+    } else {
+      line = fmt::format("put --lease={} {} {}", op.lease_id_, op.key_, quoteTxnValue(op.value_));
+    }
+    lines += quoteShell(line);
+  }
+  lines += " '' ''";
+
+  std::string out{};
+  if (!execute("txn", out, fmt::format("printf '%s\\n'{}", lines))) {
+    return TxnResult::failed;
+  }
+  if (out.find("SUCCESS") != std::string::npos) {
+    return TxnResult::committed;
+  }
+  return out.find("FAILURE") != std::string::npos ? TxnResult::conflicted : TxnResult::failed;
+}
+
+/**
+ * @brief 获取端点选择器
+ *
+ * @return const EndpointSelector& 端点选择器
+ */
+auto EtcdClientShell::getSelector() const noexcept -> const EndpointSelector & {
+  return *selector_;
+}
+
+/**
+ * @brief 获取指定端点的 etcdctl 命令前缀
+ *
+ * @param endpoints 逗号分割的端点列表
+ * @return std::string 命令前缀
+ */
+auto EtcdClientShell::getCommand(std::string_view endpoints) const -> std::string {
+  return fmt::format("etcdctl --endpoints={} --cacert={} --cert={} --key={} ", endpoints,
+                     etcd_data_.ca_cert_, etcd_data_.cert_, etcd_data_.key_);
+}
+
+namespace {
+
+/**
+ * @brief 判断 etcdctl 的错误能否换一个端点重试
+ *
+ * 连接被拒绝、gRPC Unavailable、没有 leader 时请求没有被 ETCD 执行，任何请求都可以换端点重试；
+ * 超时（context deadline exceeded、request timed out、leader changed）时请求可能已经执行，
+ * 只有只读请求可以重试，lease grant、put、txn 重试可能执行两次
+ *
+ * @param err etcdctl stderr
+ * @param read_only 是否是只读请求
+ * @return true 可以换端点重试
+ * @return false 与端点无关的错误，或者写请求结果不确定
+ */
+auto canFailover(std::string_view err, bool read_only) -> bool {
+  for (const auto *pattern : {"Unavailable", "connection refused", "no leader"}) {
+    if (err.find(pattern) != std::string_view::npos) {
+      return true;
+    }
+  }
+  if (!read_only) {
+    return false;
+  }
+  for (const auto *pattern : {"context deadline exceeded", "request timed out", "leader changed"}) {
+    if (err.find(pattern) != std::string_view::npos) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief 一次对冲读的共享状态，先成功的请求写入结果，后返回的请求只记录延迟
+ *
+ */
+class HedgedRead final {
+public:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  size_t started_{0};
+  size_t finished_{0};
+  bool done_{false};
+  bool failed_{false}; // 有请求因为与端点无关的错误失败，换端点也不会成功
+  std::string out_;
+  std::string err_;
+};
+
+// EtcdClientShell 发出的操作类型，其余的记为 other
+constexpr std::array<std::string_view, 6> OPS{"put", "get", "del", "lease", "txn", "other"};
+
+struct OpMetrics {
+  metrics::Histogram *duration_;
+  metrics::Counter *errors_;
+};
+
+/**
+ * @brief 获取 etcdctl 操作类型在 OPS 中的下标：第一个非选项参数（跳过 "-w table" 这类全局选项），
+ * 只在原字符串上查找，不分配内存
+ *
+ * @param args etcdctl 子命令及参数
+ * @return size_t 下标，不认识的操作为 other
+ */
+auto getOp(std::string_view args) -> size_t {
+  helper::Tokenizer tokens{args, ' '};
+  std::string_view token{};
+  while (tokens.next(token)) {
+    if (token == "-w") {
+      tokens.next(token);
+    } else if (!token.empty() && token[0] != '-') {
+      break;
+    }
+    token = {};
+  }
+  auto iter = std::find(OPS.begin(), OPS.end() - 1, token);
+  return static_cast<size_t>(iter - OPS.begin());
+}
+
+/**
+ * @brief 记录一次 etcdctl 操作的耗时与失败次数，按操作类型区分；指标在第一次调用时一次性注册，
+ * 之后不再访问注册表
+ *
+ * @param args etcdctl 子命令及参数
+ * @param start 开始时间
+ * @param ret 执行结果
+ * @return bool 原样返回执行结果
+ */
+auto observe(std::string_view args, std::chrono::steady_clock::time_point start, bool ret)
+    -> bool {
+  static const auto METRICS = []() {
+    std::array<OpMetrics, OPS.size()> result{};
+    auto &registry = metrics::Registry::instance();
+    for (size_t i = 0; i < OPS.size(); ++i) {
+      metrics::Labels labels{{"op", std::string{OPS[i]}}};
+      result[i] = OpMetrics{&registry.histogram("ohno_etcd_op_duration_seconds",
+                                                "ETCD operation latency",
+                                                metrics::Buckets::latency, labels),
+                            &registry.counter("ohno_etcd_op_errors_total",
+                                              "ETCD operation failures", labels)};
+    }
+    return result;
+  }();
+
+  const auto &metrics = METRICS[getOp(args)];
+  metrics.duration_->observe(
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  if (!ret) {
+    metrics.errors_->inc();
+  }
+  return ret;
+}
+
+} // namespace
+
+/**
+ * @brief 按照端点选择器给出的顺序执行 etcdctl 命令，端点不可用时换下一个端点
+ *
+ * @param args etcdctl 子命令及参数（如 "get foo"）
+ * @param out stdout（返回值）
+ * @param input 可选的 shell 命令，它的 stdout 作为 etcdctl 的 stdin
+ * @return true 执行成功
+ * @return false 执行失败
+ */
+auto EtcdClientShell::execute(std::string_view args, std::string &out, std::string_view input) const
+    -> bool {
+  auto start = std::chrono::steady_clock::now();
+  return observe(args, start, detect(execute(selector_->getOrder(), false, args, out, input)));
+}
+
+/**
+ * @brief 第一次访问 ETCD 时的故障检测：调用者没有事先执行 test() 时，第一条命令就失败
+ * 说明 ETCD 很可能不可达或者证书配置有误，打印与 test() 相同的排查提示（只打印一次）
+ *
+ * @param ret 命令执行结果
+ * @return bool 原样返回命令执行结果
+ */
+auto EtcdClientShell::detect(bool ret) const -> bool {
+  if (!used_.exchange(true) && !ret) {
+    logUnreachable("first access");
+  }
+  return ret;
+}
+
+/**
+ * @brief 打印 ETCD 不可达时的排查提示
+ *
+ * @param stage 发现故障的阶段
+ */
+auto EtcdClientShell::logUnreachable(std::string_view stage) const -> void {
+  OHNO_LOG(warn,
+           "ETCD cluster {} failed, addr:\"{}\", ca_cert:\"{}\", cert:\"{}\", key:\"{}\", "
+           "please check out env var ETCDCTL_ENDPOINTS, ETCDCTL_CACERT, ETCDCTL_CERT and "
+           "ETCDCTL_KEY separately",
+           stage, etcd_data_.endpoints_, etcd_data_.ca_cert_, etcd_data_.cert_, etcd_data_.key_);
+}
+
+/**
+ * @brief 依次在指定端点上执行 etcdctl 命令，直到成功或者遇到不能换端点重试的错误
+ *
+ * @param order 端点下标
+ * @param read_only 是否是只读请求，只读请求超时之后也换端点重试
+ * @param args etcdctl 子命令及参数
+ * @param out stdout（返回值）
+ * @param input 可选的 shell 命令，它的 stdout 作为 etcdctl 的 stdin
+ * @return true 执行成功
+ * @return false 执行失败
+ */
+auto EtcdClientShell::execute(const std::vector<size_t> &order, bool read_only,
+                              std::string_view args, std::string &out, std::string_view input) const
+    -> bool {
+  auto command = [&](size_t index) -> std::string {
+    auto etcdctl = fmt::format("{}{}", getCommand(selector_->getEndpoint(index)), args);
+    return input.empty() ? etcdctl : fmt::format("{} | {}", input, etcdctl);
+  };
+
+  // 只有一个端点时没有可以切换的端点，不必区分错误类型
+  if (selector_->size() == 1) {
+    return order.empty() ? false : shell_->execute(command(order.front()), out);
+  }
+
+  for (auto index : order) {
+    std::string err{};
+    auto start = std::chrono::steady_clock::now();
+    auto ret = shell_->execute(command(index), out, err);
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    if (ret == 0) {
+      selector_->record(index, latency, true);
+      return true;
+    }
+    if (!canFailover(err, read_only)) {
+      OHNO_LOG(warn, "etcdctl {} failed on {}: {}", args, selector_->getEndpoint(index), err);
+      return false;
+    }
+    OHNO_LOG(warn, "ETCD endpoint {} unavailable: {}", selector_->getEndpoint(index), err);
+    selector_->record(index, latency, false);
+  }
+  return false;
+}
+
+/**
+ * @brief 执行只读的 etcdctl 命令，开启对冲读时第一个端点超过 p95 预算仍未返回，
+ * 就向第二个端点再发一次，取先成功的结果
+ *
+ * @param args etcdctl 子命令及参数
+ * @param out stdout（返回值）
+ * @return true 执行成功
+ * @return false 执行失败
+ */
+auto EtcdClientShell::read(std::string_view args, std::string &out) const -> bool {
+  auto begin = std::chrono::steady_clock::now();
+  auto order = selector_->getOrder();
+  if (!etcd_data_.hedge_reads_ || order.size() < 2) {
+    if (!detect(execute(order, true, args, out))) {
+      return observe(args, begin, false);
+    }
+    selector_->recordRead(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - begin));
+    return observe(args, begin, true);
+  }
+
+  // 后台线程持有 shell 与选择器的共享所有权，输掉的请求可以在客户端析构之后再结束
+  auto state = std::make_shared<HedgedRead>();
+  auto launch = [&](size_t index) {
+    ++state->started_;
+    auto command = fmt::format("{}{}", getCommand(selector_->getEndpoint(index)), args);
+    std::thread{[shell = shell_, selector = selector_, state, index, command]() {
+      std::string result{};
+      std::string err{};
+      auto start = std::chrono::steady_clock::now();
+      auto ret = shell->execute(command, result, err);
+      auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start);
+      auto failover = ret != 0 && canFailover(err, true);
+      selector->record(index, latency, !failover);
+      if (ret == 0) {
+        selector->recordRead(latency);
+      }
+
+      std::lock_guard<std::mutex> lock{state->mutex_};
+      ++state->finished_;
+      if (ret == 0 && !state->done_) {
+        state->done_ = true;
+        state->out_ = std::move(result);
+      } else if (ret != 0 && !failover) {
+        state->failed_ = true;
+        state->err_ = std::move(err);
+      }
+      state->cond_.notify_all();
+    }}.detach();
+  };
+
+  std::unique_lock<std::mutex> lock{state->mutex_};
+  auto finished = [&state]() { return state->done_ || state->finished_ == state->started_; };
+  launch(order[0]);
+  // 第一个请求超过预算仍未返回，或者因为端点不可用而失败时才发出第二个请求
+  auto slow = !state->cond_.wait_for(lock, selector_->getHedgeBudget(), finished);
+  if (slow || (!state->done_ && !state->failed_)) {
+    launch(order[1]);
+  }
+  state->cond_.wait(lock, finished);
+  if (state->done_) {
+    out = std::move(state->out_);
+    return observe(args, begin, detect(true));
+  }
+  if (state->failed_) {
+    OHNO_LOG(warn, "etcdctl {} failed: {}", args, state->err_);
+    return observe(args, begin, detect(false));
+  }
+  lock.unlock();
+
+  // 两个端点都不可用，剩下的端点依次重试
+  return observe(args, begin,
+                 detect(execute(std::vector<size_t>{order.begin() + 2, order.end()}, true, args,
+                                out)));
+}
+
 } // namespace etcd
 } // namespace ohno
@@ -1,8 +1,10 @@
 #pragma once
 
 // clang-format off
+#include <atomic>
 #include <memory>
 #include <vector>
+#include "endpoint_selector.h"
 #include "etcd_client_if.h"
 #include "etcd_data.hpp"
 #include "src/log/logger.h"
@@ -19,25 +21,50 @@ constexpr std::string_view ETCDCTL_VERSION_VALUE{"3"};
 class EtcdClientShell final : public EtcdClientIf, public log::Loggable<log::Id::etcd> {
 public:
   explicit EtcdClientShell(const EtcdData &etcd_data, std::unique_ptr<util::ShellIf> shell,
-                           std::unique_ptr<util::EnvIf> env);
+                           std::unique_ptr<util::EnvIf> env,
+                           std::shared_ptr<EndpointSelector> selector = nullptr);
   ~EtcdClientShell();
 
   auto test() const -> bool override;
   auto put(std::string_view key, std::string_view value) const -> bool override;
+  auto put(std::string_view key, std::string_view value, std::string_view lease_id) const
+      -> bool override;
   auto append(std::string_view key, std::string_view value) const -> bool override;
   auto get(std::string_view key, std::string &value) const -> bool override;
+  auto get(std::string_view key, std::string &value, int64_t &revision) const -> bool override;
   auto get(std::string_view key, std::unordered_map<std::string, std::string> &value) const
       -> bool override;
   auto del(std::string_view key) const -> bool override;
   auto del(std::string_view key, std::string_view value) const -> bool override;
+  auto delPrefix(std::string_view prefix) const -> bool override;
   auto list(std::string_view key, std::vector<std::string> &results) const -> bool override;
   auto dump(std::string_view key) const -> std::string override;
+  auto grantLease(int64_t ttl, std::string &lease_id) const -> bool override;
+  auto keepAliveLease(std::string_view lease_id) const -> bool override;
+  auto snapshot(std::string_view prefix, std::unordered_map<std::string, std::string> &values,
+                int64_t &revision) const -> bool override;
+  auto watch(std::string_view prefix, int64_t revision, const WatchCallback &callback) const
+      -> WatchResult override;
+  auto commit(const EtcdTxn &txn) const -> TxnResult override;
+
+  auto getSelector() const noexcept -> const EndpointSelector &;
 
 private:
+  auto getCommand(std::string_view endpoints) const -> std::string;
+  auto execute(std::string_view args, std::string &out, std::string_view input = {}) const
+      -> bool;
+  auto execute(const std::vector<size_t> &order, bool read_only, std::string_view args,
+               std::string &out, std::string_view input = {}) const -> bool;
+  auto read(std::string_view args, std::string &out) const -> bool;
+  auto detect(bool ret) const -> bool;
+  auto logUnreachable(std::string_view stage) const -> void;
+
   EtcdData etcd_data_;
-  std::string command_prefix_;
-  std::unique_ptr<util::ShellIf> shell_;
+  std::string command_prefix_; // 包含所有端点，用于 watch 这类由 etcdctl 自己负责切换端点的命令
+  std::shared_ptr<util::ShellIf> shell_; // 对冲读的后台线程可能比客户端活得更久
+  std::shared_ptr<EndpointSelector> selector_; // 可以与同一进程中的其他客户端共享
   std::unique_ptr<util::EnvIf> env_;
+  mutable std::atomic<bool> used_{false}; // 是否已经访问过 ETCD，用于第一次访问时的故障检测
 };
 
 } // namespace etcd
@@ -10,6 +10,8 @@
 namespace ohno {
 namespace etcd {
 
+constexpr std::string_view ENV_ETCD_HEDGE_READS{"OHNO_ETCD_HEDGE_READS"};
+
 class EtcdData final {
 public:
   explicit EtcdData() {
@@ -30,6 +32,8 @@ public:
     if (key_.empty()) {
       key_ = "/etc/kubernetes/pki/etcd/healthcheck-client.key";
     }
+    auto hedge = env.get(ENV_ETCD_HEDGE_READS);
+    hedge_reads_ = hedge == "1" || hedge == "true";
   }
   explicit EtcdData(std::string_view endpoints) : EtcdData{} { endpoints_ = endpoints; }
 
@@ -37,6 +41,7 @@ public:
   std::string ca_cert_;
   std::string cert_;
   std::string key_;
+  bool hedge_reads_{false}; // 读请求超过 p95 仍未返回时向另一个端点再发一次
 };
 
 } // namespace etcd
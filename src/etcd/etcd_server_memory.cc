@@ -0,0 +1,901 @@
+// clang-format off
+#include "etcd_server_memory.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <iterator>
+#include <optional>
+#include <thread>
+#include "nlohmann/json.hpp"
+#include "spdlog/fmt/fmt.h"
+#include "src/common/assert.h"
+#include "src/helper/string.h"
+#include "src/util/shell_sync.h"
+// clang-format on
+
+namespace ohno {
+namespace etcd {
+
+EtcdServerMemory::EtcdServerMemory(uint64_t seed) : random_{seed} {}
+
+/**
+ * @brief 设置一类请求的延迟分布
+ *
+ * @param op etcdctl 子命令（如 "get"、"put"、"txn"），为空时作为没有单独配置的请求的默认值
+ * @param latency 延迟分布
+ */
+auto EtcdServerMemory::setLatency(std::string_view op, EtcdLatency latency) -> void {
+  std::lock_guard<std::mutex> lock{mutex_};
+  latency_[std::string{op}] = latency;
+}
+
+/**
+ * @brief 设置一个端点的故障注入概率
+ *
+ * @param endpoint 端点，为空时作为没有单独配置的端点的默认值
+ * @param fault 故障概率
+ */
+auto EtcdServerMemory::setFault(std::string_view endpoint, EtcdFault fault) -> void {
+  std::lock_guard<std::mutex> lock{mutex_};
+  faults_[std::string{endpoint}] = fault;
+}
+
+/**
+ * @brief 开启自动压缩，相当于 etcd --auto-compaction-mode=revision
+ *
+ * @param retention 保留最近多少个 revision 的历史，0 表示关闭
+ */
+auto EtcdServerMemory::setAutoCompaction(int64_t retention) -> void {
+  OHNO_ASSERT(retention >= 0);
+  std::lock_guard<std::mutex> lock{mutex_};
+  retention_ = retention;
+}
+
+/**
+ * @brief 压缩历史事件，之后从更早的 revision 开始的 watch 会失败
+ *
+ * @param revision 压缩到哪个 revision（不包含）
+ * @return true 压缩成功
+ * @return false revision 已经被压缩过或者大于当前 revision
+ */
+auto EtcdServerMemory::compact(int64_t revision) -> bool {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (revision <= compact_revision_ || revision > revision_) {
+    return false;
+  }
+  compactLocked(revision);
+  return true;
+}
+
+/**
+ * @brief 让一个租约立即过期，绑定的 key 随之删除，用于模拟节点失联
+ *
+ * @param lease_id 租约 ID
+ * @return true 租约存在
+ * @return false 租约不存在
+ */
+auto EtcdServerMemory::expireLease(std::string_view lease_id) -> bool {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto iter = leases_.find(lease_id);
+  if (iter == leases_.end()) {
+    return false;
+  }
+  iter->second.deadline_ = std::chrono::steady_clock::time_point{};
+  expireLocked();
+  return true;
+}
+
+/**
+ * @brief 关闭服务端，正在进行的 watch 以失败结束
+ *
+ */
+auto EtcdServerMemory::shutdown() -> void {
+  std::lock_guard<std::mutex> lock{mutex_};
+  stopped_ = true;
+  cond_.notify_all();
+}
+
+auto EtcdServerMemory::getRevision() const -> int64_t {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return revision_;
+}
+
+auto EtcdServerMemory::getCompactRevision() const -> int64_t {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return compact_revision_;
+}
+
+/**
+ * @brief 获取请求数量
+ *
+ * @param op etcdctl 子命令，为空时返回所有请求的数量
+ * @return uint64_t 请求数量（包括被注入故障的请求）
+ */
+auto EtcdServerMemory::getRequests(std::string_view op) const -> uint64_t {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (!op.empty()) {
+    auto iter = requests_.find(op);
+    return iter == requests_.end() ? 0 : iter->second;
+  }
+  uint64_t count{0};
+  for (const auto &item : requests_) {
+    count += item.second;
+  }
+  return count;
+}
+
+auto EtcdServerMemory::getFaults() const -> uint64_t {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return fault_count_;
+}
+
+auto EtcdServerMemory::size() const -> size_t {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return data_.size();
+}
+
+/**
+ * @brief 一个请求到达服务端：计数、抽样故障，然后按照延迟分布等待（不持有锁）
+ *
+ * @param endpoint 请求发往的端点
+ * @param op etcdctl 子命令
+ * @return Fault 本次请求注入的故障
+ */
+auto EtcdServerMemory::inject(std::string_view endpoint, std::string_view op) -> Fault {
+  std::chrono::microseconds delay{0};
+  auto fault = Fault::none;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    ++requests_[std::string{op}];
+
+    auto latency = latency_.find(op);
+    if (latency == latency_.end()) {
+      latency = latency_.find(std::string_view{});
+    }
+    if (latency != latency_.end() && latency->second.median_.count() > 0) {
+      delay = latency->second.median_;
+      if (latency->second.sigma_ > 0) {
+        std::lognormal_distribution<double> dist{
+            std::log(static_cast<double>(delay.count())), latency->second.sigma_};
+        delay = std::chrono::microseconds{static_cast<int64_t>(dist(random_))};
+      }
+    }
+
+    auto config = faults_.find(endpoint);
+    if (config == faults_.end()) {
+      config = faults_.find(std::string_view{});
+    }
+    if (config != faults_.end()) {
+      const auto &prob = config->second;
+      auto sample = std::uniform_real_distribution<double>{0, 1}(random_);
+      if (sample < prob.unavailable_) {
+        fault = Fault::unavailable;
+      } else if (sample < prob.unavailable_ + prob.rejected_) {
+        fault = Fault::rejected;
+      } else if (sample < prob.unavailable_ + prob.rejected_ + prob.ambiguous_) {
+        fault = Fault::ambiguous;
+      }
+      fault_count_ += fault == Fault::none ? 0 : 1;
+    }
+  }
+
+  if (delay.count() > 0) {
+    std::this_thread::sleep_for(delay);
+  }
+  return fault;
+}
+
+/**
+ * @brief 写入一个 key
+ *
+ * @param key ETCD key
+ * @param value ETCD value
+ * @param lease_id 绑定的租约，为空时不绑定
+ * @return true 写入成功
+ * @return false 租约不存在
+ */
+auto EtcdServerMemory::put(std::string_view key, std::string_view value,
+                           std::string_view lease_id) -> bool {
+  std::lock_guard<std::mutex> lock{mutex_};
+  expireLocked();
+  if (!lease_id.empty() && leases_.find(lease_id) == leases_.end()) {
+    return false;
+  }
+  putLocked(key, value, lease_id);
+  commitLocked();
+  return true;
+}
+
+/**
+ * @brief 读取一个 key 或者一个前缀下的所有 key，按 key 排序
+ *
+ * @param key ETCD key 或者前缀
+ * @param prefix 是否按前缀读取
+ * @param revision 读取时的 revision（返回值）
+ * @return std::vector<std::pair<std::string, std::string>> key-value
+ */
+auto EtcdServerMemory::range(std::string_view key, bool prefix, int64_t &revision)
+    -> std::vector<std::pair<std::string, KeyValue>> {
+  std::lock_guard<std::mutex> lock{mutex_};
+  expireLocked();
+  revision = revision_;
+
+  std::vector<std::pair<std::string, KeyValue>> result{};
+  for (auto iter = data_.lower_bound(key); iter != data_.end(); ++iter) {
+    if (prefix ? iter->first.compare(0, key.size(), key) != 0 : iter->first != key) {
+      break;
+    }
+    result.emplace_back(iter->first, iter->second);
+  }
+  return result;
+}
+
+/**
+ * @brief 删除一个 key 或者一个前缀下的所有 key
+ *
+ * @param key ETCD key 或者前缀
+ * @param prefix 是否按前缀删除
+ * @return int64_t 删除的数量
+ */
+auto EtcdServerMemory::del(std::string_view key, bool prefix) -> int64_t {
+  std::lock_guard<std::mutex> lock{mutex_};
+  expireLocked();
+
+  int64_t count{0};
+  auto iter = data_.lower_bound(key);
+  while (iter != data_.end() &&
+         (prefix ? iter->first.compare(0, key.size(), key) == 0 : iter->first == key)) {
+    auto next = std::next(iter);
+    delLocked(iter);
+    iter = next;
+    ++count;
+  }
+  commitLocked();
+  return count;
+}
+
+/**
+ * @brief 申请一个租约
+ *
+ * @param ttl 有效期，单位秒
+ * @return std::string 租约 ID（十六进制）
+ */
+auto EtcdServerMemory::grantLease(int64_t ttl) -> std::string {
+  OHNO_ASSERT(ttl > 0);
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto lease_id = fmt::format("{:016x}", next_lease_++);
+  leases_[lease_id] = Lease{ttl, std::chrono::steady_clock::now() + std::chrono::seconds{ttl}};
+  return lease_id;
+}
+
+/**
+ * @brief 续约一次
+ *
+ * @param lease_id 租约 ID
+ * @return std::optional<int64_t> 租约的有效期，租约已经过期时为空
+ */
+auto EtcdServerMemory::keepAliveLease(std::string_view lease_id) -> std::optional<int64_t> {
+  std::lock_guard<std::mutex> lock{mutex_};
+  expireLocked();
+  auto iter = leases_.find(lease_id);
+  if (iter == leases_.end()) {
+    return std::nullopt;
+  }
+  iter->second.deadline_ =
+      std::chrono::steady_clock::now() + std::chrono::seconds{iter->second.ttl_};
+  return iter->second.ttl_;
+}
+
+/**
+ * @brief 原子执行一个事务：比较条件全部成立时执行所有操作，所有操作共用一个 revision
+ *
+ * @param cmps 比较条件，key 不存在时 mod/create revision 为 0
+ * @param ops 事务中的操作
+ * @return TxnResult committed 执行成功；conflicted 比较条件不成立，没有任何操作生效；
+ * failed 引用了不存在的租约，没有任何操作生效
+ */
+auto EtcdServerMemory::commit(const std::vector<TxnCmp> &cmps, const std::vector<TxnOp> &ops)
+    -> TxnResult {
+  std::lock_guard<std::mutex> lock{mutex_};
+  expireLocked();
+  for (const auto &cmp : cmps) {
+    auto iter = data_.find(cmp.key_);
+    int64_t revision{0};
+    if (iter != data_.end()) {
+      revision = cmp.target_ == TxnCmpTarget::mod ? iter->second.mod_revision_
+                                                  : iter->second.create_revision_;
+    }
+    if (revision != cmp.revision_) {
+      return TxnResult::conflicted;
+    }
+  }
+  for (const auto &op : ops) {
+    if (!op.lease_id_.empty() && leases_.find(op.lease_id_) == leases_.end()) {
+      return TxnResult::failed;
+    }
+  }
+
+  for (const auto &op : ops) {
+    if (op.type_ == TxnOpType::put) {
+      putLocked(op.key_, op.value_, op.lease_id_);
+    } else if (auto iter = data_.find(op.key_); iter != data_.end()) {
+      delLocked(iter);
+    }
+  }
+  commitLocked();
+  return TxnResult::committed;
+}
+
+/**
+ * @brief 监听一个前缀，输出格式与 etcdctl watch -w json 相同；与 ShellSync::stream() 一样，
+ * 空闲时以空行调用回调
+ *
+ * @param prefix ETCD key 前缀
+ * @param revision 从哪个 revision 开始（包含）
+ * @param callback 每批事件调用一次，返回 false 时停止监听
+ * @return int 被回调结束时为 0，revision 被压缩或者服务端关闭时为 1
+ */
+auto EtcdServerMemory::watch(std::string_view prefix, int64_t revision,
+                             const std::function<bool(std::string_view line)> &callback)
+    -> int {
+  std::unique_lock<std::mutex> lock{mutex_};
+  auto next = revision;
+  while (!stopped_) {
+    if (next < compact_revision_) {
+      auto line = fmt::format(
+          R"({{"Header":{{"revision":{}}},"CompactRevision":{},"Canceled":true,"Created":false}})",
+          revision_, compact_revision_);
+      lock.unlock();
+      callback(line);
+      return 1;
+    }
+
+    std::vector<const Event *> events{};
+    auto iter =
+        std::lower_bound(history_.begin(), history_.end(), next,
+                         [](const Event &event, int64_t rev) { return event.revision_ < rev; });
+    for (; iter != history_.end(); ++iter) {
+      if (iter->key_.compare(0, prefix.size(), prefix) == 0) {
+        events.emplace_back(&*iter);
+      }
+    }
+    next = std::max(next, revision_ + 1);
+
+    std::string line{};
+    if (!events.empty()) {
+      line = watchLine(events);
+    } else if (cond_.wait_for(lock, util::STREAM_IDLE_INTERVAL,
+                              [&]() { return stopped_ || revision_ >= next; })) {
+      continue;
+    }
+    lock.unlock();
+    if (!callback(line)) {
+      return 0;
+    }
+    lock.lock();
+  }
+  return 1;
+}
+
+/**
+ * @brief 写入一个 key，调用者持有锁，同一个写请求中的所有修改共用一个 revision
+ *
+ */
+auto EtcdServerMemory::putLocked(std::string_view key, std::string_view value,
+                                 std::string_view lease_id) -> void {
+  if (!pending_) {
+    ++revision_;
+    pending_ = true;
+  }
+  auto &kv = data_[std::string{key}];
+  if (kv.version_ == 0) {
+    kv.create_revision_ = revision_;
+  }
+  kv.value_ = value;
+  kv.mod_revision_ = revision_;
+  ++kv.version_;
+  kv.lease_id_ = lease_id;
+  history_.emplace_back(Event{revision_, false, std::string{key}, kv});
+}
+
+/**
+ * @brief 删除一个 key，调用者持有锁
+ *
+ */
+auto EtcdServerMemory::delLocked(KeyValueMap::iterator iter) -> void {
+  if (!pending_) {
+    ++revision_;
+    pending_ = true;
+  }
+  history_.emplace_back(Event{revision_, true, iter->first, KeyValue{{}, 0, revision_, 0, {}}});
+  data_.erase(iter);
+}
+
+/**
+ * @brief 结束一个写请求：需要时自动压缩，并唤醒 watch
+ *
+ */
+auto EtcdServerMemory::commitLocked() -> void {
+  if (!pending_) {
+    return;
+  }
+  pending_ = false;
+  if (retention_ > 0 && revision_ - retention_ > compact_revision_) {
+    compactLocked(revision_ - retention_);
+  }
+  cond_.notify_all();
+}
+
+/**
+ * @brief 删除过期的租约以及绑定的 key，每个租约的删除是一个单独的写请求
+ *
+ */
+auto EtcdServerMemory::expireLocked() -> void {
+  auto now = std::chrono::steady_clock::now();
+  for (auto lease = leases_.begin(); lease != leases_.end();) {
+    if (lease->second.deadline_ > now) {
+      ++lease;
+      continue;
+    }
+    OHNO_LOG(debug, "Lease {} expired", lease->first);
+    for (auto iter = data_.begin(); iter != data_.end();) {
+      auto next = std::next(iter);
+      if (iter->second.lease_id_ == lease->first) {
+        delLocked(iter);
+      }
+      iter = next;
+    }
+    commitLocked();
+    lease = leases_.erase(lease);
+  }
+}
+
+/**
+ * @brief 删除 revision 之前的历史事件，调用者持有锁
+ *
+ */
+auto EtcdServerMemory::compactLocked(int64_t revision) -> void {
+  compact_revision_ = revision;
+  while (!history_.empty() && history_.front().revision_ < revision) {
+    history_.pop_front();
+  }
+}
+
+/**
+ * @brief 将一批事件格式化为 etcdctl watch -w json 的一行输出
+ *
+ */
+auto EtcdServerMemory::watchLine(const std::vector<const Event *> &events) const -> std::string {
+  auto array = nlohmann::json::array();
+  for (const auto *event : events) {
+    nlohmann::json kv{{"key", helper::base64Encode(event->key_)},
+                      {"mod_revision", event->kv_.mod_revision_}};
+    nlohmann::json item{};
+    if (event->del_) {
+      item["type"] = 1; // etcdctl 省略值为 0 的 PUT
+    } else {
+      kv["create_revision"] = event->kv_.create_revision_;
+      kv["version"] = event->kv_.version_;
+      kv["value"] = helper::base64Encode(event->kv_.value_);
+    }
+    item["kv"] = std::move(kv);
+    array.emplace_back(std::move(item));
+  }
+  nlohmann::json json{{"Header", {{"revision", revision_}}},
+                      {"Events", std::move(array)},
+                      {"CompactRevision", 0},
+                      {"Canceled", false},
+                      {"Created", false}};
+  return json.dump();
+}
+
+namespace {
+
+/**
+ * @brief 解析之后的 etcdctl 命令
+ *
+ */
+struct Command {
+  std::string endpoint_;                               // --endpoints 中的第一个端点
+  std::vector<std::string_view> args_;                 // 子命令及位置参数
+  std::map<std::string_view, std::string_view> flags_; // 开关选项（如 --prefix）的值为空
+  std::vector<std::string> input_;                     // 管道输入的各行（txn）
+};
+
+auto tokenize(std::string_view str) -> std::vector<std::string_view> {
+  std::vector<std::string_view> tokens{};
+  while (!str.empty()) {
+    auto pos = str.find(' ');
+    auto token = str.substr(0, pos);
+    if (!token.empty()) {
+      tokens.emplace_back(token);
+    }
+    str.remove_prefix(pos == std::string_view::npos ? str.size() : pos + 1);
+  }
+  return tokens;
+}
+
+/**
+ * @brief 解析 EtcdClientShell 生成的命令，形如 "[exec ]etcdctl --endpoints=... <子命令>"，
+ * 或者 "printf '%s\n' '...' ... | etcdctl ..."
+ *
+ * @param command shell 命令
+ * @return Command 解析结果，位置参数为空表示无法识别
+ */
+auto parseCommand(std::string_view command) -> Command {
+  Command cmd{};
+  if (auto pipe = command.rfind(" | "); pipe != std::string_view::npos) {
+    // printf 的第一个参数是格式，之后每个参数是一行；参数由单引号字符串与 \' 拼接而成
+    auto input = command.substr(0, pipe);
+    command.remove_prefix(pipe + 3);
+    std::vector<std::string> words{};
+    std::optional<std::string> word{};
+    for (size_t i = 0; i < input.size(); ++i) {
+      if (input[i] == ' ') {
+        if (word) {
+          words.emplace_back(std::move(*word));
+          word.reset();
+        }
+        continue;
+      }
+      if (!word) {
+        word.emplace();
+      }
+      if (input[i] == '\\' && i + 1 < input.size()) {
+        *word += input[++i];
+      } else if (input[i] == '\'') {
+        auto end = input.find('\'', i + 1);
+        if (end == std::string_view::npos) {
+          break;
+        }
+        *word += input.substr(i + 1, end - i - 1);
+        i = end;
+      } else {
+        *word += input[i];
+      }
+    }
+    if (word) {
+      words.emplace_back(std::move(*word));
+    }
+    if (words.size() > 2 && words[0] == "printf") {
+      cmd.input_.assign(std::make_move_iterator(words.begin() + 2),
+                        std::make_move_iterator(words.end()));
+    }
+  }
+
+  auto tokens = tokenize(command);
+  size_t index = !tokens.empty() && tokens[0] == "exec" ? 1 : 0;
+  if (index >= tokens.size() || tokens[index] != "etcdctl") {
+    return cmd;
+  }
+  bool positional = false; // "--" 之后全部是位置参数
+  for (++index; index < tokens.size(); ++index) {
+    auto token = tokens[index];
+    if (positional || token[0] != '-') {
+      cmd.args_.emplace_back(token);
+    } else if (token == "--") {
+      positional = true;
+    } else if (token == "-w" && index + 1 < tokens.size()) {
+      cmd.flags_[token] = tokens[++index];
+    } else {
+      auto equal = token.find('=');
+      cmd.flags_[token.substr(0, equal)] =
+          equal == std::string_view::npos ? std::string_view{} : token.substr(equal + 1);
+    }
+  }
+
+  auto endpoints = cmd.flags_["--endpoints"];
+  cmd.endpoint_ = endpoints.substr(0, endpoints.find(','));
+  return cmd;
+}
+
+/**
+ * @brief 还原 etcdctl txn 中双引号字符串的转义（与 etcdctl 一样按 Go 字符串字面量解析）
+ *
+ * @param str 双引号之间的内容
+ * @return std::string 原始字符串
+ */
+auto unquote(std::string_view str) -> std::string {
+  std::string result{};
+  for (size_t i = 0; i < str.size(); ++i) {
+    if (str[i] != '\\' || i + 1 == str.size()) {
+      result += str[i];
+      continue;
+    }
+    switch (str[++i]) {
+    case 'n':
+      result += '\n';
+      break;
+    case 'r':
+      result += '\r';
+      break;
+    case 't':
+      result += '\t';
+      break;
+    default:
+      result += str[i];
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief 解析 etcdctl txn 的一行操作："put [--lease=ID] KEY \"VALUE\"" 或者 "del KEY"
+ *
+ * @param line 一行操作
+ * @return std::optional<TxnOp> 操作，无法识别时为空
+ */
+auto parseTxnOp(std::string_view line) -> std::optional<TxnOp> {
+  TxnOp op{};
+  auto quote = line.find('"');
+  if (quote != std::string_view::npos) {
+    auto end = line.rfind('"');
+    if (end == quote) {
+      return std::nullopt;
+    }
+    op.value_ = unquote(line.substr(quote + 1, end - quote - 1));
+  }
+
+  auto tokens = tokenize(line.substr(0, quote));
+  if (tokens.size() == 2 && tokens[0] == "del" && quote == std::string_view::npos) {
+    op.type_ = TxnOpType::del;
+    op.key_ = tokens[1];
+    return op;
+  }
+  if (tokens.empty() || tokens[0] != "put" || quote == std::string_view::npos) {
+    return std::nullopt;
+  }
+  for (size_t i = 1; i < tokens.size(); ++i) {
+    constexpr std::string_view LEASE{"--lease="};
+    if (tokens[i].substr(0, LEASE.size()) == LEASE) {
+      op.lease_id_ = tokens[i].substr(LEASE.size());
+    } else {
+      op.key_ = tokens[i];
+    }
+  }
+  return op.key_.empty() ? std::nullopt : std::make_optional(std::move(op));
+}
+
+/**
+ * @brief 解析 etcdctl txn 的一行比较条件：mod("KEY") = "REVISION" 或者 create("KEY") = "REVISION"
+ *
+ * @param line 一行比较条件
+ * @return std::optional<TxnCmp> 比较条件，无法识别时为空
+ */
+auto parseTxnCmp(std::string_view line) -> std::optional<TxnCmp> {
+  TxnCmp cmp{};
+  constexpr std::string_view MOD{"mod(\""};
+  constexpr std::string_view CREATE{"create(\""};
+  constexpr std::string_view EQUAL{"\") = \""};
+  if (line.substr(0, MOD.size()) == MOD) {
+    cmp.target_ = TxnCmpTarget::mod;
+    line.remove_prefix(MOD.size());
+  } else if (line.substr(0, CREATE.size()) == CREATE) {
+    cmp.target_ = TxnCmpTarget::create;
+    line.remove_prefix(CREATE.size());
+  } else {
+    return std::nullopt;
+  }
+  auto equal = line.find(EQUAL);
+  if (equal == std::string_view::npos || line.size() < equal + EQUAL.size() + 2 ||
+      line.back() != '"') {
+    return std::nullopt;
+  }
+  cmp.key_ = line.substr(0, equal);
+  auto revision = line.substr(equal + EQUAL.size());
+  revision.remove_suffix(1);
+  auto [ptr, ec] = std::from_chars(revision.data(), revision.data() + revision.size(),
+                                   cmp.revision_);
+  if (ec != std::errc{} || ptr != revision.data() + revision.size() || cmp.key_.empty()) {
+    return std::nullopt;
+  }
+  return cmp;
+}
+
+/**
+ * @brief 在服务端上执行一条 etcdctl 命令
+ *
+ * @return int etcdctl 返回值
+ */
+auto run(EtcdServerMemory &server, const Command &cmd, std::string &out, std::string &err)
+    -> int {
+  auto flag = [&cmd](std::string_view name) -> std::optional<std::string_view> {
+    auto iter = cmd.flags_.find(name);
+    return iter == cmd.flags_.end() ? std::nullopt : std::make_optional(iter->second);
+  };
+  const auto &args = cmd.args_;
+  auto op = args[0];
+
+  if (op == "endpoint" && args.size() == 2 && args[1] == "health") {
+    out = fmt::format("{} is healthy: successfully committed proposal: took = 1ms\n",
+                      cmd.endpoint_);
+    return 0;
+  }
+  if (op == "put" && args.size() >= 3) {
+    // 与 shell 分词不同，value 中的空格保留下来
+    const auto *begin = args[2].data();
+    const auto *end = args.back().data() + args.back().size();
+    if (!server.put(args[1], std::string_view{begin, static_cast<size_t>(end - begin)},
+                    flag("--lease").value_or(std::string_view{}))) {
+      err = ETCD_ERR_LEASE;
+      return 1;
+    }
+    out = "OK\n";
+    return 0;
+  }
+  if (op == "get" && args.size() == 2) {
+    int64_t revision{0};
+    auto kvs = server.range(args[1], flag("--prefix").has_value(), revision);
+    if (flag("-w").value_or(std::string_view{}) == "json") {
+      auto array = nlohmann::json::array();
+      for (const auto &[key, kv] : kvs) {
+        array.push_back({{"key", helper::base64Encode(key)},
+                         {"create_revision", kv.create_revision_},
+                         {"mod_revision", kv.mod_revision_},
+                         {"version", kv.version_},
+                         {"value", helper::base64Encode(kv.value_)}});
+      }
+      nlohmann::json json{{"header", {{"revision", revision}}}, {"count", kvs.size()}};
+      if (!array.empty()) {
+        json["kvs"] = std::move(array);
+      }
+      out = json.dump();
+      return 0;
+    }
+    auto value_only = flag("--print-value-only").has_value();
+    out.clear();
+    for (const auto &[key, kv] : kvs) {
+      out += value_only ? fmt::format("{}\n", kv.value_)
+                        : fmt::format("{}\n{}\n", key, kv.value_);
+    }
+    return 0;
+  }
+  if (op == "del" && args.size() == 2) {
+    out = fmt::format("{}\n", server.del(args[1], flag("--prefix").has_value()));
+    return 0;
+  }
+  if (op == "lease" && args.size() == 3 && args[1] == "grant") {
+    auto ttl = std::stoll(std::string{args[2]});
+    out = fmt::format("lease {} granted with TTL({}s)\n", server.grantLease(ttl), ttl);
+    return 0;
+  }
+  if (op == "lease" && args.size() == 3 && args[1] == "keep-alive") {
+    auto ttl = server.keepAliveLease(args[2]);
+    if (!ttl.has_value()) {
+      out = fmt::format("lease {} expired or revoked.\n", args[2]);
+      return 0;
+    }
+    out = fmt::format("lease {} keepalived with TTL({})\n", args[2], ttl.value());
+    return 0;
+  }
+  if (op == "compaction" && args.size() == 2) {
+    auto revision = std::stoll(std::string{args[1]});
+    if (!server.compact(revision)) {
+      err = ETCD_ERR_COMPACTED;
+      return 1;
+    }
+    out = fmt::format("compacted revision {}\n", revision);
+    return 0;
+  }
+  if (op == "txn" && args.size() == 1) {
+    // 输入依次为：比较条件、空行、成功时的操作、空行、失败时的操作、空行
+    const auto &lines = cmd.input_;
+    auto begin = std::find(lines.begin(), lines.end(), std::string_view{});
+    auto end = begin == lines.end() ? begin : std::find(begin + 1, lines.end(), std::string_view{});
+    if (end == lines.end()) {
+      err = "Error: malformed txn input";
+      return 1;
+    }
+    std::vector<TxnCmp> cmps{};
+    for (auto iter = lines.begin(); iter != begin; ++iter) {
+      auto txn_cmp = parseTxnCmp(*iter);
+      if (!txn_cmp.has_value()) {
+        err = fmt::format("Error: invalid txn compare: {}", *iter);
+        return 1;
+      }
+      cmps.emplace_back(std::move(txn_cmp.value()));
+    }
+    std::vector<TxnOp> ops{};
+    for (auto iter = begin + 1; iter != end; ++iter) {
+      auto txn_op = parseTxnOp(*iter);
+      if (!txn_op.has_value()) {
+        err = fmt::format("Error: invalid txn operation: {}", *iter);
+        return 1;
+      }
+      ops.emplace_back(std::move(txn_op.value()));
+    }
+    if (ops.size() > MAX_TXN_OPS) {
+      err = "Error: etcdserver: too many operations in txn request";
+      return 1;
+    }
+    auto result = server.commit(cmps, ops);
+    if (result == TxnResult::failed) {
+      err = ETCD_ERR_LEASE;
+      return 1;
+    }
+    if (result == TxnResult::conflicted) {
+      out = "FAILURE\n";
+      return 0;
+    }
+    out = "SUCCESS\n";
+    for (const auto &txn_op : ops) {
+      out += txn_op.type_ == TxnOpType::put ? "\nOK\n" : "\n1\n";
+    }
+    return 0;
+  }
+
+  err = fmt::format("Error: unknown command: {}", op);
+  return 1;
+}
+
+} // namespace
+
+EtcdctlMemory::EtcdctlMemory(std::shared_ptr<EtcdServerMemory> server)
+    : server_{std::move(server)} {
+  OHNO_ASSERT(server_);
+}
+
+auto EtcdctlMemory::execute(std::string_view command, std::string &out) const -> bool {
+  std::string err{};
+  return execute(command, out, err) == 0;
+}
+
+/**
+ * @brief 执行一条 etcdctl 命令，先经过服务端的故障注入与延迟
+ *
+ * @param command shell 命令
+ * @param out stdout（返回值）
+ * @param err stderr（返回值）
+ * @return int etcdctl 返回值
+ */
+auto EtcdctlMemory::execute(std::string_view command, std::string &out, std::string &err) const
+    -> int {
+  out.clear();
+  err.clear();
+  auto cmd = parseCommand(command);
+  if (cmd.args_.empty()) {
+    err = fmt::format("Error: unsupported command: {}", command);
+    return 1;
+  }
+
+  auto fault = server_->inject(cmd.endpoint_, cmd.args_[0]);
+  if (fault == EtcdServerMemory::Fault::unavailable) {
+    err = ETCD_ERR_UNAVAILABLE;
+    return 1;
+  }
+  if (fault == EtcdServerMemory::Fault::rejected) {
+    err = ETCD_ERR_REJECTED;
+    return 1;
+  }
+  auto ret = run(*server_, cmd, out, err);
+  if (fault == EtcdServerMemory::Fault::ambiguous) {
+    out.clear();
+    err = ETCD_ERR_TIMEOUT;
+    return 1;
+  }
+  return ret;
+}
+
+/**
+ * @brief 执行 etcdctl watch，直到回调要求停止、revision 被压缩或者服务端关闭
+ *
+ * @param command shell 命令
+ * @param callback 每行输出调用一次，空闲时以空行调用
+ * @return int etcdctl 返回值，被回调结束时为 0
+ */
+auto EtcdctlMemory::stream(std::string_view command,
+                           const std::function<bool(std::string_view line)> &callback) const
+    -> int {
+  auto cmd = parseCommand(command);
+  auto rev = cmd.flags_.find("--rev");
+  if (cmd.args_.size() != 2 || cmd.args_[0] != "watch" || rev == cmd.flags_.end()) {
+    return 1;
+  }
+  if (server_->inject(cmd.endpoint_, "watch") != EtcdServerMemory::Fault::none) {
+    return 1;
+  }
+  return server_->watch(cmd.args_[1], std::stoll(std::string{rev->second}), callback);
+}
+
+} // namespace etcd
+} // namespace ohno
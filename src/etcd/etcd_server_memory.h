@@ -0,0 +1,162 @@
+#pragma once
+
+// clang-format off
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "etcd_txn.h"
+#include "src/log/logger.h"
+#include "src/util/shell_if.h"
+// clang-format on
+
+namespace ohno {
+namespace etcd {
+
+constexpr std::string_view ETCD_ERR_UNAVAILABLE{
+    "Error: rpc error: code = Unavailable desc = connection error: connect: connection refused"};
+constexpr std::string_view ETCD_ERR_TIMEOUT{"Error: context deadline exceeded"};
+constexpr std::string_view ETCD_ERR_REJECTED{"Error: etcdserver: too many requests"};
+constexpr std::string_view ETCD_ERR_LEASE{"Error: etcdserver: requested lease not found"};
+constexpr std::string_view ETCD_ERR_COMPACTED{
+    "Error: etcdserver: mvcc: required revision has been compacted"};
+
+/**
+ * @brief 一类请求的延迟分布：对数正态分布，sigma_ 为 0 时是固定延迟
+ *
+ */
+struct EtcdLatency {
+  std::chrono::microseconds median_{0};
+  double sigma_{0}; // 形状参数，0.5 左右时 p99 约为中位数的 3 倍
+};
+
+/**
+ * @brief 一个端点的故障注入概率，每次请求独立抽样
+ *
+ */
+struct EtcdFault {
+  double unavailable_{0}; // 请求没有执行，返回 connection refused，客户端换端点重试
+  double rejected_{0};    // 请求没有执行，返回 too many requests，客户端直接失败
+  double ambiguous_{0};   // 请求已经执行，但客户端看到 context deadline exceeded，只有读请求重试
+};
+
+/**
+ * @brief 内存中的 ETCD 服务端，多个 EtcdctlMemory 共享同一个实例，相当于同一个 ETCD 集群
+ *
+ * 按照 ETCD v3 的语义维护 revision、租约与历史事件：每个写请求（包括事务）使 revision 加一，
+ * 租约过期时绑定的 key 被删除，压缩之后从更早的 revision 开始 watch 会失败；
+ * 另外可以按请求类型配置延迟分布、按端点注入故障，用于离线的基准测试与长时间稳定性测试
+ *
+ * @note 所有数据由一把锁保护，延迟在锁外等待，所以并发请求的延迟互不累加
+ */
+class EtcdServerMemory final : public log::Loggable<log::Id::etcd> {
+public:
+  enum class Fault : uint8_t { none, unavailable, rejected, ambiguous };
+
+  struct KeyValue {
+    std::string value_;
+    int64_t create_revision_{0};
+    int64_t mod_revision_{0};
+    int64_t version_{0};
+    std::string lease_id_;
+  };
+
+  explicit EtcdServerMemory(uint64_t seed = 0);
+
+  auto setLatency(std::string_view op, EtcdLatency latency) -> void;
+  auto setFault(std::string_view endpoint, EtcdFault fault) -> void;
+  auto setAutoCompaction(int64_t retention) -> void;
+  auto compact(int64_t revision) -> bool;
+  auto expireLease(std::string_view lease_id) -> bool;
+  auto shutdown() -> void;
+
+  auto getRevision() const -> int64_t;
+  auto getCompactRevision() const -> int64_t;
+  auto getRequests(std::string_view op = {}) const -> uint64_t;
+  auto getFaults() const -> uint64_t;
+  auto size() const -> size_t;
+
+  auto inject(std::string_view endpoint, std::string_view op) -> Fault;
+  auto put(std::string_view key, std::string_view value, std::string_view lease_id = {})
+      -> bool;
+  auto range(std::string_view key, bool prefix, int64_t &revision)
+      -> std::vector<std::pair<std::string, KeyValue>>;
+  auto del(std::string_view key, bool prefix) -> int64_t;
+  auto grantLease(int64_t ttl) -> std::string;
+  auto keepAliveLease(std::string_view lease_id) -> std::optional<int64_t>;
+  auto commit(const std::vector<TxnCmp> &cmps, const std::vector<TxnOp> &ops) -> TxnResult;
+  auto watch(std::string_view prefix, int64_t revision,
+             const std::function<bool(std::string_view line)> &callback) -> int;
+
+private:
+  struct Event {
+    int64_t revision_{0};
+    bool del_{false};
+    std::string key_;
+    KeyValue kv_;
+  };
+
+  struct Lease {
+    int64_t ttl_{0};
+    std::chrono::steady_clock::time_point deadline_;
+  };
+
+  using KeyValueMap = std::map<std::string, KeyValue, std::less<>>;
+
+  auto putLocked(std::string_view key, std::string_view value, std::string_view lease_id)
+      -> void;
+  auto delLocked(KeyValueMap::iterator iter) -> void;
+  auto commitLocked() -> void;
+  auto expireLocked() -> void;
+  auto compactLocked(int64_t revision) -> void;
+  auto watchLine(const std::vector<const Event *> &events) const -> std::string;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cond_; // revision 变化或者服务端关闭时唤醒 watch
+  KeyValueMap data_;
+  std::map<std::string, Lease, std::less<>> leases_;
+  std::deque<Event> history_; // 按 revision 排列，压缩时删除较早的事件
+  int64_t revision_{1};       // 与 ETCD 一样，空集群的 revision 为 1
+  int64_t compact_revision_{0};
+  int64_t retention_{0}; // 自动压缩时保留的 revision 数，0 表示不自动压缩
+  uint64_t next_lease_{0x694d7a5d2d1c2b00};
+  bool pending_{false}; // 当前写请求是否已经修改过数据，决定 revision 是否加一
+  bool stopped_{false};
+
+  std::map<std::string, EtcdLatency, std::less<>> latency_; // key 为空表示默认延迟
+  std::map<std::string, EtcdFault, std::less<>> faults_;    // key 为空表示所有端点
+  std::map<std::string, uint64_t, std::less<>> requests_;
+  uint64_t fault_count_{0};
+  std::mt19937_64 random_;
+};
+
+/**
+ * @brief 在 EtcdServerMemory 上解释 EtcdClientShell 生成的 etcdctl 命令，
+ * 输出格式与 etcdctl 一致，可以直接替换 ShellSync
+ *
+ */
+class EtcdctlMemory final : public util::ShellIf {
+public:
+  explicit EtcdctlMemory(std::shared_ptr<EtcdServerMemory> server);
+
+  auto execute(std::string_view command, std::string &out) const -> bool override;
+  auto execute(std::string_view command, std::string &out, std::string &err) const -> int override;
+  auto stream(std::string_view command,
+              const std::function<bool(std::string_view line)> &callback) const -> int override;
+
+private:
+  std::shared_ptr<EtcdServerMemory> server_;
+};
+
+} // namespace etcd
+} // namespace ohno
@@ -0,0 +1,120 @@
+// clang-format off
+#include "etcd_txn.h"
+#include <algorithm>
+#include <random>
+#include "src/common/assert.h"
+// clang-format on
+
+namespace ohno {
+namespace etcd {
+
+/**
+ * @brief 增加一个 put 操作
+ *
+ * @param key ETCD key
+ * @param value ETCD value
+ * @param lease_id 租约 ID（十六进制，为空时不绑定租约）
+ * @return EtcdTxn& 事务本身，便于链式调用
+ */
+auto EtcdTxn::put(std::string_view key, std::string_view value, std::string_view lease_id)
+    -> EtcdTxn & {
+  OHNO_ASSERT(!key.empty());
+  OHNO_ASSERT(!value.empty());
+  erase(key);
+  ops_.emplace_back(TxnOp{TxnOpType::put, std::string{key}, std::string{value},
+                          std::string{lease_id}});
+  return *this;
+}
+
+/**
+ * @brief 增加一个 del 操作
+ *
+ * @param key ETCD key
+ * @return EtcdTxn& 事务本身，便于链式调用
+ */
+auto EtcdTxn::del(std::string_view key) -> EtcdTxn & {
+  OHNO_ASSERT(!key.empty());
+  erase(key);
+  ops_.emplace_back(TxnOp{TxnOpType::del, std::string{key}, std::string{}, std::string{}});
+  return *this;
+}
+
+/**
+ * @brief 增加一个比较条件，同一个 key 的同一种条件只保留第一次（即第一次读取时的 revision）
+ *
+ * @param target 比较 mod_revision 还是 create_revision
+ * @param key ETCD key
+ * @param revision 期望的 revision，0 表示 key 不存在
+ * @return EtcdTxn& 事务本身，便于链式调用
+ */
+auto EtcdTxn::compare(TxnCmpTarget target, std::string_view key, int64_t revision)
+    -> EtcdTxn & {
+  OHNO_ASSERT(!key.empty());
+  OHNO_ASSERT(revision >= 0);
+  auto iter = std::find_if(cmps_.begin(), cmps_.end(), [target, key](const TxnCmp &cmp) {
+    return cmp.target_ == target && cmp.key_ == key;
+  });
+  if (iter == cmps_.end()) {
+    cmps_.emplace_back(TxnCmp{target, std::string{key}, revision});
+  }
+  return *this;
+}
+
+/**
+ * @brief 查找 key 在事务中尚未提交的值，便于在提交之前读到自己的写入
+ *
+ * @param key ETCD key
+ * @return std::optional<std::string> 事务没有操作过该 key 时为空；被删除时为空字符串
+ */
+auto EtcdTxn::find(std::string_view key) const -> std::optional<std::string> {
+  auto iter =
+      std::find_if(ops_.begin(), ops_.end(), [key](const TxnOp &op) { return op.key_ == key; });
+  if (iter == ops_.end()) {
+    return std::nullopt;
+  }
+  return iter->value_;
+}
+
+auto EtcdTxn::empty() const noexcept -> bool { return ops_.empty(); }
+
+auto EtcdTxn::size() const noexcept -> size_t { return ops_.size(); }
+
+auto EtcdTxn::getOps() const noexcept -> const std::vector<TxnOp> & { return ops_; }
+
+auto EtcdTxn::getCmps() const noexcept -> const std::vector<TxnCmp> & { return cmps_; }
+
+auto EtcdTxn::clear() noexcept -> void {
+  ops_.clear();
+  cmps_.clear();
+}
+
+/**
+ * @brief 删除 key 之前的操作
+ *
+ * @param key ETCD key
+ */
+auto EtcdTxn::erase(std::string_view key) -> void {
+  ops_.erase(std::remove_if(ops_.begin(), ops_.end(),
+                            [key](const TxnOp &op) { return op.key_ == key; }),
+             ops_.end());
+}
+
+/**
+ * @brief 事务冲突之后重试前等待的时间
+ *
+ * 等待上限随重试次数翻倍，实际等待时间在上限内随机选取：同一时刻冲突的 CNI 进程错开重试，
+ * 不会每一轮都挑中同一个地址、同时重写同一个列表
+ *
+ * @param attempt 已经冲突的次数（从 1 开始）
+ * @return std::chrono::milliseconds 等待时间
+ */
+auto getTxnBackoff(int attempt) -> std::chrono::milliseconds {
+  OHNO_ASSERT(attempt > 0);
+  thread_local std::mt19937_64 engine{std::random_device{}()};
+  auto limit = TXN_BACKOFF_BASE.count() << std::min(attempt - 1, TXN_BACKOFF_MAX_SHIFT);
+  std::uniform_int_distribution<int64_t> dist{0, limit};
+  return std::chrono::milliseconds{dist(engine)};
+}
+
+} // namespace etcd
+} // namespace ohno
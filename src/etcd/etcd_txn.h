@@ -0,0 +1,67 @@
+#pragma once
+
+// clang-format off
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+// clang-format on
+
+namespace ohno {
+namespace etcd {
+
+constexpr size_t MAX_TXN_OPS{128}; // ETCD 服务端 --max-txn-ops 默认值
+constexpr std::chrono::milliseconds TXN_BACKOFF_BASE{2}; // 冲突之后第一次重试前最多等待的时间
+constexpr int TXN_BACKOFF_MAX_SHIFT{6};                 // 等待上限最多翻倍的次数
+
+enum class TxnOpType : uint8_t { put, del };
+enum class TxnCmpTarget : uint8_t { mod, create };
+enum class TxnResult : uint8_t { committed, conflicted, failed };
+
+class TxnOp final {
+public:
+  TxnOpType type_{TxnOpType::put};
+  std::string key_;
+  std::string value_;
+  std::string lease_id_; // 为空时不绑定租约
+};
+
+class TxnCmp final {
+public:
+  TxnCmpTarget target_{TxnCmpTarget::mod};
+  std::string key_;
+  int64_t revision_{0}; // key 不存在时 mod/create revision 都为 0
+};
+
+/**
+ * @brief ETCD 事务构造器，收集若干 put/del 之后由 EtcdClientIf::commit() 一次性原子提交
+ *
+ * ETCD 不允许同一个事务中多次操作同一个 key，所以同一个 key 只保留最后一次操作；
+ * 比较条件全部成立时操作才会执行，否则整个事务不生效，调用方重新读取之后再重试
+ */
+class EtcdTxn final {
+public:
+  auto put(std::string_view key, std::string_view value, std::string_view lease_id = {})
+      -> EtcdTxn &;
+  auto del(std::string_view key) -> EtcdTxn &;
+  auto compare(TxnCmpTarget target, std::string_view key, int64_t revision) -> EtcdTxn &;
+  auto find(std::string_view key) const -> std::optional<std::string>;
+  auto empty() const noexcept -> bool;
+  auto size() const noexcept -> size_t;
+  auto getOps() const noexcept -> const std::vector<TxnOp> &;
+  auto getCmps() const noexcept -> const std::vector<TxnCmp> &;
+  auto clear() noexcept -> void;
+
+private:
+  auto erase(std::string_view key) -> void;
+
+  std::vector<TxnOp> ops_;
+  std::vector<TxnCmp> cmps_;
+};
+
+auto getTxnBackoff(int attempt) -> std::chrono::milliseconds;
+
+} // namespace etcd
+} // namespace ohno
@@ -0,0 +1,221 @@
+// clang-format off
+#include "node_lease.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <optional>
+#include "spdlog/fmt/fmt.h"
+#include "src/common/assert.h"
+#include "src/common/except.h"
+// clang-format on
+
+namespace ohno {
+namespace etcd {
+
+NodeLease::NodeLease(std::unique_ptr<EtcdClientIf> etcd_client, std::string_view node_name,
+                     std::vector<std::string> keys, int64_t ttl)
+    : etcd_client_{std::move(etcd_client)}, node_name_{node_name}, keys_{std::move(keys)},
+      ttl_{ttl} {
+  OHNO_ASSERT(etcd_client_);
+  OHNO_ASSERT(!node_name_.empty());
+  OHNO_ASSERT(ttl_ > 0);
+}
+
+NodeLease::~NodeLease() { stop(); }
+
+/**
+ * @brief 设置 key 的重建回调，必须在 start 之前调用
+ *
+ * @param restorer 回调，返回 key 与值，节点网络设施已经不存在时返回空
+ */
+auto NodeLease::setRestorer(Restorer restorer) -> void {
+  OHNO_ASSERT(!running_);
+  restorer_ = std::move(restorer);
+}
+
+/**
+ * @brief 启动续约线程，每 TTL/3 续约一次
+ *
+ */
+auto NodeLease::start() -> void {
+  if (running_) {
+    return;
+  }
+  running_ = true;
+
+  keeper_ = std::thread{[this]() {
+    try {
+      pthread_setname_np(pthread_self(), "lease");
+      auto period = std::chrono::seconds{std::max<int64_t>(ttl_ / 3, 1)};
+      std::unique_lock<std::mutex> lock{mutex_};
+      while (running_) {
+        lock.unlock();
+        keepAlive();
+        lock.lock();
+        cond_.wait_for(lock, period, [this]() { return !running_; });
+      }
+    } catch (const ohno::except::Exception &exc) {
+      std::cerr << "[error] Ohnod lease thread terminated!" << exc.getMsg() << "\n";
+    } catch (const std::exception &exc) {
+      std::cerr << "[error] Ohnod lease thread terminated!" << exc.what() << "\n";
+    }
+  }};
+}
+
+/**
+ * @brief 停止续约线程（不撤销租约，ohnod 重启期间节点级别 key 依然有效）
+ *
+ */
+auto NodeLease::stop() -> void {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    running_ = false;
+  }
+  cond_.notify_all();
+  if (keeper_.joinable()) {
+    keeper_.join();
+  }
+}
+
+/**
+ * @brief 续约一次，租约不存在或已过期时重新申请
+ *
+ * @return true 租约有效
+ * @return false 续约与重新申请都失败
+ */
+auto NodeLease::keepAlive() -> bool {
+  auto lease_id = getLeaseId();
+  if (!lease_id.empty()) {
+    if (etcd_client_->keepAliveLease(lease_id)) {
+      refresh();
+      return true;
+    }
+    OHNO_LOG(warn, "Lease {} of {} expired or revoked, granting a new one", lease_id, node_name_);
+  }
+  return grant();
+}
+
+/**
+ * @brief 获取当前租约 ID
+ *
+ * @return std::string 租约 ID，尚未申请成功时为空
+ */
+auto NodeLease::getLeaseId() const -> std::string {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return lease_id_;
+}
+
+/**
+ * @brief 获取保存节点租约 ID 的 key
+ *
+ * @param node_name 节点名称
+ * @return std::string ETCD key
+ */
+auto NodeLease::getLeaseKey(std::string_view node_name) -> std::string {
+  return fmt::format("{}/{}", ETCD_KEY_LEASE, node_name);
+}
+
+/**
+ * @brief 读取节点租约 ID（供 CNI 插件写节点级别 key 时使用）
+ *
+ * @param etcd_client ETCD 客户端
+ * @param node_name 节点名称
+ * @return std::string 租约 ID，ohnod 没有运行时为空
+ */
+auto NodeLease::getLeaseId(const EtcdClientIf &etcd_client, std::string_view node_name)
+    -> std::string {
+  std::string lease_id{};
+  if (!etcd_client.get(getLeaseKey(node_name), lease_id)) {
+    lease_id.clear();
+  }
+  return lease_id;
+}
+
+/**
+ * @brief 每次续约成功之后重新读取所有 key，缓存与 ETCD 保持一致
+ *
+ * @note 租约有效期间 key 不会被 ETCD 删除，读到空值说明 key 被有意删除（比如释放子网、
+ * 删除节点），从缓存中去掉，租约过期之后也不会恢复
+ */
+auto NodeLease::refresh() -> void {
+  for (const auto &key : keys_) {
+    std::string value{};
+    if (!etcd_client_->get(key, value)) {
+      continue; // 读取失败时保留上次的缓存
+    }
+    if (value.empty()) {
+      cache_.erase(key);
+    } else {
+      cache_[key] = std::move(value);
+    }
+  }
+}
+
+/**
+ * @brief 申请新租约，并把节点级别 key 重新绑定到新租约上
+ *
+ * @note 只有旧租约确实过期（保存租约 ID 的 key 随之删除）时才恢复 key；
+ * 续约只是暂时失败，或者 ohnod 在 TTL 内重启时旧租约仍然有效，不存在的 key 都是被有意删除的。
+ * 恢复优先使用上次续约时的缓存，进程启动之后第一次申请还没有缓存，使用 restorer_ 重建
+ *
+ * @return true 申请成功
+ * @return false 申请失败
+ */
+auto NodeLease::grant() -> bool {
+  auto startup = getLeaseId().empty();
+  std::string stored{};
+  auto expired = etcd_client_->get(getLeaseKey(node_name_), stored) && stored.empty();
+
+  std::string lease_id{};
+  if (!etcd_client_->grantLease(ttl_, lease_id)) {
+    OHNO_LOG(warn, "Failed to grant lease for {}", node_name_);
+    return false;
+  }
+
+  // 仍然存在的 key 直接换绑，随旧租约过期的 key 用缓存或持久化状态恢复
+  std::optional<std::unordered_map<std::string, std::string>> durable{};
+  for (const auto &key : keys_) {
+    std::string value{};
+    if (!etcd_client_->get(key, value)) {
+      OHNO_LOG(warn, "Failed to read {} before attaching it to lease {}", key, lease_id);
+      continue;
+    }
+    if (!value.empty()) {
+      cache_[key] = value;
+    } else if (expired && cache_.find(key) != cache_.end()) {
+      value = cache_[key];
+      OHNO_LOG(info, "Restore {} expired with the lease of {}", key, node_name_);
+    } else if (expired && startup && restorer_) {
+      if (!durable) {
+        durable = restorer_();
+      }
+      auto iter = durable->find(key);
+      if (iter == durable->end() || iter->second.empty()) {
+        continue;
+      }
+      value = iter->second;
+      cache_[key] = value;
+      OHNO_LOG(info, "Rebuild {}:{} expired with the lease of {}", key, value, node_name_);
+    } else {
+      cache_.erase(key);
+      continue;
+    }
+    if (!etcd_client_->put(key, value, lease_id)) {
+      OHNO_LOG(warn, "Failed to attach {} to lease {}", key, lease_id);
+    }
+  }
+  if (!etcd_client_->put(getLeaseKey(node_name_), lease_id, lease_id)) {
+    OHNO_LOG(warn, "Failed to store lease {} of {}", lease_id, node_name_);
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    lease_id_ = lease_id;
+  }
+  OHNO_LOG(info, "Granted lease {} (TTL {}s) for {}", lease_id, ttl_, node_name_);
+  return true;
+}
+
+} // namespace etcd
+} // namespace ohno
@@ -0,0 +1,74 @@
+#pragma once
+
+// clang-format off
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "etcd_client_if.h"
+#include "src/log/logger.h"
+// clang-format on
+
+namespace ohno {
+namespace etcd {
+
+constexpr std::string_view ETCD_KEY_LEASE{"/ohno/leases"};
+constexpr int64_t DEFAULT_LEASE_TTL{60}; // 单位秒，ohnod 每 TTL/3 续约一次
+
+/**
+ * @brief 节点租约：节点级别的 key（子网、VTEP 等）绑定到由 ohnod 续约的租约上，
+ * 节点宕机之后租约过期，这些 key 被 ETCD 自动删除，watcher 会收到删除事件
+ *
+ * 租约 ID 保存在 /ohno/leases/节点名称（同样绑定该租约），CNI 插件写节点级别 key 时读取它
+ *
+ * ohnod 停止超过 TTL 时这些 key 已经随租约删除，重启之后进程内没有缓存，
+ * 由 setRestorer 设置的回调从持久化状态（节点 bridge、vxlan 记录）重建
+ *
+ * @note 只有子网与 VTEP 绑定租约。节点的地址（/ohno/addresses/节点名称/）、地址块
+ * （/ohno/blocks/节点名称/）以及 Pod、网卡记录没有绑定，节点宕机之后仍然保留并占用地址：
+ * 节点恢复之后由 kubelet 对这些 Pod 执行 CNI DEL 时释放，节点不再恢复时需要人工删除这些前缀
+ */
+class NodeLease final : public log::Loggable<log::Id::etcd> {
+public:
+  using Restorer = std::function<std::unordered_map<std::string, std::string>()>;
+
+  NodeLease(std::unique_ptr<EtcdClientIf> etcd_client, std::string_view node_name,
+            std::vector<std::string> keys, int64_t ttl = DEFAULT_LEASE_TTL);
+  ~NodeLease() override;
+
+  auto setRestorer(Restorer restorer) -> void;
+  auto start() -> void;
+  auto stop() -> void;
+  auto keepAlive() -> bool;
+  auto getLeaseId() const -> std::string;
+
+  static auto getLeaseKey(std::string_view node_name) -> std::string;
+  static auto getLeaseId(const EtcdClientIf &etcd_client, std::string_view node_name)
+      -> std::string;
+
+private:
+  auto refresh() -> void;
+  auto grant() -> bool;
+
+  std::unique_ptr<EtcdClientIf> etcd_client_;
+  std::string node_name_;
+  std::vector<std::string> keys_;                      // 需要绑定租约的节点级别 key
+  std::unordered_map<std::string, std::string> cache_; // 上次续约时的 key，租约过期后用来恢复
+  Restorer restorer_; // 进程启动时旧租约已经过期，从持久化状态重建 key
+  int64_t ttl_;
+  std::string lease_id_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cond_;
+  std::atomic<bool> running_{false};
+  std::thread keeper_;
+};
+
+} // namespace etcd
+} // namespace ohno
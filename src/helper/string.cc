@@ -1,11 +1,35 @@
 // clang-format off
 #include "string.h"
-#include <sstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 // clang-format on
 
 namespace ohno {
 namespace helper {
 
+Tokenizer::Tokenizer(std::string_view str, char delim) : str_{str}, delim_{delim} {}
+
+/**
+ * @brief 取出下一个 token
+ *
+ * @param token 下一个 token（返回值）
+ * @return true 取出成功
+ * @return false 已经没有 token
+ */
+auto Tokenizer::next(std::string_view &token) -> bool {
+  if (pos_ >= str_.size()) {
+    return false;
+  }
+  // memchr 由 libc 按平台做了向量化，长字符串上比逐字符比较快得多
+  const auto *begin = str_.data() + pos_;
+  const auto *found = static_cast<const char *>(std::memchr(begin, delim_, str_.size() - pos_));
+  auto length = found == nullptr ? str_.size() - pos_ : static_cast<size_t>(found - begin);
+  token = std::string_view{begin, length};
+  pos_ += length + 1;
+  return true;
+}
+
 /**
  * @brief 切分字符串
  *
@@ -15,13 +39,105 @@ namespace helper {
  */
 auto split(std::string_view str, char delim) -> std::vector<std::string> {
   std::vector<std::string> tokens{};
-  std::string token{};
-  std::istringstream tokenStream(std::string{str});
-  while (std::getline(tokenStream, token, delim)) {
-    tokens.push_back(token);
+  tokens.reserve(std::count(str.begin(), str.end(), delim) + 1);
+  Tokenizer tokenizer{str, delim};
+  std::string_view token{};
+  while (tokenizer.next(token)) {
+    tokens.emplace_back(token);
+  }
+  return tokens;
+}
+
+/**
+ * @brief 切分字符串，不复制 token
+ *
+ * @param str 字符串（需要在使用结果期间有效）
+ * @param delim 分隔符
+ * @return std::vector<std::string_view> 原字符串上的 token 视图数组
+ */
+auto splitView(std::string_view str, char delim) -> std::vector<std::string_view> {
+  std::vector<std::string_view> tokens{};
+  tokens.reserve(std::count(str.begin(), str.end(), delim) + 1);
+  Tokenizer tokenizer{str, delim};
+  std::string_view token{};
+  while (tokenizer.next(token)) {
+    tokens.emplace_back(token);
   }
   return tokens;
 }
 
+/**
+ * @brief Base64 解码（ETCD JSON 输出中的 key 与 value 都是 Base64 编码的）
+ *
+ * @param str Base64 字符串
+ * @return std::optional<std::string> 解码结果，非法输入为空
+ */
+auto base64Decode(std::string_view str) -> std::optional<std::string> {
+  auto decode = [](char chr) -> int {
+    if (chr >= 'A' && chr <= 'Z') {
+      return chr - 'A';
+    }
+    if (chr >= 'a' && chr <= 'z') {
+      return chr - 'a' + 26;
+    }
+    if (chr >= '0' && chr <= '9') {
+      return chr - '0' + 52;
+    }
+    return chr == '+' ? 62 : chr == '/' ? 63 : -1;
+  };
+
+  while (!str.empty() && str.back() == '=') {
+    str.remove_suffix(1);
+  }
+  std::string result{};
+  result.reserve(str.size() * 3 / 4);
+  uint32_t buffer = 0;
+  int bits = 0;
+  for (char chr : str) {
+    auto value = decode(chr);
+    if (value < 0) {
+      return std::nullopt;
+    }
+    buffer = (buffer << 6) | static_cast<uint32_t>(value);
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      result.push_back(static_cast<char>((buffer >> bits) & 0xff));
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief Base64 编码，与 base64Decode() 互逆
+ *
+ * @param str 原始字节
+ * @return std::string Base64 字符串（带 '=' 填充）
+ */
+auto base64Encode(std::string_view str) -> std::string {
+  constexpr std::string_view TABLE{
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"};
+
+  std::string result{};
+  result.reserve((str.size() + 2) / 3 * 4);
+  uint32_t buffer = 0;
+  int bits = 0;
+  for (char chr : str) {
+    buffer = (buffer << 8) | static_cast<uint8_t>(chr);
+    bits += 8;
+    while (bits >= 6) {
+      bits -= 6;
+      result.push_back(TABLE[(buffer >> bits) & 0x3f]);
+    }
+  }
+  if (bits > 0) {
+    result.push_back(TABLE[(buffer << (6 - bits)) & 0x3f]);
+  }
+  while (result.size() % 4 != 0) {
+    result.push_back('=');
+  }
+  return result;
+}
+
 } // namespace helper
 } // namespace ohno
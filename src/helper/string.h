@@ -1,6 +1,7 @@
 #pragma once
 
 // clang-format off
+#include <optional>
 #include <string_view>
 #include <string>
 #include <vector>
@@ -9,7 +10,28 @@
 namespace ohno {
 namespace helper {
 
+/**
+ * @brief 按分隔符逐个取出 token，token 是原字符串上的视图，不复制也不分配内存
+ *
+ * @note 与 std::getline 的切分语义一致：空字符串没有 token，末尾的分隔符不产生空 token；
+ * 调用者需要保证原字符串在使用 token 期间有效
+ */
+class Tokenizer {
+public:
+  explicit Tokenizer(std::string_view str, char delim);
+
+  auto next(std::string_view &token) -> bool;
+
+private:
+  std::string_view str_;
+  char delim_;
+  size_t pos_{0};
+};
+
 auto split(std::string_view str, char delim) -> std::vector<std::string>;
+auto splitView(std::string_view str, char delim) -> std::vector<std::string_view>;
+auto base64Decode(std::string_view str) -> std::optional<std::string>;
+auto base64Encode(std::string_view str) -> std::string;
 
 } // namespace helper
 } // namespace ohno
@@ -0,0 +1,48 @@
+// clang-format off
+#include "arena.h"
+// clang-format on
+
+namespace ohno {
+namespace ipam {
+
+/**
+ * @brief 创建内存区域
+ *
+ * @param initial_size 第一次向堆申请的大小（字节）
+ */
+Arena::Arena(size_t initial_size) : resource_{initial_size, &upstream_} {}
+
+/**
+ * @brief 获取区域的内存资源，用于 std::pmr 容器
+ *
+ * @note 容器的生命周期不能超过区域，一般是区域中对象的成员
+ *
+ * @return std::pmr::memory_resource* 内存资源
+ */
+auto Arena::getResource() noexcept -> std::pmr::memory_resource * { return &resource_; }
+
+/**
+ * @brief 获取区域已经向堆申请的内存大小
+ *
+ * @return size_t 字节数
+ */
+auto Arena::getReservedBytes() const noexcept -> size_t { return upstream_.getBytes(); }
+
+auto Arena::Upstream::do_allocate(size_t bytes, size_t alignment) -> void * {
+  auto *ptr = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  bytes_ += bytes;
+  return ptr;
+}
+
+auto Arena::Upstream::do_deallocate(void *ptr, size_t bytes, size_t alignment) -> void {
+  std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+  bytes_ -= bytes;
+}
+
+auto Arena::Upstream::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+    -> bool {
+  return this == &other;
+}
+
+} // namespace ipam
+} // namespace ohno
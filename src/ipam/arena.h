@@ -0,0 +1,91 @@
+#pragma once
+
+// clang-format off
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+// clang-format on
+
+namespace ohno {
+namespace ipam {
+
+constexpr size_t ARENA_INITIAL_SIZE{64 * 1024}; // 大约是一百个 Pod 的集群模型，不够时成倍扩大
+
+/**
+ * @brief 一次 CNI 调用内集群模型的内存区域
+ *
+ * 节点、网络空间、网卡对象连同 std::shared_ptr 的控制块都从单调增长的 buffer 中分配，
+ * 释放对象不归还内存，最后一个对象析构之后整块内存一次归还
+ *
+ * @note 必须用 std::make_shared 创建：每个对象的控制块都持有区域，区域不会先于对象销毁；
+ * 分配不是线程安全的，只应在构建模型的线程中调用 make()
+ */
+class Arena final : public std::enable_shared_from_this<Arena> {
+public:
+  explicit Arena(size_t initial_size = ARENA_INITIAL_SIZE);
+  Arena(const Arena &) = delete;
+  auto operator=(const Arena &) -> Arena & = delete;
+
+  template <typename T, typename... Args>
+  auto make(Args &&...args) -> std::shared_ptr<T>;
+  auto getResource() noexcept -> std::pmr::memory_resource *;
+  auto getReservedBytes() const noexcept -> size_t;
+
+private:
+  /**
+   * @brief 统计区域向堆申请了多少内存
+   *
+   */
+  class Upstream final : public std::pmr::memory_resource {
+  public:
+    auto getBytes() const noexcept -> size_t { return bytes_; }
+
+  private:
+    auto do_allocate(size_t bytes, size_t alignment) -> void * override;
+    auto do_deallocate(void *ptr, size_t bytes, size_t alignment) -> void override;
+    auto do_is_equal(const std::pmr::memory_resource &other) const noexcept -> bool override;
+
+    size_t bytes_{0};
+  };
+
+  Upstream upstream_;                            // 必须先于 resource_ 构造
+  std::pmr::monotonic_buffer_resource resource_; // 只增不减，析构时归还给 upstream_
+};
+
+/**
+ * @brief 从 Arena 分配内存的分配器，同时持有 Arena 的所有权
+ *
+ * @tparam T 分配的类型
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+  using value_type = T;
+
+  explicit ArenaAllocator(std::shared_ptr<Arena> arena) noexcept;
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) noexcept; // NOLINT(google-explicit-constructor)
+
+  auto allocate(size_t size) -> T *;
+  auto deallocate(T *ptr, size_t size) noexcept -> void;
+
+  template <typename U>
+  auto operator==(const ArenaAllocator<U> &other) const noexcept -> bool {
+    return arena_ == other.arena_;
+  }
+  template <typename U>
+  auto operator!=(const ArenaAllocator<U> &other) const noexcept -> bool {
+    return arena_ != other.arena_;
+  }
+
+private:
+  template <typename U>
+  friend class ArenaAllocator;
+
+  std::shared_ptr<Arena> arena_;
+};
+
+} // namespace ipam
+} // namespace ohno
+
+#include "arena.tpp"
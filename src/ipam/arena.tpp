@@ -0,0 +1,45 @@
+#pragma once
+
+// clang-format off
+#include "arena.h"
+#include <utility>
+// clang-format on
+
+namespace ohno {
+namespace ipam {
+
+/**
+ * @brief 在区域中创建对象，对象与控制块一起分配
+ *
+ * @tparam T 对象类型
+ * @tparam Args 构造参数类型
+ * @param args 构造参数
+ * @return std::shared_ptr<T> 对象，持有区域直到对象析构
+ */
+template <typename T, typename... Args>
+auto Arena::make(Args &&...args) -> std::shared_ptr<T> {
+  return std::allocate_shared<T>(ArenaAllocator<T>{shared_from_this()},
+                                 std::forward<Args>(args)...);
+}
+
+template <typename T>
+ArenaAllocator<T>::ArenaAllocator(std::shared_ptr<Arena> arena) noexcept
+    : arena_{std::move(arena)} {}
+
+template <typename T>
+template <typename U>
+ArenaAllocator<T>::ArenaAllocator(const ArenaAllocator<U> &other) noexcept
+    : arena_{other.arena_} {}
+
+template <typename T>
+auto ArenaAllocator<T>::allocate(size_t size) -> T * {
+  return static_cast<T *>(arena_->getResource()->allocate(size * sizeof(T), alignof(T)));
+}
+
+template <typename T>
+auto ArenaAllocator<T>::deallocate(T *ptr, size_t size) noexcept -> void {
+  arena_->getResource()->deallocate(ptr, size * sizeof(T), alignof(T));
+}
+
+} // namespace ipam
+} // namespace ohno
@@ -6,6 +6,17 @@
 namespace ohno {
 namespace ipam {
 
+/**
+ * @brief 创建使用内存区域的 Kubernetes 集群，节点索引从区域中分配
+ *
+ * @note 集群持有区域，节点等对象应当通过 Arena::make() 创建
+ *
+ * @param arena 内存区域
+ */
+Cluster::Cluster(std::shared_ptr<Arena> arena)
+    : arena_{std::move(arena)}, nodes_{arena_ ? arena_->getResource()
+                                              : std::pmr::get_default_resource()} {}
+
 /**
  * @brief 向 Kubernetes 集群中增加一个节点
  *
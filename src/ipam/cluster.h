@@ -2,6 +2,10 @@
 
 // clang-format off
 #include "cluster_if.h"
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include "arena.h"
 #include "src/log/logger.h"
 // clang-format on
 
@@ -10,12 +14,16 @@ namespace ipam {
 
 class Cluster : public ClusterIf, public log::Loggable<log::Id::ipam> {
 public:
+  Cluster() = default;
+  explicit Cluster(std::shared_ptr<Arena> arena);
+
   auto addNode(std::string_view node_name, std::shared_ptr<NodeIf> node) -> void override;
   auto delNode(std::string_view node_name) -> void override;
   auto getNode(std::string_view node_name) const -> std::shared_ptr<NodeIf> override;
 
 private:
-  std::unordered_map<std::string, std::shared_ptr<NodeIf>> nodes_;
+  std::shared_ptr<Arena> arena_; // 可以为空，必须先于 nodes_ 构造、晚于 nodes_ 析构
+  std::pmr::unordered_map<std::pmr::string, std::shared_ptr<NodeIf>> nodes_;
 };
 
 } // namespace ipam
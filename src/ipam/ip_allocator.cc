@@ -0,0 +1,242 @@
+// clang-format off
+#include "ip_allocator.h"
+#include <algorithm>
+#include <iterator>
+// clang-format on
+
+namespace ohno {
+namespace ipam {
+
+IpAllocator::IpAllocator(const net::IpPrefix &subnet) : subnet_{subnet.network()}, first_{1} {
+  auto host_bits = subnet_.hostBits();
+  net::Uint128 span =
+      host_bits >= net::MAX_PREFIX_IPV6 ? ~net::Uint128{0} : (net::Uint128{1} << host_bits) - 1;
+
+  // IPv4 最后一个地址是广播地址，IPv6 没有广播地址
+  last_ = subnet_.version() == net::IpVersion::IPv4 && span > 0 ? span - 1 : span;
+}
+
+/**
+ * @brief 预留一个地址（通常是从持久化中恢复的已分配地址）
+ *
+ * @param addr 地址
+ * @return true 预留成功
+ * @return false 地址不属于当前子网或者已被预留
+ */
+auto IpAllocator::reserve(net::IpAddr addr) -> bool {
+  auto offset = toOffset(addr);
+  return offset.has_value() && reserveOffset(offset.value());
+}
+
+/**
+ * @brief 预留整个范围（比如节点已经租用的地址块），与已有区间合并为一个区间
+ *
+ * @param range 地址范围，不属于当前子网时忽略
+ */
+auto IpAllocator::reserve(const net::IpPrefix &range) -> void {
+  auto offsets = toOffsets(range);
+  if (!offsets.has_value()) {
+    return;
+  }
+  auto [start, end] = offsets.value();
+
+  // 吸收所有与 [start, end] 重叠或相邻的区间，偏移从 1 开始，所以减 1 不会回绕
+  auto iter = used_.upper_bound(start);
+  if (iter != used_.begin() && std::prev(iter)->second >= start - 1) {
+    --iter;
+  }
+  while (iter != used_.end() && iter->first - 1 <= end) {
+    start = std::min(start, iter->first);
+    end = std::max(end, iter->second);
+    iter = used_.erase(iter);
+  }
+  used_.emplace(start, end);
+}
+
+/**
+ * @brief 归还一个地址
+ *
+ * @param addr 地址
+ * @return true 归还成功
+ * @return false 地址未被分配
+ */
+auto IpAllocator::release(net::IpAddr addr) -> bool {
+  auto offset = toOffset(addr);
+  if (!offset.has_value()) {
+    return false;
+  }
+
+  auto iter = used_.upper_bound(offset.value());
+  if (iter == used_.begin()) {
+    return false;
+  }
+  --iter;
+  auto [start, end] = *iter;
+  if (end < offset.value()) {
+    return false;
+  }
+
+  // 将区间 [start, end] 拆分为 [start, offset - 1] 和 [offset + 1, end]
+  used_.erase(iter);
+  if (start < offset.value()) {
+    used_.emplace(start, offset.value() - 1);
+  }
+  if (offset.value() < end) {
+    used_.emplace(offset.value() + 1, end);
+  }
+  return true;
+}
+
+/**
+ * @brief 分配子网内最小的空闲地址
+ *
+ * @return std::optional<net::IpAddr> 地址，子网已满时为空
+ */
+auto IpAllocator::allocate() -> std::optional<net::IpAddr> { return allocateImpl(first_, last_); }
+
+/**
+ * @brief 分配指定范围（比如节点租用的地址块）内最小的空闲地址
+ *
+ * @param range 地址范围，必须属于当前子网
+ * @return std::optional<net::IpAddr> 地址，范围已满或不属于当前子网时为空
+ */
+auto IpAllocator::allocate(const net::IpPrefix &range) -> std::optional<net::IpAddr> {
+  auto offsets = toOffsets(range);
+  if (!offsets.has_value()) {
+    return std::nullopt;
+  }
+  return allocateImpl(offsets->first, offsets->second);
+}
+
+/**
+ * @brief 判断地址是否已被分配
+ *
+ * @param addr 地址
+ * @return true 已分配
+ * @return false 未分配
+ */
+auto IpAllocator::isReserved(net::IpAddr addr) const -> bool {
+  auto offset = toOffset(addr);
+  if (!offset.has_value()) {
+    return false;
+  }
+  auto iter = used_.upper_bound(offset.value());
+  return iter != used_.begin() && std::prev(iter)->second >= offset.value();
+}
+
+/**
+ * @brief 获取分配器管理的子网
+ *
+ * @return net::IpPrefix 子网
+ */
+auto IpAllocator::getSubnet() const noexcept -> net::IpPrefix { return subnet_; }
+
+/**
+ * @brief 获取已分配区间的数量
+ *
+ * @return size_t 区间数量
+ */
+auto IpAllocator::getIntervalSize() const noexcept -> size_t { return used_.size(); }
+
+/**
+ * @brief 将地址转换为子网内偏移
+ *
+ * @param addr 地址
+ * @return std::optional<net::Uint128> 偏移，地址不可分配时为空
+ */
+auto IpAllocator::toOffset(net::IpAddr addr) const -> std::optional<net::Uint128> {
+  if (!subnet_.contains(addr)) {
+    return std::nullopt;
+  }
+  auto offset = subnet_.offsetOf(addr);
+  if (offset < first_ || offset > last_) {
+    return std::nullopt;
+  }
+  return offset;
+}
+
+/**
+ * @brief 将地址范围转换为子网内可分配的偏移区间
+ *
+ * @param range 地址范围
+ * @return std::optional<std::pair<net::Uint128, net::Uint128>> 闭区间 [first, last]，范围不属于
+ * 当前子网或者没有可分配的地址时为空
+ */
+auto IpAllocator::toOffsets(const net::IpPrefix &range) const
+    -> std::optional<std::pair<net::Uint128, net::Uint128>> {
+  if (!subnet_.contains(range)) {
+    return std::nullopt;
+  }
+  auto network = range.network();
+  auto first = subnet_.offsetOf(network.addr());
+  auto host_bits = network.hostBits();
+  auto last = host_bits >= net::MAX_PREFIX_IPV6
+                  ? ~net::Uint128{0}
+                  : first + ((net::Uint128{1} << host_bits) - 1);
+  first = std::max(first, first_);
+  last = std::min(last, last_);
+  if (first > last) {
+    return std::nullopt;
+  }
+  return std::make_pair(first, last);
+}
+
+/**
+ * @brief 分配 [first, last] 内最小的空闲偏移
+ *
+ * @param first 起始偏移
+ * @param last 结束偏移
+ * @return std::optional<net::IpAddr> 地址，范围已满时为空
+ */
+auto IpAllocator::allocateImpl(net::Uint128 first, net::Uint128 last)
+    -> std::optional<net::IpAddr> {
+  if (first > last) {
+    return std::nullopt;
+  }
+
+  // 相邻区间总是被合并，所以包含 first 的区间之后的第一个偏移一定空闲
+  auto candidate = first;
+  auto iter = used_.upper_bound(first);
+  if (iter != used_.begin()) {
+    auto prev = std::prev(iter);
+    if (prev->second >= first) {
+      if (prev->second >= last) {
+        return std::nullopt;
+      }
+      candidate = prev->second + 1;
+    }
+  }
+
+  reserveOffset(candidate);
+  return subnet_.hostAt(candidate);
+}
+
+/**
+ * @brief 预留一个偏移，并与相邻区间合并
+ *
+ * @param offset 偏移
+ * @return true 预留成功
+ * @return false 已被预留
+ */
+auto IpAllocator::reserveOffset(net::Uint128 offset) -> bool {
+  auto next = used_.upper_bound(offset);
+  auto prev = next == used_.begin() ? used_.end() : std::prev(next);
+  if (prev != used_.end() && prev->second >= offset) {
+    return false;
+  }
+
+  auto end = offset;
+  if (next != used_.end() && next->first == offset + 1) {
+    end = next->second;
+    used_.erase(next);
+  }
+  if (prev != used_.end() && prev->second + 1 == offset) {
+    prev->second = end;
+    return true;
+  }
+  used_.emplace(offset, end);
+  return true;
+}
+
+} // namespace ipam
+} // namespace ohno
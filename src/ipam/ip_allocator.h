@@ -0,0 +1,46 @@
+#pragma once
+
+// clang-format off
+#include <map>
+#include <optional>
+#include <utility>
+#include "src/net/ip.h"
+// clang-format on
+
+namespace ohno {
+namespace ipam {
+
+/**
+ * @brief 稀疏 IP 地址分配器
+ *
+ * 已分配的地址以互不相交、互不相邻的闭区间保存在有序容器中，分配、预留、归还都是
+ * O(log n)（n 为区间数量），与子网大小无关，因此可以用于 IPv6 /64 这种无法位图化的网段
+ */
+class IpAllocator final {
+public:
+  explicit IpAllocator(const net::IpPrefix &subnet);
+
+  auto reserve(net::IpAddr addr) -> bool;
+  auto reserve(const net::IpPrefix &range) -> void;
+  auto release(net::IpAddr addr) -> bool;
+  auto allocate() -> std::optional<net::IpAddr>;
+  auto allocate(const net::IpPrefix &range) -> std::optional<net::IpAddr>;
+  auto isReserved(net::IpAddr addr) const -> bool;
+  auto getSubnet() const noexcept -> net::IpPrefix;
+  auto getIntervalSize() const noexcept -> size_t;
+
+private:
+  auto toOffset(net::IpAddr addr) const -> std::optional<net::Uint128>;
+  auto toOffsets(const net::IpPrefix &range) const
+      -> std::optional<std::pair<net::Uint128, net::Uint128>>;
+  auto reserveOffset(net::Uint128 offset) -> bool;
+  auto allocateImpl(net::Uint128 first, net::Uint128 last) -> std::optional<net::IpAddr>;
+
+  net::IpPrefix subnet_;
+  net::Uint128 first_; // 第一个可分配的偏移（跳过网络地址）
+  net::Uint128 last_;  // 最后一个可分配的偏移（IPv4 跳过广播地址）
+  std::map<net::Uint128, net::Uint128> used_; // 已分配区间：起始偏移 -> 结束偏移
+};
+
+} // namespace ipam
+} // namespace ohno
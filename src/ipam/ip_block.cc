@@ -0,0 +1,480 @@
+// clang-format off
+#include "ip_block.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include "spdlog/fmt/fmt.h"
+#include "src/common/assert.h"
+// clang-format on
+
+namespace ohno {
+namespace ipam {
+
+namespace {
+
+constexpr char RANGE_DELIMITER{'-'}; // 地址段："第一个地址/前缀长度-最后一个地址"
+
+auto lastAddr(const net::IpPrefix &prefix) noexcept -> net::IpAddr {
+  return prefix.network().hostAt((net::Uint128{1} << prefix.hostBits()) - 1);
+}
+
+auto prevAddr(net::IpAddr addr) noexcept -> net::IpAddr { return addr.advance(~net::Uint128{0}); }
+
+} // namespace
+
+void from_json(const nlohmann::json &json, IpBlock &block) {
+  auto prefix = net::IpPrefix::parse(json.at(JKEY_IPAM_BLOCK_CIDR).get<std::string>());
+  if (!prefix.has_value() || prefix->hostBits() > MAX_IPAM_BLOCK_BITS) {
+    throw std::invalid_argument{"invalid IPAM block"};
+  }
+  block = IpBlock{prefix.value()};
+  auto used = json.value(JKEY_IPAM_BLOCK_USED, std::vector<uint64_t>{});
+  std::copy_n(used.begin(), std::min(used.size(), block.used_.size()), block.used_.begin());
+}
+
+void to_json(nlohmann::json &json, const IpBlock &block) {
+  json = nlohmann::json{{JKEY_IPAM_BLOCK_CIDR, block.prefix_.toString()},
+                        {JKEY_IPAM_BLOCK_USED, block.used_}};
+}
+
+void from_json(const nlohmann::json &json, IpBlockState &state) {
+  if (json.contains(JKEY_IPAM_BLOCK_BLOCKS)) {
+    for (const auto &item : json.at(JKEY_IPAM_BLOCK_BLOCKS)) {
+      if (item.is_string()) {
+        // 旧格式：地址块只有 CIDR，块内的地址与块外的地址一起保存在 allocated 中
+        auto prefix = net::IpPrefix::parse(item.get<std::string>());
+        if (!prefix.has_value() || prefix->hostBits() > MAX_IPAM_BLOCK_BITS) {
+          throw std::invalid_argument{"invalid IPAM block"};
+        }
+        state.blocks_.emplace_back(prefix.value());
+      } else {
+        state.blocks_.emplace_back(item.get<IpBlock>());
+      }
+    }
+  }
+  if (json.contains(JKEY_IPAM_BLOCK_ALLOCATED)) {
+    for (const auto &ip : json.at(JKEY_IPAM_BLOCK_ALLOCATED).get<std::vector<std::string>>()) {
+      auto pos = ip.find(RANGE_DELIMITER);
+      if (pos == std::string::npos) {
+        state.use(ip); // 单个地址，旧格式中地址块内的地址也在这里
+        continue;
+      }
+      auto first = net::IpPrefix::parse(std::string_view{ip}.substr(0, pos));
+      auto last = net::IpAddr::parse(std::string_view{ip}.substr(pos + 1));
+      if (!first.has_value() || !last.has_value() || last->version() != first->version() ||
+          last.value() < first->addr()) {
+        throw std::invalid_argument{"invalid IPAM address range"};
+      }
+      state.others_.insert_or_assign(first->addr(), IpRange{last.value(), first->length()});
+    }
+  }
+  if (json.contains(JKEY_IPAM_BLOCK_JOURNAL_ADD)) {
+    state.journal_add_ = json.at(JKEY_IPAM_BLOCK_JOURNAL_ADD).get<std::vector<std::string>>();
+  }
+  if (json.contains(JKEY_IPAM_BLOCK_JOURNAL_DEL)) {
+    state.journal_del_ = json.at(JKEY_IPAM_BLOCK_JOURNAL_DEL).get<std::vector<std::string>>();
+  }
+}
+
+void to_json(nlohmann::json &json, const IpBlockState &state) {
+  std::vector<std::string> others{};
+  others.reserve(state.others_.size());
+  for (const auto &[first, range] : state.others_) {
+    auto ip = net::IpPrefix{first, range.length_}.toString();
+    others.emplace_back(first == range.last_
+                            ? ip
+                            : fmt::format("{}{}{}", ip, RANGE_DELIMITER, range.last_.toString()));
+  }
+  json = nlohmann::json{{JKEY_IPAM_BLOCK_BLOCKS, state.blocks_},
+                        {JKEY_IPAM_BLOCK_ALLOCATED, others},
+                        {JKEY_IPAM_BLOCK_JOURNAL_ADD, state.journal_add_},
+                        {JKEY_IPAM_BLOCK_JOURNAL_DEL, state.journal_del_}};
+}
+
+/**
+ * @brief 构造一个没有已分配地址的地址块
+ *
+ * @param prefix 地址块，主机位不超过 MAX_IPAM_BLOCK_BITS
+ */
+IpBlock::IpBlock(const net::IpPrefix &prefix) : prefix_{prefix.network()} {
+  OHNO_ASSERT(prefix_.hostBits() <= MAX_IPAM_BLOCK_BITS);
+  used_.resize((size() + 63) / 64);
+}
+
+auto IpBlock::getPrefix() const noexcept -> const net::IpPrefix & { return prefix_; }
+
+auto IpBlock::contains(net::IpAddr addr) const noexcept -> bool { return prefix_.contains(addr); }
+
+auto IpBlock::size() const noexcept -> size_t { return size_t{1} << prefix_.hostBits(); }
+
+/**
+ * @brief 地址是否已分配
+ *
+ * @param addr 地址
+ * @return true 已分配
+ * @return false 未分配或者不属于当前地址块
+ */
+auto IpBlock::isUsed(net::IpAddr addr) const noexcept -> bool {
+  if (!contains(addr)) {
+    return false;
+  }
+  auto offset = static_cast<size_t>(prefix_.offsetOf(addr));
+  return (used_[offset / 64] >> (offset % 64) & 1) != 0;
+}
+
+/**
+ * @brief 标记地址已分配
+ *
+ * @param addr 地址
+ * @return true 标记成功
+ * @return false 不属于当前地址块
+ */
+auto IpBlock::use(net::IpAddr addr) noexcept -> bool {
+  if (!contains(addr)) {
+    return false;
+  }
+  auto offset = static_cast<size_t>(prefix_.offsetOf(addr));
+  used_[offset / 64] |= uint64_t{1} << (offset % 64);
+  return true;
+}
+
+/**
+ * @brief 归还地址
+ *
+ * @param addr 地址
+ * @return true 归还成功
+ * @return false 不属于当前地址块或者没有分配
+ */
+auto IpBlock::release(net::IpAddr addr) noexcept -> bool {
+  if (!isUsed(addr)) {
+    return false;
+  }
+  auto offset = static_cast<size_t>(prefix_.offsetOf(addr));
+  used_[offset / 64] &= ~(uint64_t{1} << (offset % 64));
+  return true;
+}
+
+/**
+ * @brief 分配块内最小的空闲地址，跳过子网的网络地址与 IPv4 广播地址
+ *
+ * @param subnet 地址块所在的节点子网
+ * @return std::optional<net::IpAddr> 地址，地址块已满时为空
+ */
+auto IpBlock::allocate(const net::IpPrefix &subnet) noexcept -> std::optional<net::IpAddr> {
+  auto network = subnet.network();
+  auto host_bits = network.hostBits();
+  auto is_reserved = [&network, host_bits](net::IpAddr addr) {
+    if (addr == network.addr()) {
+      return true;
+    }
+    return network.version() == net::IpVersion::IPv4 && host_bits > 0 &&
+           network.offsetOf(addr) == (net::Uint128{1} << host_bits) - 1;
+  };
+
+  auto count = size();
+  for (size_t word = 0; word < used_.size(); ++word) {
+    auto bits = count - word * 64;
+    auto valid = bits >= 64 ? ~uint64_t{0} : (uint64_t{1} << bits) - 1;
+    auto free = ~used_[word] & valid;
+    while (free != 0) {
+      auto bit = static_cast<size_t>(__builtin_ctzll(free));
+      auto addr = prefix_.hostAt(word * 64 + bit);
+      free &= free - 1;
+      if (!is_reserved(addr)) {
+        used_[word] |= uint64_t{1} << bit;
+        return addr;
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+/**
+ * @brief 地址块内是否没有已分配的地址
+ *
+ * @return true 没有已分配的地址
+ * @return false 有已分配的地址
+ */
+auto IpBlock::empty() const noexcept -> bool {
+  return std::all_of(used_.begin(), used_.end(), [](uint64_t word) { return word == 0; });
+}
+
+/**
+ * @brief 获取尚未同步到 ETCD 的记录数量
+ *
+ * @return size_t 记录数量
+ */
+auto IpBlockState::journalSize() const noexcept -> size_t {
+  return journal_add_.size() + journal_del_.size();
+}
+
+/**
+ * @brief 查找地址所在的地址块
+ *
+ * @param addr 地址
+ * @return IpBlock* 地址块，不属于任何已租用的地址块时为空
+ */
+auto IpBlockState::findBlock(net::IpAddr addr) noexcept -> IpBlock * {
+  auto iter = std::find_if(blocks_.begin(), blocks_.end(),
+                           [&addr](const IpBlock &block) { return block.contains(addr); });
+  return iter == blocks_.end() ? nullptr : &*iter;
+}
+
+/**
+ * @brief 地址是否已分配（地址块内或者地址块之外）
+ *
+ * @param addr 地址
+ * @return true 已分配
+ * @return false 未分配
+ */
+auto IpBlockState::isUsed(net::IpAddr addr) const -> bool {
+  auto iter = std::find_if(blocks_.begin(), blocks_.end(),
+                           [&addr](const IpBlock &block) { return block.contains(addr); });
+  if (iter != blocks_.end()) {
+    return iter->isUsed(addr);
+  }
+  return findOther(addr) != others_.end();
+}
+
+/**
+ * @brief 标记地址已分配，地址块之外的地址与前后相邻、前缀长度相同的地址段合并
+ *
+ * @param ip 地址（带前缀）
+ * @return true 标记成功
+ * @return false 地址非法
+ */
+auto IpBlockState::use(std::string_view ip) -> bool {
+  auto prefix = net::IpPrefix::parse(ip);
+  if (!prefix.has_value()) {
+    return false;
+  }
+  auto addr = prefix->addr();
+  auto *block = findBlock(addr);
+  if (block != nullptr) {
+    return block->use(addr);
+  }
+  if (findOther(addr) != others_.end()) {
+    return true;
+  }
+
+  IpRange range{addr, prefix->length()};
+  auto next = others_.find(addr.advance(1));
+  if (next != others_.end() && addr < next->first && next->second.length_ == range.length_) {
+    range.last_ = next->second.last_;
+    others_.erase(next);
+  }
+  auto iter = others_.lower_bound(addr);
+  if (iter != others_.begin()) {
+    auto &prev = std::prev(iter)->second;
+    if (prev.last_.advance(1) == addr && prev.length_ == range.length_) {
+      prev.last_ = range.last_;
+      return true;
+    }
+  }
+  others_.emplace_hint(iter, addr, range);
+  return true;
+}
+
+/**
+ * @brief 归还地址
+ *
+ * @param addr 地址
+ * @return true 归还成功
+ * @return false 地址没有分配
+ */
+auto IpBlockState::release(net::IpAddr addr) -> bool {
+  auto *block = findBlock(addr);
+  if (block != nullptr) {
+    return block->release(addr);
+  }
+  return removeOthers(addr, addr);
+}
+
+/**
+ * @brief 构造一个新地址块，块内已经分配的地址块之外的地址标记为已分配
+ *
+ * @param prefix 地址块
+ * @return IpBlock 地址块，尚未加入租约状态
+ */
+auto IpBlockState::makeBlock(const net::IpPrefix &prefix) const -> IpBlock {
+  IpBlock block{prefix};
+  markOthers(block);
+  return block;
+}
+
+/**
+ * @brief 加入一个地址块，块内原本在地址块之外的地址改由位图记录
+ *
+ * @param block 地址块
+ * @return IpBlock& 加入后的地址块
+ */
+auto IpBlockState::addBlock(IpBlock block) -> IpBlock & {
+  markOthers(block);
+  removeOthers(block.getPrefix().addr(), lastAddr(block.getPrefix()));
+  blocks_.emplace_back(std::move(block));
+  return blocks_.back();
+}
+
+/**
+ * @brief 在地址块的位图中标记块内属于地址块之外地址段的地址
+ *
+ * @param block 地址块
+ */
+auto IpBlockState::markOthers(IpBlock &block) const -> void {
+  auto first = block.getPrefix().addr();
+  auto last = lastAddr(block.getPrefix());
+  for (auto iter = others_.upper_bound(last); iter != others_.begin();) {
+    --iter;
+    if (iter->second.last_ < first) {
+      break;
+    }
+    auto addr = std::max(iter->first, first);
+    auto end = std::min(iter->second.last_, last);
+    for (; addr < end; addr = addr.advance(1)) {
+      block.use(addr);
+    }
+    block.use(end);
+  }
+}
+
+/**
+ * @brief 查找地址块之外包含地址的地址段
+ *
+ * @param addr 地址
+ * @return std::map<net::IpAddr, IpRange>::const_iterator 地址段，没有时为 others_.end()
+ */
+auto IpBlockState::findOther(net::IpAddr addr) const
+    -> std::map<net::IpAddr, IpRange>::const_iterator {
+  auto iter = others_.upper_bound(addr);
+  if (iter == others_.begin()) {
+    return others_.end();
+  }
+  --iter;
+  return iter->second.last_ < addr ? others_.end() : iter;
+}
+
+/**
+ * @brief 从地址块之外的地址段中去掉 [first, last]，被截断的地址段保留剩下的部分
+ *
+ * @param first 第一个地址
+ * @param last 最后一个地址（包含）
+ * @return true 去掉了地址
+ * @return false 没有地址在 [first, last] 中
+ */
+auto IpBlockState::removeOthers(net::IpAddr first, net::IpAddr last) -> bool {
+  std::vector<std::pair<net::IpAddr, IpRange>> kept{};
+  bool removed{false};
+  auto iter = others_.upper_bound(last);
+  while (iter != others_.begin()) {
+    auto prev = std::prev(iter);
+    if (prev->second.last_ < first) {
+      break;
+    }
+    removed = true;
+    if (prev->first < first) {
+      kept.emplace_back(prev->first, IpRange{prevAddr(first), prev->second.length_});
+    }
+    if (last < prev->second.last_) {
+      kept.emplace_back(last.advance(1), prev->second);
+    }
+    iter = others_.erase(prev);
+  }
+  others_.insert(kept.begin(), kept.end());
+  return removed;
+}
+
+/**
+ * @brief 对 "<path>.lock" 加排他锁（阻塞直到其他 CNI 进程释放）
+ *
+ * @param path 状态文件路径
+ */
+IpBlockStore::IpBlockStore(std::string_view path)
+    : path_{path}, lock_{fmt::format("{}.lock", path), "ip_block"} {}
+
+/**
+ * @brief 是否已经持有锁
+ *
+ * @return true 已加锁
+ * @return false 加锁失败
+ */
+auto IpBlockStore::isLocked() const noexcept -> bool { return lock_.isLocked(); }
+
+/**
+ * @brief 状态文件是否存在（不存在时 load() 得到空状态，无法与确实为空的状态区分）
+ *
+ * @return true 存在
+ * @return false 不存在，比如节点重启后 /var/run 被清空
+ */
+auto IpBlockStore::exists() const -> bool {
+  std::error_code code{};
+  return std::filesystem::exists(path_, code);
+}
+
+/**
+ * @brief 读取租约状态，状态文件不存在时得到空状态
+ *
+ * @param state 租约状态（返回值）
+ * @return true 读取成功
+ * @return false 状态文件损坏
+ */
+auto IpBlockStore::load(IpBlockState &state) const -> bool {
+  state = IpBlockState{};
+  std::ifstream file{path_};
+  if (!file.is_open()) {
+    return true;
+  }
+
+  try {
+    state = nlohmann::json::parse(file).get<IpBlockState>();
+  } catch (const std::exception &exc) {
+    OHNO_LOG(warn, "Failed to parse IPAM state {}: {}", path_, exc.what());
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief 保存租约状态，先写临时文件再 rename，避免进程中断时留下半个文件
+ *
+ * @param state 租约状态
+ * @return true 保存成功
+ * @return false 保存失败
+ */
+auto IpBlockStore::save(const IpBlockState &state) const -> bool {
+  auto tmp_path = fmt::format("{}.tmp", path_);
+  {
+    std::ofstream file{tmp_path, std::ios::trunc};
+    if (!file.is_open()) {
+      OHNO_LOG(warn, "Failed to open IPAM state {}", tmp_path);
+      return false;
+    }
+    file << nlohmann::json(state).dump();
+    if (!file.flush()) {
+      OHNO_LOG(warn, "Failed to write IPAM state {}", tmp_path);
+      return false;
+    }
+  }
+
+  if (std::rename(tmp_path.c_str(), path_.c_str()) != 0) {
+    OHNO_LOG(warn, "Failed to replace IPAM state {}", path_);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief 删除状态文件（锁文件保留，其他进程可能正在等待）
+ *
+ * @return true 删除成功或文件不存在
+ * @return false 删除失败
+ */
+auto IpBlockStore::remove() const -> bool {
+  std::error_code code{};
+  std::filesystem::remove(path_, code);
+  return !code;
+}
+
+} // namespace ipam
+} // namespace ohno
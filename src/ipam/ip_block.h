@@ -0,0 +1,118 @@
+#pragma once
+
+// clang-format off
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "nlohmann/json.hpp"
+#include "src/log/logger.h"
+#include "src/net/ip.h"
+#include "src/util/file_lock.h"
+// clang-format on
+
+namespace ohno {
+namespace ipam {
+
+constexpr std::string_view JKEY_IPAM_BLOCK_BLOCKS{"blocks"};
+constexpr std::string_view JKEY_IPAM_BLOCK_CIDR{"cidr"};
+constexpr std::string_view JKEY_IPAM_BLOCK_USED{"used"};
+constexpr std::string_view JKEY_IPAM_BLOCK_ALLOCATED{"allocated"};
+constexpr std::string_view JKEY_IPAM_BLOCK_JOURNAL_ADD{"journalAdd"};
+constexpr std::string_view JKEY_IPAM_BLOCK_JOURNAL_DEL{"journalDel"};
+constexpr net::Prefix MAX_IPAM_BLOCK_BITS{16}; // 位图最多 65536 位，更大的地址块不租用
+
+/**
+ * @brief 节点租用的一个地址块，块内已分配的地址保存为位图：第 i 位对应块内第 i 个地址，
+ * 分配、归还只需要找到地址块之后修改一位
+ */
+class IpBlock final {
+public:
+  IpBlock() = default;
+  explicit IpBlock(const net::IpPrefix &prefix);
+  friend void from_json(const nlohmann::json &json, IpBlock &block);
+  friend void to_json(nlohmann::json &json, const IpBlock &block);
+
+  auto getPrefix() const noexcept -> const net::IpPrefix &;
+  auto contains(net::IpAddr addr) const noexcept -> bool;
+  auto isUsed(net::IpAddr addr) const noexcept -> bool;
+  auto use(net::IpAddr addr) noexcept -> bool;
+  auto release(net::IpAddr addr) noexcept -> bool;
+  auto allocate(const net::IpPrefix &subnet) noexcept -> std::optional<net::IpAddr>;
+  auto empty() const noexcept -> bool;
+
+private:
+  auto size() const noexcept -> size_t;
+
+  net::IpPrefix prefix_;
+  std::vector<uint64_t> used_;
+};
+
+/**
+ * @brief 地址块之外已分配的一段连续地址，段内地址的前缀长度相同
+ */
+struct IpRange {
+  net::IpAddr last_;      // 最后一个地址（包含）
+  net::Prefix length_{0}; // 前缀长度
+};
+
+/**
+ * @brief 节点本地的地址块租约状态
+ *
+ * CNI 插件是短生命周期进程，租约状态保存在节点本地文件中，journal 记录尚未同步到 ETCD
+ * 的分配与归还，攒够一批后一次性写回。状态文件的大小与地址块、块外地址段的数量成正比，
+ * 与已分配地址数量无关
+ */
+class IpBlockState final {
+public:
+  friend void from_json(const nlohmann::json &json, IpBlockState &state);
+  friend void to_json(nlohmann::json &json, const IpBlockState &state);
+
+  auto journalSize() const noexcept -> size_t;
+  auto findBlock(net::IpAddr addr) noexcept -> IpBlock *;
+  auto isUsed(net::IpAddr addr) const -> bool;
+  auto use(std::string_view ip) -> bool;
+  auto release(net::IpAddr addr) -> bool;
+  auto makeBlock(const net::IpPrefix &prefix) const -> IpBlock;
+  auto addBlock(IpBlock block) -> IpBlock &;
+
+  std::vector<IpBlock> blocks_;           // 已租用的地址块
+  std::map<net::IpAddr, IpRange> others_; // 地址块之外已分配的地址：第一个地址 -> 地址段
+  std::vector<std::string> journal_add_;  // 尚未同步到 ETCD 的分配
+  std::vector<std::string> journal_del_;  // 尚未同步到 ETCD 的归还
+
+private:
+  auto markOthers(IpBlock &block) const -> void;
+  auto findOther(net::IpAddr addr) const -> std::map<net::IpAddr, IpRange>::const_iterator;
+  auto removeOthers(net::IpAddr first, net::IpAddr last) -> bool;
+};
+
+/**
+ * @brief 地址块租约状态文件，构造时对 "<path>.lock" 加排他锁，析构时解锁
+ *
+ * @note 状态文件通过 rename 原子替换，所以锁必须加在独立的锁文件上
+ */
+class IpBlockStore final : public log::Loggable<log::Id::ipam> {
+public:
+  explicit IpBlockStore(std::string_view path);
+  ~IpBlockStore() override = default;
+  IpBlockStore(const IpBlockStore &) = delete;
+  IpBlockStore(IpBlockStore &&) = delete;
+  auto operator=(const IpBlockStore &) -> IpBlockStore & = delete;
+  auto operator=(IpBlockStore &&) -> IpBlockStore & = delete;
+
+  auto isLocked() const noexcept -> bool;
+  auto exists() const -> bool;
+  auto load(IpBlockState &state) const -> bool;
+  auto save(const IpBlockState &state) const -> bool;
+  auto remove() const -> bool;
+
+private:
+  std::string path_;
+  util::FileLock lock_;
+};
+
+} // namespace ipam
+} // namespace ohno
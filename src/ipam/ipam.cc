@@ -1,32 +1,132 @@
 // clang-format off
 #include "ipam.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <thread>
 #include "spdlog/fmt/fmt.h"
 #include "src/backend/center_if.h"
 #include "src/common/assert.h"
 #include "src/common/except.h"
 #include "src/etcd/etcd_client_shell.h"
+#include "src/etcd/node_lease.h"
+#include "src/helper/string.h"
+#include "src/ipam/ip_allocator.h"
+#include "src/ipam/ip_block.h"
 #include "src/net/subnet.h"
 // clang-format on
 
 namespace ohno {
 namespace ipam {
 
+namespace {
+
+/**
+ * @brief 在地址列表中查找地址（按地址比较，不区分字符串写法）
+ *
+ * @param addrs 地址列表，元素带前缀
+ * @param addr 地址
+ * @return std::vector<std::string>::iterator 找到的位置，找不到为 end()
+ */
+auto findAddr(std::vector<std::string> &addrs, const net::IpAddr &addr)
+    -> std::vector<std::string>::iterator {
+  return std::find_if(addrs.begin(), addrs.end(), [&addr](const std::string &item) {
+    auto prefix = net::IpPrefix::parse(item);
+    return prefix.has_value() && prefix->addr() == addr;
+  });
+}
+
+/**
+ * @brief 记录一条 journal，与尚未写回的相反操作相互抵消（journal 最多 journal_size_ 条）
+ *
+ * @param records 本次操作对应的 journal
+ * @param opposite 相反操作对应的 journal
+ * @param ip 地址（带前缀）
+ * @param addr 地址
+ */
+auto journal(std::vector<std::string> &records, std::vector<std::string> &opposite,
+             std::string_view ip, const net::IpAddr &addr) -> void {
+  auto iter = findAddr(opposite, addr);
+  if (iter != opposite.end()) {
+    opposite.erase(iter);
+    return;
+  }
+  records.emplace_back(ip);
+}
+
+} // namespace
+
 /**
  * @brief IPAM 初始化
  *
  * @param etcd_client Etcd 客户端
+ * @param check_health 是否立即检查 ETCD 健康，不检查时由第一次访问 ETCD 时发现故障
  * @return true 初始化成功
  * @return false 初始化失败
  */
-auto Ipam::init(std::unique_ptr<etcd::EtcdClientIf> etcd_client) -> bool {
+auto Ipam::init(std::unique_ptr<etcd::EtcdClientIf> etcd_client, bool check_health) -> bool {
   etcd_client_ = std::move(etcd_client);
-  if (etcd_client_ == nullptr || !etcd_client_->test()) {
+  if (etcd_client_ == nullptr || (check_health && !etcd_client_->test())) {
     OHNO_LOG(warn, "ETCD client initialization failed");
     return false;
   }
   return true;
 }
 
+/**
+ * @brief 开启地址块租用：节点一次租用一整块地址，之后从本地状态分配，分配与归还记录在 journal
+ * 中批量写回 ETCD
+ *
+ * @param block_size 每个地址块包含的地址数量，必须是 2 的幂
+ * @param journal_size journal 攒够多少条记录后写回 ETCD
+ * @param state_dir 本地状态文件目录
+ * @return true 开启成功
+ * @return false 参数非法
+ */
+auto Ipam::enableBlockLease(size_t block_size, size_t journal_size, std::string_view state_dir)
+    -> bool {
+  // 地址块按 CIDR 对齐，所以大小必须是 2 的幂
+  if (block_size < 2 || (block_size & (block_size - 1)) != 0 || state_dir.empty()) {
+    OHNO_LOG(warn, "Invalid IPAM block size {} or state directory \"{}\"", block_size, state_dir);
+    return false;
+  }
+
+  block_size_ = block_size;
+  journal_size_ = std::max<size_t>(journal_size, 1);
+  state_dir_ = state_dir;
+  return true;
+}
+
+/**
+ * @brief 将节点 IPAM 数据从旧布局迁移到每个条目一个 key 的布局，可以重复执行
+ *
+ * 旧布局：/ohno/addresses/节点名称 与 /ohno/blocks/节点名称 的 value 是以 ',' 分割的列表，
+ * /ohno/subnets 保存集群所有子网；新布局：/ohno/addresses/节点名称/地址 -> CIDR，
+ * /ohno/blocks/节点名称/地址 -> CIDR，集群所有子网通过前缀读取 /ohno/subnets/ 得到
+ *
+ * @param node_name 节点名称
+ * @return true 迁移成功
+ * @return false 迁移失败
+ */
+auto Ipam::migrate(std::string_view node_name) -> bool {
+  OHNO_ASSERT(!node_name.empty());
+  OHNO_ASSERT(etcd_client_);
+
+  return migrateAddresses(node_name) &&
+         migrateList(fmt::format("{}/{}", ETCD_KEY_BLOCK, node_name)) &&
+         etcd_client_->del(ETCD_KEY_SUBNET);
+}
+
+/**
+ * @brief 设置本地状态目录（地址块租约状态与迁移标记）
+ *
+ * @param state_dir 本地状态目录
+ */
+auto Ipam::setStateDir(std::string_view state_dir) -> void {
+  OHNO_ASSERT(!state_dir.empty());
+  state_dir_ = state_dir;
+}
+
 /**
  * @brief 将 IPAM 信息全部输出出来
  *
@@ -38,11 +138,11 @@ auto Ipam::dump() const -> std::string {
 }
 
 /**
- * @brief 分配 Kubernetes 节点的子网
+ * @brief 分配 Kubernetes 节点的子网，双栈节点会同时保存 IPv4 与 IPv6 子网
  *
  * @param node_name Kubernetes 节点名称
  * @param center Center 对象
- * @param subnet 节点子网（返回值）
+ * @param subnet 节点主子网（返回值）
  * @return true 分配成功
  * @return false 分配失败
  */
@@ -55,27 +155,41 @@ auto Ipam::allocateSubnet(std::string_view node_name, const backend::CenterIf *c
     return true;
   }
 
+  // 双栈节点 spec.podCIDRs 同时包含两个地址族的子网，第一个与 spec.podCIDR 相同
   auto node_info = center->getKubernetesData(node_name);
-  subnet = node_info.pod_cidr_;
+  auto subnets = node_info.pod_cidrs_;
+  if (subnets.empty() && !node_info.pod_cidr_.empty()) {
+    subnets.emplace_back(node_info.pod_cidr_);
+  }
+  if (subnets.empty()) {
+    OHNO_LOG(warn, "No pod CIDR for {}", node_name);
+    subnet.clear();
+    return false;
+  }
 
-  std::string key = std::string{ETCD_KEY_SUBNET};
-  if (etcd_client_->append(key, subnet)) {
-    if (etcd_client_->put(fmt::format("{}/{}", key, node_name), subnet)) {
-      OHNO_LOG(trace, "IPAM allocated subnet:{} for {}", subnet, node_name);
-      return true;
-    }
-    etcd_client_->del(key, subnet);
+  // 集群所有子网通过前缀读取 /ohno/subnets/ 得到，不再单独维护一份列表；
+  // 子网绑定节点租约，节点宕机后自动释放
+  std::string value{};
+  for (const auto &item : subnets) {
+    value += value.empty() ? item : fmt::format(",{}", item);
+  }
+  auto lease_id = etcd::NodeLease::getLeaseId(*etcd_client_, node_name);
+  if (!etcd_client_->put(fmt::format("{}/{}", ETCD_KEY_SUBNET, node_name), value, lease_id)) {
+    OHNO_LOG(warn, "Failed to store subnet {} for {}", value, node_name);
+    subnet.clear();
+    return false;
   }
 
-  subnet.clear();
-  return false;
+  subnet = subnets.front();
+  OHNO_LOG(trace, "IPAM allocated subnet:{} for {}", value, node_name);
+  return true;
 }
 
 /**
- * @brief 删除为 Kubernetes 节点分配的子网
+ * @brief 删除为 Kubernetes 节点分配的子网（包括双栈节点的所有子网）
  *
  * @param node_name Kubernetes 节点
- * @param subnet 节点对应子网
+ * @param subnet 节点对应子网（仅用于日志）
  * @return true 删除成功
  * @return false 删除失败
  */
@@ -83,6 +197,17 @@ auto Ipam::releaseSubnet(std::string_view node_name, std::string_view subnet) ->
   OHNO_ASSERT(!node_name.empty());
   OHNO_ASSERT(etcd_client_);
 
+  // 先把 journal 写回，再删除本地租约状态以及 /ohno/blocks/节点名称
+  if (block_size_ > 0) {
+    IpBlockStore store{getStatePath(node_name)};
+    IpBlockState state{};
+    if (store.isLocked() && store.load(state)) {
+      flushJournal(node_name, state);
+    }
+    store.remove();
+    etcd_client_->delPrefix(fmt::format("{}/{}/", ETCD_KEY_BLOCK, node_name));
+  }
+
   // 删除 /ohno/subnets/节点名称
   std::string key = fmt::format("{}/{}", ETCD_KEY_SUBNET, node_name);
   if (!etcd_client_->del(key)) {
@@ -90,19 +215,12 @@ auto Ipam::releaseSubnet(std::string_view node_name, std::string_view subnet) ->
     return false;
   }
 
-  // 删除 /ohno/subnets 出现的子网
-  key = std::string{ETCD_KEY_SUBNET};
-  if (!etcd_client_->del(key, subnet)) {
-    OHNO_LOG(warn, "Failed to release subnet {} in {}", subnet, ETCD_KEY_SUBNET);
-    return false;
-  }
-
   OHNO_LOG(trace, "IPAM release subnet {} for {}", subnet, node_name);
   return true;
 }
 
 /**
- * @brief 获取 Kubernetes 节点所属子网
+ * @brief 获取 Kubernetes 节点所属主子网
  *
  * @param node_name Kubernetes 节点名称
  * @param subnet 子网（返回值）
@@ -110,21 +228,43 @@ auto Ipam::releaseSubnet(std::string_view node_name, std::string_view subnet) ->
  * @return false 获取失败
  */
 auto Ipam::getSubnet(std::string_view node_name, std::string &subnet) -> bool {
+  std::vector<std::string> subnets{};
+  if (!getSubnets(node_name, subnets)) {
+    subnet.clear();
+    return false;
+  }
+
+  subnet = subnets.front();
+  return true;
+}
+
+/**
+ * @brief 获取 Kubernetes 节点所有子网，单栈节点只有一个，双栈节点第一个为主子网
+ *
+ * @param node_name Kubernetes 节点名称
+ * @param subnets 子网（返回值）
+ * @return true 获取成功
+ * @return false 获取失败
+ */
+auto Ipam::getSubnets(std::string_view node_name, std::vector<std::string> &subnets) -> bool {
   OHNO_ASSERT(!node_name.empty());
   OHNO_ASSERT(etcd_client_);
 
-  subnet.clear();
-  bool ret = etcd_client_->get(fmt::format("{}/{}", ETCD_KEY_SUBNET, node_name), subnet);
+  subnets.clear();
+  std::string value{};
+  bool ret = etcd_client_->get(fmt::format("{}/{}", ETCD_KEY_SUBNET, node_name), value);
   if (!ret) {
     OHNO_LOG(warn, "Failed to get {}/{}", ETCD_KEY_SUBNET, node_name);
     return false;
   }
 
-  return !subnet.empty();
+  subnets = helper::split(value, ',');
+  subnets.erase(std::remove(subnets.begin(), subnets.end(), std::string{}), subnets.end());
+  return !subnets.empty();
 }
 
 /**
- * @brief 分配 Kubernetes 节点的待使用的 IP 地址
+ * @brief 从 Kubernetes 节点主子网分配待使用的 IP 地址
  *
  * @param node_name 节点名称
  * @param result_ip 待使用的 IP 地址（返回值）
@@ -140,26 +280,39 @@ auto Ipam::allocateIp(std::string_view node_name, std::string &result_ip) -> boo
     return false;
   }
 
-  net::Subnet subnet_obj{};
-  subnet_obj.init(subnet);
-  auto max_hosts = subnet_obj.getMaxHosts();
-
-  // 查找可用 IP（从 .1 到 .254）
-  for (net::Prefix i = 1; i < max_hosts - 1; ++i) {
-    std::string candidate_ip = subnet_obj.generateIp(i);
-
-    if (isIpAvailable(node_name, candidate_ip)) {
-      std::string key = fmt::format("{}/{}", ETCD_KEY_ADDRESS, node_name);
-      if (etcd_client_->append(key, candidate_ip)) {
-        OHNO_LOG(trace, "IPAM allocate IP {} for {}", candidate_ip, node_name);
-        result_ip = candidate_ip;
-        return true;
+  return allocateIpImpl(node_name, subnet, result_ip);
+}
+
+/**
+ * @brief 从 Kubernetes 节点每个子网各分配一个 IP 地址（双栈），任意一个失败则全部归还
+ *
+ * @param node_name 节点名称
+ * @param result_ips 待使用的 IP 地址，顺序与节点子网一致（返回值）
+ * @return true 分配成功
+ * @return false 分配失败
+ */
+auto Ipam::allocateIps(std::string_view node_name, std::vector<std::string> &result_ips) -> bool {
+  OHNO_ASSERT(etcd_client_);
+
+  result_ips.clear();
+  std::vector<std::string> subnets{};
+  if (!getSubnets(node_name, subnets)) {
+    OHNO_LOG(warn, "Failed to allocate ip because get {}/{} failed", ETCD_KEY_SUBNET, node_name);
+    return false;
+  }
+
+  for (const auto &subnet : subnets) {
+    std::string result_ip{};
+    if (!allocateIpImpl(node_name, subnet, result_ip)) {
+      for (const auto &allocated : result_ips) {
+        releaseIp(node_name, allocated);
       }
+      result_ips.clear();
+      return false;
     }
+    result_ips.emplace_back(std::move(result_ip));
   }
-
-  result_ip.clear();
-  return false;
+  return true;
 }
 
 /**
@@ -174,10 +327,24 @@ auto Ipam::releaseIp(std::string_view node_name, std::string_view ip_to_del) ->
   OHNO_ASSERT(!node_name.empty());
   OHNO_ASSERT(etcd_client_);
 
-  // 删除 /ohno/address/${节点名字} 出现的 IP 地址
-  std::string key = fmt::format("{}/{}", ETCD_KEY_ADDRESS, node_name);
-  if (!etcd_client_->del(key, ip_to_del)) {
-    OHNO_LOG(warn, "Failed to release IP {} in {}/{}", ip_to_del, ETCD_KEY_ADDRESS, node_name);
+  if (block_size_ > 0) {
+    auto released = releaseIpInBlock(node_name, ip_to_del);
+    if (released.has_value()) {
+      return released.value();
+    }
+  }
+
+  // 旧布局中的地址还没有迁移时（ohnod 尚未运行 migrate），先迁移再按地址删除，否则迁移时会复活
+  if (!migrateAddresses(node_name)) {
+    OHNO_LOG(warn, "Failed to migrate {}/{} before releasing IP {}", ETCD_KEY_ADDRESS, node_name,
+             ip_to_del);
+    return false;
+  }
+
+  // 删除 /ohno/addresses/${节点名字}/${IP 地址}
+  std::string key = getAddressKey(node_name, ip_to_del);
+  if (!etcd_client_->del(key)) {
+    OHNO_LOG(warn, "Failed to release IP {} in {}", ip_to_del, key);
     return false;
   }
 
@@ -185,6 +352,115 @@ auto Ipam::releaseIp(std::string_view node_name, std::string_view ip_to_del) ->
   return true;
 }
 
+/**
+ * @brief 归还节点没有已分配地址的地址块（节点最后一个 Pod 删除之后调用），
+ * 节点网络设施回收时 releaseSubnet() 归还全部地址块
+ *
+ * @param node_name 节点名称
+ * @return true 归还成功或者没有开启地址块租用
+ * @return false 归还失败
+ */
+auto Ipam::releaseEmptyBlocks(std::string_view node_name) -> bool {
+  OHNO_ASSERT(!node_name.empty());
+  OHNO_ASSERT(etcd_client_);
+  if (block_size_ == 0) {
+    return true;
+  }
+
+  IpBlockStore store{getStatePath(node_name)};
+  IpBlockState state{};
+  if (!store.isLocked() || !loadState(node_name, store, state)) {
+    OHNO_LOG(warn, "Failed to load IPAM state of {}", node_name);
+    return false;
+  }
+
+  std::vector<IpBlock> kept{};
+  bool ret{true};
+  for (auto &block : state.blocks_) {
+    if (block.empty()) {
+      auto block_str = block.getPrefix().toString();
+      auto key = getEntryKey(fmt::format("{}/{}", ETCD_KEY_BLOCK, node_name), block_str);
+      if (etcd_client_->del(key)) {
+        OHNO_LOG(debug, "IPAM released empty block {} of {}", block_str, node_name);
+        continue;
+      }
+      OHNO_LOG(warn, "Failed to release empty block {} in {}", block_str, key);
+      ret = false;
+    }
+    kept.emplace_back(std::move(block));
+  }
+  state.blocks_ = std::move(kept);
+  return store.save(state) && ret;
+}
+
+/**
+ * @brief 从指定子网分配一个 IP 地址
+ *
+ * @note 每次分配都从 ETCD 前缀读取节点所有已分配地址并重建稀疏分配器，这一步与已分配地址数
+ * 成正比（ipam_bm 中 /20 子网半满时一次分配加释放约 0.85ms）；O(log n) 只是读入之后在内存中
+ * 挑选空闲地址这一步，不依赖子网大小。每个地址是一个独立的 key，分配只写入一个 key，
+ * 写入时比较 create_revision 为 0，同一节点上并发的 CNI 挑中同一个地址时只有一个成功，
+ * 其余的重新读取之后再挑选。需要每次分配都不读前缀时使用地址块（block_size_ > 0）
+ *
+ * @param node_name 节点名称
+ * @param subnet 节点子网
+ * @param result_ip 待使用的 IP 地址（返回值）
+ * @return true 分配成功
+ * @return false 分配失败
+ */
+auto Ipam::allocateIpImpl(std::string_view node_name, std::string_view subnet,
+                          std::string &result_ip) -> bool {
+  if (block_size_ > 0) {
+    return allocateIpInBlock(node_name, subnet, result_ip);
+  }
+
+  net::Subnet subnet_obj{};
+  subnet_obj.init(subnet);
+  result_ip.clear();
+
+  for (int attempt = 1; attempt <= IPAM_ALLOCATE_ATTEMPTS; ++attempt) {
+    IpAllocator allocator{subnet_obj.getNetwork()};
+    std::vector<std::string> all_ip{};
+    if (getAllIp(node_name, all_ip)) {
+      for (const auto &ip : all_ip) {
+        auto addr = net::IpPrefix::parse(ip);
+        if (addr.has_value()) {
+          allocator.reserve(addr->addr()); // 其他地址族或其他子网的地址会被忽略
+        }
+      }
+    }
+
+    auto candidate = allocator.allocate();
+    if (!candidate.has_value()) {
+      OHNO_LOG(warn, "IPAM subnet {} of {} is exhausted", subnet, node_name);
+      return false;
+    }
+
+    std::string candidate_ip =
+        net::IpPrefix{candidate.value(), subnet_obj.getPrefix()}.toString();
+    std::string key = getAddressKey(node_name, candidate_ip);
+    etcd::EtcdTxn txn{};
+    txn.compare(etcd::TxnCmpTarget::create, key, 0).put(key, candidate_ip);
+    auto result = etcd_client_->commit(txn);
+    if (result == etcd::TxnResult::committed) {
+      OHNO_LOG(trace, "IPAM allocate IP {} for {}", candidate_ip, node_name);
+      result_ip = candidate_ip;
+      return true;
+    }
+    if (result == etcd::TxnResult::failed) {
+      OHNO_LOG(warn, "Failed to store IP {} in {}", candidate_ip, key);
+      return false;
+    }
+    OHNO_LOG(debug, "IPAM IP {} was taken concurrently on attempt {}, retrying", candidate_ip,
+             attempt);
+    std::this_thread::sleep_for(etcd::getTxnBackoff(attempt));
+  }
+
+  OHNO_LOG(warn, "IPAM failed to allocate IP in {} of {} after {} conflicts", subnet, node_name,
+           IPAM_ALLOCATE_ATTEMPTS);
+  return false;
+}
+
 /**
  * @brief 获取 Kubernetes 节点所有已使用的 IP 地址
  *
@@ -196,35 +472,406 @@ auto Ipam::releaseIp(std::string_view node_name, std::string_view ip_to_del) ->
 auto Ipam::getAllIp(std::string_view node_name, std::vector<std::string> &all_ip) -> bool {
   OHNO_ASSERT(!node_name.empty());
 
-  if (!etcd_client_->list(fmt::format("{}/{}", ETCD_KEY_ADDRESS, node_name), all_ip)) {
-    OHNO_LOG(warn, "Failed to get {}/{}", ETCD_KEY_ADDRESS, node_name);
+  // 前缀不带 '/'，一次读到旧布局的列表 key 与新布局的地址 key，名称只是以本节点名称开头的
+  // 其他节点的 key 也会读到，需要过滤掉
+  auto legacy_key = fmt::format("{}/{}", ETCD_KEY_ADDRESS, node_name);
+  std::unordered_map<std::string, std::string> entries{};
+  if (!etcd_client_->get(legacy_key, entries)) {
+    OHNO_LOG(warn, "Failed to get {}", legacy_key);
     return false;
   }
 
-  return !all_ip.empty();
+  all_ip.clear();
+  all_ip.reserve(entries.size());
+  bool has_legacy{false};
+  for (auto &[key, value] : entries) {
+    if (key == legacy_key) {
+      for (auto &ip : helper::split(value, ',')) {
+        if (!ip.empty()) {
+          all_ip.emplace_back(std::move(ip));
+        }
+      }
+      has_legacy = true;
+    } else if (key.size() > legacy_key.size() && key[legacy_key.size()] == '/') {
+      all_ip.emplace_back(std::move(value));
+    }
+  }
+
+  // 升级之后 CNI 可能先于 ohnod 运行，旧布局中的地址同样已被占用，就地迁移之后才能按地址归还
+  if (has_legacy && !migrateList(legacy_key)) {
+    OHNO_LOG(warn, "Failed to migrate {}, addresses in it are still reserved", legacy_key);
+  }
+  return true;
 }
 
 /**
- * @brief IP 地址是否未分配
+ * @brief 从节点租用的地址块分配一个 IP 地址，地址块用尽时再租用一块
  *
- * @param node_name Kubernetes 节点名称
- * @param ip_to_confirm 待确认的 IP 地址
- * @return true 未分配
- * @return false 已分配
+ * @note 只有租用新地址块以及 journal 攒满时才会访问 ETCD，其余情况只读写本地状态文件；
+ * 本地状态中已分配的地址是每个地址块的位图，分配只需要在地址块内找第一个空位
+ *
+ * @param node_name 节点名称
+ * @param subnet 节点子网
+ * @param result_ip 待使用的 IP 地址（返回值）
+ * @return true 分配成功
+ * @return false 分配失败
  */
-auto Ipam::isIpAvailable(std::string_view node_name, std::string_view ip_to_confirm) const -> bool {
-  OHNO_ASSERT(!node_name.empty());
-  OHNO_ASSERT(!ip_to_confirm.empty());
-  OHNO_ASSERT(etcd_client_);
+auto Ipam::allocateIpInBlock(std::string_view node_name, std::string_view subnet,
+                             std::string &result_ip) -> bool {
+  result_ip.clear();
+  net::Subnet subnet_obj{};
+  subnet_obj.init(subnet);
+  auto network = subnet_obj.getNetwork();
 
-  std::vector<std::string> all_addresses{};
-  auto ret = etcd_client_->list(fmt::format("{}/{}", ETCD_KEY_ADDRESS, node_name), all_addresses);
-  if (!ret) {
-    return true; // 获取失败，假设地址可用
+  IpBlockStore store{getStatePath(node_name)};
+  IpBlockState state{};
+  if (!store.isLocked() || !loadState(node_name, store, state)) {
+    OHNO_LOG(warn, "Failed to load IPAM state of {}", node_name);
+    return false;
+  }
+
+  std::optional<net::IpAddr> candidate{};
+  for (auto &block : state.blocks_) {
+    if (network.contains(block.getPrefix())) {
+      candidate = block.allocate(network);
+      if (candidate.has_value()) {
+        break;
+      }
+    }
+  }
+  if (!candidate.has_value()) {
+    candidate = leaseBlock(node_name, network, state);
+  }
+  if (!candidate.has_value()) {
+    return false;
+  }
+
+  std::string candidate_ip = net::IpPrefix{candidate.value(), subnet_obj.getPrefix()}.toString();
+  journal(state.journal_add_, state.journal_del_, candidate_ip, candidate.value());
+  if (state.journalSize() >= journal_size_) {
+    flushJournal(node_name, state); // 写回失败的记录留在 journal 中，下次再写回
+  }
+  if (!store.save(state)) {
+    return false;
+  }
+
+  OHNO_LOG(trace, "IPAM allocate IP {} for {} from leased block", candidate_ip, node_name);
+  result_ip = candidate_ip;
+  return true;
+}
+
+/**
+ * @brief 归还节点地址块内的 IP 地址
+ *
+ * @param node_name 节点名称
+ * @param ip_to_del 已使用的 IP 地址
+ * @return std::optional<bool> 是否归还成功，地址不在本地状态中（比如开启租用之前分配）时为空
+ */
+auto Ipam::releaseIpInBlock(std::string_view node_name, std::string_view ip_to_del)
+    -> std::optional<bool> {
+  auto addr = net::IpPrefix::parse(ip_to_del);
+  if (!addr.has_value()) {
+    return std::nullopt;
+  }
+
+  IpBlockStore store{getStatePath(node_name)};
+  IpBlockState state{};
+  if (!store.isLocked() || !loadState(node_name, store, state)) {
+    OHNO_LOG(warn, "Failed to load IPAM state of {}", node_name);
+    return false;
+  }
+  if (!state.release(addr->addr())) {
+    return std::nullopt;
+  }
+
+  journal(state.journal_del_, state.journal_add_, ip_to_del, addr->addr());
+  if (state.journalSize() >= journal_size_) {
+    flushJournal(node_name, state);
+  }
+  if (!store.save(state)) {
+    return false;
+  }
+
+  OHNO_LOG(trace, "IPAM release IP {} for {} to leased block", ip_to_del, node_name);
+  return true;
+}
+
+/**
+ * @brief 为节点租用一个有空闲地址的地址块，并从中分配一个地址
+ *
+ * @note 只有一次前缀读取（节点已租用的地址块）和一次写入；已租用的地址块与块外已分配的地址
+ * 在分配器中整体预留，剩下的最小空闲地址所在的地址块就是要租用的地址块，不需要逐个地址块尝试
+ *
+ * @param node_name 节点名称
+ * @param network 节点子网
+ * @param state 本地租约状态
+ * @return std::optional<net::IpAddr> 地址，子网已满或者访问 ETCD 失败时为空
+ */
+auto Ipam::leaseBlock(std::string_view node_name, const net::IpPrefix &network,
+                      IpBlockState &state) -> std::optional<net::IpAddr> {
+  // 本地状态之外租用的地址块（比如节点切换过状态目录）先用；读取失败时无法确认哪些地址块
+  // 已经租用，不能再租用新的地址块
+  std::unordered_map<std::string, std::string> leased{};
+  if (!etcd_client_->get(fmt::format("{}/{}/", ETCD_KEY_BLOCK, node_name), leased)) {
+    OHNO_LOG(warn, "Failed to get leased blocks of {}", node_name);
+    return std::nullopt;
+  }
+  for (const auto &[_, block] : leased) {
+    auto prefix = net::IpPrefix::parse(block);
+    if (!prefix.has_value() || !network.contains(prefix.value()) ||
+        prefix->hostBits() > MAX_IPAM_BLOCK_BITS ||
+        std::any_of(state.blocks_.begin(), state.blocks_.end(), [&prefix](const IpBlock &item) {
+          return item.getPrefix() == prefix->network();
+        })) {
+      continue;
+    }
+    auto candidate = state.addBlock(state.makeBlock(prefix.value())).allocate(network);
+    if (candidate.has_value()) {
+      return candidate;
+    }
+  }
+
+  // 地址块比子网还大时整个子网就是一个地址块
+  net::Prefix block_bits = 0;
+  while ((size_t{1} << block_bits) < block_size_) {
+    ++block_bits;
+  }
+  block_bits = std::min(block_bits, network.hostBits());
+  auto length = network.addr().maxPrefix() - block_bits;
+
+  IpAllocator unleased{network};
+  for (const auto &block : state.blocks_) {
+    unleased.reserve(block.getPrefix());
+  }
+  for (const auto &[first, range] : state.others_) {
+    for (auto addr = first; addr < range.last_; addr = addr.advance(1)) {
+      unleased.reserve(addr); // 其他地址族的地址会被忽略
+    }
+    unleased.reserve(range.last_);
+  }
+  auto first_free = unleased.allocate();
+  if (!first_free.has_value()) {
+    OHNO_LOG(warn, "IPAM subnet {} of {} is exhausted", network.toString(), node_name);
+    return std::nullopt;
   }
+  auto block = state.makeBlock(net::IpPrefix{first_free.value(), length});
+  auto candidate = block.allocate(network);
+  OHNO_ASSERT(candidate.has_value());
 
-  return std::find(all_addresses.begin(), all_addresses.end(), ip_to_confirm) ==
-         all_addresses.end();
+  auto block_str = block.getPrefix().toString();
+  auto key = getEntryKey(fmt::format("{}/{}", ETCD_KEY_BLOCK, node_name), block_str);
+  if (!etcd_client_->put(key, block_str)) {
+    OHNO_LOG(warn, "Failed to lease block {} in {}", block_str, key);
+    return std::nullopt;
+  }
+  state.addBlock(std::move(block));
+  OHNO_LOG(debug, "IPAM leased block {} for {}", block_str, node_name);
+  return candidate;
+}
+
+/**
+ * @brief 将 journal 写回 /ohno/addresses/节点名称/，每条记录只修改一个 key，
+ * 一批记录在一个事务中提交（超过 etcd::MAX_TXN_OPS 条时分多个事务）
+ *
+ * @param node_name 节点名称
+ * @param state 本地租约状态，写回成功的记录会从 journal 中移除
+ * @return true 全部写回成功
+ * @return false 写回失败
+ */
+auto Ipam::flushJournal(std::string_view node_name, IpBlockState &state) -> bool {
+  auto size = state.journalSize();
+  while (state.journalSize() > 0) {
+    auto dels = std::min(state.journal_del_.size(), etcd::MAX_TXN_OPS);
+    auto puts = std::min(state.journal_add_.size(), etcd::MAX_TXN_OPS - dels);
+    etcd::EtcdTxn txn{};
+    for (size_t i = 0; i < dels; ++i) {
+      txn.del(getAddressKey(node_name, state.journal_del_[i]));
+    }
+    for (size_t i = 0; i < puts; ++i) {
+      txn.put(getAddressKey(node_name, state.journal_add_[i]), state.journal_add_[i]);
+    }
+    if (etcd_client_->commit(txn) != etcd::TxnResult::committed) {
+      OHNO_LOG(warn, "Failed to flush IPAM journal of {}: {} records left", node_name,
+               state.journalSize());
+      return false;
+    }
+    state.journal_del_.erase(state.journal_del_.begin(), state.journal_del_.begin() + dels);
+    state.journal_add_.erase(state.journal_add_.begin(), state.journal_add_.begin() + puts);
+  }
+
+  if (size > 0) {
+    OHNO_LOG(trace, "IPAM flushed {} journal records of {}", size, node_name);
+  }
+  return true;
+}
+
+/**
+ * @brief 读取本地租约状态，状态文件不存在时从 ETCD 重建并保存
+ *
+ * @param node_name 节点名称
+ * @param store 已加锁的状态文件
+ * @param state 本地租约状态（返回值）
+ * @return true 读取成功
+ * @return false 状态文件损坏或者重建失败
+ */
+auto Ipam::loadState(std::string_view node_name, const IpBlockStore &store, IpBlockState &state)
+    -> bool {
+  if (!store.load(state)) {
+    return false;
+  }
+  if (store.exists()) {
+    return true;
+  }
+  return rebuildState(node_name, state) && store.save(state);
+}
+
+/**
+ * @brief 从 ETCD 重建本地租约状态：已租用的地址块、已写回的地址，以及 Pod 记录引用但没有
+ * 写回的地址（丢失的 journal），后者重新记入 journal，随下一批写回
+ *
+ * @note 地址列表中有而 Pod 记录中没有的地址仍然视为已占用，它可能属于正在执行的 CNI ADD
+ *
+ * @param node_name 节点名称
+ * @param state 本地租约状态（返回值）
+ * @return true 重建成功
+ * @return false 读取 ETCD 失败
+ */
+auto Ipam::rebuildState(std::string_view node_name, IpBlockState &state) -> bool {
+  state = IpBlockState{};
+  std::unordered_map<std::string, std::string> entries{};
+  if (!etcd_client_->get(fmt::format("{}/{}/", ETCD_KEY_BLOCK, node_name), entries)) {
+    OHNO_LOG(warn, "Failed to get leased blocks of {}", node_name);
+    return false;
+  }
+  for (const auto &[_, block] : entries) {
+    auto prefix = net::IpPrefix::parse(block);
+    if (prefix.has_value() && prefix->hostBits() <= MAX_IPAM_BLOCK_BITS) {
+      state.blocks_.emplace_back(prefix.value());
+    }
+  }
+
+  std::vector<std::string> allocated{};
+  if (!getAllIp(node_name, allocated)) {
+    return false;
+  }
+  for (const auto &ip : allocated) {
+    state.use(ip);
+  }
+
+  // Pod 记录：/ohno/node/节点名称/pod/Pod 名称/nic/网卡名称/addr -> 以 ',' 分割的地址
+  constexpr std::string_view addr_suffix{"/addr"};
+  entries.clear();
+  if (!etcd_client_->get(fmt::format("{}/{}/pod/", ETCD_KEY_NODE, node_name), entries)) {
+    OHNO_LOG(warn, "Failed to get pod records of {}", node_name);
+    return false;
+  }
+  for (const auto &[key, value] : entries) {
+    if (key.size() < addr_suffix.size() ||
+        std::string_view{key}.substr(key.size() - addr_suffix.size()) != addr_suffix) {
+      continue;
+    }
+    helper::Tokenizer tokens{value, ','};
+    std::string_view ip{};
+    while (tokens.next(ip)) {
+      auto addr = net::IpPrefix::parse(ip);
+      if (addr.has_value() && !state.isUsed(addr->addr())) {
+        state.use(ip);
+        state.journal_add_.emplace_back(ip);
+      }
+    }
+  }
+
+  OHNO_LOG(info, "IPAM rebuilt state of {}: {} blocks, {} addresses, {} lost journal records",
+           node_name, state.blocks_.size(), allocated.size(), state.journal_add_.size());
+  return true;
+}
+
+/**
+ * @brief 迁移节点旧布局的地址列表，迁移完成后在本地状态目录留下标记，之后不再读取旧 key
+ *
+ * @note 节点上的 CNI 与 ohnod 升级之后不会再写旧布局，所以标记按节点记录即可；/var/run
+ * 清空后标记丢失，只是多读一次旧 key
+ *
+ * @param node_name 节点名称
+ * @return true 迁移成功或者已经迁移
+ * @return false 迁移失败
+ */
+auto Ipam::migrateAddresses(std::string_view node_name) -> bool {
+  auto marker = fmt::format("{}/{}.migrated", state_dir_, node_name);
+  std::error_code code{};
+  if (std::filesystem::exists(marker, code)) {
+    return true;
+  }
+  if (!migrateList(fmt::format("{}/{}", ETCD_KEY_ADDRESS, node_name))) {
+    return false;
+  }
+
+  std::filesystem::create_directories(state_dir_, code);
+  if (!std::ofstream{marker}.is_open()) {
+    OHNO_LOG(debug, "Failed to create IPAM migration marker {}", marker);
+  }
+  return true;
+}
+
+/**
+ * @brief 将旧布局中以 ',' 分割的列表拆分为每个条目一个 key，然后删除旧 key
+ *
+ * @param key 旧布局的 key，同时也是新布局的 key 前缀
+ * @return true 迁移成功或无需迁移
+ * @return false 迁移失败
+ */
+auto Ipam::migrateList(std::string_view key) -> bool {
+  std::vector<std::string> values{};
+  if (!etcd_client_->list(key, values)) {
+    return false;
+  }
+  values.erase(std::remove(values.begin(), values.end(), std::string{}), values.end());
+  if (values.empty()) {
+    return true;
+  }
+
+  for (const auto &value : values) {
+    if (!etcd_client_->put(getEntryKey(key, value), value)) {
+      OHNO_LOG(warn, "Failed to migrate {} in {}", value, key);
+      return false;
+    }
+  }
+  OHNO_LOG(info, "IPAM migrated {} entries of {}", values.size(), key);
+  return etcd_client_->del(key);
+}
+
+/**
+ * @brief 获取条目对应的 key，key 中只保留地址本身，前缀长度保存在 value 中
+ *
+ * @param key 条目所属的 key 前缀（如 /ohno/addresses/节点名称）
+ * @param cidr 条目（地址或者 CIDR）
+ * @return std::string 条目 key（如 /ohno/addresses/节点名称/10.244.1.2）
+ */
+auto Ipam::getEntryKey(std::string_view key, std::string_view cidr) -> std::string {
+  auto prefix = net::IpPrefix::parse(cidr);
+  auto addr = prefix.has_value() ? std::optional{prefix->addr()} : net::IpAddr::parse(cidr);
+  return fmt::format("{}/{}", key, addr.has_value() ? addr->toString() : std::string{cidr});
+}
+
+/**
+ * @brief 获取节点地址对应的 key
+ *
+ * @param node_name 节点名称
+ * @param ip 地址
+ * @return std::string 地址 key
+ */
+auto Ipam::getAddressKey(std::string_view node_name, std::string_view ip) -> std::string {
+  return getEntryKey(fmt::format("{}/{}", ETCD_KEY_ADDRESS, node_name), ip);
+}
+
+/**
+ * @brief 获取节点本地租约状态文件路径
+ *
+ * @param node_name 节点名称
+ * @return std::string 状态文件路径
+ */
+auto Ipam::getStatePath(std::string_view node_name) const -> std::string {
+  return fmt::format("{}/{}.json", state_dir_, node_name);
 }
 
 } // namespace ipam
@@ -2,34 +2,71 @@
 
 // clang-format off
 #include <memory>
+#include <optional>
 #include "ipam_if.h"
 #include "src/etcd/etcd_client_if.h"
 #include "src/log/logger.h"
+#include "src/net/ip.h"
 // clang-format on
 
 namespace ohno {
 namespace ipam {
 
 constexpr std::string_view ETCD_KEY_PREFIX{"/ohno"};
+constexpr std::string_view ETCD_KEY_CACHE{"/ohno/"}; // 缓存的前缀，不能匹配到 /ohnoxxx
 constexpr std::string_view ETCD_KEY_SUBNET{"/ohno/subnets"};
 constexpr std::string_view ETCD_KEY_ADDRESS{"/ohno/addresses"};
+constexpr std::string_view ETCD_KEY_BLOCK{"/ohno/blocks"};
+constexpr std::string_view ETCD_KEY_NODE{"/ohno/node"}; // Storage 的 Pod 记录，重建本地状态时核对
+constexpr std::string_view PATH_IPAM_STATE{"/var/run/ohno/ipam"};
+constexpr int IPAM_ALLOCATE_ATTEMPTS{16}; // 同一地址被并发分配时重新挑选的次数
+
+class IpBlockState;
+class IpBlockStore;
 
 class Ipam final : public IpamIf, public log::Loggable<log::Id::ipam> {
 public:
-  auto init(std::unique_ptr<etcd::EtcdClientIf> etcd_client) -> bool;
+  auto init(std::unique_ptr<etcd::EtcdClientIf> etcd_client, bool check_health = true) -> bool;
+  auto enableBlockLease(size_t block_size, size_t journal_size,
+                        std::string_view state_dir = PATH_IPAM_STATE) -> bool;
+  auto setStateDir(std::string_view state_dir) -> void;
+  auto migrate(std::string_view node_name) -> bool;
   auto dump() const -> std::string override;
   auto allocateSubnet(std::string_view node_name, const backend::CenterIf *center,
                       std::string &subnet) -> bool override;
   auto releaseSubnet(std::string_view node_name, std::string_view subnet) -> bool override;
   auto getSubnet(std::string_view node_name, std::string &subnet) -> bool override;
+  auto getSubnets(std::string_view node_name, std::vector<std::string> &subnets) -> bool override;
   auto allocateIp(std::string_view node_name, std::string &result_ip) -> bool override;
+  auto allocateIps(std::string_view node_name, std::vector<std::string> &result_ips)
+      -> bool override;
   auto releaseIp(std::string_view node_name, std::string_view ip_to_del) -> bool override;
+  auto releaseEmptyBlocks(std::string_view node_name) -> bool override;
 
 private:
+  auto allocateIpImpl(std::string_view node_name, std::string_view subnet, std::string &result_ip)
+      -> bool;
   auto getAllIp(std::string_view node_name, std::vector<std::string> &all_ip) -> bool;
-  auto isIpAvailable(std::string_view node_name, std::string_view ip_to_confirm) const -> bool;
+  auto allocateIpInBlock(std::string_view node_name, std::string_view subnet,
+                         std::string &result_ip) -> bool;
+  auto releaseIpInBlock(std::string_view node_name, std::string_view ip_to_del)
+      -> std::optional<bool>;
+  auto leaseBlock(std::string_view node_name, const net::IpPrefix &network, IpBlockState &state)
+      -> std::optional<net::IpAddr>;
+  auto flushJournal(std::string_view node_name, IpBlockState &state) -> bool;
+  auto loadState(std::string_view node_name, const IpBlockStore &store, IpBlockState &state)
+      -> bool;
+  auto rebuildState(std::string_view node_name, IpBlockState &state) -> bool;
+  auto getStatePath(std::string_view node_name) const -> std::string;
+  auto migrateAddresses(std::string_view node_name) -> bool;
+  auto migrateList(std::string_view key) -> bool;
+  static auto getEntryKey(std::string_view key, std::string_view cidr) -> std::string;
+  static auto getAddressKey(std::string_view node_name, std::string_view ip) -> std::string;
 
   std::unique_ptr<etcd::EtcdClientIf> etcd_client_;
+  size_t block_size_{0};   // 每个地址块包含的地址数量，0 表示不租用地址块
+  size_t journal_size_{1}; // journal 攒够多少条记录后写回 ETCD
+  std::string state_dir_{PATH_IPAM_STATE}; // 地址块租约状态与迁移标记
 };
 
 } // namespace ipam
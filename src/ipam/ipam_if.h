@@ -18,8 +18,13 @@ public:
                               std::string &subnet) -> bool = 0;
   virtual auto releaseSubnet(std::string_view node_name, std::string_view subnet) -> bool = 0;
   virtual auto getSubnet(std::string_view node_name, std::string &subnet) -> bool = 0;
+  virtual auto getSubnets(std::string_view node_name, std::vector<std::string> &subnets)
+      -> bool = 0;
   virtual auto allocateIp(std::string_view node_name, std::string &result_ip) -> bool = 0;
+  virtual auto allocateIps(std::string_view node_name, std::vector<std::string> &result_ips)
+      -> bool = 0;
   virtual auto releaseIp(std::string_view node_name, std::string_view ip_to_del) -> bool = 0;
+  virtual auto releaseEmptyBlocks(std::string_view node_name) -> bool = 0;
 };
 
 } // namespace ipam
@@ -6,6 +6,13 @@
 namespace ohno {
 namespace ipam {
 
+/**
+ * @brief 创建网络空间
+ *
+ * @param resource 名称与网卡索引的内存资源，一般是对象所在的 Arena
+ */
+Netns::Netns(std::pmr::memory_resource *resource) : name_{resource}, nic_{resource} {}
+
 /**
  * @brief 设置 Pod 名称
  *
@@ -18,7 +25,7 @@ auto Netns::setName(std::string_view pod_name) -> void { name_ = pod_name; }
  *
  * @return std::string Pod 名称
  */
-auto Netns::getName() const -> std::string { return name_; }
+auto Netns::getName() const -> std::string { return std::string{name_}; }
 
 /**
  * @brief 向网络空间中添加网络接口
@@ -2,7 +2,9 @@
 
 // clang-format off
 #include "netns_if.h"
+#include <memory_resource>
 #include <string>
+#include <unordered_map>
 #include "src/log/logger.h"
 // clang-format on
 
@@ -11,6 +13,8 @@ namespace ipam {
 
 class Netns : public NetnsIf, public log::Loggable<log::Id::ipam> {
 public:
+  explicit Netns(std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
   auto setName(std::string_view pod_name) -> void override;
   auto getName() const -> std::string override;
   auto addNic(std::shared_ptr<net::NicIf> nic) -> void override;
@@ -18,8 +22,8 @@ public:
   auto getNic(std::string_view nic_name) const -> std::shared_ptr<net::NicIf> override;
 
 private:
-  std::string name_;
-  std::unordered_map<std::string, std::shared_ptr<net::NicIf>>
+  std::pmr::string name_;
+  std::pmr::unordered_map<std::pmr::string, std::shared_ptr<net::NicIf>>
       nic_; // 网络接口名称 -> 网络接口对象（用 std::shared_ptr<T> 是为了接管生命周期）
 };
 
@@ -13,6 +13,13 @@
 namespace ohno {
 namespace ipam {
 
+/**
+ * @brief 创建 Kubernetes 节点
+ *
+ * @param resource 名称与网络空间索引的内存资源，一般是对象所在的 Arena
+ */
+Node::Node(std::pmr::memory_resource *resource) : name_{resource}, netns_{resource} {}
+
 /**
  * @brief 为 Kubernetes 节点设置名称
  *
@@ -28,7 +35,7 @@ auto Node::setName(std::string_view node_name) -> void {
  *
  * @return std::string 节点名称，还没设置则返回空字符串
  */
-auto Node::getName() const -> std::string { return name_; }
+auto Node::getName() const -> std::string { return std::string{name_}; }
 
 /**
  * @brief 向 Kubernetes 节点中增加一个 Linux namespace
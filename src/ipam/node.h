@@ -2,6 +2,7 @@
 
 // clang-format off
 #include "node_if.h"
+#include <memory_resource>
 #include <unordered_map>
 #include "src/log/logger.h"
 #include "src/net/addr_if.h"
@@ -15,6 +16,8 @@ namespace ipam {
 
 class Node : public NodeIf, public log::Loggable<log::Id::ipam> {
 public:
+  explicit Node(std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
   auto setName(std::string_view node_name) -> void override;
   auto getName() const -> std::string override;
   auto addNetns(std::string_view netns_name, std::shared_ptr<NetnsIf> netns) -> void override;
@@ -29,8 +32,8 @@ public:
   auto getUnderlayDev() const -> std::string override;
 
 private:
-  std::string name_;
-  std::unordered_map<std::string, std::shared_ptr<NetnsIf>> netns_;
+  std::pmr::string name_;
+  std::pmr::unordered_map<std::pmr::string, std::shared_ptr<NetnsIf>> netns_;
   std::unique_ptr<net::SubnetIf> subnet_;
   std::unique_ptr<net::AddrIf> underlay_addr_;
   std::string underlay_dev_;
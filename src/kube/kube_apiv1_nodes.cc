@@ -58,10 +58,14 @@ void from_json(const nlohmann::json &json, Spec &spec) {
   if (json.contains(JKEY_KUBE_SPEC_PODCIDR)) {
     spec.pod_cidr_ = json.at(JKEY_KUBE_SPEC_PODCIDR).get<std::string>();
   }
+  if (json.contains(JKEY_KUBE_SPEC_PODCIDRS)) {
+    spec.pod_cidrs_ = json.at(JKEY_KUBE_SPEC_PODCIDRS).get<std::vector<std::string>>();
+  }
 }
 
 void to_json(nlohmann::json &json, const Spec &spec) {
-  json = nlohmann::json{{JKEY_KUBE_SPEC_PODCIDR, spec.pod_cidr_}};
+  json = nlohmann::json{{JKEY_KUBE_SPEC_PODCIDR, spec.pod_cidr_},
+                        {JKEY_KUBE_SPEC_PODCIDRS, spec.pod_cidrs_}};
 }
 
 void from_json(const nlohmann::json &json, Item &items) {
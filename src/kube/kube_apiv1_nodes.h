@@ -16,6 +16,7 @@ constexpr std::string_view JKEY_KUBE_ADDRESS_TYPE{"type"};
 constexpr std::string_view JKEY_KUBE_ADDRESS_ADDR{"address"};
 constexpr std::string_view JKEY_KUBE_STATUS_ADDR{"addresses"};
 constexpr std::string_view JKEY_KUBE_SPEC_PODCIDR{"podCIDR"};
+constexpr std::string_view JKEY_KUBE_SPEC_PODCIDRS{"podCIDRs"};
 constexpr std::string_view JKEY_KUBE_ITEM_MD{"metadata"};
 constexpr std::string_view JKEY_KUBE_ITEM_STATUS{"status"};
 constexpr std::string_view JKEY_KUBE_ITEM_SPEC{"spec"};
@@ -69,6 +70,7 @@ public:
   friend void to_json(nlohmann::json &json, const Spec &spec);
 
   std::string pod_cidr_;
+  std::vector<std::string> pod_cidrs_;
 };
 
 class Item {
@@ -0,0 +1,259 @@
+// clang-format off
+#include "metrics.h"
+#include <algorithm>
+#include "spdlog/fmt/fmt.h"
+#include "src/common/except.h"
+// clang-format on
+
+namespace ohno {
+namespace metrics {
+
+namespace {
+
+/**
+ * @brief 获取固定分桶的上界
+ *
+ * @param buckets 分桶类型
+ * @return const std::vector<double>& 各个桶的上界，升序
+ */
+auto getBucketBounds(Buckets buckets) -> const std::vector<double> & {
+  static const std::vector<double> latency{0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05,
+                                           0.1,    0.25,  0.5,    1,     2.5,  5,     10};
+  static const std::vector<double> size{256, 1024, 4096, 16384, 65536, 262144, 1048576, 4194304};
+  return buckets == Buckets::size ? size : latency;
+}
+
+/**
+ * @brief 转义标签值中的反斜杠、双引号和换行
+ *
+ * @param value 标签值
+ * @return std::string 转义之后的标签值
+ */
+auto escape(std::string_view value) -> std::string {
+  std::string out{};
+  out.reserve(value.size());
+  for (auto chr : value) {
+    if (chr == '\\' || chr == '"') {
+      out += '\\';
+      out += chr;
+    } else if (chr == '\n') {
+      out += "\\n";
+    } else {
+      out += chr;
+    }
+  }
+  return out;
+}
+
+} // namespace
+
+auto Counter::inc(uint64_t value) noexcept -> void {
+  value_.fetch_add(value, std::memory_order_relaxed);
+}
+
+auto Counter::get() const noexcept -> uint64_t { return value_.load(std::memory_order_relaxed); }
+
+auto Gauge::set(int64_t value) noexcept -> void { value_.store(value, std::memory_order_relaxed); }
+
+auto Gauge::add(int64_t value) noexcept -> void {
+  value_.fetch_add(value, std::memory_order_relaxed);
+}
+
+auto Gauge::get() const noexcept -> int64_t { return value_.load(std::memory_order_relaxed); }
+
+Histogram::Histogram(Buckets buckets)
+    : bounds_{getBucketBounds(buckets)},
+      buckets_{std::make_unique<std::atomic<uint64_t>[]>(bounds_.size() + 1)} {
+  for (size_t i = 0; i <= bounds_.size(); ++i) {
+    buckets_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * @brief 记录一个观测值
+ *
+ * @param value 观测值（耗时为秒，大小为字节）
+ */
+auto Histogram::observe(double value) noexcept -> void {
+  auto index = static_cast<size_t>(std::lower_bound(bounds_.begin(), bounds_.end(), value) -
+                                   bounds_.begin());
+  buckets_[index].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+
+  // C++17 的 std::atomic<double> 没有 fetch_add
+  auto sum = sum_.load(std::memory_order_relaxed);
+  while (!sum_.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed)) {
+  }
+}
+
+auto Histogram::getBounds() const noexcept -> const std::vector<double> & { return bounds_; }
+
+/**
+ * @brief 获取某个桶的计数（非累计）
+ *
+ * @param index 桶下标，bounds 的大小表示 +Inf 桶
+ * @return uint64_t 计数
+ */
+auto Histogram::getBucket(size_t index) const noexcept -> uint64_t {
+  return index <= bounds_.size() ? buckets_[index].load(std::memory_order_relaxed) : 0;
+}
+
+auto Histogram::getCount() const noexcept -> uint64_t {
+  return count_.load(std::memory_order_relaxed);
+}
+
+auto Histogram::getSum() const noexcept -> double { return sum_.load(std::memory_order_relaxed); }
+
+ScopedTimer::ScopedTimer(Histogram &histogram) noexcept
+    : histogram_{histogram}, start_{std::chrono::steady_clock::now()} {}
+
+ScopedTimer::~ScopedTimer() {
+  histogram_.observe(
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count());
+}
+
+/**
+ * @brief 获取进程唯一的注册表
+ *
+ * @return Registry& 注册表
+ */
+auto Registry::instance() -> Registry & {
+  static Registry registry{};
+  return registry;
+}
+
+/**
+ * @brief 获取（不存在时注册）一个计数器
+ *
+ * @param name 指标名称
+ * @param help 指标说明
+ * @param labels 标签
+ * @return Counter& 计数器
+ */
+auto Registry::counter(std::string_view name, std::string_view help, const Labels &labels)
+    -> Counter & {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto &metric = getFamily(name, help, Type::counter).counters_[formatLabels(labels)];
+  if (metric == nullptr) {
+    metric = std::make_unique<Counter>();
+  }
+  return *metric;
+}
+
+/**
+ * @brief 获取（不存在时注册）一个仪表
+ *
+ * @param name 指标名称
+ * @param help 指标说明
+ * @param labels 标签
+ * @return Gauge& 仪表
+ */
+auto Registry::gauge(std::string_view name, std::string_view help, const Labels &labels)
+    -> Gauge & {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto &metric = getFamily(name, help, Type::gauge).gauges_[formatLabels(labels)];
+  if (metric == nullptr) {
+    metric = std::make_unique<Gauge>();
+  }
+  return *metric;
+}
+
+/**
+ * @brief 获取（不存在时注册）一个直方图
+ *
+ * @param name 指标名称
+ * @param help 指标说明
+ * @param buckets 分桶类型（同一个名称应该使用相同的分桶）
+ * @param labels 标签
+ * @return Histogram& 直方图
+ */
+auto Registry::histogram(std::string_view name, std::string_view help, Buckets buckets,
+                         const Labels &labels) -> Histogram & {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto &metric = getFamily(name, help, Type::histogram).histograms_[formatLabels(labels)];
+  if (metric == nullptr) {
+    metric = std::make_unique<Histogram>(buckets);
+  }
+  return *metric;
+}
+
+/**
+ * @brief 以 Prometheus 文本格式输出全部指标
+ *
+ * @return std::string 指标文本
+ */
+auto Registry::render() const -> std::string {
+  std::lock_guard<std::mutex> lock{mutex_};
+  std::string out{};
+  for (const auto &[name, family] : families_) {
+    static constexpr std::string_view TYPES[]{"counter", "gauge", "histogram"};
+    out += fmt::format("# HELP {} {}\n# TYPE {} {}\n", name, family.help_, name,
+                       TYPES[static_cast<size_t>(family.type_)]);
+
+    auto series = [&name](std::string_view suffix, std::string_view labels) {
+      return labels.empty() ? fmt::format("{}{}", name, suffix)
+                            : fmt::format("{}{}{{{}}}", name, suffix, labels);
+    };
+    for (const auto &[labels, metric] : family.counters_) {
+      out += fmt::format("{} {}\n", series("", labels), metric->get());
+    }
+    for (const auto &[labels, metric] : family.gauges_) {
+      out += fmt::format("{} {}\n", series("", labels), metric->get());
+    }
+    for (const auto &[labels, metric] : family.histograms_) {
+      const auto &bounds = metric->getBounds();
+      uint64_t cumulative = 0;
+      for (size_t i = 0; i < bounds.size(); ++i) {
+        cumulative += metric->getBucket(i);
+        auto bucket_labels = joinLabels(labels, fmt::format("le=\"{}\"", bounds[i]));
+        out += fmt::format("{} {}\n", series("_bucket", bucket_labels), cumulative);
+      }
+      cumulative += metric->getBucket(bounds.size());
+      out += fmt::format("{} {}\n", series("_bucket", joinLabels(labels, "le=\"+Inf\"")),
+                         cumulative);
+      out += fmt::format("{} {}\n", series("_sum", labels), metric->getSum());
+      out += fmt::format("{} {}\n", series("_count", labels), metric->getCount());
+    }
+  }
+  return out;
+}
+
+/**
+ * @brief 获取（不存在时创建）指标族，同一个名称不能注册成不同类型
+ *
+ * @param name 指标名称
+ * @param help 指标说明
+ * @param type 指标类型
+ * @return Family& 指标族
+ */
+auto Registry::getFamily(std::string_view name, std::string_view help, Type type) -> Family & {
+  auto iter = families_.find(name);
+  if (iter == families_.end()) {
+    iter = families_.emplace(std::string{name}, Family{type, std::string{help}, {}, {}, {}}).first;
+  }
+  if (iter->second.type_ != type) {
+    throw OHNO_EXCEPT(fmt::format("Metric {} is registered with another type", name), false);
+  }
+  return iter->second;
+}
+
+/**
+ * @brief 把标签序列化成 Prometheus 格式（不含花括号），同时作为指标的 key
+ *
+ * @param labels 标签
+ * @return std::string 形如 op="get",code="200"
+ */
+auto Registry::formatLabels(const Labels &labels) -> std::string {
+  std::string out{};
+  for (const auto &[key, value] : labels) {
+    out += fmt::format("{}{}=\"{}\"", out.empty() ? "" : ",", key, escape(value));
+  }
+  return out;
+}
+
+auto Registry::joinLabels(std::string_view labels, std::string_view extra) -> std::string {
+  return labels.empty() ? std::string{extra} : fmt::format("{},{}", labels, extra);
+}
+
+} // namespace metrics
+} // namespace ohno
@@ -0,0 +1,123 @@
+#pragma once
+
+// clang-format off
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+// clang-format on
+
+namespace ohno {
+namespace metrics {
+
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * @brief 直方图的固定分桶
+ *
+ */
+enum class Buckets : uint8_t {
+  latency, // 耗时（秒），0.5ms ~ 10s
+  size     // 大小（字节），256B ~ 4MiB
+};
+
+class Counter final {
+public:
+  auto inc(uint64_t value = 1) noexcept -> void;
+  auto get() const noexcept -> uint64_t;
+
+private:
+  std::atomic<uint64_t> value_{0};
+};
+
+class Gauge final {
+public:
+  auto set(int64_t value) noexcept -> void;
+  auto add(int64_t value) noexcept -> void;
+  auto get() const noexcept -> int64_t;
+
+private:
+  std::atomic<int64_t> value_{0};
+};
+
+/**
+ * @brief 固定分桶的直方图，记录时只做原子操作，不加锁
+ *
+ */
+class Histogram final {
+public:
+  explicit Histogram(Buckets buckets);
+
+  auto observe(double value) noexcept -> void;
+  auto getBounds() const noexcept -> const std::vector<double> &;
+  auto getBucket(size_t index) const noexcept -> uint64_t;
+  auto getCount() const noexcept -> uint64_t;
+  auto getSum() const noexcept -> double;
+
+private:
+  const std::vector<double> &bounds_;                // 各个桶的上界（不含 +Inf）
+  std::unique_ptr<std::atomic<uint64_t>[]> buckets_; // 非累计计数，最后一个是 +Inf
+  std::atomic<uint64_t> count_{0};
+  std::atomic<double> sum_{0};
+};
+
+/**
+ * @brief 耗时计时器，析构时把经过的秒数记录到直方图
+ *
+ */
+class ScopedTimer final {
+public:
+  explicit ScopedTimer(Histogram &histogram) noexcept;
+  ~ScopedTimer();
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer(ScopedTimer &&) = delete;
+  auto operator=(const ScopedTimer &) -> ScopedTimer & = delete;
+  auto operator=(ScopedTimer &&) -> ScopedTimer & = delete;
+
+private:
+  Histogram &histogram_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief 进程内的指标注册表
+ *
+ * 注册（第一次获取某个名称与标签的指标）加锁，返回的引用在进程生命周期内有效，
+ * 调用者可以缓存下来，之后的更新都是无锁的原子操作
+ */
+class Registry final {
+public:
+  static auto instance() -> Registry &;
+
+  auto counter(std::string_view name, std::string_view help, const Labels &labels = {})
+      -> Counter &;
+  auto gauge(std::string_view name, std::string_view help, const Labels &labels = {}) -> Gauge &;
+  auto histogram(std::string_view name, std::string_view help, Buckets buckets,
+                 const Labels &labels = {}) -> Histogram &;
+  auto render() const -> std::string;
+
+private:
+  enum class Type : uint8_t { counter, gauge, histogram };
+  struct Family {
+    Type type_;
+    std::string help_;
+    std::map<std::string, std::unique_ptr<Counter>> counters_; // key 为序列化之后的标签
+    std::map<std::string, std::unique_ptr<Gauge>> gauges_;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms_;
+  };
+
+  auto getFamily(std::string_view name, std::string_view help, Type type) -> Family &;
+  static auto formatLabels(const Labels &labels) -> std::string;
+  static auto joinLabels(std::string_view labels, std::string_view extra) -> std::string;
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Family, std::less<>> families_;
+};
+
+} // namespace metrics
+} // namespace ohno
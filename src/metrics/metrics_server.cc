@@ -0,0 +1,170 @@
+// clang-format off
+#include "metrics_server.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <iostream>
+#include "spdlog/fmt/fmt.h"
+#include "metrics.h"
+#include "src/common/except.h"
+// clang-format on
+
+namespace ohno {
+namespace metrics {
+
+/**
+ * @brief 构造指标端点
+ *
+ * @param addr 监听地址，形如 "127.0.0.1:9961"，端口为 0 时由内核分配
+ */
+MetricsServer::MetricsServer(std::string_view addr) : addr_{addr} {}
+
+MetricsServer::~MetricsServer() { stop(); }
+
+/**
+ * @brief 监听端口并启动服务线程
+ *
+ * @return true 启动成功
+ * @return false 地址非法或者监听失败
+ */
+auto MetricsServer::start() -> bool {
+  if (running_) {
+    return true;
+  }
+  if (!listen()) {
+    return false;
+  }
+  running_ = true;
+
+  server_ = std::thread{[this]() {
+    try {
+      pthread_setname_np(pthread_self(), "metrics");
+      while (running_) {
+        pollfd pfd{listen_fd_, POLLIN, 0};
+        if (::poll(&pfd, 1, static_cast<int>(METRICS_POLL_INTERVAL.count())) <= 0) {
+          continue;
+        }
+        auto conn = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (conn < 0) {
+          continue;
+        }
+        serve(conn);
+        ::close(conn);
+      }
+    } catch (const ohno::except::Exception &exc) {
+      std::cerr << "[error] Ohnod metrics thread terminated!" << exc.getMsg() << "\n";
+    } catch (const std::exception &exc) {
+      std::cerr << "[error] Ohnod metrics thread terminated!" << exc.what() << "\n";
+    }
+  }};
+  OHNO_LOG(info, "Metrics endpoint listening on {}", addr_);
+  return true;
+}
+
+/**
+ * @brief 停止服务线程并关闭监听端口
+ *
+ */
+auto MetricsServer::stop() -> void {
+  running_ = false;
+  if (server_.joinable()) {
+    server_.join();
+  }
+  if (listen_fd_ >= 0) {
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+  }
+}
+
+/**
+ * @brief 获取实际监听的端口
+ *
+ * @return uint16_t 端口，未监听时为 0
+ */
+auto MetricsServer::getPort() const noexcept -> uint16_t { return port_; }
+
+/**
+ * @brief 解析监听地址并监听
+ *
+ * @return true 监听成功
+ * @return false 失败
+ */
+auto MetricsServer::listen() -> bool {
+  auto colon = addr_.rfind(':');
+  sockaddr_in sin{};
+  sin.sin_family = AF_INET;
+  try {
+    if (colon == std::string::npos ||
+        ::inet_pton(AF_INET, addr_.substr(0, colon).c_str(), &sin.sin_addr) != 1) {
+      throw std::invalid_argument{"invalid host"};
+    }
+    sin.sin_port = htons(static_cast<uint16_t>(std::stoi(addr_.substr(colon + 1))));
+  } catch (const std::exception &exc) {
+    OHNO_LOG(error, "Invalid metrics address {}: {}", addr_, exc.what());
+    return false;
+  }
+
+  listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) {
+    OHNO_LOG(error, "Failed to create metrics socket");
+    return false;
+  }
+  int reuse = 1;
+  ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  socklen_t len = sizeof(sin);
+  if (::bind(listen_fd_, reinterpret_cast<sockaddr *>(&sin), sizeof(sin)) != 0 ||
+      ::listen(listen_fd_, SOMAXCONN) != 0 ||
+      ::getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&sin), &len) != 0) {
+    OHNO_LOG(error, "Failed to listen on metrics address {}", addr_);
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+  port_ = ntohs(sin.sin_port);
+  return true;
+}
+
+/**
+ * @brief 处理一个连接：读取请求头，GET /metrics 返回指标，其他请求返回 404
+ *
+ * @param conn 连接
+ */
+auto MetricsServer::serve(int conn) const -> void {
+  std::string request{};
+  char buf[512];
+  while (request.find("\r\n\r\n") == std::string::npos && request.size() < METRICS_REQUEST_MAX) {
+    pollfd pfd{conn, POLLIN, 0};
+    if (::poll(&pfd, 1, static_cast<int>(METRICS_POLL_INTERVAL.count())) <= 0) {
+      return; // 客户端迟迟不发请求，不能阻塞其他抓取
+    }
+    auto size = ::read(conn, buf, sizeof(buf));
+    if (size <= 0) {
+      return;
+    }
+    request.append(buf, static_cast<size_t>(size));
+  }
+
+  std::string response{};
+  if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 6, "GET / ") == 0) {
+    auto body = Registry::instance().render();
+    response = fmt::format("HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                           "Content-Length: {}\r\nConnection: close\r\n\r\n{}",
+                           body.size(), body);
+  } else {
+    response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+  }
+
+  size_t sent = 0;
+  while (sent < response.size()) {
+    auto size = ::send(conn, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+    if (size <= 0) {
+      return;
+    }
+    sent += static_cast<size_t>(size);
+  }
+}
+
+} // namespace metrics
+} // namespace ohno
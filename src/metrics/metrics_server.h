@@ -0,0 +1,49 @@
+#pragma once
+
+// clang-format off
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "src/log/logger.h"
+// clang-format on
+
+namespace ohno {
+namespace metrics {
+
+constexpr std::string_view METRICS_ADDR_DEFAULT{"127.0.0.1:9961"};
+constexpr std::chrono::milliseconds METRICS_POLL_INTERVAL{200}; // 检查退出标志的间隔
+constexpr size_t METRICS_REQUEST_MAX{4096};
+
+/**
+ * @brief 指标 HTTP 端点（ohnod）：GET /metrics 返回 Prometheus 文本格式的全部指标
+ *
+ * 只实现抓取所需的最小 HTTP/1.0 子集，每个连接处理一个请求之后关闭
+ */
+class MetricsServer final : public log::Loggable<log::Id::metrics> {
+public:
+  explicit MetricsServer(std::string_view addr = METRICS_ADDR_DEFAULT);
+  ~MetricsServer() override;
+  MetricsServer(const MetricsServer &) = delete;
+  MetricsServer(MetricsServer &&) = delete;
+  auto operator=(const MetricsServer &) -> MetricsServer & = delete;
+  auto operator=(MetricsServer &&) -> MetricsServer & = delete;
+
+  auto start() -> bool;
+  auto stop() -> void;
+  auto getPort() const noexcept -> uint16_t;
+
+private:
+  auto listen() -> bool;
+  auto serve(int conn) const -> void;
+
+  std::string addr_;
+  int listen_fd_{-1};
+  uint16_t port_{0};
+  std::atomic<bool> running_{false};
+  std::thread server_;
+};
+
+} // namespace metrics
+} // namespace ohno
@@ -1,52 +1,38 @@
 // clang-format off
 #include "addr.h"
-#include <regex>
-#include "spdlog/fmt/fmt.h"
-#include "src/common/except.h"
+#include "src/common/enum_name.hpp"
 // clang-format on
 
 namespace ohno {
 namespace net {
 
 Addr::Addr(std::string_view cidr) {
-  // TODO: 将 Boost 方法调用过程从构造函数中移除出去
-
-  try {
-    if (cidr.empty()) {
-      throw std::invalid_argument("Missing CIDR");
-    }
-
-    std::string cidr_str{cidr};
-    std::string addr_str{};
+  if (cidr.empty()) {
+    OHNO_LOG(warn, "Missing CIDR");
+    return;
+  }
 
-    size_t pos = cidr_str.find('/');
-    if (pos == std::string::npos) {
-      addr_str = cidr_str;
-      cidr_str += fmt::format("/{}", MAX_PREFIX_IPV4);
-      prefix_ = MAX_PREFIX_IPV4;
-    } else {
-      addr_str = cidr_str.substr(0, pos);
-      prefix_ = static_cast<Prefix>(std::stoi(cidr_str.substr(pos + 1)));
+  // 不带前缀时视为主机地址
+  std::optional<IpPrefix> prefix{};
+  if (cidr.find('/') == std::string_view::npos) {
+    auto addr = IpAddr::parse(cidr);
+    if (addr.has_value()) {
+      prefix = IpPrefix{addr.value(), addr->maxPrefix()};
     }
+  } else {
+    prefix = IpPrefix::parse(cidr);
+  }
 
-    const std::regex IPv4_RE(IPv4_REGEX.data());
-    if (std::regex_match(cidr_str, IPv4_RE)) {
-      // IPv4 解析
-      ipversion_ = IpVersion::IPv4;
-      address_v4_ = boost::asio::ip::make_address_v4(addr_str);
-      OHNO_LOG(trace, "Addr ctor cidr {} belongs to IPv4, with IP {}", cidr_str,
-               address_v4_.to_string());
-    } else {
-      // IPv6 解析
-      ipversion_ = IpVersion::IPv6;
-      address_v6_ = boost::asio::ip::make_address_v6(addr_str);
-      OHNO_LOG(trace, "Addr ctor cidr {} belongs to IPv6, with IP {}", cidr_str,
-               address_v6_.to_string());
-    }
-  } catch (const std::exception &err) {
-    OHNO_LOG(warn, "cidr \"{}\" is invalid, {}", cidr, err.what());
-    ipversion_ = IpVersion::RESERVED;
+  if (!prefix.has_value()) {
+    OHNO_LOG(warn, "cidr \"{}\" is invalid", cidr);
+    return;
   }
+
+  address_ = prefix->addr();
+  prefix_ = prefix->length();
+  ipversion_ = address_.version();
+  OHNO_LOG(trace, "Addr ctor cidr {} belongs to {}, with IP {}", cidr, enumName(ipversion_),
+           address_.toString());
 }
 
 /**
@@ -54,19 +40,14 @@ Addr::Addr(std::string_view cidr) {
  *
  * @return std::string 字符串
  */
-auto Addr::getAddr() const -> std::string {
-  checkIpv6();
-  return address_v4_.to_string();
-}
+auto Addr::getAddr() const -> std::string { return address_.toString(); }
 
 /**
  * @brief 获取 IP 地址 CIDR 格式
  *
  * @return std::string 字符串
  */
-auto Addr::getAddrCidr() const -> std::string {
-  return fmt::format("{}/{}", getAddr(), getPrefix());
-}
+auto Addr::getAddrCidr() const -> std::string { return IpPrefix{address_, prefix_}.toString(); }
 
 /**
  * @brief 获取 IP 地址子网掩码
@@ -80,17 +61,14 @@ auto Addr::getPrefix() const noexcept -> Prefix { return prefix_; }
  *
  * @return IpVersion 版本
  */
-auto Addr::ipVersion() -> IpVersion { return ipversion_; }
+auto Addr::ipVersion() const noexcept -> IpVersion { return ipversion_; }
 
 /**
- * @brief 暂时不支持 IPv6，所以对于 IPv6 地址抛出 ohno::except::Exception
+ * @brief 获取整数形式的 IP 地址
  *
+ * @return IpAddr 地址
  */
-auto Addr::checkIpv6() const -> void {
-  if (ipversion_ == IpVersion::IPv6) {
-    throw OHNO_EXCEPT("IPv6 not supported yet", false);
-  }
-}
+auto Addr::getIp() const noexcept -> IpAddr { return address_; }
 
 } // namespace net
 } // namespace ohno
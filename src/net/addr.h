@@ -4,9 +4,8 @@
 #include <memory>
 #include <string>
 #include <string_view>
-#include <boost/asio/ip/address_v4.hpp>
-#include <boost/asio/ip/address_v6.hpp>
 #include "addr_if.h"
+#include "ip.h"
 #include "src/log/logger.h"
 // clang-format on
 
@@ -20,17 +19,14 @@ public:
   auto getAddr() const -> std::string override;
   auto getAddrCidr() const -> std::string override;
   auto getPrefix() const noexcept -> Prefix override;
-  auto ipVersion() -> IpVersion override;
+  auto ipVersion() const noexcept -> IpVersion override;
 
-private:
-  // TODO: IPv6 支持
-
-  auto checkIpv6() const -> void;
+  auto getIp() const noexcept -> IpAddr;
 
-  boost::asio::ip::address_v4 address_v4_;
-  boost::asio::ip::address_v6 address_v6_;
-  IpVersion ipversion_;
-  Prefix prefix_;
+private:
+  IpAddr address_;
+  IpVersion ipversion_{IpVersion::RESERVED};
+  Prefix prefix_{0};
 };
 
 } // namespace net
@@ -14,7 +14,7 @@ public:
   virtual auto getAddr() const -> std::string = 0;
   virtual auto getAddrCidr() const -> std::string = 0;
   virtual auto getPrefix() const noexcept -> Prefix = 0;
-  virtual auto ipVersion() -> IpVersion = 0;
+  virtual auto ipVersion() const noexcept -> IpVersion = 0;
 };
 
 } // namespace net
@@ -1,5 +1,6 @@
 // clang-format off
 #include "http_client.h"
+#include <chrono>
 #include <list>
 #include <sstream>
 #include "curlpp/cURLpp.hpp"
@@ -9,6 +10,7 @@
 #include "src/common/assert.h"
 #include "src/common/enum_name.hpp"
 #include "src/common/except.h"
+#include "src/metrics/metrics.h"
 // clang-format on
 
 namespace ohno {
@@ -30,6 +32,7 @@ auto HttpClient::httpRequest(HttpMethod method, std::string_view uri, std::strin
                              std::string_view ca_path) const -> HttpCode {
   OHNO_ASSERT(!uri.empty());
   HttpCode code = HttpCode::Bad_Request;
+  auto start = std::chrono::steady_clock::now();
 
   try {
     curlpp::Easy request{};
@@ -92,6 +95,19 @@ auto HttpClient::httpRequest(HttpMethod method, std::string_view uri, std::strin
     OHNO_LOG(warn, "HTTP req failed: {}", e.what());
   }
 
+  // 异常时 code 保持为 400，响应体是错误信息
+  auto &registry = metrics::Registry::instance();
+  metrics::Labels labels{{"method", std::string{enumName(method)}}};
+  registry
+      .histogram("ohno_apiserver_request_duration_seconds", "Kubernetes api server request latency",
+                 metrics::Buckets::latency, labels)
+      .observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  registry
+      .histogram("ohno_apiserver_response_size_bytes", "Kubernetes api server response size",
+                 metrics::Buckets::size, labels)
+      .observe(static_cast<double>(resp_body.size()));
+  labels.emplace_back("code", std::to_string(static_cast<int>(code)));
+  registry.counter("ohno_apiserver_requests_total", "Kubernetes api server requests", labels).inc();
   return code;
 }
 
@@ -0,0 +1,451 @@
+// clang-format off
+#include "ip.h"
+#include <array>
+#include <charconv>
+// clang-format on
+
+namespace ohno {
+namespace net {
+
+namespace {
+
+constexpr std::string_view HEX_DIGITS{"0123456789abcdef"};
+constexpr size_t IPV6_GROUPS{8};
+constexpr size_t IPV6_GROUP_BITS{16};
+constexpr uint32_t IPV4_MASK{0xffffffff};
+
+/**
+ * @brief 解析十进制无符号整数，要求整个字符串都是数字
+ *
+ * @param str 字符串
+ * @param max 允许的最大值
+ * @return std::optional<uint32_t> 解析结果，失败为空
+ */
+auto parseDecimal(std::string_view str, uint32_t max) -> std::optional<uint32_t> {
+  if (str.empty() || str.size() > 3) {
+    return std::nullopt;
+  }
+  uint32_t value{0};
+  auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+  if (ec != std::errc{} || ptr != str.data() + str.size() || value > max) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+} // namespace
+
+IpAddr::IpAddr(Uint128 value, IpVersion version) noexcept : value_{value}, version_{version} {}
+
+/**
+ * @brief 从 32 位整数构造 IPv4 地址
+ *
+ * @param value 主机字节序的地址
+ * @return IpAddr 地址
+ */
+auto IpAddr::fromV4(uint32_t value) noexcept -> IpAddr { return IpAddr{value, IpVersion::IPv4}; }
+
+/**
+ * @brief 从 128 位整数构造 IPv6 地址
+ *
+ * @param value 主机字节序的地址
+ * @return IpAddr 地址
+ */
+auto IpAddr::fromV6(Uint128 value) noexcept -> IpAddr { return IpAddr{value, IpVersion::IPv6}; }
+
+/**
+ * @brief 解析不带前缀的 IP 地址字符串
+ *
+ * @param str 地址字符串，比如 "10.244.0.1" 或 "fd00::1"
+ * @return std::optional<IpAddr> 解析结果，格式错误为空
+ */
+auto IpAddr::parse(std::string_view str) -> std::optional<IpAddr> {
+  if (str.find(':') != std::string_view::npos) {
+    auto value = parseV6(str);
+    return value.has_value() ? std::optional<IpAddr>{fromV6(value.value())} : std::nullopt;
+  }
+  auto value = parseV4(str);
+  return value.has_value() ? std::optional<IpAddr>{fromV4(value.value())} : std::nullopt;
+}
+
+/**
+ * @brief 转换为地址字符串，只应该在与 ETCD/netlink 交互时调用
+ *
+ * @return std::string 地址字符串，无效地址为空
+ */
+auto IpAddr::toString() const -> std::string {
+  if (version_ == IpVersion::IPv4) {
+    std::array<char, SZ_IPV4_STRING> buf{};
+    return std::string(buf.data(), formatV4(buf.data()));
+  }
+  if (version_ == IpVersion::IPv6) {
+    std::array<char, SZ_IPV6_STRING> buf{};
+    return std::string(buf.data(), formatV6(buf.data()));
+  }
+  return {};
+}
+
+/**
+ * @brief 获取 IP 版本
+ *
+ * @return IpVersion 版本
+ */
+auto IpAddr::version() const noexcept -> IpVersion { return version_; }
+
+/**
+ * @brief 获取当前 IP 版本的最大前缀长度
+ *
+ * @return Prefix 前缀长度
+ */
+auto IpAddr::maxPrefix() const noexcept -> Prefix {
+  return version_ == IpVersion::IPv6 ? MAX_PREFIX_IPV6 : MAX_PREFIX_IPV4;
+}
+
+/**
+ * @brief 获取整数形式的地址
+ *
+ * @return Uint128 地址
+ */
+auto IpAddr::toUint() const noexcept -> Uint128 { return value_; }
+
+/**
+ * @brief 获取 32 位整数形式的 IPv4 地址
+ *
+ * @return uint32_t 地址
+ */
+auto IpAddr::toV4() const noexcept -> uint32_t { return static_cast<uint32_t>(value_); }
+
+/**
+ * @brief 计算偏移之后的地址，IPv4 地址在 32 位内回绕
+ *
+ * @param delta 偏移量
+ * @return IpAddr 新地址
+ */
+auto IpAddr::advance(Uint128 delta) const noexcept -> IpAddr {
+  Uint128 value = value_ + delta;
+  if (version_ != IpVersion::IPv6) {
+    value &= IPV4_MASK;
+  }
+  return IpAddr{value, version_};
+}
+
+/**
+ * @brief 解析点分十进制 IPv4 地址
+ *
+ * @param str 地址字符串
+ * @return std::optional<uint32_t> 解析结果，格式错误为空
+ */
+auto IpAddr::parseV4(std::string_view str) -> std::optional<uint32_t> {
+  uint32_t value{0};
+  for (int i = 0; i < 4; ++i) {
+    auto dot = str.find('.');
+    if ((i < 3) == (dot == std::string_view::npos)) {
+      return std::nullopt;
+    }
+    auto octet = parseDecimal(str.substr(0, dot), UINT8_MAX);
+    if (!octet.has_value()) {
+      return std::nullopt;
+    }
+    value = (value << 8) | octet.value();
+    str = dot == std::string_view::npos ? std::string_view{} : str.substr(dot + 1);
+  }
+  return value;
+}
+
+/**
+ * @brief 解析 IPv6 地址，支持 "::" 缩写以及结尾内嵌 IPv4 地址
+ *
+ * @param str 地址字符串
+ * @return std::optional<Uint128> 解析结果，格式错误为空
+ */
+auto IpAddr::parseV6(std::string_view str) -> std::optional<Uint128> {
+  std::array<uint16_t, IPV6_GROUPS> groups{};
+  size_t count{0};
+  size_t gap{IPV6_GROUPS + 1}; // "::" 出现的位置，不存在则越界
+  size_t pos{0};
+
+  if (str.substr(0, 2) == "::") {
+    gap = 0;
+    pos = 2;
+  } else if (str.empty() || str.front() == ':') {
+    return std::nullopt;
+  }
+
+  while (pos < str.size()) {
+    if (count == IPV6_GROUPS) {
+      return std::nullopt;
+    }
+    auto end = str.find(':', pos);
+    auto token = str.substr(pos, end == std::string_view::npos ? end : end - pos);
+
+    if (token.find('.') != std::string_view::npos) {
+      // 内嵌 IPv4 地址只能出现在结尾，占两组
+      auto v4 = parseV4(token);
+      if (end != std::string_view::npos || count > IPV6_GROUPS - 2 || !v4.has_value()) {
+        return std::nullopt;
+      }
+      groups[count++] = static_cast<uint16_t>(v4.value() >> IPV6_GROUP_BITS);
+      groups[count++] = static_cast<uint16_t>(v4.value());
+      break;
+    }
+
+    uint16_t group{0};
+    auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), group, 16);
+    if (token.empty() || token.size() > 4 || ec != std::errc{} ||
+        ptr != token.data() + token.size()) {
+      return std::nullopt;
+    }
+    groups[count++] = group;
+
+    if (end == std::string_view::npos) {
+      break;
+    }
+    pos = end + 1;
+    if (pos < str.size() && str[pos] == ':') {
+      if (gap <= IPV6_GROUPS) {
+        return std::nullopt; // "::" 只能出现一次
+      }
+      gap = count;
+      ++pos;
+    } else if (pos == str.size()) {
+      return std::nullopt; // 结尾单个 ':'
+    }
+  }
+
+  bool has_gap = gap <= IPV6_GROUPS;
+  if ((!has_gap && count != IPV6_GROUPS) || (has_gap && count >= IPV6_GROUPS)) {
+    return std::nullopt;
+  }
+
+  Uint128 value{0};
+  for (size_t i = 0; i <= count; ++i) {
+    if (i == gap) {
+      for (size_t zero = 0; zero < IPV6_GROUPS - count; ++zero) {
+        value <<= IPV6_GROUP_BITS;
+      }
+    }
+    if (i < count) {
+      value = (value << IPV6_GROUP_BITS) | groups[i];
+    }
+  }
+  return value;
+}
+
+/**
+ * @brief 将 IPv4 地址格式化到缓冲区
+ *
+ * @param buf 缓冲区，至少 SZ_IPV4_STRING 字节
+ * @return size_t 写入的字符数
+ */
+auto IpAddr::formatV4(char *buf) const noexcept -> size_t {
+  auto value = toV4();
+  char *cur = buf;
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    auto octet = static_cast<uint8_t>(value >> shift);
+    if (octet >= 100) {
+      *cur++ = static_cast<char>('0' + octet / 100);
+    }
+    if (octet >= 10) {
+      *cur++ = static_cast<char>('0' + octet / 10 % 10);
+    }
+    *cur++ = static_cast<char>('0' + octet % 10);
+    if (shift > 0) {
+      *cur++ = '.';
+    }
+  }
+  return static_cast<size_t>(cur - buf);
+}
+
+/**
+ * @brief 将 IPv6 地址按 RFC 5952 格式化到缓冲区（小写、最长连续零组压缩为 "::"）
+ *
+ * @param buf 缓冲区，至少 SZ_IPV6_STRING 字节
+ * @return size_t 写入的字符数
+ */
+auto IpAddr::formatV6(char *buf) const noexcept -> size_t {
+  std::array<uint16_t, IPV6_GROUPS> groups{};
+  for (size_t i = 0; i < IPV6_GROUPS; ++i) {
+    groups[i] = static_cast<uint16_t>(value_ >> ((IPV6_GROUPS - 1 - i) * IPV6_GROUP_BITS));
+  }
+
+  // 查找最长的连续零组，长度至少为 2 才压缩
+  size_t best_start{IPV6_GROUPS};
+  size_t best_len{1};
+  for (size_t i = 0; i < IPV6_GROUPS;) {
+    if (groups[i] != 0) {
+      ++i;
+      continue;
+    }
+    size_t j = i;
+    while (j < IPV6_GROUPS && groups[j] == 0) {
+      ++j;
+    }
+    if (j - i > best_len) {
+      best_start = i;
+      best_len = j - i;
+    }
+    i = j;
+  }
+
+  char *cur = buf;
+  for (size_t i = 0; i < IPV6_GROUPS; ++i) {
+    if (i == best_start) {
+      *cur++ = ':';
+      if (i == 0) {
+        *cur++ = ':';
+      }
+      i += best_len - 1;
+      continue;
+    }
+    bool leading = true;
+    for (int shift = 12; shift >= 0; shift -= 4) {
+      auto nibble = (groups[i] >> shift) & 0xf;
+      if (nibble == 0 && leading && shift > 0) {
+        continue;
+      }
+      leading = false;
+      *cur++ = HEX_DIGITS[nibble];
+    }
+    if (i + 1 < IPV6_GROUPS) {
+      *cur++ = ':';
+    }
+  }
+  return static_cast<size_t>(cur - buf);
+}
+
+IpPrefix::IpPrefix(IpAddr addr, Prefix length) noexcept : addr_{addr}, length_{length} {}
+
+/**
+ * @brief 解析 CIDR 字符串，必须带前缀长度
+ *
+ * @param cidr CIDR 字符串，比如 "10.244.0.0/16"
+ * @return std::optional<IpPrefix> 解析结果，格式错误为空
+ */
+auto IpPrefix::parse(std::string_view cidr) -> std::optional<IpPrefix> {
+  auto slash = cidr.find('/');
+  if (slash == std::string_view::npos) {
+    return std::nullopt;
+  }
+  auto addr = IpAddr::parse(cidr.substr(0, slash));
+  if (!addr.has_value()) {
+    return std::nullopt;
+  }
+  auto length = parseDecimal(cidr.substr(slash + 1), addr->maxPrefix());
+  if (!length.has_value()) {
+    return std::nullopt;
+  }
+  return IpPrefix{addr.value(), length.value()};
+}
+
+/**
+ * @brief 转换为 CIDR 字符串，只应该在与 ETCD/netlink 交互时调用
+ *
+ * @return std::string CIDR 字符串
+ */
+auto IpPrefix::toString() const -> std::string {
+  auto str = addr_.toString();
+  if (str.empty()) {
+    return str;
+  }
+  std::array<char, 4> buf{};
+  auto [ptr, ec] = std::to_chars(buf.data(), buf.data() + buf.size(), length_);
+  str.push_back('/');
+  str.append(buf.data(), ptr);
+  return str;
+}
+
+/**
+ * @brief 获取地址部分（不做掩码运算）
+ *
+ * @return IpAddr 地址
+ */
+auto IpPrefix::addr() const noexcept -> IpAddr { return addr_; }
+
+/**
+ * @brief 获取前缀长度
+ *
+ * @return Prefix 前缀长度
+ */
+auto IpPrefix::length() const noexcept -> Prefix { return length_; }
+
+/**
+ * @brief 获取 IP 版本
+ *
+ * @return IpVersion 版本
+ */
+auto IpPrefix::version() const noexcept -> IpVersion { return addr_.version(); }
+
+/**
+ * @brief 获取主机位数
+ *
+ * @return Prefix 主机位数
+ */
+auto IpPrefix::hostBits() const noexcept -> Prefix { return addr_.maxPrefix() - length_; }
+
+/**
+ * @brief 获取网络地址（主机位清零）
+ *
+ * @return IpPrefix 网络前缀
+ */
+auto IpPrefix::network() const noexcept -> IpPrefix {
+  return IpPrefix{IpAddr{addr_.value_ & mask(), addr_.version_}, length_};
+}
+
+/**
+ * @brief 获取网段内第 index 个地址
+ *
+ * @param index 相对网络地址的偏移
+ * @return IpAddr 地址
+ */
+auto IpPrefix::hostAt(Uint128 index) const noexcept -> IpAddr {
+  return network().addr_.advance(index);
+}
+
+/**
+ * @brief 获取地址相对网络地址的偏移，调用方需要保证地址属于当前网段
+ *
+ * @param addr 地址
+ * @return Uint128 偏移
+ */
+auto IpPrefix::offsetOf(IpAddr addr) const noexcept -> Uint128 {
+  return addr.value_ - (addr_.value_ & mask());
+}
+
+/**
+ * @brief 判断地址是否属于当前网段
+ *
+ * @param addr 地址
+ * @return true 属于
+ * @return false 不属于
+ */
+auto IpPrefix::contains(IpAddr addr) const noexcept -> bool {
+  return addr.version_ == addr_.version_ && (addr.value_ & mask()) == (addr_.value_ & mask());
+}
+
+/**
+ * @brief 判断给定网段是否是当前网段的子网（包括相等）
+ *
+ * @param other 网段
+ * @return true 是
+ * @return false 不是
+ */
+auto IpPrefix::contains(const IpPrefix &other) const noexcept -> bool {
+  return other.length_ >= length_ && contains(other.addr_);
+}
+
+/**
+ * @brief 计算网络掩码
+ *
+ * @return Uint128 掩码
+ */
+auto IpPrefix::mask() const noexcept -> Uint128 {
+  auto host_bits = hostBits();
+  if (host_bits >= MAX_PREFIX_IPV6) {
+    return 0;
+  }
+  Uint128 full = addr_.version_ == IpVersion::IPv6 ? ~Uint128{0} : Uint128{IPV4_MASK};
+  return (full << host_bits) & full;
+}
+
+} // namespace net
+} // namespace ohno
@@ -0,0 +1,95 @@
+#pragma once
+
+// clang-format off
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "macro.h"
+// clang-format on
+
+namespace ohno {
+namespace net {
+
+// IPv6 地址需要 128 位整数表示，IPv4 地址只使用低 32 位
+__extension__ using Uint128 = unsigned __int128;
+
+constexpr size_t SZ_IPV4_STRING{16}; // "255.255.255.255" 加上结尾 '\0'
+constexpr size_t SZ_IPV6_STRING{40}; // 8 组 4 位十六进制 + 7 个冒号 + 结尾 '\0'
+
+/**
+ * @brief 紧凑的 IP 地址值类型，内部以整数保存，只在与 ETCD/netlink 交互时才转换为字符串
+ */
+class IpAddr {
+public:
+  IpAddr() = default;
+  static auto fromV4(uint32_t value) noexcept -> IpAddr;
+  static auto fromV6(Uint128 value) noexcept -> IpAddr;
+  static auto parse(std::string_view str) -> std::optional<IpAddr>;
+
+  auto toString() const -> std::string;
+  auto version() const noexcept -> IpVersion;
+  auto maxPrefix() const noexcept -> Prefix;
+  auto toUint() const noexcept -> Uint128;
+  auto toV4() const noexcept -> uint32_t;
+  auto advance(Uint128 delta) const noexcept -> IpAddr;
+
+  friend auto operator==(const IpAddr &lhs, const IpAddr &rhs) noexcept -> bool {
+    return lhs.version_ == rhs.version_ && lhs.value_ == rhs.value_;
+  }
+  friend auto operator!=(const IpAddr &lhs, const IpAddr &rhs) noexcept -> bool {
+    return !(lhs == rhs);
+  }
+  friend auto operator<(const IpAddr &lhs, const IpAddr &rhs) noexcept -> bool {
+    return lhs.version_ != rhs.version_ ? lhs.version_ < rhs.version_ : lhs.value_ < rhs.value_;
+  }
+
+private:
+  friend class IpPrefix;
+  IpAddr(Uint128 value, IpVersion version) noexcept;
+
+  static auto parseV4(std::string_view str) -> std::optional<uint32_t>;
+  static auto parseV6(std::string_view str) -> std::optional<Uint128>;
+  auto formatV4(char *buf) const noexcept -> size_t;
+  auto formatV6(char *buf) const noexcept -> size_t;
+
+  Uint128 value_{0};
+  IpVersion version_{IpVersion::RESERVED};
+};
+
+/**
+ * @brief 紧凑的 CIDR 值类型（地址 + 前缀长度）
+ */
+class IpPrefix {
+public:
+  IpPrefix() = default;
+  IpPrefix(IpAddr addr, Prefix length) noexcept;
+  static auto parse(std::string_view cidr) -> std::optional<IpPrefix>;
+
+  auto toString() const -> std::string;
+  auto addr() const noexcept -> IpAddr;
+  auto length() const noexcept -> Prefix;
+  auto version() const noexcept -> IpVersion;
+  auto hostBits() const noexcept -> Prefix;
+  auto network() const noexcept -> IpPrefix;
+  auto hostAt(Uint128 index) const noexcept -> IpAddr;
+  auto offsetOf(IpAddr addr) const noexcept -> Uint128;
+  auto contains(IpAddr addr) const noexcept -> bool;
+  auto contains(const IpPrefix &other) const noexcept -> bool;
+
+  friend auto operator==(const IpPrefix &lhs, const IpPrefix &rhs) noexcept -> bool {
+    return lhs.addr_ == rhs.addr_ && lhs.length_ == rhs.length_;
+  }
+  friend auto operator!=(const IpPrefix &lhs, const IpPrefix &rhs) noexcept -> bool {
+    return !(lhs == rhs);
+  }
+
+private:
+  auto mask() const noexcept -> Uint128;
+
+  IpAddr addr_{};
+  Prefix length_{0};
+};
+
+} // namespace net
+} // namespace ohno
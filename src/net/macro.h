@@ -1,6 +1,7 @@
 #pragma once
 
 // clang-format off
+#include <cstdint>
 #include <string_view>
 // clang-format on
 
@@ -14,7 +15,8 @@ using Prefix = uint32_t;
 enum class IpVersion : uint8_t { RESERVED, IPv4, IPv6 };
 enum class LinkStatus : uint8_t { RESERVED, UP, DOWN };
 
-constexpr Prefix MAX_PREFIX_IPV4{32}; // IPv4 地址的最大前缀长度
+constexpr Prefix MAX_PREFIX_IPV4{32};  // IPv4 地址的最大前缀长度
+constexpr Prefix MAX_PREFIX_IPV6{128}; // IPv6 地址的最大前缀长度
 constexpr std::string_view IPv4_REGEX{R"(^(\d+)\.(\d+)\.(\d+)\.(\d+)/(\d+)$)"};
 constexpr std::string_view IPv6_REGEX{R"(^([\da-fA-F:]+)/(\d+)$)"};
 
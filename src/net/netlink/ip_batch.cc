@@ -0,0 +1,233 @@
+// clang-format off
+#include "ip_batch.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include "spdlog/fmt/fmt.h"
+#include "src/common/assert.h"
+// clang-format on
+
+extern char **environ; // NOLINT
+
+namespace ohno {
+namespace net {
+
+/**
+ * @brief 构造批处理子进程（第一次执行命令时才真正启动）
+ *
+ * @param program "ip" 或者 "bridge"（也可以是可执行文件路径）
+ */
+IpBatch::IpBatch(std::string_view program) : program_{program} {
+  OHNO_ASSERT(!program_.empty());
+  // 哨兵命令必须不修改任何状态、必定失败、且不会让子进程退出
+  sentinel_ = program_.find("bridge") != std::string::npos
+                  ? fmt::format("fdb show dev {}", BATCH_SENTINEL)
+                  : fmt::format("link show dev {}", BATCH_SENTINEL);
+}
+
+IpBatch::~IpBatch() { stop(); }
+
+/**
+ * @brief 执行一条命令
+ *
+ * @param command 去掉程序名之后的命令（如 "route add 10.0.0.0/24 via 10.0.1.1"）
+ * @return true 执行成功
+ * @return false 执行失败，或者子进程在执行期间退出（不确定是否已经生效）
+ */
+auto IpBatch::execute(std::string_view command) -> bool {
+  OHNO_ASSERT(!command.empty());
+  if (command.find('\n') != std::string_view::npos) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (pid_ < 0 && !start()) {
+    return false;
+  }
+
+  auto command_line = fmt::format("Command failed -:{}", ++line_no_);
+  auto sentinel_line = fmt::format("Command failed -:{}", ++line_no_);
+  if (!writeAll(fmt::format("{}\n{}\n", command, sentinel_))) {
+    OHNO_LOG(warn, "{} -batch is gone, restart it on next command", program_);
+    stop();
+    return false;
+  }
+
+  bool failed = false;
+  std::string error{};
+  auto deadline = std::chrono::steady_clock::now() + BATCH_TIMEOUT;
+  for (;;) {
+    std::string line{};
+    if (!readLine(line, deadline)) {
+      OHNO_LOG(warn, "{} -batch exited or timed out on \"{}\", restart it on next command",
+               program_, command);
+      stop();
+      return false;
+    }
+    if (line == sentinel_line) {
+      break;
+    }
+    if (line == command_line) {
+      failed = true;
+    } else if (line.find(BATCH_SENTINEL) == std::string::npos) {
+      error += error.empty() ? line : fmt::format("; {}", line);
+    }
+  }
+
+  if (failed) {
+    OHNO_LOG(debug, "\"{} {}\" failed: {}", program_, command, error);
+  }
+  return !failed;
+}
+
+/**
+ * @brief 获取子进程启动之后又被重新拉起的次数
+ *
+ * @return size_t 次数
+ */
+auto IpBatch::getRestarts() const noexcept -> size_t { return starts_ > 0 ? starts_ - 1 : 0; }
+
+/**
+ * @brief 启动子进程，stdin 使用 socketpair（写入时可以用 MSG_NOSIGNAL 避免 SIGPIPE）
+ *
+ * @return true 启动成功
+ * @return false 启动失败
+ */
+auto IpBatch::start() -> bool {
+  int in_pair[2] = {-1, -1};
+  int err_pipe[2] = {-1, -1};
+  if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, in_pair) != 0) {
+    OHNO_LOG(warn, "Failed to create stdin of {} -batch", program_);
+    return false;
+  }
+  if (::pipe2(err_pipe, O_CLOEXEC) != 0) {
+    OHNO_LOG(warn, "Failed to create stderr of {} -batch", program_);
+    ::close(in_pair[0]);
+    ::close(in_pair[1]);
+    return false;
+  }
+
+  posix_spawn_file_actions_t actions{};
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, in_pair[1], STDIN_FILENO);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+  posix_spawn_file_actions_adddup2(&actions, err_pipe[1], STDERR_FILENO);
+
+  std::string force{"-force"};
+  std::string batch{"-batch"};
+  std::string from_stdin{"-"};
+  char *argv[] = {program_.data(), force.data(), batch.data(), from_stdin.data(), nullptr};
+  auto ret = ::posix_spawnp(&pid_, program_.c_str(), &actions, nullptr, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  ::close(in_pair[1]);
+  ::close(err_pipe[1]);
+  if (ret != 0) {
+    OHNO_LOG(warn, "Failed to spawn {} -batch: {}", program_, ret);
+    ::close(in_pair[0]);
+    ::close(err_pipe[0]);
+    pid_ = -1;
+    return false;
+  }
+
+  in_fd_ = in_pair[0];
+  err_fd_ = err_pipe[0];
+  buffer_.clear();
+  line_no_ = 0;
+  ++starts_;
+  OHNO_LOG(debug, "{} -batch started, pid:{}", program_, pid_);
+  return true;
+}
+
+/**
+ * @brief 关闭管道，结束并回收子进程
+ *
+ */
+auto IpBatch::stop() -> void {
+  if (in_fd_ >= 0) {
+    ::close(in_fd_);
+    in_fd_ = -1;
+  }
+  if (err_fd_ >= 0) {
+    ::close(err_fd_);
+    err_fd_ = -1;
+  }
+  if (pid_ > 0) {
+    // 子进程可能卡在某条命令上，不能等它读到 EOF 之后自己退出
+    ::kill(pid_, SIGTERM);
+    ::waitpid(pid_, nullptr, 0);
+    pid_ = -1;
+  }
+}
+
+/**
+ * @brief 写入子进程 stdin
+ *
+ * @param data 数据
+ * @return true 写入成功
+ * @return false 子进程已经退出
+ */
+auto IpBatch::writeAll(std::string_view data) const -> bool {
+  while (!data.empty()) {
+    auto written = ::send(in_fd_, data.data(), data.size(), MSG_NOSIGNAL);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data.remove_prefix(static_cast<size_t>(written));
+  }
+  return true;
+}
+
+/**
+ * @brief 从子进程 stderr 读取一行
+ *
+ * @param line 一行内容（返回值，不包含换行符）
+ * @param deadline 截止时间
+ * @return true 读取成功
+ * @return false 子进程已经退出或者超时
+ */
+auto IpBatch::readLine(std::string &line, std::chrono::steady_clock::time_point deadline)
+    -> bool {
+  for (;;) {
+    auto pos = buffer_.find('\n');
+    if (pos != std::string::npos) {
+      line = buffer_.substr(0, pos);
+      buffer_.erase(0, pos + 1);
+      return true;
+    }
+
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    if (remaining.count() <= 0) {
+      return false;
+    }
+    pollfd pfd{err_fd_, POLLIN, 0};
+    auto ret = ::poll(&pfd, 1, static_cast<int>(remaining.count()));
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret <= 0) {
+      return false;
+    }
+
+    char chunk[4096];
+    auto size = ::read(err_fd_, chunk, sizeof(chunk));
+    if (size < 0 && errno == EINTR) {
+      continue;
+    }
+    if (size <= 0) {
+      return false;
+    }
+    buffer_.append(chunk, static_cast<size_t>(size));
+  }
+}
+
+} // namespace net
+} // namespace ohno
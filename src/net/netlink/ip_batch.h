@@ -0,0 +1,57 @@
+#pragma once
+
+// clang-format off
+#include <sys/types.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "src/log/logger.h"
+// clang-format on
+
+namespace ohno {
+namespace net {
+
+constexpr std::string_view BATCH_SENTINEL{"ohno_sentinel"}; // 不存在的网卡名称
+constexpr std::chrono::seconds BATCH_TIMEOUT{5};
+
+/**
+ * @brief 常驻的 "ip -force -batch -" / "bridge -force -batch -" 子进程
+ *
+ * 每条命令之后紧跟一条必定失败的哨兵命令（查询不存在的网卡），-force 模式下每条失败的命令
+ * 都会在 stderr 输出 "Command failed -:<行号>"，读到哨兵的行号说明命令已经执行完，
+ * 期间读到命令自己的行号说明命令失败；子进程退出或超时则下一条命令重新拉起子进程
+ *
+ * @note 子进程的 stdout 被丢弃，所以只适用于只关心成功与否的命令
+ */
+class IpBatch final : public log::Loggable<log::Id::net> {
+public:
+  explicit IpBatch(std::string_view program);
+  ~IpBatch() override;
+  IpBatch(const IpBatch &) = delete;
+  IpBatch(IpBatch &&) = delete;
+  auto operator=(const IpBatch &) -> IpBatch & = delete;
+  auto operator=(IpBatch &&) -> IpBatch & = delete;
+
+  auto execute(std::string_view command) -> bool;
+  auto getRestarts() const noexcept -> size_t;
+
+private:
+  auto start() -> bool;
+  auto stop() -> void;
+  auto writeAll(std::string_view data) const -> bool;
+  auto readLine(std::string &line, std::chrono::steady_clock::time_point deadline) -> bool;
+
+  std::string program_;
+  std::string sentinel_;
+  pid_t pid_{-1};
+  int in_fd_{-1};       // 子进程 stdin
+  int err_fd_{-1};      // 子进程 stderr
+  std::string buffer_;  // stderr 中尚未组成完整一行的数据
+  size_t line_no_{0};   // 子进程已经读取的行数
+  size_t starts_{0};
+  std::mutex mutex_;
+};
+
+} // namespace net
+} // namespace ohno
@@ -1,7 +1,9 @@
 #pragma once
 
 // clang-format off
+#include <string>
 #include <string_view>
+#include <vector>
 #include "src/net/macro.h"
 // clang-format on
 
@@ -17,6 +19,11 @@ public:
   virtual ~NetlinkIf() = default;
   virtual auto linkDestory(std::string_view name, std::string_view netns = {}) -> bool = 0;
   virtual auto linkExist(std::string_view name, std::string_view netns = {}) -> bool = 0;
+  virtual auto linkList(std::string_view prefix, std::string_view netns = {})
+      -> std::vector<std::string> = 0;
+  virtual auto linkGetMaster(std::string_view name, std::string_view netns = {})
+      -> std::string = 0;
+  virtual auto linkGetMac(std::string_view name, std::string_view netns = {}) -> std::string = 0;
   virtual auto linkSetStatus(std::string_view name, LinkStatus status, std::string_view netns = {})
       -> bool = 0;
   virtual auto linkIsInNetns(std::string_view name, std::string_view netns) -> bool = 0;
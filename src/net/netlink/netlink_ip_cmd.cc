@@ -1,15 +1,130 @@
 // clang-format off
 #include "netlink_ip_cmd.h"
+#include <array>
 #include "spdlog/fmt/fmt.h"
 #include "src/common/assert.h"
 #include "src/common/enum_name.hpp"
+#include "src/helper/string.h"
+#include "src/metrics/metrics.h"
 // clang-format on
 
 namespace ohno {
 namespace net {
 
+namespace {
+
+enum class Mode : uint8_t { exec, batch }; // exec 单独启动进程，batch 交给 -batch 子进程
+
+// 按 "程序 对象" 区分的命令，其余的记为 other
+constexpr std::array<std::pair<std::string_view, std::string_view>, 5> OPS{
+    {{"ip", "link"}, {"ip", "addr"}, {"ip", "route"}, {"ip", "neigh"}, {"bridge", "fdb"}}};
+constexpr size_t OP_OTHER{OPS.size()};
+
+struct OpMetrics {
+  metrics::Histogram *duration_;
+  metrics::Counter *errors_;
+};
+
+/**
+ * @brief 获取命令的 "程序 对象"（如 "ip route"）在 OPS 中的下标，跳过 "ip netns exec <netns>"
+ * 前缀与选项，只在原字符串上查找，不分配内存
+ *
+ * @param command 完整的 shell 命令
+ * @return size_t 下标，不认识的命令为 OP_OTHER
+ */
+auto getOp(std::string_view command) -> size_t {
+  helper::Tokenizer tokens{command, ' '};
+  std::string_view program{};
+  std::string_view token{};
+  while (tokens.next(token)) {
+    if (token.empty() || token[0] == '-') {
+      continue;
+    }
+    if (program.empty()) {
+      program = token;
+      continue;
+    }
+    if (program == "ip" && token == "netns") {
+      if (!tokens.next(token) || token != "exec" || !tokens.next(token)) {
+        return OP_OTHER;
+      }
+      program = {}; // 跳过网络空间名称，从真正执行的命令重新开始
+      continue;
+    }
+    for (size_t i = 0; i < OPS.size(); ++i) {
+      if (OPS[i].first == program && OPS[i].second == token) {
+        return i;
+      }
+    }
+    return OP_OTHER;
+  }
+  return OP_OTHER;
+}
+
+/**
+ * @brief 获取命令对应的指标，第一次调用时一次性注册所有组合，之后不再访问注册表
+ *
+ * @param op OPS 中的下标
+ * @param mode 执行方式
+ * @return const OpMetrics& 指标
+ */
+auto getMetrics(size_t op, Mode mode) -> const OpMetrics & {
+  constexpr size_t MODES{2};
+  static const auto METRICS = []() {
+    std::array<OpMetrics, (OPS.size() + 1) * MODES> result{};
+    auto &registry = metrics::Registry::instance();
+    for (size_t i = 0; i <= OPS.size(); ++i) {
+      auto name = i == OP_OTHER ? std::string{"other"}
+                                : fmt::format("{} {}", OPS[i].first, OPS[i].second);
+      for (size_t j = 0; j < MODES; ++j) {
+        metrics::Labels labels{{"op", name}, {"mode", j == 0 ? "exec" : "batch"}};
+        result[i * MODES + j] = OpMetrics{
+            &registry.histogram("ohno_netlink_op_duration_seconds",
+                                "Netlink (ip/bridge command) latency", metrics::Buckets::latency,
+                                labels),
+            &registry.counter("ohno_netlink_op_errors_total",
+                              "Netlink (ip/bridge command) failures", labels)};
+      }
+    }
+    return result;
+  }();
+  return METRICS[op * MODES + static_cast<size_t>(mode)];
+}
+
+/**
+ * @brief 记录一次 ip/bridge 命令的耗时与失败次数，按 "程序 对象"（如 "ip route"）和执行方式区分
+ *
+ * @param command 完整的 shell 命令
+ * @param mode 执行方式
+ * @param start 开始时间
+ * @param ret 执行结果
+ * @return bool 原样返回执行结果
+ */
+auto observe(std::string_view command, Mode mode, std::chrono::steady_clock::time_point start,
+             bool ret) -> bool {
+  const auto &metrics = getMetrics(getOp(command), mode);
+  metrics.duration_->observe(
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  if (!ret) {
+    metrics.errors_->inc();
+  }
+  return ret;
+}
+
+} // namespace
+
 NetlinkIpCmd::NetlinkIpCmd(std::unique_ptr<util::ShellIf> shell) : shell_{std::move(shell)} {}
 
+/**
+ * @brief 开启批处理模式：只关心成功与否的 ip、bridge 命令交给常驻的 -batch 子进程执行，
+ * 不再每条命令启动一个进程，适合需要频繁下发表项的常驻进程
+ *
+ */
+auto NetlinkIpCmd::enableBatch() -> void {
+  ip_batch_ = std::make_unique<IpBatch>("ip");
+  bridge_batch_ = std::make_unique<IpBatch>("bridge");
+}
+
 /**
  * @brief 删除网络接口
  *
@@ -38,6 +153,94 @@ auto NetlinkIpCmd::linkExist(std::string_view name, std::string_view netns) -> b
   return executeCommand(cmd, "Link {} is not exist", name);
 }
 
+/**
+ * @brief 列出名称以指定前缀开头的网卡
+ *
+ * @param prefix 名称前缀（为空时列出所有网卡）
+ * @param netns 网络空间名称（可以为空）
+ * @return std::vector<std::string> 网卡名称，命令执行失败时为空
+ */
+auto NetlinkIpCmd::linkList(std::string_view prefix, std::string_view netns)
+    -> std::vector<std::string> {
+  std::string cmd = addNetns("ip -o link show", netns);
+  std::string output{};
+  if (!query(cmd, output)) {
+    OHNO_LOG(warn, "Failed to execute command: {}", cmd);
+    return {};
+  }
+
+  // 每行形如 "12: ohnop_3@ohnoq_3: <BROADCAST,MULTICAST> mtu 1500 ..."
+  std::vector<std::string> names{};
+  for (const auto &line : helper::split(output, '\n')) {
+    auto begin = line.find(": ");
+    if (begin == std::string::npos) {
+      continue;
+    }
+    begin += 2;
+    auto end = line.find_first_of("@:", begin);
+    if (end == std::string::npos) {
+      continue;
+    }
+    auto name = line.substr(begin, end - begin);
+    if (name.compare(0, prefix.size(), prefix) == 0) {
+      names.emplace_back(std::move(name));
+    }
+  }
+  return names;
+}
+
+/**
+ * @brief 获取网卡所在的 bridge
+ *
+ * @param name 网卡名称
+ * @param netns 网络空间名称（可以为空）
+ * @return std::string bridge 名称，网卡没有插入 bridge 或者命令执行失败时为空
+ */
+auto NetlinkIpCmd::linkGetMaster(std::string_view name, std::string_view netns) -> std::string {
+  OHNO_ASSERT(!name.empty());
+  std::string cmd = addNetns(fmt::format("ip -o link show {}", name), netns);
+  std::string output{};
+  if (!query(cmd, output)) {
+    OHNO_LOG(warn, "Failed to execute command: {}", cmd);
+    return {};
+  }
+
+  // 形如 "12: ohnoq_3@ohnop_3: <BROADCAST,MULTICAST> mtu 1500 qdisc noop master ohnobr ..."
+  constexpr std::string_view MASTER{" master "};
+  auto begin = output.find(MASTER);
+  if (begin == std::string::npos) {
+    return {};
+  }
+  begin += MASTER.size();
+  return output.substr(begin, output.find_first_of(" \n", begin) - begin);
+}
+
+/**
+ * @brief 获取网卡的 MAC 地址
+ *
+ * @param name 网卡名称
+ * @param netns 网络空间名称（可以为空）
+ * @return std::string MAC 地址，网卡不是以太网设备或者命令执行失败时为空
+ */
+auto NetlinkIpCmd::linkGetMac(std::string_view name, std::string_view netns) -> std::string {
+  OHNO_ASSERT(!name.empty());
+  std::string cmd = addNetns(fmt::format("ip -o link show {}", name), netns);
+  std::string output{};
+  if (!query(cmd, output)) {
+    OHNO_LOG(warn, "Failed to execute command: {}", cmd);
+    return {};
+  }
+
+  // 形如 "8: ohnov: <BROADCAST,MULTICAST,UP,LOWER_UP> mtu 1450 ... link/ether 5e:1f:... brd ..."
+  constexpr std::string_view ETHER{" link/ether "};
+  auto begin = output.find(ETHER);
+  if (begin == std::string::npos) {
+    return {};
+  }
+  begin += ETHER.size();
+  return output.substr(begin, output.find_first_of(" \n", begin) - begin);
+}
+
 /**
  * @brief 设置网络接口开启或关闭
  *
@@ -68,7 +271,7 @@ auto NetlinkIpCmd::linkIsInNetns(std::string_view name, std::string_view netns)
   OHNO_ASSERT(!netns.empty());
   std::string cmd = addNetns(fmt::format("ip link show dev {}", name), netns);
   std::string output{};
-  if (shell_->execute(cmd, output)) {
+  if (query(cmd, output)) {
     return output.find(name) != std::string::npos;
   }
   return false;
@@ -230,7 +433,7 @@ auto NetlinkIpCmd::addressIsExist(std::string_view name, std::string_view addr,
   OHNO_ASSERT(!addr.empty());
   std::string cmd = addNetns(fmt::format("ip addr show dev {}", name), netns);
   std::string output{};
-  if (shell_->execute(cmd, output)) {
+  if (query(cmd, output)) {
     return output.find(addr) != std::string::npos;
   }
   OHNO_LOG(warn, "Failed to execute command: {}", cmd);
@@ -271,10 +474,12 @@ auto NetlinkIpCmd::routeIsExist(std::string_view dst, std::string_view via, std:
   OHNO_ASSERT(!via.empty());
   std::string dest = dst.empty() ? "default" : std::string{dst};
   std::string device = dev.empty() ? std::string{} : fmt::format("dev {}", dev);
-  std::string cmd = addNetns(fmt::format("ip route show {} via {} {}", dest, via, device), netns);
+  std::string family = via.find(':') == std::string_view::npos ? "" : "-6 "; // IPv6 下一跳
+  std::string cmd =
+      addNetns(fmt::format("ip {}route show {} via {} {}", family, dest, via, device), netns);
   std::string output{};
   std::string error{};
-  if (shell_->execute(cmd, output, error) == 0) {
+  if (query(cmd, output, error) == 0) {
     return !output.empty(); // 输出为空则路由不存在；存在输出则路由存在
   }
   OHNO_LOG(warn, "Failed to execute command: {}", cmd);
@@ -302,8 +507,10 @@ auto NetlinkIpCmd::routeSetEntry(std::string_view dst, std::string_view via, boo
   std::string device = dev.empty() ? std::string{} : fmt::format("dev {}", dev);
   std::string nhflags_str =
       nhflags == RouteNHFlags::NONE ? std::string{} : std::string{enumName(nhflags)};
+  std::string family = via.find(':') == std::string_view::npos ? "" : "-6 "; // IPv6 下一跳
   std::string cmd = addNetns(
-      fmt::format("ip route {} {} via {} {} {}", action, dest, via, device, nhflags_str), netns);
+      fmt::format("ip {}route {} {} via {} {} {}", family, action, dest, via, device, nhflags_str),
+      netns);
   return executeCommand(cmd, "Failed to {} route({} via {}) {}", action, dest, via, nhflags_str);
 }
 
@@ -323,7 +530,7 @@ auto NetlinkIpCmd::neighIsExist(std::string_view addr, std::string_view dev,
   std::string cmd = addNetns(fmt::format("ip neigh show {} {}", addr, device), netns);
   std::string output{};
   std::string error{};
-  if (shell_->execute(cmd, output, error) == 0) {
+  if (query(cmd, output, error) == 0) {
     return !output.empty(); // 输出为空则不存在；存在输出则存在
   }
   OHNO_LOG(warn, "Failed to execute command: {}", cmd);
@@ -371,7 +578,7 @@ auto NetlinkIpCmd::fdbIsExist(std::string_view mac, std::string_view underlay_ad
       fmt::format("bridge fdb show dev {} | grep {} | grep {}", dev, mac, underlay_addr), netns);
   std::string output{};
   std::string error{};
-  if (shell_->execute(cmd, output, error) == 0) {
+  if (query(cmd, output, error) == 0) {
     return !output.empty(); // 输出为空则不存在；存在输出则存在
   }
   OHNO_LOG(warn, "Failed to execute command: {}", cmd);
@@ -402,6 +609,63 @@ auto NetlinkIpCmd::fdbSetEntry(std::string_view mac, std::string_view underlay_a
                         underlay_addr);
 }
 
+/**
+ * @brief 执行一条只关心成功与否的命令，批处理模式下优先交给 -batch 子进程
+ *
+ * @note ip netns exec 需要切换 namespace 再执行另一个程序，带管道或者全局选项（如 -6）的命令
+ * 无法写成一行批处理命令，这些命令依然单独启动进程
+ *
+ * @param command 完整的 shell 命令
+ * @return true 执行成功
+ * @return false 执行失败
+ */
+auto NetlinkIpCmd::execute(std::string_view command) const -> bool {
+  auto batchable = [command](std::string_view program) {
+    return command.size() > program.size() + 1 &&
+           command.compare(0, program.size(), program) == 0 && command[program.size()] == ' ' &&
+           command[program.size() + 1] != '-' && command.find('|') == std::string_view::npos;
+  };
+  auto start = std::chrono::steady_clock::now();
+  if (ip_batch_ && batchable("ip") && command.compare(0, 9, "ip netns ") != 0) {
+    return observe(command, Mode::batch, start, ip_batch_->execute(command.substr(3)));
+  }
+  if (bridge_batch_ && batchable("bridge")) {
+    return observe(command, Mode::batch, start, bridge_batch_->execute(command.substr(7)));
+  }
+
+  std::string output{}; // 并不关注输出什么内容
+  return observe(command, Mode::exec, start, shell_->execute(command, output));
+}
+
+/**
+ * @brief 执行一条需要读取输出的命令
+ *
+ * @param command 完整的 shell 命令
+ * @param output stdout（返回值）
+ * @return true 执行成功
+ * @return false 执行失败
+ */
+auto NetlinkIpCmd::query(std::string_view command, std::string &output) const -> bool {
+  auto start = std::chrono::steady_clock::now();
+  return observe(command, Mode::exec, start, shell_->execute(command, output));
+}
+
+/**
+ * @brief 执行一条需要读取输出与错误输出的命令
+ *
+ * @param command 完整的 shell 命令
+ * @param output stdout（返回值）
+ * @param error stderr（返回值）
+ * @return int 命令退出码
+ */
+auto NetlinkIpCmd::query(std::string_view command, std::string &output, std::string &error) const
+    -> int {
+  auto start = std::chrono::steady_clock::now();
+  auto ret = shell_->execute(command, output, error);
+  observe(command, Mode::exec, start, ret == 0);
+  return ret;
+}
+
 /**
  * @brief 将 ip 命令加上 Linux namespace 前缀
  *
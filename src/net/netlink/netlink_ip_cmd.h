@@ -2,6 +2,7 @@
 
 // clang-format off
 #include <memory>
+#include "ip_batch.h"
 #include "netlink_if.h"
 #include "src/log/logger.h"
 #include "src/util/shell_if.h"
@@ -17,8 +18,15 @@ class NetlinkIpCmd : public NetlinkIf, public log::Loggable<log::Id::net> {
 public:
   explicit NetlinkIpCmd(std::unique_ptr<util::ShellIf> shell);
 
+  auto enableBatch() -> void;
+
   auto linkDestory(std::string_view name, std::string_view netns = {}) -> bool override;
   auto linkExist(std::string_view name, std::string_view netns = {}) -> bool override;
+  auto linkList(std::string_view prefix, std::string_view netns = {})
+      -> std::vector<std::string> override;
+  auto linkGetMaster(std::string_view name, std::string_view netns = {})
+      -> std::string override;
+  auto linkGetMac(std::string_view name, std::string_view netns = {}) -> std::string override;
   auto linkSetStatus(std::string_view name, LinkStatus status, std::string_view netns = {})
       -> bool override;
   auto linkIsInNetns(std::string_view name, std::string_view netns) -> bool override;
@@ -54,11 +62,16 @@ public:
 
 private:
   static auto addNetns(std::string_view command, std::string_view netns = {}) -> std::string;
+  auto execute(std::string_view command) const -> bool;
+  auto query(std::string_view command, std::string &output) const -> bool;
+  auto query(std::string_view command, std::string &output, std::string &error) const -> int;
   template <typename... Args>
   auto executeCommand(std::string_view command, std::string_view error_message,
                       Args &&...args) const -> bool;
 
   std::unique_ptr<util::ShellIf> shell_;
+  std::unique_ptr<IpBatch> ip_batch_;     // 为空时每条命令单独启动进程
+  std::unique_ptr<IpBatch> bridge_batch_;
 };
 
 } // namespace net
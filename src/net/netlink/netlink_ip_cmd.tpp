@@ -24,8 +24,7 @@ auto NetlinkIpCmd::executeCommand(std::string_view command, std::string_view err
   OHNO_ASSERT(!error_message.empty());
   OHNO_ASSERT(shell_);
 
-  std::string output{}; // 并不关注输出什么内容
-  if (!shell_->execute(command, output)) {
+  if (!execute(command)) {
     OHNO_LOG(warn, error_message.data(), std::forward<Args>(args)...);
     return false;
   }
@@ -0,0 +1,982 @@
+// clang-format off
+#include "netlink_memory.h"
+#include <algorithm>
+#include <cctype>
+#include "spdlog/fmt/fmt.h"
+#include "src/common/assert.h"
+// clang-format on
+
+namespace ohno {
+namespace net {
+
+/**
+ * @brief 创建只有 root 网络空间的模型，与新启动的节点一样 root 网络空间中有一个启用的 lo
+ *
+ */
+NetlinkMemory::NetlinkMemory() {
+  auto &root = netns_[std::string{}];
+  root.links_.emplace(NAME_LOOPBACK, Link{next_index_++, LinkType::loopback, true, 0, 0, {}});
+}
+
+/**
+ * @brief 创建网络空间（相当于 ip netns add），新的网络空间只有一个关闭的 lo
+ *
+ * @param netns 网络空间名称
+ * @return true 创建成功
+ * @return false 名称为空或者已经存在
+ */
+auto NetlinkMemory::netnsAdd(std::string_view netns) -> bool {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (netns.empty() || netns_.find(netns) != netns_.end()) {
+    return reject("netns add", netns, "File exists");
+  }
+  auto &space = netns_[std::string{netns}];
+  space.links_.emplace(NAME_LOOPBACK, Link{next_index_++, LinkType::loopback, false, 0, 0, {}});
+  return true;
+}
+
+/**
+ * @brief 删除网络空间（相当于 ip netns del），其中的网卡全部删除，veth 的另一端随之删除
+ *
+ * @param netns 网络空间名称
+ * @return true 删除成功
+ * @return false 不存在，或者是 root 网络空间
+ */
+auto NetlinkMemory::netnsDel(std::string_view netns) -> bool {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto iter = netns_.find(netns);
+  if (netns.empty() || iter == netns_.end()) {
+    return reject("netns del", netns, "No such file or directory");
+  }
+  auto &space = iter->second;
+  while (!space.links_.empty()) {
+    destroyLink(space, space.links_.begin()->first);
+  }
+  netns_.erase(iter);
+  return true;
+}
+
+/**
+ * @brief 判断网络空间是否存在
+ *
+ * @param netns 网络空间名称（可以为空）
+ * @return true 存在
+ * @return false 不存在
+ */
+auto NetlinkMemory::netnsExist(std::string_view netns) const -> bool {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return findNetns(netns) != nullptr;
+}
+
+/**
+ * @brief 网络空间中经过网关的路由数量（不含地址生成的直连路由）
+ *
+ * @param netns 网络空间名称（可以为空）
+ * @return size_t 数量，网络空间不存在时为 0
+ */
+auto NetlinkMemory::routeCount(std::string_view netns) const -> size_t {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto *space = findNetns(netns);
+  return space == nullptr ? 0 : space->routes_.size();
+}
+
+/**
+ * @brief 网络空间中的 ARP 缓存数量
+ *
+ * @param netns 网络空间名称（可以为空）
+ * @return size_t 数量，网络空间不存在时为 0
+ */
+auto NetlinkMemory::neighCount(std::string_view netns) const -> size_t {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto *space = findNetns(netns);
+  return space == nullptr ? 0 : space->neighs_.size();
+}
+
+/**
+ * @brief 网络空间中的 FDB 表项数量
+ *
+ * @param netns 网络空间名称（可以为空）
+ * @return size_t 数量，网络空间不存在时为 0
+ */
+auto NetlinkMemory::fdbCount(std::string_view netns) const -> size_t {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto *space = findNetns(netns);
+  return space == nullptr ? 0 : space->fdbs_.size();
+}
+
+/**
+ * @brief NetlinkIf 接口被调用的总次数，相当于 ip 命令的执行次数
+ *
+ * @return uint64_t 次数
+ */
+auto NetlinkMemory::getCalls() const noexcept -> uint64_t { return calls_; }
+
+/**
+ * @brief 删除网络接口
+ *
+ * @param name 网络接口名称
+ * @param netns 网络空间名称（可以为空）
+ * @return true 删除成功
+ * @return false 网卡不存在，或者是 lo
+ */
+auto NetlinkMemory::linkDestory(std::string_view name, std::string_view netns) -> bool {
+  OHNO_ASSERT(!name.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *link = findLink(name, netns);
+  if (link == nullptr) {
+    return reject("link del", name, "Cannot find device");
+  }
+  if (link->type_ == LinkType::loopback) {
+    return reject("link del", name, "Operation not supported");
+  }
+  destroyLink(*findNetns(netns), name);
+  return true;
+}
+
+/**
+ * @brief 判断网卡是否存在
+ *
+ * @param name 网卡名称
+ * @param netns 网络空间名称（可以为空）
+ * @return true 存在
+ * @return false 不存在
+ */
+auto NetlinkMemory::linkExist(std::string_view name, std::string_view netns) -> bool {
+  OHNO_ASSERT(!name.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  return findLink(name, netns) != nullptr;
+}
+
+/**
+ * @brief 列出名称以指定前缀开头的网卡，与 ip link show 一样按 ifindex 排序
+ *
+ * @param prefix 名称前缀（为空时列出所有网卡）
+ * @param netns 网络空间名称（可以为空）
+ * @return std::vector<std::string> 网卡名称，网络空间不存在时为空
+ */
+auto NetlinkMemory::linkList(std::string_view prefix, std::string_view netns)
+    -> std::vector<std::string> {
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *space = findNetns(netns);
+  if (space == nullptr) {
+    return {};
+  }
+
+  std::vector<std::pair<uint32_t, std::string>> links{};
+  for (const auto &[name, link] : space->links_) {
+    if (name.compare(0, prefix.size(), prefix) == 0) {
+      links.emplace_back(link.index_, name);
+    }
+  }
+  std::sort(links.begin(), links.end());
+
+  std::vector<std::string> names{};
+  names.reserve(links.size());
+  for (auto &[index, name] : links) {
+    names.emplace_back(std::move(name));
+  }
+  return names;
+}
+
+/**
+ * @brief 获取网卡所在的 bridge
+ *
+ * @param name 网卡名称
+ * @param netns 网络空间名称（可以为空）
+ * @return std::string bridge 名称，网卡不存在或者没有插入 bridge 时为空
+ */
+auto NetlinkMemory::linkGetMaster(std::string_view name, std::string_view netns) -> std::string {
+  OHNO_ASSERT(!name.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *link = findLink(name, netns);
+  if (link == nullptr || link->master_ == 0) {
+    return {};
+  }
+  return findIndex(link->master_).second;
+}
+
+/**
+ * @brief 获取网卡的 MAC 地址，由 ifindex 生成（本地管理的单播地址），网卡生命周期内不变
+ *
+ * @param name 网卡名称
+ * @param netns 网络空间名称（可以为空）
+ * @return std::string MAC 地址，网卡不存在或者是 loopback 时为空
+ */
+auto NetlinkMemory::linkGetMac(std::string_view name, std::string_view netns) -> std::string {
+  OHNO_ASSERT(!name.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *link = findLink(name, netns);
+  if (link == nullptr || link->type_ == LinkType::loopback) {
+    return {};
+  }
+  return fmt::format("02:00:00:{:02x}:{:02x}:{:02x}", (link->index_ >> 16) & 0xff,
+                     (link->index_ >> 8) & 0xff, link->index_ & 0xff);
+}
+
+/**
+ * @brief 设置网络接口开启或关闭，关闭时经过它的路由被内核删除
+ *
+ * @param name 网络接口名称
+ * @param status 网络接口状态
+ * @param netns 网络空间名称（可以为空）
+ * @return true 设置成功
+ * @return false 网卡不存在
+ */
+auto NetlinkMemory::linkSetStatus(std::string_view name, LinkStatus status, std::string_view netns)
+    -> bool {
+  OHNO_ASSERT(!name.empty());
+  OHNO_ASSERT(status != LinkStatus::RESERVED);
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *link = findLink(name, netns);
+  if (link == nullptr) {
+    return reject("link set", name, "Cannot find device");
+  }
+  link->up_ = status == LinkStatus::UP;
+  if (!link->up_) {
+    flushRoutes(*findNetns(netns), link->index_);
+  }
+  return true;
+}
+
+/**
+ * @brief 判断 namespace 中是否存在网卡
+ *
+ * @param name 网卡名称
+ * @param netns 网络空间名称
+ * @return true 存在
+ * @return false 不存在
+ */
+auto NetlinkMemory::linkIsInNetns(std::string_view name, std::string_view netns) -> bool {
+  OHNO_ASSERT(!name.empty());
+  OHNO_ASSERT(!netns.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  return findLink(name, netns) != nullptr;
+}
+
+/**
+ * @brief 将 root 网络空间中的网络接口移动到指定网络空间；与内核一样，移动之后网卡处于关闭状态，
+ * 地址、路由、ARP 缓存、FDB 表项以及 bridge 从属关系都被清除
+ *
+ * @param name 网络接口名称
+ * @param netns 网络空间名称
+ * @return true 移动成功
+ * @return false 网卡或者网络空间不存在，或者目标网络空间中已有同名网卡
+ */
+auto NetlinkMemory::linkToNetns(std::string_view name, std::string_view netns) -> bool {
+  OHNO_ASSERT(!name.empty());
+  OHNO_ASSERT(!netns.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *root = findNetns({});
+  auto iter = root->links_.find(name);
+  if (iter == root->links_.end()) {
+    return reject("link set netns", name, "Cannot find device");
+  }
+  auto *target = findNetns(netns);
+  if (target == nullptr) {
+    return reject("link set netns", netns, "Invalid netns value");
+  }
+  if (iter->second.type_ == LinkType::loopback ||
+      target->links_.find(name) != target->links_.end()) {
+    return reject("link set netns", name, "File exists");
+  }
+
+  auto link = std::move(iter->second);
+  root->links_.erase(iter);
+  detachLink(*root, link.index_);
+  link.up_ = false;
+  link.master_ = 0;
+  link.addrs_.clear();
+  target->links_.emplace(name, std::move(link));
+  return true;
+}
+
+/**
+ * @brief 网络接口重命名，与内核一样只能修改关闭状态的网卡
+ *
+ * @param name 网络接口
+ * @param new_name 新名称
+ * @param netns 网络空间名称（可以为空）
+ * @return true 重命名成功
+ * @return false 网卡不存在、处于启用状态、新名称非法或者已被占用
+ */
+auto NetlinkMemory::linkRename(std::string_view name, std::string_view new_name,
+                               std::string_view netns) -> bool {
+  OHNO_ASSERT(!name.empty());
+  OHNO_ASSERT(!new_name.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *space = findNetns(netns);
+  if (space == nullptr || space->links_.find(name) == space->links_.end()) {
+    return reject("link set name", name, "Cannot find device");
+  }
+  auto iter = space->links_.find(name);
+  if (iter->second.up_) {
+    return reject("link set name", name, "Device or resource busy");
+  }
+  if (!isValidName(new_name) || space->links_.find(new_name) != space->links_.end()) {
+    return reject("link set name", new_name, "File exists");
+  }
+
+  auto link = std::move(iter->second);
+  space->links_.erase(iter);
+  space->links_.emplace(new_name, std::move(link));
+  return true;
+}
+
+/**
+ * @brief 在 root 网络空间中创建 veth pair，两端都处于关闭状态
+ *
+ * @param name1 veth pair 一端名称
+ * @param name2 veth pair 另一端名称
+ * @return true 创建成功
+ * @return false 名称非法或者已被占用
+ */
+auto NetlinkMemory::vethCreate(std::string_view name1, std::string_view name2) -> bool {
+  OHNO_ASSERT(!name1.empty());
+  OHNO_ASSERT(!name2.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  if (name1 == name2 || !isValidName(name2) || findLink(name2, {}) != nullptr) {
+    return reject("link add", name2, "File exists");
+  }
+  auto *link1 = createLink(name1, LinkType::veth);
+  if (link1 == nullptr) {
+    return false;
+  }
+  auto *link2 = createLink(name2, LinkType::veth);
+  link1->peer_ = link2->index_;
+  link2->peer_ = link1->index_;
+  return true;
+}
+
+/**
+ * @brief 在 root 网络空间中创建 bridge
+ *
+ * @param name bridge 名称
+ * @return true 创建成功
+ * @return false 名称非法或者已被占用
+ */
+auto NetlinkMemory::bridgeCreate(std::string_view name) -> bool {
+  OHNO_ASSERT(!name.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  return createLink(name, LinkType::bridge) != nullptr;
+}
+
+/**
+ * @brief 在 root 网络空间中创建 vxlan
+ *
+ * @param name 网卡名称
+ * @param underlay_addr 底层网卡地址
+ * @param underlay_dev 底层网卡
+ * @return true 成功
+ * @return false 底层网卡不存在、底层地址非法、名称非法或者已被占用
+ */
+auto NetlinkMemory::vxlanCreate(std::string_view name, std::string_view underlay_addr,
+                                std::string_view underlay_dev) -> bool {
+  OHNO_ASSERT(!name.empty());
+  OHNO_ASSERT(!underlay_addr.empty());
+  OHNO_ASSERT(!underlay_dev.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  if (findLink(underlay_dev, {}) == nullptr) {
+    return reject("link add", underlay_dev, "Cannot find device");
+  }
+  if (!IpAddr::parse(underlay_addr).has_value()) {
+    return reject("link add", underlay_addr, "Invalid address");
+  }
+  return createLink(name, LinkType::vxlan) != nullptr;
+}
+
+/**
+ * @brief 在 root 网络空间中创建 vrf
+ *
+ * @param name 网卡名称
+ * @param table 要绑定的路由表
+ * @return true 成功
+ * @return false 名称非法或者已被占用
+ */
+auto NetlinkMemory::vrfCreate(std::string_view name, uint32_t /*table*/) -> bool {
+  OHNO_ASSERT(!name.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  return createLink(name, LinkType::vrf) != nullptr;
+}
+
+/**
+ * @brief 将网络接口插入 bridge 或者从 bridge 拔出，两者必须在同一个网络空间
+ *
+ * @param name 需要处理的网络接口
+ * @param master 插入 bridge（true），从 bridge 拔出（false）
+ * @param bridge Linux bridge 接口
+ * @param mode 地址生成模式（模型中不生成链路本地地址，忽略）
+ * @param netns 网络空间名称（可以为空）
+ * @return true 设置成功
+ * @return false 网卡或者 bridge 不存在，或者 bridge 不是 bridge 类型
+ */
+auto NetlinkMemory::bridgeSetStatus(std::string_view name, bool master, std::string_view bridge,
+                                    BridgeAddrGenMode /*mode*/, std::string_view netns) -> bool {
+  OHNO_ASSERT(!name.empty());
+  OHNO_ASSERT(!bridge.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *link = findLink(name, netns);
+  auto *bridge_link = findLink(bridge, netns);
+  if (link == nullptr || bridge_link == nullptr) {
+    return reject("link set master", link == nullptr ? name : bridge, "Cannot find device");
+  }
+  if (bridge_link->type_ != LinkType::bridge || link == bridge_link) {
+    return reject("link set master", bridge, "Operation not supported");
+  }
+  link->master_ = master ? bridge_link->index_ : 0;
+  return true;
+}
+
+/**
+ * @brief 设置 VTEP 桥接从接口属性，网卡必须已经插入 bridge
+ *
+ * @param name VTEP 设备名称
+ * @param neigh_suppress 启用（true）/ 禁用（false）邻居表抑制
+ * @param learning 启用（true）/ 禁用（false）地址学习
+ * @param netns 网络空间名称（可以为空）
+ * @return true 成功
+ * @return false 网卡不存在或者没有插入 bridge
+ */
+auto NetlinkMemory::vxlanSetSlave(std::string_view name, bool /*neigh_suppress*/,
+                                  bool /*learning*/, std::string_view netns) -> bool {
+  OHNO_ASSERT(!name.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *link = findLink(name, netns);
+  if (link == nullptr) {
+    return reject("link set type bridge_slave", name, "Cannot find device");
+  }
+  if (link->master_ == 0) {
+    return reject("link set type bridge_slave", name, "Operation not supported");
+  }
+  return true;
+}
+
+/**
+ * @brief 判断 IP 地址是否存在
+ *
+ * @param name 网卡名称
+ * @param addr IP 地址（带前缀长度时前缀长度也要相同）
+ * @param netns 网络空间（可以为空）
+ * @return true 地址存在
+ * @return false 地址或者网卡不存在
+ */
+auto NetlinkMemory::addressIsExist(std::string_view name, std::string_view addr,
+                                   std::string_view netns) -> bool {
+  OHNO_ASSERT(!name.empty());
+  OHNO_ASSERT(!addr.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *link = findLink(name, netns);
+  if (link == nullptr) {
+    return false;
+  }
+  auto prefix = IpPrefix::parse(addr);
+  auto ip = prefix.has_value() ? std::optional<IpAddr>{prefix->addr()} : IpAddr::parse(addr);
+  return std::any_of(link->addrs_.begin(), link->addrs_.end(), [&](const IpPrefix &item) {
+    return prefix.has_value() ? item == prefix.value()
+                              : ip.has_value() && item.addr() == ip.value();
+  });
+}
+
+/**
+ * @brief 设置 IP 地址，不带前缀长度时与 ip 命令一样按主机地址处理
+ *
+ * @param name 网络接口名称
+ * @param addr 地址
+ * @param add 增加地址（true），删除地址（false）
+ * @param netns 网络空间名称（可以为空）
+ * @return true 设置成功
+ * @return false 网卡不存在、地址非法、重复添加或者删除不存在的地址
+ */
+auto NetlinkMemory::addressSetEntry(std::string_view name, std::string_view addr, bool add,
+                                    std::string_view netns) -> bool {
+  OHNO_ASSERT(!name.empty());
+  OHNO_ASSERT(!addr.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *link = findLink(name, netns);
+  if (link == nullptr) {
+    return reject("addr", name, "Cannot find device");
+  }
+  auto prefix = IpPrefix::parse(addr);
+  if (!prefix.has_value()) {
+    auto ip = IpAddr::parse(addr);
+    if (!ip.has_value()) {
+      return reject("addr", addr, "Invalid address");
+    }
+    prefix = IpPrefix{ip.value(), ip->maxPrefix()};
+  }
+
+  auto iter =
+      std::find_if(link->addrs_.begin(), link->addrs_.end(),
+                   [&prefix](const IpPrefix &item) { return item.addr() == prefix->addr(); });
+  if (add) {
+    if (iter != link->addrs_.end()) {
+      return reject("addr add", addr, "File exists");
+    }
+    link->addrs_.emplace_back(prefix.value());
+    return true;
+  }
+  if (iter == link->addrs_.end() ||
+      (addr.find('/') != std::string_view::npos && iter->length() != prefix->length())) {
+    return reject("addr del", addr, "Cannot assign requested address");
+  }
+  link->addrs_.erase(iter);
+  return true;
+}
+
+/**
+ * @brief 检查路由是否存在
+ *
+ * @param dst 目的网段（可以为空）
+ * @param via 下一跳地址
+ * @param dev 经过设备（可以为空）
+ * @param netns 网络空间（可以为空）
+ * @return true 路由存在
+ * @return false 路由不存在
+ */
+auto NetlinkMemory::routeIsExist(std::string_view dst, std::string_view via, std::string_view dev,
+                                 std::string_view netns) const -> bool {
+  OHNO_ASSERT(!via.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *space = findNetns(netns);
+  if (space == nullptr) {
+    return false;
+  }
+  auto iter = space->routes_.find(routeKey(dst, via));
+  if (iter == space->routes_.end() || iter->second.via_ != via) {
+    return false;
+  }
+  if (dev.empty()) {
+    return true;
+  }
+  auto link = space->links_.find(dev);
+  return link != space->links_.end() && link->second.index_ == iter->second.dev_;
+}
+
+/**
+ * @brief 设置路由表条目
+ *
+ * 与内核一致：目的网段已有路由时添加失败；出口设备必须存在并且处于启用状态；
+ * 不带 onlink 时下一跳必须落在出口设备（未指定时为任意启用的网卡）的直连网段内
+ *
+ * @param dst 目的网络（可以为空，为空则设置为 default）
+ * @param via 下一跳地址
+ * @param add 增加路由（true），删除路由（false）
+ * @param dev 网络接口名称（可以为空）
+ * @param netns 网络空间名称（可以为空）
+ * @param nhflags NH 标识（可以为空）
+ * @return true 设置成功
+ * @return false 设置失败
+ */
+auto NetlinkMemory::routeSetEntry(std::string_view dst, std::string_view via, bool add,
+                                  std::string_view dev, std::string_view netns,
+                                  RouteNHFlags nhflags) const -> bool {
+  OHNO_ASSERT(!via.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *space = findNetns(netns);
+  auto gateway = IpAddr::parse(via);
+  auto key = routeKey(dst, via);
+  auto dest = IpPrefix::parse(key);
+  if (space == nullptr || !gateway.has_value() || !dest.has_value() ||
+      dest->network() != dest.value() || dest->version() != gateway->version()) {
+    return reject("route", key, "Invalid argument");
+  }
+
+  const Link *device = nullptr;
+  if (!dev.empty()) {
+    auto link = space->links_.find(dev);
+    if (link == space->links_.end()) {
+      return reject("route", dev, "Cannot find device");
+    }
+    device = &link->second;
+  }
+
+  auto iter = space->routes_.find(key);
+  if (!add) {
+    if (iter == space->routes_.end() || iter->second.via_ != via ||
+        (device != nullptr && device->index_ != iter->second.dev_)) {
+      return reject("route del", key, "No such process");
+    }
+    space->routes_.erase(iter);
+    return true;
+  }
+  if (iter != space->routes_.end()) {
+    return reject("route add", key, "File exists");
+  }
+
+  // 查找下一跳所在的直连网段
+  auto reachable = [&gateway](const Link &link) {
+    return link.up_ && std::any_of(link.addrs_.begin(), link.addrs_.end(),
+                                   [&gateway](const IpPrefix &addr) {
+                                     return addr.contains(gateway.value());
+                                   });
+  };
+  if (device == nullptr) {
+    auto link = std::find_if(space->links_.begin(), space->links_.end(),
+                             [&reachable](const auto &item) { return reachable(item.second); });
+    if (nhflags != RouteNHFlags::NONE || link == space->links_.end()) {
+      return reject("route add", via, "Network is unreachable");
+    }
+    device = &link->second;
+  } else if (!device->up_) {
+    return reject("route add", dev, "Nexthop device is not up");
+  } else if (nhflags == RouteNHFlags::NONE && !reachable(*device)) {
+    return reject("route add", via, "Nexthop has invalid gateway");
+  }
+  space->routes_.emplace(std::move(key), Route{std::string{via}, device->index_});
+  return true;
+}
+
+/**
+ * @brief 检查 ARP 缓存是否存在
+ *
+ * @param addr 三层地址
+ * @param dev 经过设备（可以为空）
+ * @param netns 网络空间（可以为空）
+ * @return true 存在
+ * @return false 不存在
+ */
+auto NetlinkMemory::neighIsExist(std::string_view addr, std::string_view dev,
+                                 std::string_view netns) const -> bool {
+  OHNO_ASSERT(!addr.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *space = findNetns(netns);
+  if (space == nullptr) {
+    return false;
+  }
+  if (dev.empty()) {
+    return std::any_of(space->neighs_.begin(), space->neighs_.end(),
+                       [addr](const auto &item) { return item.first.first == addr; });
+  }
+  auto link = space->links_.find(dev);
+  return link != space->links_.end() &&
+         space->neighs_.count({std::string{addr}, link->second.index_}) > 0;
+}
+
+/**
+ * @brief 设置 ARP 缓存条目，与 ip neigh add/del 一样必须指定设备
+ *
+ * @param addr 三层地址
+ * @param mac MAC 地址
+ * @param add 增加（true），删除（false）
+ * @param dev 网络接口名称
+ * @param netns 网络空间名称（可以为空）
+ * @return true 设置成功
+ * @return false 设备不存在、参数非法、重复添加或者删除不存在的表项
+ */
+auto NetlinkMemory::neighSetEntry(std::string_view addr, std::string_view mac, bool add,
+                                  std::string_view dev, std::string_view netns) const -> bool {
+  OHNO_ASSERT(!addr.empty());
+  OHNO_ASSERT(!mac.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *space = findNetns(netns);
+  if (space == nullptr || dev.empty()) {
+    return reject("neigh", addr, "Device and destination are required arguments");
+  }
+  auto link = space->links_.find(dev);
+  if (link == space->links_.end()) {
+    return reject("neigh", dev, "Cannot find device");
+  }
+  if (!IpAddr::parse(addr).has_value() || !isValidMac(mac)) {
+    return reject("neigh", addr, "Invalid argument");
+  }
+
+  std::pair<std::string, uint32_t> key{addr, link->second.index_};
+  if (add) {
+    if (!space->neighs_.emplace(std::move(key), mac).second) {
+      return reject("neigh add", addr, "File exists");
+    }
+    return true;
+  }
+  if (space->neighs_.erase(key) == 0) {
+    return reject("neigh del", addr, "No such file or directory");
+  }
+  return true;
+}
+
+/**
+ * @brief 检查 FDB 表项是否存在
+ *
+ * @param mac MAC 地址
+ * @param underlay_addr 底层地址
+ * @param dev 所在设备
+ * @param netns 网络空间（可以为空）
+ * @return true 存在
+ * @return false 不存在
+ */
+auto NetlinkMemory::fdbIsExist(std::string_view mac, std::string_view underlay_addr,
+                               std::string_view dev, std::string_view netns) const -> bool {
+  OHNO_ASSERT(!mac.empty());
+  OHNO_ASSERT(!underlay_addr.empty());
+  OHNO_ASSERT(!dev.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *space = findNetns(netns);
+  if (space == nullptr) {
+    return false;
+  }
+  auto link = space->links_.find(dev);
+  if (link == space->links_.end()) {
+    return false;
+  }
+  auto iter = space->fdbs_.find({std::string{mac}, link->second.index_});
+  return iter != space->fdbs_.end() && iter->second == underlay_addr;
+}
+
+/**
+ * @brief 设置 FDB 条目，远端地址只对 vxlan 设备有意义
+ *
+ * @param mac MAC 地址
+ * @param underlay_addr 底层地址
+ * @param dev 网络接口名称
+ * @param add 增加（true），删除（false）
+ * @param netns 网络空间名称（可以为空）
+ * @return true 设置成功
+ * @return false 设备不存在或者不是 vxlan、重复添加或者删除不存在的表项
+ */
+auto NetlinkMemory::fdbSetEntry(std::string_view mac, std::string_view underlay_addr,
+                                std::string_view dev, bool add, std::string_view netns) const
+    -> bool {
+  OHNO_ASSERT(!mac.empty());
+  OHNO_ASSERT(!underlay_addr.empty());
+  OHNO_ASSERT(!dev.empty());
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++calls_;
+  auto *space = findNetns(netns);
+  if (space == nullptr || space->links_.find(dev) == space->links_.end()) {
+    return reject("fdb", dev, "Cannot find device");
+  }
+  auto link = space->links_.find(dev);
+  if (link->second.type_ != LinkType::vxlan) {
+    return reject("fdb", dev, "Operation not supported");
+  }
+  if (!isValidMac(mac) || !IpAddr::parse(underlay_addr).has_value()) {
+    return reject("fdb", mac, "Invalid argument");
+  }
+
+  std::pair<std::string, uint32_t> key{mac, link->second.index_};
+  auto iter = space->fdbs_.find(key);
+  if (add) {
+    if (iter != space->fdbs_.end()) {
+      return reject("fdb add", mac, "File exists");
+    }
+    space->fdbs_.emplace(std::move(key), underlay_addr);
+    return true;
+  }
+  if (iter == space->fdbs_.end() || iter->second != underlay_addr) {
+    return reject("fdb del", mac, "No such file or directory");
+  }
+  space->fdbs_.erase(iter);
+  return true;
+}
+
+/**
+ * @brief 查找网络空间（调用者持有锁）
+ *
+ * @param netns 网络空间名称（可以为空）
+ * @return Netns* 网络空间，不存在时为 nullptr
+ */
+auto NetlinkMemory::findNetns(std::string_view netns) const -> Netns * {
+  auto iter = netns_.find(netns);
+  return iter == netns_.end() ? nullptr : &iter->second;
+}
+
+/**
+ * @brief 查找网卡（调用者持有锁）
+ *
+ * @param name 网卡名称
+ * @param netns 网络空间名称（可以为空）
+ * @return Link* 网卡，网卡或者网络空间不存在时为 nullptr
+ */
+auto NetlinkMemory::findLink(std::string_view name, std::string_view netns) const -> Link * {
+  auto *space = findNetns(netns);
+  if (space == nullptr) {
+    return nullptr;
+  }
+  auto iter = space->links_.find(name);
+  return iter == space->links_.end() ? nullptr : &iter->second;
+}
+
+/**
+ * @brief 按 ifindex 在所有网络空间中查找网卡（调用者持有锁）
+ *
+ * @param index ifindex
+ * @return std::pair<Netns *, std::string> 所在网络空间与网卡名称，不存在时网络空间为 nullptr
+ */
+auto NetlinkMemory::findIndex(uint32_t index) const -> std::pair<Netns *, std::string> {
+  for (auto &[netns, space] : netns_) {
+    for (const auto &[name, link] : space.links_) {
+      if (link.index_ == index) {
+        return {&space, name};
+      }
+    }
+  }
+  return {nullptr, {}};
+}
+
+/**
+ * @brief 在 root 网络空间中创建一个关闭状态的网卡（调用者持有锁）
+ *
+ * @param name 网卡名称
+ * @param type 网卡类型
+ * @return Link* 网卡，名称非法或者已被占用时为 nullptr
+ */
+auto NetlinkMemory::createLink(std::string_view name, LinkType type) -> Link * {
+  auto &root = netns_.find(std::string_view{})->second;
+  if (!isValidName(name)) {
+    reject("link add", name, "Invalid argument");
+    return nullptr;
+  }
+  auto [iter, inserted] = root.links_.emplace(name, Link{next_index_, type, false, 0, 0, {}});
+  if (!inserted) {
+    reject("link add", name, "File exists");
+    return nullptr;
+  }
+  ++next_index_;
+  return &iter->second;
+}
+
+/**
+ * @brief 删除网卡以及挂在它上面的表项，veth 的另一端一起删除（调用者持有锁）
+ *
+ * @param netns 网卡所在网络空间
+ * @param name 网卡名称
+ */
+auto NetlinkMemory::destroyLink(Netns &netns, std::string_view name) -> void {
+  auto iter = netns.links_.find(name);
+  if (iter == netns.links_.end()) {
+    return;
+  }
+  auto index = iter->second.index_;
+  auto peer = iter->second.type_ == LinkType::veth ? iter->second.peer_ : 0;
+  netns.links_.erase(iter);
+  detachLink(netns, index);
+
+  if (peer != 0) {
+    auto [peer_netns, peer_name] = findIndex(peer);
+    if (peer_netns != nullptr) {
+      destroyLink(*peer_netns, peer_name);
+    }
+  }
+}
+
+/**
+ * @brief 网卡离开网络空间：删除经过它的路由、ARP 缓存、FDB 表项，插在它上面的网卡被拔出
+ *
+ * @param netns 网卡所在网络空间
+ * @param index 网卡 ifindex
+ */
+auto NetlinkMemory::detachLink(Netns &netns, uint32_t index) -> void {
+  flushRoutes(netns, index);
+  for (auto iter = netns.neighs_.begin(); iter != netns.neighs_.end();) {
+    iter = iter->first.second == index ? netns.neighs_.erase(iter) : std::next(iter);
+  }
+  for (auto iter = netns.fdbs_.begin(); iter != netns.fdbs_.end();) {
+    iter = iter->first.second == index ? netns.fdbs_.erase(iter) : std::next(iter);
+  }
+  for (auto &[name, link] : netns.links_) {
+    if (link.master_ == index) {
+      link.master_ = 0;
+    }
+  }
+}
+
+/**
+ * @brief 删除经过指定网卡的路由
+ *
+ * @param netns 网卡所在网络空间
+ * @param index 网卡 ifindex
+ */
+auto NetlinkMemory::flushRoutes(Netns &netns, uint32_t index) -> void {
+  for (auto iter = netns.routes_.begin(); iter != netns.routes_.end();) {
+    iter = iter->second.dev_ == index ? netns.routes_.erase(iter) : std::next(iter);
+  }
+}
+
+/**
+ * @brief 判断网卡名称是否合法：不超过 15 个字符，不含 '/'、':' 与空白字符
+ *
+ * @param name 网卡名称
+ * @return true 合法
+ * @return false 非法
+ */
+auto NetlinkMemory::isValidName(std::string_view name) noexcept -> bool {
+  return !name.empty() && name.size() <= LINK_NAME_MAX && name != "." && name != ".." &&
+         std::none_of(name.begin(), name.end(), [](char ch) {
+           return ch == '/' || ch == ':' || std::isspace(static_cast<unsigned char>(ch)) != 0;
+         });
+}
+
+/**
+ * @brief 判断 MAC 地址格式是否合法（xx:xx:xx:xx:xx:xx）
+ *
+ * @param mac MAC 地址
+ * @return true 合法
+ * @return false 非法
+ */
+auto NetlinkMemory::isValidMac(std::string_view mac) noexcept -> bool {
+  constexpr size_t MAC_LENGTH{17};
+  if (mac.size() != MAC_LENGTH) {
+    return false;
+  }
+  for (size_t i = 0; i < mac.size(); ++i) {
+    auto ch = static_cast<unsigned char>(mac[i]);
+    if (i % 3 == 2 ? ch != ':' : std::isxdigit(ch) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief 路由表的 key：目的网段，为空时按下一跳的地址族换成默认路由，不带前缀长度时为主机路由
+ *
+ * @param dst 目的网段（可以为空）
+ * @param via 下一跳地址
+ * @return std::string key
+ */
+auto NetlinkMemory::routeKey(std::string_view dst, std::string_view via) -> std::string {
+  if (dst.empty()) {
+    return via.find(':') == std::string_view::npos ? "0.0.0.0/0" : "::/0";
+  }
+  if (dst.find('/') != std::string_view::npos) {
+    return std::string{dst};
+  }
+  return fmt::format("{}/{}", dst, dst.find(':') == std::string_view::npos ? 32 : 128);
+}
+
+/**
+ * @brief 记录一次被拒绝的操作，错误信息与内核返回的一致
+ *
+ * @param op 操作
+ * @param target 操作对象
+ * @param reason 错误信息
+ * @return false 始终返回 false
+ */
+auto NetlinkMemory::reject(std::string_view op, std::string_view target,
+                           std::string_view reason) const -> bool {
+  OHNO_LOG(debug, "Netlink model rejects {} {}: {}", op, target, reason);
+  return false;
+}
+
+} // namespace net
+} // namespace ohno
@@ -0,0 +1,128 @@
+#pragma once
+
+// clang-format off
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "netlink_if.h"
+#include "src/log/logger.h"
+#include "src/net/ip.h"
+// clang-format on
+
+namespace ohno {
+namespace net {
+
+constexpr size_t LINK_NAME_MAX{15}; // IFNAMSIZ - 1
+constexpr std::string_view NAME_LOOPBACK{"lo"};
+
+/**
+ * @brief 内存中的内核网络模型，代替 ip 命令实现 NetlinkIf，测试与基准测试不需要 root 权限
+ *
+ * 与内核一致地维护网络空间、网卡、地址、路由、ARP 缓存与 FDB 表项：重复添加、删除不存在的表项、
+ * 操作不存在的网卡都会失败；删除网卡或者移入其他网络空间时，挂在它上面的表项一起清理；
+ * 删除 veth 任意一端，另一端一起删除；所有操作由一把锁串行化，相当于内核的 rtnl_lock
+ *
+ * @note 网络空间由容器运行时创建，所以额外提供 netnsAdd() / netnsDel()；
+ * 空字符串表示 root 网络空间，始终存在
+ */
+class NetlinkMemory final : public NetlinkIf, public log::Loggable<log::Id::net> {
+public:
+  NetlinkMemory();
+
+  auto netnsAdd(std::string_view netns) -> bool;
+  auto netnsDel(std::string_view netns) -> bool;
+  auto netnsExist(std::string_view netns) const -> bool;
+  auto routeCount(std::string_view netns = {}) const -> size_t;
+  auto neighCount(std::string_view netns = {}) const -> size_t;
+  auto fdbCount(std::string_view netns = {}) const -> size_t;
+  auto getCalls() const noexcept -> uint64_t;
+
+  auto linkDestory(std::string_view name, std::string_view netns = {}) -> bool override;
+  auto linkExist(std::string_view name, std::string_view netns = {}) -> bool override;
+  auto linkList(std::string_view prefix, std::string_view netns = {})
+      -> std::vector<std::string> override;
+  auto linkGetMaster(std::string_view name, std::string_view netns = {})
+      -> std::string override;
+  auto linkGetMac(std::string_view name, std::string_view netns = {}) -> std::string override;
+  auto linkSetStatus(std::string_view name, LinkStatus status, std::string_view netns = {})
+      -> bool override;
+  auto linkIsInNetns(std::string_view name, std::string_view netns) -> bool override;
+  auto linkToNetns(std::string_view name, std::string_view netns) -> bool override;
+  auto linkRename(std::string_view name, std::string_view new_name, std::string_view netns = {})
+      -> bool override;
+  auto vethCreate(std::string_view name1, std::string_view name2) -> bool override;
+  auto bridgeCreate(std::string_view name) -> bool override;
+  auto vxlanCreate(std::string_view name, std::string_view underlay_addr,
+                   std::string_view underlay_dev) -> bool override;
+  auto vrfCreate(std::string_view name, uint32_t table) -> bool override;
+  auto bridgeSetStatus(std::string_view name, bool master, std::string_view bridge,
+                       BridgeAddrGenMode mode, std::string_view netns = {}) -> bool override;
+  auto vxlanSetSlave(std::string_view name, bool neigh_suppress, bool learning,
+                     std::string_view netns = {}) -> bool override;
+  auto addressIsExist(std::string_view name, std::string_view addr, std::string_view netns = {})
+      -> bool override;
+  auto addressSetEntry(std::string_view name, std::string_view addr, bool add,
+                       std::string_view netns = {}) -> bool override;
+  auto routeIsExist(std::string_view dst, std::string_view via, std::string_view dev = {},
+                    std::string_view netns = {}) const -> bool override;
+  auto routeSetEntry(std::string_view dst, std::string_view via, bool add,
+                     std::string_view dev = {}, std::string_view netns = {},
+                     RouteNHFlags nhflags = RouteNHFlags::NONE) const -> bool override;
+  auto neighIsExist(std::string_view addr, std::string_view dev = {},
+                    std::string_view netns = {}) const -> bool override;
+  auto neighSetEntry(std::string_view addr, std::string_view mac, bool add,
+                     std::string_view dev = {}, std::string_view netns = {}) const -> bool override;
+  auto fdbIsExist(std::string_view mac, std::string_view underlay_addr, std::string_view dev,
+                  std::string_view netns = {}) const -> bool override;
+  auto fdbSetEntry(std::string_view mac, std::string_view underlay_addr, std::string_view dev,
+                   bool add, std::string_view netns = {}) const -> bool override;
+
+private:
+  enum class LinkType : uint8_t { loopback, veth, bridge, vxlan, vrf };
+
+  struct Link {
+    uint32_t index_{0}; // ifindex，全局唯一；表项通过它引用网卡，网卡改名不影响表项
+    LinkType type_{LinkType::loopback};
+    bool up_{false};
+    uint32_t master_{0}; // 所在 bridge 的 ifindex，0 表示没有插入 bridge
+    uint32_t peer_{0};   // veth 对端的 ifindex
+    std::vector<IpPrefix> addrs_;
+  };
+
+  struct Route {
+    std::string via_;
+    uint32_t dev_{0};
+  };
+
+  struct Netns {
+    std::map<std::string, Link, std::less<>> links_;
+    std::map<std::string, Route> routes_;                            // key 为目的网段
+    std::map<std::pair<std::string, uint32_t>, std::string> neighs_; // (地址, 网卡) -> MAC
+    std::map<std::pair<std::string, uint32_t>, std::string> fdbs_;   // (MAC, 网卡) -> 远端地址
+  };
+
+  auto findNetns(std::string_view netns) const -> Netns *;
+  auto findLink(std::string_view name, std::string_view netns) const -> Link *;
+  auto findIndex(uint32_t index) const -> std::pair<Netns *, std::string>;
+  auto createLink(std::string_view name, LinkType type) -> Link *;
+  auto destroyLink(Netns &netns, std::string_view name) -> void;
+  static auto detachLink(Netns &netns, uint32_t index) -> void;
+  static auto flushRoutes(Netns &netns, uint32_t index) -> void;
+  static auto isValidName(std::string_view name) noexcept -> bool;
+  static auto isValidMac(std::string_view mac) noexcept -> bool;
+  static auto routeKey(std::string_view dst, std::string_view via) -> std::string;
+  auto reject(std::string_view op, std::string_view target, std::string_view reason) const
+      -> bool;
+
+  mutable std::mutex mutex_;
+  mutable std::map<std::string, Netns, std::less<>> netns_; // key 为空表示 root 网络空间
+  uint32_t next_index_{1};
+  mutable std::atomic<uint64_t> calls_{0};
+};
+
+} // namespace net
+} // namespace ohno
@@ -1,6 +1,7 @@
 // clang-format off
 #include "nic.h"
 #include "spdlog/fmt/fmt.h"
+#include "route.h"
 #include "src/common/assert.h"
 // clang-format on
 
@@ -237,6 +238,20 @@ auto Nic::getAddr(std::string_view cidr) const -> const AddrIf * {
   return nullptr;
 }
 
+/**
+ * @brief 获取所有 IP 地址对象（双栈网卡同时有 IPv4 与 IPv6 地址）
+ *
+ * @return std::vector<const AddrIf *> IP 地址对象
+ */
+auto Nic::getAllAddrs() const -> std::vector<const AddrIf *> {
+  std::vector<const AddrIf *> addrs{};
+  addrs.reserve(addrs_.size());
+  for (const auto &addr : addrs_) {
+    addrs.emplace_back(addr.get());
+  }
+  return addrs;
+}
+
 /**
  * @brief 向网络接口中添加一条路由，该路由写入系统配置中
  *
@@ -283,12 +298,9 @@ auto Nic::delRoute(std::string_view dst, std::string_view via, std::string_view
       if (!ntl->routeSetEntry(dst, via, false, dev, netns)) {
         return false;
       }
+      const Route target{dst, via, dev};
       routes_.erase(std::remove_if(routes_.begin(), routes_.end(),
-                                   [dst, via, dev](const auto &route) {
-                                     return route->getDest() == std::string{dst} &&
-                                            route->getVia() == std::string{via} &&
-                                            route->getDev() == std::string{dev};
-                                   }),
+                                   [&target](const auto &route) { return target.isSame(*route); }),
                     routes_.end());
     }
     return true;
@@ -311,10 +323,9 @@ auto Nic::getRoute(std::string_view dst, std::string_view via, std::string_view
   OHNO_ASSERT(!via.empty());
   OHNO_ASSERT(!dev.empty());
 
-  auto iter = std::find_if(routes_.begin(), routes_.end(), [dst, via, dev](const auto &route) {
-    return route->getDest() == dst.data() && route->getVia() == via.data() &&
-           route->getDev() == dev.data();
-  });
+  const Route target{dst, via, dev};
+  auto iter = std::find_if(routes_.begin(), routes_.end(),
+                           [&target](const auto &route) { return target.isSame(*route); });
   if (iter != routes_.end()) {
     return iter->get();
   }
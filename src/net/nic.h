@@ -24,6 +24,7 @@ public:
   auto addAddr(std::unique_ptr<AddrIf> addr) -> bool override;
   auto delAddr(std::string_view cidr) -> bool override;
   auto getAddr(std::string_view cidr = {}) const -> const AddrIf * override;
+  auto getAllAddrs() const -> std::vector<const AddrIf *> override;
   auto addRoute(std::unique_ptr<RouteIf> route, NetlinkIf::RouteNHFlags nhflags) -> bool override;
   auto delRoute(std::string_view dst, std::string_view via, std::string_view dev) -> bool override;
   auto getRoute(std::string_view dst, std::string_view via, std::string_view dev) const
@@ -4,6 +4,7 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
 #include "macro.h"
 #include "addr_if.h"
 #include "fdb_if.h"
@@ -31,6 +32,7 @@ public:
   virtual auto addAddr(std::unique_ptr<AddrIf> addr) -> bool = 0;
   virtual auto delAddr(std::string_view cidr) -> bool = 0;
   virtual auto getAddr(std::string_view cidr = {}) const -> const AddrIf * = 0;
+  virtual auto getAllAddrs() const -> std::vector<const AddrIf *> = 0;
   virtual auto addRoute(std::unique_ptr<RouteIf> route, NetlinkIf::RouteNHFlags nhflags)
       -> bool = 0;
   virtual auto delRoute(std::string_view dst, std::string_view via, std::string_view dev)
@@ -5,14 +5,47 @@
 namespace ohno {
 namespace net {
 
-Route::Route(std::string_view dest, std::string_view via, std::string_view dev)
-    : dest_{dest}, via_{via}, dev_{dev} {}
+Route::Route(std::string_view dest, std::string_view via, std::string_view dev) : dev_{dev} {
+  if (!dest.empty()) {
+    dest_ = IpPrefix::parse(dest);
+    if (!dest_.has_value()) {
+      // 不带前缀的目的地址视为主机路由
+      auto addr = IpAddr::parse(dest);
+      if (addr.has_value()) {
+        dest_ = IpPrefix{addr.value(), addr->maxPrefix()};
+      } else {
+        OHNO_LOG(warn, "Route destination \"{}\" is invalid", dest);
+      }
+    }
+  }
+  if (!via.empty()) {
+    via_ = IpAddr::parse(via);
+    if (!via_.has_value()) {
+      OHNO_LOG(warn, "Route via \"{}\" is invalid", via);
+    }
+  }
+}
 
-auto Route::getDest() const -> std::string { return dest_; }
+auto Route::getDest() const -> std::string { return dest_.has_value() ? dest_->toString() : ""; }
 
-auto Route::getVia() const -> std::string { return via_; }
+auto Route::getVia() const -> std::string { return via_.has_value() ? via_->toString() : ""; }
 
 auto Route::getDev() const -> std::string { return dev_; }
 
+auto Route::getDestPrefix() const noexcept -> std::optional<IpPrefix> { return dest_; }
+
+auto Route::getViaAddr() const noexcept -> std::optional<IpAddr> { return via_; }
+
+/**
+ * @brief 以整数形式比较两条路由是否相同，避免格式化字符串
+ *
+ * @param other 另一条路由
+ * @return true 相同
+ * @return false 不同
+ */
+auto Route::isSame(const RouteIf &other) const -> bool {
+  return dest_ == other.getDestPrefix() && via_ == other.getViaAddr() && dev_ == other.getDev();
+}
+
 } // namespace net
 } // namespace ohno
@@ -15,9 +15,13 @@ public:
   auto getDest() const -> std::string override;
   auto getVia() const -> std::string override;
   auto getDev() const -> std::string override;
+  auto getDestPrefix() const noexcept -> std::optional<IpPrefix> override;
+  auto getViaAddr() const noexcept -> std::optional<IpAddr> override;
 
-  std::string dest_;
-  std::string via_;
+  auto isSame(const RouteIf &other) const -> bool;
+
+  std::optional<IpPrefix> dest_; // 为空表示默认路由
+  std::optional<IpAddr> via_;    // 为空表示没有下一跳
   std::string dev_;
 };
 
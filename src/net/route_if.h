@@ -1,7 +1,9 @@
 #pragma once
 
 // clang-format off
+#include <optional>
 #include <string>
+#include "ip.h"
 #include "macro.h"
 // clang-format on
 
@@ -14,6 +16,8 @@ public:
   virtual auto getDest() const -> std::string = 0;
   virtual auto getVia() const -> std::string = 0;
   virtual auto getDev() const -> std::string = 0;
+  virtual auto getDestPrefix() const noexcept -> std::optional<IpPrefix> = 0;
+  virtual auto getViaAddr() const noexcept -> std::optional<IpAddr> = 0;
 };
 
 } // namespace net
@@ -1,7 +1,7 @@
 // clang-format off
 #include "subnet.h"
-#include <regex>
 #include "src/common/assert.h"
+#include "src/common/enum_name.hpp"
 #include "src/common/except.h"
 // clang-format on
 
@@ -14,30 +14,18 @@ namespace net {
  * @param cidr CIDR 字符串
  */
 auto Subnet::init(std::string_view cidr) -> void {
-  // TODO: 将 Boost 方法调用过程从构造函数中移除出去
-
   OHNO_ASSERT(!cidr.empty());
 
-  const std::regex IPv4_RE(IPv4_REGEX.data());
-  const std::regex IPv6_RE(IPv6_REGEX.data());
-
-  std::string cidr_str{cidr};
-  if (std::regex_match(cidr_str, IPv4_RE)) {
-    // IPv4 解析
-    ipversion_ = IpVersion::IPv4;
-    subnet_v4_ = boost::asio::ip::make_network_v4(cidr_str);
-    OHNO_LOG(trace, "Subnet ctor cidr {} belongs to IPv4, with subnet {}", cidr,
-             subnet_v4_.to_string());
-  } else if (std::regex_match(cidr_str, IPv6_RE)) {
-    // IPv6 解析
-    ipversion_ = IpVersion::IPv6;
-    subnet_v6_ = boost::asio::ip::make_network_v6(cidr_str);
-    OHNO_LOG(trace, "Subnet ctor cidr {} belongs to IPv6, with subnet {}", cidr,
-             subnet_v6_.to_string());
-  } else {
+  auto prefix = IpPrefix::parse(cidr);
+  if (!prefix.has_value()) {
     ipversion_ = IpVersion::RESERVED;
     throw OHNO_EXCEPT("Invalid CIDR format", false);
   }
+
+  subnet_ = prefix.value();
+  ipversion_ = subnet_.version();
+  OHNO_LOG(trace, "Subnet ctor cidr {} belongs to {}, with subnet {}", cidr, enumName(ipversion_),
+           subnet_.toString());
 }
 
 /**
@@ -45,35 +33,21 @@ auto Subnet::init(std::string_view cidr) -> void {
  *
  * @return std::string 子网地址字符串
  */
-auto Subnet::getSubnet() const -> std::string {
-  checkIpv6();
-  return subnet_v4_.to_string();
-}
+auto Subnet::getSubnet() const -> std::string { return subnet_.toString(); }
 
 /**
  * @brief 获取子网前缀
  *
  * @return Prefix 子网前缀
  */
-auto Subnet::getPrefix() const -> Prefix {
-  checkIpv6();
-  return subnet_v4_.prefix_length();
-}
+auto Subnet::getPrefix() const -> Prefix { return subnet_.length(); }
 
 /**
  * @brief 提取不带前缀的子网地址
  *
  * @return std::string 子网地址
  */
-auto Subnet::extractAddr() const -> std::string {
-  checkIpv6();
-  auto cidr = getSubnet();
-  size_t slash_pos = cidr.find('/');
-  if (slash_pos != std::string::npos) {
-    return cidr.substr(0, slash_pos);
-  }
-  return cidr;
-}
+auto Subnet::extractAddr() const -> std::string { return subnet_.addr().toString(); }
 
 /**
  * @brief 从当前子网中生成一个 IP 地址，出错抛出 ohno::except::Exception
@@ -82,13 +56,13 @@ auto Subnet::extractAddr() const -> std::string {
  * @return std::string 新的 IP 地址（CIDR 格式）
  */
 auto Subnet::generateIp(Prefix index) -> std::string {
-  checkIpv6();
-  return fmt::format("{}/{}", Subnet::generateIpImpl(subnet_v4_, index).to_string(),
-                     subnet_v4_.prefix_length());
+  return IpPrefix{Subnet::generateIpImpl(subnet_, index), subnet_.length()}.toString();
 }
 
 /**
- * @brief 判断当前子网是否是给定 CIDR 子网的子网
+ * @brief 判断当前子网是否是给定 CIDR 子网的真子网
+ *
+ * @note 与 boost::asio::ip::network_v4::is_subnet_of 一致，两个子网相同时返回 false
  *
  * @param cidr 指定一个 CIDR 子网
  * @return true 是
@@ -97,16 +71,27 @@ auto Subnet::generateIp(Prefix index) -> std::string {
 auto Subnet::isSubnetOf(std::string_view cidr) const -> bool {
   Subnet other{};
   other.init(cidr);
-  checkIpv6();
-  return subnet_v4_.is_subnet_of(other.subnet_v4_);
+  return other.subnet_.contains(subnet_) && !(other.subnet_ == subnet_);
 }
 
 /**
  * @brief 获取当前子网最大主机数，出错抛出 ohno::except::Exception
  *
+ * @note IPv6 子网（比如 /64）主机数无法用 Prefix 表示，此时抛出异常，应改用
+ * getNetwork().hostBits()
+ *
  * @return Prefix 最大主机数
  */
-auto Subnet::getMaxHosts() const -> Prefix { return getMaxSubnetsFromCidr(MAX_PREFIX_IPV4); }
+auto Subnet::getMaxHosts() const -> Prefix {
+  return getMaxSubnetsFromCidr(subnet_.addr().maxPrefix());
+}
+
+/**
+ * @brief 获取整数形式的子网，供需要批量计算地址的调用方使用，避免反复解析字符串
+ *
+ * @return IpPrefix 子网
+ */
+auto Subnet::getNetwork() const -> IpPrefix { return subnet_; }
 
 /**
  * @brief 根据 CIDR 网段前缀计算最大子网数，出错抛出 ohno::except::Exception
@@ -115,23 +100,17 @@ auto Subnet::getMaxHosts() const -> Prefix { return getMaxSubnetsFromCidr(MAX_PR
  * @return Prefix 最大子网数
  */
 auto Subnet::getMaxSubnetsFromCidr(Prefix new_prefix) const -> Prefix {
-  checkIpv6();
-  if (new_prefix <= subnet_v4_.prefix_length()) {
+  if (new_prefix <= subnet_.length()) {
     throw OHNO_EXCEPT(fmt::format("New prefix({}) must be larger than current prefix({})",
-                                  new_prefix, subnet_v4_.prefix_length()),
+                                  new_prefix, subnet_.length()),
                       false);
   }
-  return 1 << (new_prefix - subnet_v4_.prefix_length());
-}
-
-/**
- * @brief 暂时不支持 IPv6，所以对于 IPv6 地址抛出 ohno::except::Exception
- *
- */
-auto Subnet::checkIpv6() const -> void {
-  if (ipversion_ == IpVersion::IPv6) {
-    throw OHNO_EXCEPT("IPv6 not supported yet", false);
+  if (new_prefix - subnet_.length() >= sizeof(Prefix) * 8) {
+    throw OHNO_EXCEPT(fmt::format("Too many subnets between prefix({}) and prefix({})",
+                                  subnet_.length(), new_prefix),
+                      false);
   }
+  return static_cast<Prefix>(1) << (new_prefix - subnet_.length());
 }
 
 /**
@@ -139,23 +118,19 @@ auto Subnet::checkIpv6() const -> void {
  *
  * @param base_net 基础子网
  * @param index 生成 IP 的依据
- * @return boost::asio::ip::address_v4 对象
+ * @return IpAddr 对象
  */
-auto Subnet::generateIpImpl(const boost::asio::ip::network_v4 &base_net, Prefix index)
-    -> boost::asio::ip::address_v4 {
+auto Subnet::generateIpImpl(const IpPrefix &base_net, Prefix index) -> IpAddr {
   if (index < 1) {
     throw OHNO_EXCEPT("Index out of range", false);
   }
 
-  auto prefix = base_net.prefix_length();
-  auto base_ip = base_net.address();
-
   // 检查是否单个地址 (前缀长度等于总位数)
-  if (static_cast<Prefix>(prefix) == MAX_PREFIX_IPV4) {
-    return base_ip;
+  if (base_net.hostBits() == 0) {
+    return base_net.addr();
   }
 
-  return boost::asio::ip::address_v4(base_ip.to_uint() + index);
+  return base_net.addr().advance(index);
 }
 
 } // namespace net
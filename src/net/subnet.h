@@ -1,9 +1,8 @@
 #pragma once
 
 // clang-format off
-#include <boost/asio/ip/network_v4.hpp>
-#include <boost/asio/ip/network_v6.hpp>
 #include "subnet_if.h"
+#include "ip.h"
 #include "src/log/logger.h"
 // clang-format on
 
@@ -20,19 +19,15 @@ public:
   auto isSubnetOf(std::string_view cidr) const -> bool override;
 
   auto getMaxHosts() const -> Prefix;
+  auto getNetwork() const -> IpPrefix;
 
 private:
   auto getMaxSubnetsFromCidr(Prefix new_prefix) const -> Prefix;
 
-  // TODO: IPv6 支持
+  static auto generateIpImpl(const IpPrefix &base_net, Prefix index) -> IpAddr;
 
-  auto checkIpv6() const -> void;
-  static auto generateIpImpl(const boost::asio::ip::network_v4 &base_net, Prefix index)
-      -> boost::asio::ip::address_v4;
-
-  boost::asio::ip::network_v4 subnet_v4_;
-  boost::asio::ip::network_v6 subnet_v6_;
-  IpVersion ipversion_;
+  IpPrefix subnet_;
+  IpVersion ipversion_{IpVersion::RESERVED};
 };
 
 } // namespace net
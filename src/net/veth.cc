@@ -1,6 +1,7 @@
 // clang-format off
 #include "nic.h"
 #include "veth.h"
+#include "veth_pool.h"
 // clang-format on
 
 namespace ohno {
@@ -30,6 +31,25 @@ auto Veth::setup(std::weak_ptr<NetlinkIf> netlink) -> bool {
   return false;
 }
 
+/**
+ * @brief 从 ohnod 维护的 veth pair 池中领取一对，代替 setup() 创建
+ *
+ * @note 领取到的 veth 对端已经插入 bridge，两端都处于 down 状态
+ *
+ * @param netlink Netlink 对象
+ * @param bridge 节点 Linux bridge 名称
+ * @return true 领取成功
+ * @return false 池为空（或 ohnod 没有运行），需要调用 setup() 创建
+ */
+auto Veth::claim(std::weak_ptr<NetlinkIf> netlink, std::string_view bridge) -> bool {
+  Nic::setup(netlink);
+
+  if (auto ntl = Nic::netlink_.lock()) {
+    return VethPool::claim(*ntl, Nic::getName(), getPeerName(), bridge);
+  }
+  return false;
+}
+
 /**
  * @brief 启用 / 禁用网卡
  *
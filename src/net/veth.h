@@ -12,6 +12,7 @@ public:
   explicit Veth(std::string_view peer_name);
 
   auto setup(std::weak_ptr<NetlinkIf> netlink) -> bool override;
+  auto claim(std::weak_ptr<NetlinkIf> netlink, std::string_view bridge) -> bool;
   auto setStatus(LinkStatus status) -> bool override;
   auto getPeerName() const -> std::string;
 
@@ -0,0 +1,265 @@
+// clang-format off
+#include "veth_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "spdlog/fmt/fmt.h"
+#include "src/common/assert.h"
+#include "src/common/except.h"
+// clang-format on
+
+namespace ohno {
+namespace net {
+
+VethPool::VethPool(std::weak_ptr<NetlinkIf> netlink, std::string_view bridge,
+                   std::chrono::seconds orphan_grace)
+    : netlink_{std::move(netlink)}, bridge_{bridge}, orphan_grace_{orphan_grace} {
+  OHNO_ASSERT(!bridge_.empty());
+}
+
+VethPool::~VethPool() { stop(); }
+
+/**
+ * @brief 启动补充线程，每个周期把池补充到目标大小
+ *
+ */
+auto VethPool::start() -> void {
+  if (running_) {
+    return;
+  }
+  running_ = true;
+
+  filler_ = std::thread{[this]() {
+    try {
+      pthread_setname_np(pthread_self(), "vethpool");
+      std::unique_lock<std::mutex> lock{mutex_};
+      while (running_) {
+        lock.unlock();
+        refill();
+        lock.lock();
+        cond_.wait_for(lock, VETH_POOL_INTERVAL, [this]() { return !running_; });
+      }
+    } catch (const ohno::except::Exception &exc) {
+      std::cerr << "[error] Ohnod veth pool thread terminated!" << exc.getMsg() << "\n";
+    } catch (const std::exception &exc) {
+      std::cerr << "[error] Ohnod veth pool thread terminated!" << exc.what() << "\n";
+    }
+  }};
+}
+
+/**
+ * @brief 停止补充线程（池中的 veth pair 保留，ohnod 重启之后继续使用）
+ *
+ */
+auto VethPool::stop() -> void {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    running_ = false;
+  }
+  cond_.notify_all();
+  if (filler_.joinable()) {
+    filler_.join();
+  }
+}
+
+/**
+ * @brief 统计池中剩余的 veth pair，更新 ADD 速率，然后补充到目标大小
+ *
+ * @note orphans_ 只在这里访问，refill() 不能并发调用
+ *
+ * @return size_t 补充之后池中的数量
+ */
+auto VethPool::refill() -> size_t {
+  auto ntl = netlink_.lock();
+  if (!ntl) {
+    return 0;
+  }
+
+  bool bridge_ready = false;
+  std::vector<std::string> pool{};
+  std::vector<bool> used(VETH_POOL_MAX, false);
+  std::vector<bool> paired(VETH_POOL_MAX, false); // 槽位上还有 Pod 一端
+  std::vector<size_t> peers{};
+  for (const auto &name : ntl->linkList({})) {
+    if (name == bridge_) {
+      bridge_ready = true;
+    } else if (auto slot = getSlot(name, VETH_POOL_PREFIX)) {
+      pool.emplace_back(name);
+      used[*slot] = true;
+      paired[*slot] = true;
+    } else if (auto slot = getSlot(name, VETH_POOL_PEER_PREFIX)) {
+      used[*slot] = true; // 已被领取但还没改名，或者领取它的 CNI 进程中途退出
+      peers.emplace_back(*slot);
+    } else if (auto slot = getSlot(name, VETH_POOL_STAGE_PREFIX)) {
+      ntl->linkDestory(name); // 上一个 ohnod 在插入 bridge 之前退出，下个周期重新创建
+      paired[*slot] = true;
+    }
+  }
+  reapOrphans(*ntl, peers, paired);
+
+  // bridge 由第一个 Pod 的 CNI ADD 创建，在此之前没有地方可以插入；节点网络设施被回收之后，
+  // 池中剩下的 veth 也没有插在新的 bridge 上
+  if (!bridge_ready) {
+    for (const auto &name : pool) {
+      ntl->linkDestory(name);
+    }
+    std::lock_guard<std::mutex> lock{mutex_};
+    last_free_ = 0;
+    return 0;
+  }
+
+  auto free = pool.size();
+  size_t target = 0;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto claimed = last_free_ > free ? last_free_ - free : 0;
+    rate_ = VETH_POOL_ALPHA * static_cast<double>(claimed) + (1 - VETH_POOL_ALPHA) * rate_;
+    target_ = std::clamp(static_cast<size_t>(std::ceil(rate_ * VETH_POOL_LOOKAHEAD)),
+                         VETH_POOL_MIN, VETH_POOL_MAX);
+    target = target_;
+  }
+
+  for (size_t slot = 0; slot < VETH_POOL_MAX && free < target; ++slot) {
+    if (!used[slot] && create(*ntl, slot)) {
+      ++free;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  last_free_ = free;
+  return free;
+}
+
+/**
+ * @brief 获取池的目标大小
+ *
+ * @return size_t 目标大小
+ */
+auto VethPool::getTarget() const -> size_t {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return target_;
+}
+
+/**
+ * @brief 从池中领取一对 veth（CNI ADD 调用）
+ *
+ * @note 补充线程在 bridge 被回收之前列出网卡、之后才插入的 veth 不在任何 bridge 上（或者 bridge
+ * 已被重新创建），所以领取之后确认宿主机一端所在的 bridge，不对就丢弃这一对
+ *
+ * @param name Pod 一端的新名称（临时名称，移入 netns 之后再改成最终名称）
+ * @param peer_name 宿主机一端的新名称
+ * @param bridge 节点 Linux bridge 名称
+ * @return true 领取成功，宿主机一端已经插入 bridge，两端都处于 down 状态
+ * @return false 池为空，调用者需要自己创建 veth pair
+ */
+auto VethPool::claim(NetlinkIf &netlink, std::string_view name, std::string_view peer_name,
+                     std::string_view bridge) -> bool {
+  OHNO_ASSERT(!name.empty());
+  OHNO_ASSERT(!peer_name.empty());
+  OHNO_ASSERT(!bridge.empty());
+
+  auto names = netlink.linkList(VETH_POOL_PREFIX);
+  if (names.empty()) {
+    return false;
+  }
+
+  // 从随机位置开始尝试，减少并发的 CNI 进程争抢同一对
+  auto offset = std::random_device{}() % names.size();
+  for (size_t i = 0; i < names.size(); ++i) {
+    const auto &pool_name = names[(offset + i) % names.size()];
+    auto slot = getSlot(pool_name, VETH_POOL_PREFIX);
+    if (!slot || !netlink.linkRename(pool_name, name)) {
+      continue; // 已被其他 CNI 进程领取
+    }
+    if (netlink.linkRename(fmt::format("{}{}", VETH_POOL_PEER_PREFIX, *slot), peer_name) &&
+        netlink.linkGetMaster(peer_name) == bridge) {
+      return true;
+    }
+    netlink.linkDestory(name); // 宿主机一端异常或者不在 bridge 上，丢弃这一对
+  }
+  return false;
+}
+
+/**
+ * @brief 解析池中网卡名称的槽位号
+ *
+ * @param name 网卡名称
+ * @param prefix 名称前缀
+ * @return std::optional<size_t> 槽位号，名称不属于该前缀或者槽位越界时为空
+ */
+auto VethPool::getSlot(std::string_view name, std::string_view prefix) -> std::optional<size_t> {
+  if (name.size() <= prefix.size() || name.substr(0, prefix.size()) != prefix) {
+    return std::nullopt;
+  }
+
+  size_t slot = 0;
+  for (auto chr : name.substr(prefix.size())) {
+    if (chr < '0' || chr > '9') {
+      return std::nullopt;
+    }
+    slot = slot * 10 + static_cast<size_t>(chr - '0');
+    if (slot >= VETH_POOL_MAX) {
+      return std::nullopt;
+    }
+  }
+  return slot;
+}
+
+/**
+ * @brief 在槽位上创建一对 veth：先用临时名称创建并插入 bridge，最后改名才对 CNI 可见
+ *
+ * @param netlink Netlink 对象
+ * @param slot 槽位号
+ * @return true 创建成功
+ * @return false 创建失败
+ */
+auto VethPool::create(NetlinkIf &netlink, size_t slot) const -> bool {
+  auto stage = fmt::format("{}{}", VETH_POOL_STAGE_PREFIX, slot);
+  auto peer = fmt::format("{}{}", VETH_POOL_PEER_PREFIX, slot);
+  if (!netlink.vethCreate(stage, peer)) {
+    return false;
+  }
+  if (!netlink.bridgeSetStatus(peer, true, bridge_, BridgeAddrGenMode::reserved) ||
+      !netlink.linkRename(stage, fmt::format("{}{}", VETH_POOL_PREFIX, slot))) {
+    netlink.linkDestory(stage);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief 回收失去 Pod 一端的宿主机一端：领取它的 CNI 进程在两次改名之间退出，宿主机一端一直
+ * 占着槽位，Pod 一端留着临时名称；超过宽限期仍然没有改名就删除（Pod 一端随之删除）
+ *
+ * @param netlink Netlink 对象
+ * @param peers 本周期列出的宿主机一端的槽位号
+ * @param paired 槽位上是否还有 Pod 一端
+ */
+auto VethPool::reapOrphans(NetlinkIf &netlink, const std::vector<size_t> &peers,
+                           const std::vector<bool> &paired) -> void {
+  auto now = std::chrono::steady_clock::now();
+  std::map<size_t, std::chrono::steady_clock::time_point> orphans{};
+  for (auto slot : peers) {
+    if (paired[slot]) {
+      continue;
+    }
+    auto iter = orphans_.find(slot);
+    if (iter == orphans_.end()) {
+      orphans.emplace(slot, now); // 可能正在领取，下个周期再判断
+      continue;
+    }
+    if (now - iter->second < orphan_grace_) {
+      orphans.emplace(*iter);
+      continue;
+    }
+    auto name = fmt::format("{}{}", VETH_POOL_PEER_PREFIX, slot);
+    OHNO_LOG(warn, "Reap orphaned veth {}, the CNI process claiming it may have exited", name);
+    netlink.linkDestory(name);
+  }
+  orphans_.swap(orphans);
+}
+
+} // namespace net
+} // namespace ohno
@@ -0,0 +1,81 @@
+#pragma once
+
+// clang-format off
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "src/log/logger.h"
+#include "src/net/netlink/netlink_if.h"
+// clang-format on
+
+namespace ohno {
+namespace net {
+
+constexpr std::string_view VETH_POOL_PREFIX{"ohnop_"};       // 已就绪的 Pod 一端
+constexpr std::string_view VETH_POOL_PEER_PREFIX{"ohnoq_"};  // 宿主机一端
+constexpr std::string_view VETH_POOL_STAGE_PREFIX{"ohnos_"}; // 尚未插入 bridge 的 Pod 一端
+constexpr size_t VETH_POOL_MIN{2};
+constexpr size_t VETH_POOL_MAX{32};
+constexpr size_t VETH_POOL_LOOKAHEAD{10}; // 按最近的 ADD 速率预留多少个周期的用量
+constexpr double VETH_POOL_ALPHA{0.2};    // ADD 速率 EWMA 的新样本权重
+constexpr std::chrono::seconds VETH_POOL_INTERVAL{1};
+constexpr std::chrono::seconds VETH_POOL_ORPHAN_GRACE{60}; // 宿主机一端失去 Pod 一端多久之后回收
+
+/**
+ * @brief 预创建的 veth pair 池，由 ohnod 维护，CNI ADD 直接领取
+ *
+ * 池中每一对 veth 都已经创建好（内核已分配 MAC）、宿主机一端已经插入 bridge，CNI ADD
+ * 只需要把 Pod 一端改名、移入 netns 并配置地址。两端都用槽位号命名，Pod 一端处于 down
+ * 状态，领取时改名是原子操作，多个 CNI 进程并发领取同一对时只有一个能成功，不需要额外加锁
+ *
+ * 池的大小按最近的 ADD 速率（每个周期被领取的数量的 EWMA）调整；领取时确认宿主机一端仍然
+ * 插在 bridge 上，补充与节点网络设施回收并发时插在已删除 bridge 上的 veth 不会交给 Pod
+ */
+class VethPool final : public log::Loggable<log::Id::net> {
+public:
+  VethPool(std::weak_ptr<NetlinkIf> netlink, std::string_view bridge,
+           std::chrono::seconds orphan_grace = VETH_POOL_ORPHAN_GRACE);
+  ~VethPool() override;
+  VethPool(const VethPool &) = delete;
+  VethPool(VethPool &&) = delete;
+  auto operator=(const VethPool &) -> VethPool & = delete;
+  auto operator=(VethPool &&) -> VethPool & = delete;
+
+  auto start() -> void;
+  auto stop() -> void;
+  auto refill() -> size_t;
+  auto getTarget() const -> size_t;
+
+  static auto claim(NetlinkIf &netlink, std::string_view name, std::string_view peer_name,
+                    std::string_view bridge) -> bool;
+
+private:
+  static auto getSlot(std::string_view name, std::string_view prefix) -> std::optional<size_t>;
+  auto create(NetlinkIf &netlink, size_t slot) const -> bool;
+  auto reapOrphans(NetlinkIf &netlink, const std::vector<size_t> &peers,
+                   const std::vector<bool> &paired) -> void;
+
+  std::weak_ptr<NetlinkIf> netlink_;
+  std::string bridge_;
+  std::chrono::seconds orphan_grace_;
+  std::map<size_t, std::chrono::steady_clock::time_point> orphans_; // 槽位 -> 第一次发现的时间
+  size_t last_free_{0}; // 上一个周期结束时池中的数量
+  double rate_{0};      // 每个周期被领取数量的 EWMA
+  size_t target_{VETH_POOL_MIN};
+
+  mutable std::mutex mutex_;
+  std::condition_variable cond_;
+  std::atomic<bool> running_{false};
+  std::thread filler_;
+};
+
+} // namespace net
+} // namespace ohno
@@ -14,6 +14,7 @@
 #include "src/backend/strategy_client.h"
 #include "src/common/except.h"
 #include "src/log/logger.h"
+#include "src/metrics/metrics_server.h"
 #include "src/net/netlink/netlink_ip_cmd.h"
 #include "src/util/env_std.h"
 #include "src/util/shell_sync.h"
@@ -26,6 +27,7 @@
 struct Config {
   ohno::backend::BackendInfo bkinfo_;
   ohno::log::Level log_level_;
+  std::string metrics_addr_; // 为空时不开启指标端点
 };
 
 static std::unique_ptr<ohno::backend::StrategyClient> g_client{};
@@ -70,6 +72,8 @@ auto printUsage(const char *programName) -> void {
   std::cout << "  --insecure         Disable SSL certificate verification" << "\n";
   std::cout << "  --interval SEC     Refresh interval in seconds (default: " << DEF_INTERVAL_SEC
             << ")" << "\n";
+  std::cout << "  --metrics ADDR     Metrics endpoint host:port, or \"off\" (default: "
+            << ohno::metrics::METRICS_ADDR_DEFAULT << ")" << "\n";
   std::cout << "  --help             Show this help message" << "\n";
 }
 
@@ -89,6 +93,7 @@ auto parseArguments(int argc, char *argv[]) -> Config {
   config.bkinfo_.api_server_ = "";
   config.bkinfo_.ssl_ = true;
   config.bkinfo_.refresh_interval_ = DEF_INTERVAL_SEC;
+  config.metrics_addr_ = ohno::metrics::METRICS_ADDR_DEFAULT;
 
   // 解析命令行参数
   for (int i = 1; i < argc; i++) {
@@ -103,6 +108,11 @@ auto parseArguments(int argc, char *argv[]) -> Config {
       config.bkinfo_.ssl_ = false;
     } else if (arg == "--interval" && i + 1 < argc) {
       config.bkinfo_.refresh_interval_ = std::stoi(argv[++i]);
+    } else if (arg == "--metrics" && i + 1 < argc) {
+      config.metrics_addr_ = argv[++i];
+      if (config.metrics_addr_ == "off") {
+        config.metrics_addr_.clear();
+      }
     } else if (arg == "--help") {
       printUsage(argv[0]);
       config.bkinfo_.api_server_.clear();
@@ -144,6 +154,8 @@ auto main(int argc, char **argv) -> int {
     OHNO_GLOBAL_LOG(info, "API Server:       {}", config.bkinfo_.api_server_);
     OHNO_GLOBAL_LOG(info, "SSL verification: {}", (config.bkinfo_.ssl_ ? "enabled" : "disabled"));
     OHNO_GLOBAL_LOG(info, "Refresh interval: {}", config.bkinfo_.refresh_interval_);
+    OHNO_GLOBAL_LOG(info, "Metrics endpoint: {}",
+                    (config.metrics_addr_.empty() ? "disabled" : config.metrics_addr_));
 
     std::string node_name{};
     auto shell = std::make_unique<util::ShellSync>();
@@ -152,8 +164,18 @@ auto main(int argc, char **argv) -> int {
       throw OHNO_EXCEPT("Failed to get current Kubernetes node name", false);
     }
 
+    // 指标端点启动失败不影响 daemon 运行
+    std::unique_ptr<metrics::MetricsServer> metrics_server{};
+    if (!config.metrics_addr_.empty()) {
+      metrics_server = std::make_unique<metrics::MetricsServer>(config.metrics_addr_);
+      if (!metrics_server->start()) {
+        OHNO_GLOBAL_LOG(warn, "Failed to start metrics endpoint on {}", config.metrics_addr_);
+      }
+    }
+
     // 启动 daemon
     auto netlink = std::make_shared<net::NetlinkIpCmd>(std::move(shell));
+    netlink->enableBatch(); // 后端每个周期都会下发大量路由、ARP、FDB 表项
     g_client = std::make_unique<backend::StrategyClient>();
     g_client->setBackendInfo(config.bkinfo_);
     g_client->setNetlink(netlink);
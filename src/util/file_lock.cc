@@ -0,0 +1,95 @@
+// clang-format off
+#include "file_lock.h"
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#include <cerrno>
+#include <filesystem>
+#include <system_error>
+#include "src/metrics/metrics.h"
+// clang-format on
+
+namespace ohno {
+namespace util {
+
+namespace {
+
+/**
+ * @brief 执行 flock，被信号打断时重试
+ *
+ * @param fd 文件描述符
+ * @param operation LOCK_EX、LOCK_UN 等
+ * @return int 0 成功，-1 失败（errno 为失败原因）
+ */
+auto flockRetry(int fd, int operation) -> int {
+  int ret{0};
+  do {
+    ret = ::flock(fd, operation);
+  } while (ret != 0 && errno == EINTR);
+  return ret;
+}
+
+} // namespace
+
+/**
+ * @brief 打开锁文件（不存在时连同目录一起创建）并加排他锁，阻塞直到其他进程释放
+ *
+ * @param path 锁文件路径
+ * @param name 锁的名称，作为指标的 lock 标签
+ */
+FileLock::FileLock(std::string_view path, std::string_view name) : path_{path}, name_{name} {
+  std::error_code code{};
+  std::filesystem::create_directories(std::filesystem::path{path_}.parent_path(), code);
+
+  fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (fd_ < 0) {
+    OHNO_LOG(warn, "Failed to open {} lock file {}", name_, path_);
+    return;
+  }
+  if (!lock()) {
+    OHNO_LOG(warn, "Failed to lock {} lock file {}", name_, path_);
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+FileLock::~FileLock() {
+  if (fd_ >= 0) {
+    flockRetry(fd_, LOCK_UN);
+    ::close(fd_);
+  }
+}
+
+/**
+ * @brief 是否已经持有锁
+ *
+ * @return true 已加锁
+ * @return false 加锁失败
+ */
+auto FileLock::isLocked() const noexcept -> bool { return fd_ >= 0; }
+
+/**
+ * @brief 阻塞加排他锁；先尝试非阻塞加锁，失败说明其他进程持有锁，记录争用次数与等待时间
+ *
+ * @return true 加锁成功
+ * @return false 加锁失败
+ */
+auto FileLock::lock() const -> bool {
+  auto &registry = metrics::Registry::instance();
+  metrics::Labels labels{{"lock", name_}};
+  registry.counter("ohno_lock_acquisitions_total", "File lock acquisitions", labels).inc();
+  if (flockRetry(fd_, LOCK_EX | LOCK_NB) == 0) {
+    return true;
+  }
+  if (errno != EWOULDBLOCK) {
+    return false;
+  }
+  registry.counter("ohno_lock_contended_total", "File lock acquisitions that had to wait", labels)
+      .inc();
+  metrics::ScopedTimer timer{registry.histogram("ohno_lock_wait_seconds", "File lock wait time",
+                                                metrics::Buckets::latency, labels)};
+  return flockRetry(fd_, LOCK_EX) == 0;
+}
+
+} // namespace util
+} // namespace ohno
@@ -0,0 +1,39 @@
+#pragma once
+
+// clang-format off
+#include <string>
+#include <string_view>
+#include "src/log/logger.h"
+// clang-format on
+
+namespace ohno {
+namespace util {
+
+/**
+ * @brief 进程间排他文件锁（flock），构造时阻塞加锁，析构时解锁
+ *
+ * 每次加锁按 name 记录 ohno_lock_acquisitions_total、ohno_lock_contended_total 与
+ * ohno_lock_wait_seconds。指标在当前进程的注册表中：CNI 插件进程很短，不启动 exporter，
+ * 这些指标只由在同一进程内执行 CNI 调用的 storm_bm 读取并输出
+ */
+class FileLock final : public log::Loggable<log::Id::util> {
+public:
+  FileLock(std::string_view path, std::string_view name);
+  ~FileLock() override;
+  FileLock(const FileLock &) = delete;
+  FileLock(FileLock &&) = delete;
+  auto operator=(const FileLock &) -> FileLock & = delete;
+  auto operator=(FileLock &&) -> FileLock & = delete;
+
+  auto isLocked() const noexcept -> bool;
+
+private:
+  auto lock() const -> bool;
+
+  std::string path_;
+  std::string name_; // 指标的 lock 标签
+  int fd_{-1};
+};
+
+} // namespace util
+} // namespace ohno
@@ -1,6 +1,7 @@
 #pragma once
 
 // clang-format off
+#include <functional>
 #include <string>
 #include <string_view>
 // clang-format on
@@ -14,6 +15,9 @@ public:
   virtual auto execute(std::string_view command, std::string &out) const -> bool = 0;
   virtual auto execute(std::string_view command, std::string &out, std::string &err) const
       -> int = 0;
+  virtual auto stream(std::string_view command,
+                      const std::function<bool(std::string_view line)> &callback) const
+      -> int = 0;
 };
 
 } // namespace util
@@ -1,5 +1,8 @@
 // clang-format off
 #include "shell_sync.h"
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
 #include <sstream>
 #include <system_error>
 #include <boost/process.hpp>
@@ -79,5 +82,69 @@ auto ShellSync::execute(std::string_view command, std::string &out, std::string
   return exit_code;
 }
 
+/**
+ * @brief 执行长期运行的 shell 命令（如 etcdctl watch），逐行处理 stdout
+ *
+ * @param command shell 命令
+ * @param callback 每读到一行调用一次；空闲 STREAM_IDLE_INTERVAL 也会以空行调用一次，
+ * 以便调用方检查是否需要停止。返回 false 时结束子进程
+ * @return int shell 命令返回值，被回调结束时为 0
+ */
+auto ShellSync::stream(std::string_view command,
+                       const std::function<bool(std::string_view line)> &callback) const -> int {
+  OHNO_ASSERT(!command.empty());
+  OHNO_ASSERT(callback);
+
+  int exit_code = 0;
+  try {
+    namespace bp = boost::process;
+    bp::pipe output{};
+    bp::child chi{"/bin/sh", "-c", std::string{command}, bp::std_out > output,
+                  bp::std_err > bp::null, bp::std_in < bp::null};
+
+    std::string buffer{};
+    bool stopped = false;
+    bool eof = false;
+    while (!stopped && !eof) {
+      pollfd pfd{output.native_source(), POLLIN, 0};
+      auto ready = ::poll(&pfd, 1, static_cast<int>(STREAM_IDLE_INTERVAL.count()));
+      if (ready < 0 && errno != EINTR) {
+        break;
+      }
+      if (ready <= 0) {
+        stopped = !callback(std::string_view{});
+        continue;
+      }
+
+      char chunk[4096];
+      auto size = ::read(output.native_source(), chunk, sizeof(chunk));
+      if (size <= 0) {
+        eof = true;
+        size = 0;
+      }
+      buffer.append(chunk, static_cast<size_t>(size));
+      size_t pos = 0;
+      while (!stopped && (pos = buffer.find('\n')) != std::string::npos) {
+        stopped = !callback(std::string_view{buffer.data(), pos});
+        buffer.erase(0, pos + 1);
+      }
+    }
+
+    if (stopped) {
+      chi.terminate();
+      return 0;
+    }
+    if (!buffer.empty()) {
+      callback(buffer); // 最后一行没有换行符
+    }
+    chi.wait();
+    exit_code = chi.exit_code();
+  } catch (const std::system_error &sys_err) {
+    exit_code = -1;
+    OHNO_LOG(warn, "Failed to execute \"{}\": {}", command, sys_err.what());
+  }
+  return exit_code;
+}
+
 } // namespace util
 } // namespace ohno
@@ -2,16 +2,21 @@
 
 // clang-format off
 #include "shell_if.h"
+#include <chrono>
 #include "src/log/logger.h"
 // clang-format on
 
 namespace ohno {
 namespace util {
 
+constexpr std::chrono::milliseconds STREAM_IDLE_INTERVAL{500};
+
 class ShellSync final : public ShellIf, public log::Loggable<log::Id::util> {
 public:
   auto execute(std::string_view command, std::string &out) const -> bool override;
   auto execute(std::string_view command, std::string &out, std::string &err) const -> int override;
+  auto stream(std::string_view command,
+              const std::function<bool(std::string_view line)> &callback) const -> int override;
 };
 
 } // namespace util
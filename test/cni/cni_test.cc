@@ -0,0 +1,179 @@
+// clang-format off
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "gtest/gtest.h"
+#include "src/backend/center_if.h"
+#include "src/cni/cni.h"
+#include "src/cni/storage.h"
+#include "src/etcd/etcd_client_shell.h"
+#include "src/etcd/etcd_server_memory.h"
+#include "src/ipam/ipam.h"
+#include "src/net/netlink/netlink_memory.h"
+#include "src/util/env_std.h"
+// clang-format on
+
+using namespace ohno;
+using namespace ohno::cni;
+using namespace ohno::etcd;
+
+constexpr std::string_view NODE_NAME{"node1"};
+constexpr std::string_view NODE_INTERNAL_IP{"192.168.100.10"};
+constexpr std::string_view UNDERLAY_DEV{"underlay0"};
+constexpr std::string_view UNDERLAY_ADDR{"192.168.100.10/24"};
+constexpr std::string_view POD_CIDR{"10.244.0.0/16"};
+constexpr std::string_view POD_NIC{"eth0"};
+
+class FakeCenter : public backend::CenterIf {
+public:
+  auto test() const -> bool override { return true; }
+  auto getKubernetesData(std::string_view /*node_name*/) const -> backend::NodeInfo override {
+    return backend::NodeInfo{std::string{NODE_NAME},
+                             std::string{NODE_INTERNAL_IP},
+                             std::string{POD_CIDR},
+                             {std::string{POD_CIDR}}};
+  }
+  auto getKubernetesData() const -> std::unordered_map<std::string, backend::NodeInfo> override {
+    return {{std::string{NODE_NAME}, getKubernetesData(NODE_NAME)}};
+  }
+};
+
+class CniTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    state_dir_ = testing::TempDir() + "ohno-cni";
+    std::filesystem::remove_all(state_dir_);
+    std::filesystem::create_directories(state_dir_);
+
+    server_ = std::make_shared<EtcdServerMemory>();
+    kernel_ = std::make_shared<net::NetlinkMemory>();
+    ASSERT_TRUE(kernel_->vethCreate(UNDERLAY_DEV, "underlay1"));
+    ASSERT_TRUE(kernel_->addressSetEntry(UNDERLAY_DEV, UNDERLAY_ADDR, true));
+    ASSERT_TRUE(kernel_->linkSetStatus(UNDERLAY_DEV, net::LinkStatus::UP));
+  }
+
+  void TearDown() override { std::filesystem::remove_all(state_dir_); }
+
+  // 与 ohno 二进制相同的装配方式，每次调用各自创建，内核、ETCD 与 api server 换成进程内实现；
+  // CNI DEL 与 ohnod 的节点回收不访问 api server，不设置 Center
+  auto makeCni(CniConfigIpam::Mode mode,
+               int64_t node_idle_timeout = DEFAULT_CONF_NODE_IDLE_TIMEOUT, bool center = true)
+      -> std::unique_ptr<Cni> {
+    CniConfig config{};
+    config.ipam_.subnet_ = POD_CIDR;
+    config.ipam_.mode_ = mode;
+    config.node_idle_timeout_ = node_idle_timeout;
+
+    auto cni = std::make_unique<Cni>(kernel_);
+    cni->parseConfig(config);
+    auto ipam = std::make_unique<ipam::Ipam>();
+    ipam->init(makeClient(), false);
+    ipam->setStateDir(state_dir_);
+    auto storage = std::make_unique<Storage>();
+    storage->init(makeClient(), false);
+    cni->setIpam(std::move(ipam));
+    cni->setStorage(std::move(storage));
+    if (center) {
+      cni->setCenter(std::make_unique<FakeCenter>());
+    }
+    cni->setNodeInfo(NODE_NAME, UNDERLAY_DEV, UNDERLAY_ADDR);
+    cni->setNodeIdlePath(state_dir_ + "/node_idle");
+    return cni;
+  }
+
+  auto makeClient() const -> std::unique_ptr<EtcdClientShell> {
+    return std::make_unique<EtcdClientShell>(EtcdData{"https://10.0.0.1:2379"},
+                                             std::make_unique<EtcdctlMemory>(server_),
+                                             std::make_unique<util::EnvStd>());
+  }
+
+  auto getVtep() const -> std::string {
+    std::string value{};
+    EXPECT_TRUE(makeClient()->get(Storage::getVtepKey(NODE_NAME), value));
+    return value;
+  }
+
+  std::string state_dir_;
+  std::shared_ptr<EtcdServerMemory> server_;
+  std::shared_ptr<net::NetlinkMemory> kernel_;
+};
+
+// 测试 vxlan 模式下节点空闲保留期间 VTEP 记录一直存在，下一个 Pod 复用节点时对端仍能找到本节点
+TEST_F(CniTest, VxlanVtepKeptWhileIdle) {
+  // condition 1: 第一个 Pod 创建节点并发布 VTEP
+  ASSERT_TRUE(kernel_->netnsAdd("pod1"));
+  makeCni(CniConfigIpam::Mode::vxlan)->add("pod1", "pod1", POD_NIC);
+  auto vtep = getVtep();
+  EXPECT_FALSE(vtep.empty());
+
+  // condition 2: 删除最后一个 Pod 之后节点空闲保留，VTEP 不删除
+  makeCni(CniConfigIpam::Mode::vxlan)->del("pod1", POD_NIC);
+  EXPECT_TRUE(kernel_->linkExist(net::NAME_VXLAN));
+  EXPECT_EQ(getVtep(), vtep);
+
+  // condition 3: 下一个 Pod 复用空闲的节点
+  ASSERT_TRUE(kernel_->netnsAdd("pod2"));
+  makeCni(CniConfigIpam::Mode::vxlan)->add("pod2", "pod2", POD_NIC);
+  EXPECT_EQ(getVtep(), vtep);
+
+  // condition 4: 非最后一个 Pod 删除时 VTEP 同样保留
+  ASSERT_TRUE(kernel_->netnsAdd("pod3"));
+  makeCni(CniConfigIpam::Mode::vxlan)->add("pod3", "pod3", POD_NIC);
+  makeCni(CniConfigIpam::Mode::vxlan)->del("pod2", POD_NIC);
+  EXPECT_EQ(getVtep(), vtep);
+}
+
+// 测试不保留空闲节点时，删除最后一个 Pod 连同 VTEP 一起删除
+TEST_F(CniTest, VxlanVtepDeletedWithNode) {
+  ASSERT_TRUE(kernel_->netnsAdd("pod1"));
+  makeCni(CniConfigIpam::Mode::vxlan, 0)->add("pod1", "pod1", POD_NIC);
+  EXPECT_FALSE(getVtep().empty());
+
+  makeCni(CniConfigIpam::Mode::vxlan, 0)->del("pod1", POD_NIC);
+  EXPECT_FALSE(kernel_->linkExist(net::NAME_VXLAN));
+  EXPECT_TRUE(getVtep().empty());
+}
+
+// 测试 CNI DEL 不设置 Center：与 ohno 二进制一样只有 ADD 才连接 api server
+TEST_F(CniTest, DelWithoutCenter) {
+  ASSERT_TRUE(kernel_->netnsAdd("pod1"));
+  ASSERT_TRUE(kernel_->netnsAdd("pod2"));
+  makeCni(CniConfigIpam::Mode::host_gw)->add("pod1", "pod1", POD_NIC);
+  makeCni(CniConfigIpam::Mode::host_gw)->add("pod2", "pod2", POD_NIC);
+
+  // condition 1: 节点上还有其他 Pod
+  makeCni(CniConfigIpam::Mode::host_gw, DEFAULT_CONF_NODE_IDLE_TIMEOUT, false)
+      ->del("pod1", POD_NIC);
+  EXPECT_FALSE(kernel_->linkExist(POD_NIC, "pod1"));
+  EXPECT_TRUE(kernel_->linkExist(POD_NIC, "pod2"));
+
+  // condition 2: 删除最后一个 Pod，节点同时删除
+  makeCni(CniConfigIpam::Mode::host_gw, 0, false)->del("pod2", POD_NIC);
+  EXPECT_FALSE(kernel_->linkExist(POD_NIC, "pod2"));
+  EXPECT_FALSE(kernel_->linkExist(DEFAULT_CONF_PLUGINS_BRIDGE));
+}
+
+// 测试 ohnod 回收空闲节点：回收器装配的 CNI 插件没有 Center
+TEST_F(CniTest, ReclaimWithoutCenter) {
+  constexpr int64_t timeout{60};
+  ASSERT_TRUE(kernel_->netnsAdd("pod1"));
+  makeCni(CniConfigIpam::Mode::vxlan, timeout)->add("pod1", "pod1", POD_NIC);
+  makeCni(CniConfigIpam::Mode::vxlan, timeout)->del("pod1", POD_NIC);
+  ASSERT_FALSE(getVtep().empty());
+
+  // condition 1: 仍在宽限期内，不回收
+  EXPECT_FALSE(makeCni(CniConfigIpam::Mode::vxlan, timeout, false)->reclaim());
+  EXPECT_TRUE(kernel_->linkExist(net::NAME_VXLAN));
+
+  // condition 2: 空闲超过宽限期，节点网络设施与 VTEP 一起删除
+  auto since = std::chrono::duration_cast<std::chrono::seconds>(
+                   std::chrono::system_clock::now().time_since_epoch()) -
+               std::chrono::seconds{timeout * 2};
+  std::ofstream{state_dir_ + "/node_idle", std::ios::trunc} << since.count();
+  EXPECT_TRUE(makeCni(CniConfigIpam::Mode::vxlan, timeout, false)->reclaim());
+  EXPECT_FALSE(kernel_->linkExist(net::NAME_VXLAN));
+  EXPECT_TRUE(getVtep().empty());
+}
@@ -0,0 +1,163 @@
+// clang-format off
+#include <memory>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "src/cni/storage.h"
+#include "src/etcd/etcd_client_shell.h"
+#include "src/etcd/etcd_server_memory.h"
+#include "src/util/env_std.h"
+#include "test/mock/etcd_client_mock.h"
+// clang-format on
+
+using namespace ohno;
+using namespace ohno::cni;
+using namespace ohno::etcd;
+
+constexpr std::string_view NODE_NAME{"node1"};
+constexpr std::string_view PODS_KEY{"/ohno/node/node1/pod"};
+
+static auto makeClient(const std::shared_ptr<EtcdServerMemory> &server)
+    -> std::unique_ptr<EtcdClientShell> {
+  return std::make_unique<EtcdClientShell>(EtcdData{"https://10.0.0.1:2379"},
+                                           std::make_unique<EtcdctlMemory>(server),
+                                           std::make_unique<util::EnvStd>());
+}
+
+// 测试批量模式下的读操作能读到尚未提交的写入，提交之前 ETCD 中没有任何记录
+TEST(StorageTest, BatchReadYourWrites) {
+  auto server = std::make_shared<EtcdServerMemory>();
+  Storage storage{};
+  ASSERT_TRUE(storage.init(makeClient(server), false));
+
+  // condition 1: 追加的列表、put 与 del 都在提交之前可见
+  storage.beginBatch();
+  EXPECT_TRUE(storage.addPod(NODE_NAME, "/var/run/netns/cni-1", "pod1"));
+  EXPECT_TRUE(storage.addNetns(NODE_NAME, "pod1", "/var/run/netns/cni-1"));
+  EXPECT_TRUE(storage.addNic(NODE_NAME, "pod1", "eth0"));
+  EXPECT_TRUE(storage.addNic(NODE_NAME, "pod1", "eth1"));
+  EXPECT_TRUE(storage.addPod(NODE_NAME, "/var/run/netns/cni-2", "pod2"));
+  EXPECT_EQ(storage.getAllPods(NODE_NAME), (std::vector<std::string>{"pod1", "pod2"}));
+  EXPECT_EQ(storage.getPod(NODE_NAME, "/var/run/netns/cni-1"), "pod1");
+  EXPECT_EQ(storage.getNetns(NODE_NAME, "pod1"), "/var/run/netns/cni-1");
+  EXPECT_EQ(storage.getAllNic(NODE_NAME, "pod1"), (std::vector<std::string>{"eth0", "eth1"}));
+  EXPECT_EQ(server->size(), 0);
+
+  // condition 2: 列表中删除一个值之后剩余的值可见，删除 key 之后读到空值
+  EXPECT_TRUE(storage.delNic(NODE_NAME, "pod1", "eth0"));
+  EXPECT_EQ(storage.getAllNic(NODE_NAME, "pod1"), (std::vector<std::string>{"eth1"}));
+  EXPECT_TRUE(storage.delPod(NODE_NAME, "/var/run/netns/cni-2"));
+  EXPECT_EQ(storage.getAllPods(NODE_NAME), (std::vector<std::string>{"pod1"}));
+  EXPECT_TRUE(storage.getPod(NODE_NAME, "/var/run/netns/cni-2").empty());
+
+  // condition 3: 提交之后退出批量模式，读到的是 ETCD 中的值
+  EXPECT_TRUE(storage.commitBatch());
+  EXPECT_EQ(storage.getAllPods(NODE_NAME), (std::vector<std::string>{"pod1"}));
+  EXPECT_EQ(storage.getAllNic(NODE_NAME, "pod1"), (std::vector<std::string>{"eth1"}));
+  EXPECT_EQ(storage.getNetns(NODE_NAME, "pod1"), "/var/run/netns/cni-1");
+  EXPECT_TRUE(storage.getPod(NODE_NAME, "/var/run/netns/cni-2").empty());
+}
+
+// 测试列表在 ETCD 已有值的基础上展开，删除到空的列表被删除
+TEST(StorageTest, BatchListDelete) {
+  auto server = std::make_shared<EtcdServerMemory>();
+  Storage storage{};
+  ASSERT_TRUE(storage.init(makeClient(server), false));
+  ASSERT_TRUE(storage.addNic(NODE_NAME, "pod1", "eth0"));
+  ASSERT_TRUE(storage.addNic(NODE_NAME, "pod1", "eth1"));
+  auto size = server->size();
+
+  storage.beginBatch();
+  EXPECT_TRUE(storage.delNic(NODE_NAME, "pod1", "eth0"));
+  EXPECT_TRUE(storage.addNic(NODE_NAME, "pod1", "eth2"));
+  EXPECT_EQ(storage.getAllNic(NODE_NAME, "pod1"), (std::vector<std::string>{"eth1", "eth2"}));
+  EXPECT_TRUE(storage.delNic(NODE_NAME, "pod1", "eth1"));
+  EXPECT_TRUE(storage.delNic(NODE_NAME, "pod1", "eth2"));
+  EXPECT_TRUE(storage.getAllNic(NODE_NAME, "pod1").empty());
+  EXPECT_TRUE(storage.commitBatch());
+  EXPECT_TRUE(storage.getAllNic(NODE_NAME, "pod1").empty());
+  EXPECT_EQ(server->size(), size - 1);
+}
+
+// 测试并发修改同一个列表：两个批量都在对方提交之前开始，先后提交之后两个 Pod 都在列表中
+TEST(StorageTest, BatchConcurrentAppend) {
+  auto server = std::make_shared<EtcdServerMemory>();
+  Storage first{};
+  Storage second{};
+  ASSERT_TRUE(first.init(makeClient(server), false));
+  ASSERT_TRUE(second.init(makeClient(server), false));
+  ASSERT_TRUE(first.addPod(NODE_NAME, "/var/run/netns/cni-0", "pod0"));
+
+  // condition 1: 追加与删除都基于对方提交之后的列表展开
+  first.beginBatch();
+  second.beginBatch();
+  EXPECT_TRUE(first.addPod(NODE_NAME, "/var/run/netns/cni-1", "pod1"));
+  EXPECT_TRUE(second.delPod(NODE_NAME, "/var/run/netns/cni-0"));
+  EXPECT_TRUE(second.addPod(NODE_NAME, "/var/run/netns/cni-2", "pod2"));
+  EXPECT_TRUE(first.commitBatch());
+  EXPECT_TRUE(second.commitBatch());
+  EXPECT_EQ(first.getAllPods(NODE_NAME), (std::vector<std::string>{"pod1", "pod2"}));
+  EXPECT_TRUE(second.hasPod(NODE_NAME, "pod1"));
+  EXPECT_FALSE(second.hasPod(NODE_NAME, "pod0"));
+
+  // condition 2: 两个批量追加同一个值，列表中只保留一个
+  first.beginBatch();
+  second.beginBatch();
+  EXPECT_TRUE(first.addNic(NODE_NAME, "host", "br0"));
+  EXPECT_TRUE(second.addNic(NODE_NAME, "host", "br0"));
+  EXPECT_TRUE(first.commitBatch());
+  EXPECT_TRUE(second.commitBatch());
+  EXPECT_EQ(first.getAllNic(NODE_NAME, "host"), (std::vector<std::string>{"br0"}));
+}
+
+// 测试读取列表之后、提交之前列表被修改：事务比较 mod_revision 不成立，重新读取之后再提交
+TEST(StorageTest, BatchConflictRetry) {
+  auto mock = std::make_unique<MockEtcdClient>();
+  auto *etcd = mock.get();
+  Storage storage{};
+  ASSERT_TRUE(storage.init(std::move(mock), false));
+
+  auto appends = [](std::string_view value, int64_t revision) {
+    return testing::Truly([value, revision](const EtcdTxn &txn) {
+      const auto &cmps = txn.getCmps();
+      return cmps.size() == 1 && cmps[0].target_ == TxnCmpTarget::mod &&
+             cmps[0].key_ == PODS_KEY && cmps[0].revision_ == revision &&
+             txn.find(PODS_KEY) == value;
+    });
+  };
+  EXPECT_CALL(*etcd, get(std::string_view{PODS_KEY}, testing::_, testing::An<int64_t &>()))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>(""), testing::SetArgReferee<2>(0),
+                               testing::Return(true)))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>("pod2"), testing::SetArgReferee<2>(7),
+                               testing::Return(true)));
+  EXPECT_CALL(*etcd, commit(appends("pod1", 0))).WillOnce(testing::Return(TxnResult::conflicted));
+  EXPECT_CALL(*etcd, commit(appends("pod2,pod1", 7)))
+      .WillOnce(testing::Return(TxnResult::committed));
+  EXPECT_CALL(*etcd, put(testing::_, testing::_)).Times(0);
+  EXPECT_CALL(*etcd, append(testing::_, testing::_)).Times(0);
+
+  storage.beginBatch();
+  EXPECT_TRUE(storage.addPod(NODE_NAME, "/var/run/netns/cni-1", "pod1"));
+  EXPECT_TRUE(storage.commitBatch());
+}
+
+// 测试提交失败时所有写操作都不生效，并且退出批量模式
+TEST(StorageTest, BatchCommitFailed) {
+  auto mock = std::make_unique<MockEtcdClient>();
+  auto *etcd = mock.get();
+  Storage storage{};
+  ASSERT_TRUE(storage.init(std::move(mock), false));
+
+  EXPECT_CALL(*etcd, get(testing::_, testing::_, testing::An<int64_t &>()))
+      .WillOnce(testing::Return(true));
+  EXPECT_CALL(*etcd, commit(testing::_)).WillOnce(testing::Return(TxnResult::failed));
+  storage.beginBatch();
+  EXPECT_TRUE(storage.addNic(NODE_NAME, "pod1", "eth0"));
+  EXPECT_FALSE(storage.commitBatch());
+
+  // 已经退出批量模式，之后的写操作直接写入 ETCD
+  EXPECT_CALL(*etcd, append(std::string_view{"/ohno/node/node1/pod/pod1/nic"},
+                            std::string_view{"eth0"}))
+      .WillOnce(testing::Return(true));
+  EXPECT_TRUE(storage.addNic(NODE_NAME, "pod1", "eth0"));
+}
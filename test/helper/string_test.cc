@@ -0,0 +1,59 @@
+// clang-format off
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "gtest/gtest.h"
+#include "src/helper/string.h"
+// clang-format on
+
+using namespace ohno::helper;
+
+// 测试切分结果与 std::getline 一致
+TEST(StringTest, Split) {
+  auto getline_split = [](std::string_view str, char delim) {
+    std::vector<std::string> tokens{};
+    std::string token{};
+    std::istringstream stream{std::string{str}};
+    while (std::getline(stream, token, delim)) {
+      tokens.push_back(token);
+    }
+    return tokens;
+  };
+
+  for (std::string_view str : {"", ",", ",,", "a", "a,", ",a", "a,b", "a,,b", "a,b,", "a,b,,"}) {
+    auto expect = getline_split(str, ',');
+    EXPECT_EQ(split(str, ','), expect) << str;
+
+    auto views = splitView(str, ',');
+    EXPECT_EQ(std::vector<std::string>(views.begin(), views.end()), expect) << str;
+  }
+}
+
+// 测试 token 是原字符串上的视图
+TEST(StringTest, Tokenizer) {
+  std::string str{"10.244.1.0/24-10.244.1.1-eth0,10.244.2.0/24--eth1"};
+  Tokenizer items{str, ','};
+  std::string_view item{};
+  std::vector<std::vector<std::string_view>> routes{};
+  while (items.next(item)) {
+    EXPECT_GE(item.data(), str.data());
+    EXPECT_LE(item.data() + item.size(), str.data() + str.size());
+    routes.emplace_back(splitView(item, '-'));
+  }
+  ASSERT_EQ(routes.size(), 2);
+  EXPECT_EQ(routes[0], (std::vector<std::string_view>{"10.244.1.0/24", "10.244.1.1", "eth0"}));
+  EXPECT_EQ(routes[1], (std::vector<std::string_view>{"10.244.2.0/24", "", "eth1"}));
+  EXPECT_FALSE(items.next(item));
+}
+
+// 测试 Base64 编解码
+TEST(StringTest, Base64) {
+  for (std::string_view str : {"", "f", "fo", "foo", "/ohno/node/node1/subnet"}) {
+    auto decoded = base64Decode(base64Encode(str));
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ(decoded.value(), str);
+  }
+  EXPECT_EQ(base64Encode("foo"), "Zm9v");
+  EXPECT_FALSE(base64Decode("Zm9v!").has_value());
+}
@@ -0,0 +1,84 @@
+// clang-format off
+#include <memory>
+#include <string>
+#include "gtest/gtest.h"
+#include "spdlog/fmt/fmt.h"
+#include "src/ipam/arena.h"
+#include "src/ipam/cluster.h"
+#include "src/ipam/netns.h"
+#include "src/ipam/node.h"
+#include "src/net/addr.h"
+#include "src/net/nic.h"
+// clang-format on
+
+using namespace ohno;
+using namespace ohno::ipam;
+
+constexpr std::string_view NODE_NAME{"node-0001"};
+constexpr int PODS{200};
+
+static auto addPods(const std::shared_ptr<Arena> &arena, const std::shared_ptr<NodeIf> &node)
+    -> void {
+  for (int i = 0; i < PODS; ++i) {
+    auto pod = arena->make<Netns>(arena->getResource());
+    pod->setName(fmt::format("/var/run/netns/cni-{:08x}-{:04d}", i * 2654435761U, i));
+    auto nic = arena->make<net::Nic>();
+    nic->setName(fmt::format("veth{:04d}", i));
+    nic->addAddr(std::make_unique<net::Addr>(fmt::format("10.244.{}.{}/16", i / 256, i % 256)));
+    pod->addNic(nic);
+    node->addNetns(pod->getName(), pod);
+  }
+}
+
+// 测试从内存区域分配的集群模型与堆上的模型行为一致
+TEST(ClusterTest, Arena) {
+  auto arena = std::make_shared<Arena>();
+  auto cluster = std::make_unique<Cluster>(arena);
+  auto node = arena->make<Node>(arena->getResource());
+  node->setName(NODE_NAME);
+  addPods(arena, node);
+  cluster->addNode(NODE_NAME, node);
+
+  // condition 1: 节点、网络空间与网卡都可以按名称找到
+  auto found = cluster->getNode(NODE_NAME);
+  ASSERT_EQ(found, node);
+  EXPECT_EQ(found->getName(), NODE_NAME);
+  EXPECT_EQ(found->getNetnsSize(), PODS);
+  auto pod = found->getNetns(fmt::format("/var/run/netns/cni-{:08x}-{:04d}", 7 * 2654435761U, 7));
+  ASSERT_TRUE(pod);
+  auto nic = pod->getNic("veth0007");
+  ASSERT_TRUE(nic);
+  EXPECT_EQ(nic->getName(), "veth0007");
+  cluster->delNode(NODE_NAME);
+  EXPECT_FALSE(cluster->getNode(NODE_NAME));
+
+  // condition 2: 区域成倍扩大，向堆申请的次数远少于对象的数量
+  EXPECT_GT(arena->getReservedBytes(), ARENA_INITIAL_SIZE);
+  EXPECT_LT(arena->getReservedBytes(), ARENA_INITIAL_SIZE * 16);
+
+  // condition 3: 集群释放之后，仍被持有的对象也持有区域，最后一个对象析构时区域才释放
+  std::weak_ptr<Arena> weak = arena;
+  arena.reset();
+  cluster.reset();
+  node.reset();
+  found.reset();
+  pod.reset();
+  EXPECT_FALSE(weak.expired());
+  EXPECT_EQ(nic->getName(), "veth0007");
+  nic.reset();
+  EXPECT_TRUE(weak.expired());
+}
+
+// 测试不使用内存区域的集群模型
+TEST(ClusterTest, Heap) {
+  Cluster cluster{};
+  auto node = std::make_shared<Node>();
+  node->setName(NODE_NAME);
+  auto pod = std::make_shared<Netns>();
+  pod->setName("pod");
+  node->addNetns("pod", pod);
+  cluster.addNode(NODE_NAME, node);
+  EXPECT_EQ(cluster.getNode(NODE_NAME), node);
+  EXPECT_EQ(cluster.getNode(NODE_NAME)->getNetns("pod")->getName(), "pod");
+  EXPECT_FALSE(cluster.getNode("none"));
+}
@@ -0,0 +1,86 @@
+// clang-format off
+#include <filesystem>
+#include "gtest/gtest.h"
+#include "src/etcd/endpoint_selector.h"
+// clang-format on
+
+using namespace ohno::etcd;
+using std::chrono::microseconds;
+
+// 测试端点按健康状态与 EWMA 延迟排序
+TEST(EndpointSelectorTest, Order) {
+  EndpointSelector selector{"https://10.0.0.1:2379,https://10.0.0.2:2379,https://10.0.0.3:2379"};
+  ASSERT_EQ(selector.size(), 3);
+  EXPECT_EQ(selector.getEndpoint(1), "https://10.0.0.2:2379");
+
+  // condition 1: 都没有测量过时保持配置顺序，测量过的端点排在未测量的之后
+  EXPECT_EQ(selector.getOrder(), (std::vector<size_t>{0, 1, 2}));
+  selector.record(0, microseconds{9000}, true);
+  EXPECT_EQ(selector.getOrder(), (std::vector<size_t>{1, 2, 0}));
+
+  // condition 2: 按 EWMA 延迟排序
+  selector.record(1, microseconds{1000}, true);
+  selector.record(2, microseconds{5000}, true);
+  EXPECT_EQ(selector.getOrder(), (std::vector<size_t>{1, 2, 0}));
+  selector.record(1, microseconds{21000}, true); // 0.3 * 21000 + 0.7 * 1000 = 7000
+  EXPECT_DOUBLE_EQ(selector.getLatency(1), 7000);
+  EXPECT_EQ(selector.getOrder(), (std::vector<size_t>{2, 1, 0}));
+
+  // condition 3: 失败的端点冷却期间排在最后，成功一次之后恢复
+  selector.record(2, microseconds{0}, false);
+  EXPECT_EQ(selector.getOrder(), (std::vector<size_t>{1, 0, 2}));
+  selector.record(2, microseconds{5000}, true);
+  EXPECT_EQ(selector.getOrder(), (std::vector<size_t>{2, 1, 0}));
+}
+
+// 测试对冲读预算取最近读延迟的 p95
+TEST(EndpointSelectorTest, HedgeBudget) {
+  EndpointSelector selector{"https://10.0.0.1:2379"};
+  EXPECT_EQ(selector.getHedgeBudget(), microseconds{DEFAULT_HEDGE_BUDGET});
+
+  for (int64_t i = 1; i <= 100; ++i) {
+    selector.recordRead(microseconds{i * 1000});
+  }
+  // 窗口只保留最近 64 个样本：37ms ~ 100ms，p95 是第 61 个
+  EXPECT_EQ(selector.getHedgeBudget(), microseconds{97000});
+
+  for (size_t i = 0; i < LATENCY_WINDOW; ++i) {
+    selector.recordRead(microseconds{1});
+  }
+  EXPECT_EQ(selector.getHedgeBudget(), microseconds{MIN_HEDGE_BUDGET});
+}
+
+// 测试状态文件保存上一个进程的延迟统计，下一个进程构造之后直接使用
+TEST(EndpointSelectorTest, State) {
+  auto path = testing::TempDir() + "ohno_etcd_endpoints.json";
+  std::filesystem::remove(path);
+  {
+    EndpointSelector selector{"https://10.0.0.1:2379,https://10.0.0.2:2379,https://10.0.0.3:2379",
+                              path};
+    selector.record(0, microseconds{9000}, true);
+    selector.record(1, microseconds{1000}, true);
+    selector.record(2, microseconds{0}, false);
+    for (int64_t i = 1; i <= 10; ++i) {
+      selector.recordRead(microseconds{i * 10000});
+    }
+  }
+
+  // condition 1: 按端点名称恢复，新增的端点没有测量过
+  EndpointSelector selector{"https://10.0.0.2:2379,https://10.0.0.1:2379,https://10.0.0.4:2379,"
+                            "https://10.0.0.3:2379",
+                            path};
+  EXPECT_DOUBLE_EQ(selector.getLatency(0), 1000);
+  EXPECT_DOUBLE_EQ(selector.getLatency(1), 9000);
+  EXPECT_EQ(selector.getOrder(), (std::vector<size_t>{2, 0, 1, 3}));
+
+  // condition 2: 对冲读预算不再从默认值开始
+  EXPECT_EQ(selector.getHedgeBudget(), microseconds{100000});
+
+  // condition 3: 文件损坏时从空状态开始
+  ASSERT_TRUE(selector.save(path));
+  std::filesystem::resize_file(path, 10);
+  EndpointSelector broken{"https://10.0.0.1:2379", path};
+  EXPECT_EQ(broken.getHedgeBudget(), microseconds{DEFAULT_HEDGE_BUDGET});
+  EXPECT_DOUBLE_EQ(broken.getLatency(0), 0);
+  std::filesystem::remove(path);
+}
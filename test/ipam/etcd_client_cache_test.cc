@@ -0,0 +1,190 @@
+// clang-format off
+#include <future>
+#include <thread>
+#include <unordered_map>
+#include "gtest/gtest.h"
+#include "src/etcd/etcd_client_cache.h"
+#include "test/mock/etcd_client_mock.h"
+// clang-format on
+
+using namespace ohno::etcd;
+
+using EtcdEntries = std::unordered_map<std::string, std::string>;
+
+// 测试未启动 watch 时的进程内读缓存
+TEST(EtcdClientCacheTest, Memo) {
+  auto mock = std::make_unique<MockEtcdClient>();
+  auto *etcd = mock.get();
+  EtcdClientCache cache{std::move(mock), "/ohno/"};
+
+  // condition 1: 同一个 key 只读取一次
+  EXPECT_CALL(*etcd, get(std::string_view{"/ohno/subnets/node1"}, testing::An<std::string &>()))
+      .Times(2)
+      .WillRepeatedly(testing::DoAll(testing::SetArgReferee<1>("10.244.1.0/24"),
+                                     testing::Return(true)));
+  std::string value{};
+  EXPECT_TRUE(cache.get("/ohno/subnets/node1", value));
+  EXPECT_EQ(value, "10.244.1.0/24");
+  value.clear();
+  EXPECT_TRUE(cache.get("/ohno/subnets/node1", value));
+  EXPECT_EQ(value, "10.244.1.0/24");
+
+  // condition 2: 写操作使缓存失效
+  EXPECT_CALL(*etcd, put(std::string_view{"/ohno/subnets/node1"}, testing::_))
+      .WillOnce(testing::Return(true));
+  EXPECT_TRUE(cache.put("/ohno/subnets/node1", "10.244.1.0/24"));
+  EXPECT_TRUE(cache.get("/ohno/subnets/node1", value));
+
+  // condition 3: 前缀之外的 key 不缓存
+  EXPECT_CALL(*etcd, get(std::string_view{"/other"}, testing::An<std::string &>()))
+      .Times(2)
+      .WillRepeatedly(testing::Return(true));
+  EXPECT_TRUE(cache.get("/other", value));
+  EXPECT_TRUE(cache.get("/other", value));
+  EXPECT_FALSE(cache.isSynced());
+}
+
+// 测试启动 watch 之后缓存与 ETCD 保持一致
+TEST(EtcdClientCacheTest, Watch) {
+  auto mock = std::make_unique<MockEtcdClient>();
+  auto *etcd = mock.get();
+  EtcdClientCache cache{std::move(mock), "/ohno/"};
+
+  EtcdEntries entries{{"/ohno/subnets/node1", "10.244.1.0/24"},
+                      {"/ohno/addresses/node1/10.244.1.1", "10.244.1.1/24"}};
+  EXPECT_CALL(*etcd, snapshot(std::string_view{"/ohno/"}, testing::_, testing::_))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>(entries), testing::SetArgReferee<2>(10),
+                               testing::Return(true)));
+
+  // watch 线程推送一批事件之后一直阻塞到 stop()
+  std::promise<void> applied{};
+  EXPECT_CALL(*etcd, watch(std::string_view{"/ohno/"}, 11, testing::_))
+      .WillOnce([&applied](std::string_view, int64_t, const WatchCallback &callback) {
+        std::vector<WatchEvent> events{
+            {WatchEventType::put, "/ohno/subnets/node2", "10.244.2.0/24", 11},
+            {WatchEventType::del, "/ohno/addresses/node1/10.244.1.1", "", 12},
+            {WatchEventType::put, "/ohno/subnets/node1", "stale", 9}};
+        callback(events);
+        applied.set_value();
+        while (callback({})) {
+          std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+        return WatchResult::stopped;
+      });
+  ASSERT_TRUE(cache.start());
+  applied.get_future().wait();
+  EXPECT_TRUE(cache.isSynced());
+  EXPECT_EQ(cache.getRevision(), 12);
+
+  // condition 1: 读取全部由缓存提供，旧 revision 的事件被忽略
+  std::string value{};
+  EXPECT_TRUE(cache.get("/ohno/subnets/node1", value));
+  EXPECT_EQ(value, "10.244.1.0/24");
+  EXPECT_TRUE(cache.get("/ohno/subnets/node2", value));
+  EXPECT_EQ(value, "10.244.2.0/24");
+  EXPECT_TRUE(cache.get("/ohno/addresses/node1/10.244.1.1", value));
+  EXPECT_TRUE(value.empty());
+  EtcdEntries subnets{};
+  EXPECT_TRUE(cache.get("/ohno/subnets/", subnets));
+  EXPECT_EQ(subnets.size(), 2);
+
+  // condition 2: 自己写过的 key 在 watch 确认之前从 ETCD 读取
+  EXPECT_CALL(*etcd, put(std::string_view{"/ohno/subnets/node3"}, testing::_))
+      .WillOnce(testing::Return(true));
+  EXPECT_CALL(*etcd, get(std::string_view{"/ohno/subnets/node3"}, testing::An<std::string &>()))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>("10.244.3.0/24"), testing::Return(true)));
+  EXPECT_CALL(*etcd, get(std::string_view{"/ohno/subnets/"}, testing::An<EtcdEntries &>()))
+      .WillOnce(testing::Return(true));
+  EXPECT_TRUE(cache.put("/ohno/subnets/node3", "10.244.3.0/24"));
+  EXPECT_TRUE(cache.get("/ohno/subnets/node3", value));
+  EXPECT_EQ(value, "10.244.3.0/24");
+  EXPECT_TRUE(cache.get("/ohno/subnets/", subnets));
+
+  cache.stop();
+  EXPECT_FALSE(cache.isSynced());
+}
+
+// 测试 watch 事件先于写操作返回到达，以及写失败时 key 不会一直标记为 dirty
+TEST(EtcdClientCacheTest, WatchBeforeWrite) {
+  auto mock = std::make_unique<MockEtcdClient>();
+  auto *etcd = mock.get();
+  EtcdClientCache cache{std::move(mock), "/ohno/"};
+
+  EXPECT_CALL(*etcd, snapshot(std::string_view{"/ohno/"}, testing::_, testing::_))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>(EtcdEntries{}),
+                               testing::SetArgReferee<2>(10), testing::Return(true)));
+  std::promise<const WatchCallback *> started{};
+  EXPECT_CALL(*etcd, watch(std::string_view{"/ohno/"}, 11, testing::_))
+      .WillOnce([&started](std::string_view, int64_t, const WatchCallback &callback) {
+        started.set_value(&callback);
+        while (callback({})) {
+          std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+        return WatchResult::stopped;
+      });
+  ASSERT_TRUE(cache.start());
+  const auto *watch_callback = started.get_future().get();
+
+  // condition 1: 写请求返回之前 watch 已经推送了事件，之后直接从缓存读取
+  EXPECT_CALL(*etcd, put(std::string_view{"/ohno/subnets/node1"}, testing::_))
+      .WillOnce([watch_callback](std::string_view key, std::string_view value) {
+        (*watch_callback)({{WatchEventType::put, std::string{key}, std::string{value}, 11}});
+        return true;
+      });
+  EXPECT_CALL(*etcd, get(testing::_, testing::An<std::string &>())).Times(0);
+  EXPECT_CALL(*etcd, get(testing::_, testing::An<EtcdEntries &>())).Times(0);
+  EXPECT_TRUE(cache.put("/ohno/subnets/node1", "10.244.1.0/24"));
+  std::string value{};
+  EXPECT_TRUE(cache.get("/ohno/subnets/node1", value));
+  EXPECT_EQ(value, "10.244.1.0/24");
+  EtcdEntries subnets{};
+  EXPECT_TRUE(cache.get("/ohno/subnets/", subnets));
+  EXPECT_EQ(subnets.size(), 1);
+
+  // condition 2: 写失败之后仍然从缓存读取
+  EXPECT_CALL(*etcd, put(std::string_view{"/ohno/subnets/node2"}, testing::_))
+      .WillOnce(testing::Return(false));
+  EXPECT_CALL(*etcd, commit(testing::_)).WillOnce(testing::Return(TxnResult::conflicted));
+  EXPECT_FALSE(cache.put("/ohno/subnets/node2", "10.244.2.0/24"));
+  EtcdTxn txn{};
+  txn.put("/ohno/subnets/node3", "10.244.3.0/24");
+  EXPECT_EQ(cache.commit(txn), TxnResult::conflicted);
+  EXPECT_TRUE(cache.get("/ohno/subnets/node2", value));
+  EXPECT_TRUE(value.empty());
+  EXPECT_TRUE(cache.get("/ohno/subnets/node3", value));
+  EXPECT_TRUE(value.empty());
+
+  cache.stop();
+}
+
+// 测试修改记录只包含成功的写操作
+TEST(EtcdClientCacheTest, ChangeLog) {
+  auto mock = std::make_unique<MockEtcdClient>();
+  auto *etcd = mock.get();
+  EtcdClientCache cache{std::move(mock), "/ohno/"};
+  auto change_log = std::make_shared<ChangeLog>();
+  cache.setChangeLog(change_log);
+
+  EXPECT_CALL(*etcd, put(std::string_view{"/ohno/subnets/node1"}, testing::_))
+      .WillOnce(testing::Return(true));
+  EXPECT_CALL(*etcd, del(std::string_view{"/ohno/subnets/node2"})).WillOnce(testing::Return(false));
+  EXPECT_CALL(*etcd, commit(testing::_)).WillOnce(testing::Return(TxnResult::committed));
+  EXPECT_TRUE(cache.put("/ohno/subnets/node1", "10.244.1.0/24"));
+  EXPECT_FALSE(cache.del("/ohno/subnets/node2"));
+  EtcdTxn txn{};
+  txn.put("/ohno/addresses/node1/10.244.1.1", "10.244.1.1/24").del("/ohno/blocks/node1");
+  EXPECT_EQ(cache.commit(txn), TxnResult::committed);
+
+  EXPECT_EQ(change_log->size(), 3);
+  auto changes = change_log->toString();
+  EXPECT_NE(changes.find("/ohno/subnets/node1 10.244.1.0/24"), std::string::npos);
+  EXPECT_EQ(changes.find("/ohno/subnets/node2"), std::string::npos);
+  EXPECT_NE(changes.find("/ohno/blocks/node1"), std::string::npos);
+
+  // 读操作不记录
+  EXPECT_CALL(*etcd, get(std::string_view{"/ohno/subnets/node1"}, testing::An<std::string &>()))
+      .WillOnce(testing::Return(true));
+  std::string value{};
+  EXPECT_TRUE(cache.get("/ohno/subnets/node1", value));
+  EXPECT_EQ(change_log->size(), 3);
+}
@@ -1,7 +1,10 @@
 // clang-format off
+#include <chrono>
+#include <thread>
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 #include "src/etcd/etcd_client_shell.h"
+#include "src/metrics/metrics.h"
 #include "src/util/env_std.h"
 // clang-format on
 
@@ -19,6 +22,9 @@ public:
   MOCK_METHOD(bool, execute, (std::string_view command, std::string &output), (const, override));
   MOCK_METHOD(int, execute, (std::string_view command, std::string &output, std::string &error),
               (const, override));
+  MOCK_METHOD(int, stream,
+              (std::string_view command, (const std::function<bool(std::string_view)> &callback)),
+              (const, override));
 };
 
 class EtcdClientShellTest : public ::testing::Test {
@@ -79,6 +85,22 @@ TEST_F(EtcdClientShellTest, GetOperation) {
   bool result = etcd_client_->get("test-key", value);
   EXPECT_TRUE(result);
   EXPECT_EQ(value, "test-value");
+
+  // 带 revision 的读取解析 JSON 输出，key 不存在时 revision 为 0
+  int64_t revision{0};
+  EXPECT_CALL(*mock_shell_, execute(testing::HasSubstr("get test-key -w json"), testing::_))
+      .WillOnce(testing::DoAll(
+          testing::SetArgReferee<1>(R"({"header":{"revision":9},"kvs":[{"key":"dGVzdC1rZXk=",)"
+                                    R"("mod_revision":7,"value":"dGVzdC12YWx1ZQ=="}],"count":1})"),
+          testing::Return(true)))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>(R"({"header":{"revision":9}})"),
+                               testing::Return(true)));
+  EXPECT_TRUE(etcd_client_->get("test-key", value, revision));
+  EXPECT_EQ(value, "test-value");
+  EXPECT_EQ(revision, 7);
+  EXPECT_TRUE(etcd_client_->get("test-key", value, revision));
+  EXPECT_TRUE(value.empty());
+  EXPECT_EQ(revision, 0);
 }
 
 TEST_F(EtcdClientShellTest, DelOperation1) {
@@ -112,6 +134,97 @@ TEST_F(EtcdClientShellTest, DelOperation2) {
   EXPECT_STREQ(value.c_str(), "test-append");
 }
 
+TEST_F(EtcdClientShellTest, DelPrefixOperation) {
+  EXPECT_CALL(*mock_shell_, execute(testing::HasSubstr("del test-key/ --prefix"), testing::_))
+      .WillOnce(testing::Return(true));
+
+  bool result = etcd_client_->delPrefix("test-key/");
+  EXPECT_TRUE(result);
+}
+
+TEST_F(EtcdClientShellTest, LeaseOperation) {
+  EXPECT_CALL(*mock_shell_, execute(testing::HasSubstr("lease grant 60"), testing::_))
+      .WillOnce(testing::DoAll(
+          testing::SetArgReferee<1>("lease 694d7a5d2d1c2b0b granted with TTL(60s)"),
+          testing::Return(true)));
+  EXPECT_CALL(*mock_shell_,
+              execute(testing::HasSubstr("put --lease=694d7a5d2d1c2b0b -- test-key"), testing::_))
+      .WillOnce(testing::Return(true));
+  EXPECT_CALL(*mock_shell_, execute(testing::HasSubstr("lease keep-alive --once"), testing::_))
+      .WillOnce(testing::DoAll(
+          testing::SetArgReferee<1>("lease 694d7a5d2d1c2b0b keepalived with TTL(60)"),
+          testing::Return(true)))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>("lease 694d7a5d2d1c2b0b expired or "
+                                                         "revoked."),
+                               testing::Return(true)));
+
+  std::string lease_id{};
+  EXPECT_TRUE(etcd_client_->grantLease(60, lease_id));
+  EXPECT_EQ(lease_id, "694d7a5d2d1c2b0b");
+  EXPECT_TRUE(etcd_client_->put("test-key", "test-value", lease_id));
+  EXPECT_TRUE(etcd_client_->keepAliveLease(lease_id));
+  EXPECT_FALSE(etcd_client_->keepAliveLease(lease_id));
+}
+
+TEST_F(EtcdClientShellTest, TxnOperation) {
+  // 同一个 key 只保留最后一次操作，所有操作通过一次 etcdctl txn 提交
+  EtcdTxn txn{};
+  txn.put("test-key", "value1").put("test-key", "value1,value2").del("test-del");
+  txn.put("test-lease", "value", "694d7a5d2d1c2b0b");
+  EXPECT_EQ(txn.size(), 3);
+  EXPECT_EQ(txn.find("test-key"), "value1,value2");
+  EXPECT_EQ(txn.find("test-del"), "");
+  EXPECT_FALSE(txn.find("test-none").has_value());
+
+  EXPECT_CALL(
+      *mock_shell_,
+      execute(testing::AllOf(testing::HasSubstr("'' 'put test-key \"value1,value2\"' "
+                                                "'del test-del' "
+                                                "'put --lease=694d7a5d2d1c2b0b test-lease "
+                                                "\"value\"' '' '' |"),
+                             testing::EndsWith(" txn")),
+              testing::_))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>("SUCCESS\n\nOK\n\nOK\n\nOK"),
+                               testing::Return(true)));
+  EXPECT_EQ(etcd_client_->commit(txn), TxnResult::committed);
+
+  // 空事务不执行命令
+  EXPECT_EQ(etcd_client_->commit(EtcdTxn{}), TxnResult::committed);
+
+  // 比较条件在第一个空行之前，不成立时 etcdctl 输出 FAILURE
+  txn.clear();
+  txn.compare(TxnCmpTarget::mod, "test-key", 42).compare(TxnCmpTarget::mod, "test-key", 43);
+  txn.compare(TxnCmpTarget::create, "test-new", 0).put("test-new", "value");
+  EXPECT_CALL(*mock_shell_,
+              execute(testing::HasSubstr("'mod(\"test-key\") = \"42\"' "
+                                         "'create(\"test-new\") = \"0\"' '' "
+                                         "'put test-new \"value\"' '' '' |"),
+                      testing::_))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>("FAILURE\n"), testing::Return(true)));
+  EXPECT_EQ(etcd_client_->commit(txn), TxnResult::conflicted);
+}
+
+TEST_F(EtcdClientShellTest, TxnEscape) {
+  // value 先按 etcdctl 的双引号字符串转义，每一行再按 shell 单引号转义
+  EtcdTxn txn{};
+  txn.put("test-key", "it's \"a\"\\\nb");
+  EXPECT_CALL(*mock_shell_,
+              execute(testing::HasSubstr("'' 'put test-key \"it'\\''s "
+                                         "\\\"a\\\"\\\\\\nb\"' '' '' |"),
+                      testing::_))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>("SUCCESS\n\nOK"), testing::Return(true)));
+  EXPECT_EQ(etcd_client_->commit(txn), TxnResult::committed);
+
+  // key 不能转义，含有引号或空白时不执行命令
+  EXPECT_CALL(*mock_shell_, execute(testing::_, testing::_)).Times(0);
+  txn.clear();
+  txn.put("test key", "value");
+  EXPECT_EQ(etcd_client_->commit(txn), TxnResult::failed);
+  txn.clear();
+  txn.compare(TxnCmpTarget::mod, "test\"key", 1).del("test-key");
+  EXPECT_EQ(etcd_client_->commit(txn), TxnResult::failed);
+}
+
 TEST_F(EtcdClientShellTest, ListOperation) {
   std::vector<std::string> results;
   EXPECT_CALL(*mock_shell_, execute(testing::_, testing::_))
@@ -123,3 +236,142 @@ TEST_F(EtcdClientShellTest, ListOperation) {
   EXPECT_TRUE(result);
   EXPECT_THAT(results, testing::ElementsAre("value1", "value2", "value3"));
 }
+
+// 测试操作指标按操作类型记录，选项与参数不影响操作类型
+TEST_F(EtcdClientShellTest, OperationMetrics) {
+  auto &registry = ohno::metrics::Registry::instance();
+  auto &puts = registry.histogram("ohno_etcd_op_duration_seconds", "ETCD operation latency",
+                                  ohno::metrics::Buckets::latency, {{"op", "put"}});
+  auto &del_errors =
+      registry.counter("ohno_etcd_op_errors_total", "ETCD operation failures", {{"op", "del"}});
+  auto put_count = puts.getCount();
+  auto del_error_count = del_errors.get();
+
+  EXPECT_CALL(*mock_shell_, execute(testing::_, testing::_))
+      .WillOnce(testing::Return(true))
+      .WillOnce(testing::Return(true))
+      .WillOnce(testing::Return(false));
+  EXPECT_TRUE(etcd_client_->put("test-key", "test-value"));
+  EXPECT_TRUE(etcd_client_->put("test-key", "test-value", "1234"));
+  EXPECT_FALSE(etcd_client_->del("test-key"));
+  EXPECT_EQ(puts.getCount(), put_count + 2);
+  EXPECT_EQ(del_errors.get(), del_error_count + 1);
+}
+
+// 测试多个端点时不可用的端点被跳过
+TEST(EtcdClientShellEndpointTest, Failover) {
+  auto mock_shell = std::make_unique<MockShellSync>();
+  auto *shell = mock_shell.get();
+  EtcdClientShell etcd_client{EtcdData{"https://10.0.0.1:2379,https://10.0.0.2:2379"},
+                              std::move(mock_shell), std::make_unique<EnvStd>()};
+
+  // condition 1: 第一个端点不可用时换第二个端点，并且之后优先使用第二个端点
+  EXPECT_CALL(*shell, execute(testing::HasSubstr("--endpoints=https://10.0.0.1:2379 "), testing::_,
+                              testing::_))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<2>("Error: context deadline exceeded"),
+                               testing::Return(1)));
+  EXPECT_CALL(*shell, execute(testing::HasSubstr("--endpoints=https://10.0.0.2:2379 "), testing::_,
+                              testing::_))
+      .Times(3)
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>("test-value"), testing::Return(0)))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>("test-value"), testing::Return(0)))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<2>("Error: etcdserver: permission denied"),
+                               testing::Return(1)));
+  std::string value{};
+  EXPECT_TRUE(etcd_client.get("test-key", value));
+  EXPECT_EQ(value, "test-value");
+  EXPECT_EQ(etcd_client.getSelector().getOrder().front(), 1);
+  EXPECT_TRUE(etcd_client.get("test-key", value));
+
+  // condition 2: 与端点无关的错误不换端点重试
+  EXPECT_FALSE(etcd_client.put("test-key", "test-value"));
+}
+
+// 测试写请求只在连接失败时换端点，超时的写请求可能已经执行，不能重试
+TEST(EtcdClientShellEndpointTest, WriteFailover) {
+  auto mock_shell = std::make_unique<MockShellSync>();
+  auto *shell = mock_shell.get();
+  EtcdClientShell etcd_client{EtcdData{"https://10.0.0.1:2379,https://10.0.0.2:2379"},
+                              std::move(mock_shell), std::make_unique<EnvStd>()};
+
+  // condition 1: 超时的写请求直接失败，第二个端点没有收到请求
+  EXPECT_CALL(*shell, execute(testing::AllOf(testing::HasSubstr("https://10.0.0.1:2379 "),
+                                             testing::HasSubstr(" lease grant ")),
+                              testing::_, testing::_))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<2>("Error: context deadline exceeded"),
+                               testing::Return(1)));
+  EXPECT_CALL(*shell, execute(testing::AllOf(testing::HasSubstr("https://10.0.0.2:2379 "),
+                                             testing::HasSubstr(" lease grant ")),
+                              testing::_, testing::_))
+      .Times(0);
+  std::string lease_id{};
+  EXPECT_FALSE(etcd_client.grantLease(60, lease_id));
+
+  // condition 2: 连接被拒绝时请求没有执行，换端点重试
+  EXPECT_CALL(*shell, execute(testing::AllOf(testing::HasSubstr("https://10.0.0.1:2379 "),
+                                             testing::HasSubstr(" put ")),
+                              testing::_, testing::_))
+      .WillOnce(testing::DoAll(
+          testing::SetArgReferee<2>("Error: rpc error: code = Unavailable desc = connection "
+                                    "error: connect: connection refused"),
+          testing::Return(1)));
+  EXPECT_CALL(*shell, execute(testing::AllOf(testing::HasSubstr("https://10.0.0.2:2379 "),
+                                             testing::HasSubstr(" put ")),
+                              testing::_, testing::_))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>("OK"), testing::Return(0)));
+  EXPECT_TRUE(etcd_client.put("test-key", "test-value"));
+}
+
+// 测试对冲读取先返回的结果
+TEST(EtcdClientShellEndpointTest, HedgedRead) {
+  auto mock_shell = std::make_unique<MockShellSync>();
+  auto *shell = mock_shell.get();
+  EtcdData etcd_data{"https://10.0.0.1:2379,https://10.0.0.2:2379"};
+  etcd_data.hedge_reads_ = true;
+  EtcdClientShell etcd_client{etcd_data, std::move(mock_shell), std::make_unique<EnvStd>()};
+
+  // 第一个端点超过默认预算才返回，第二个端点立即返回
+  auto slow = DEFAULT_HEDGE_BUDGET + std::chrono::milliseconds{100};
+  EXPECT_CALL(*shell, execute(testing::HasSubstr("--endpoints=https://10.0.0.1:2379 "), testing::_,
+                              testing::_))
+      .WillOnce([slow](std::string_view, std::string &output, std::string &) {
+        std::this_thread::sleep_for(slow);
+        output = "slow-value";
+        return 0;
+      });
+  EXPECT_CALL(*shell, execute(testing::HasSubstr("--endpoints=https://10.0.0.2:2379 "), testing::_,
+                              testing::_))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>("fast-value"), testing::Return(0)));
+
+  std::string value{};
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(etcd_client.get("test-key", value));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, slow);
+  EXPECT_EQ(value, "fast-value");
+
+  // 等待输掉的请求结束，它的延迟同样会被记录
+  std::this_thread::sleep_for(slow);
+  EXPECT_EQ(etcd_client.getSelector().getOrder().front(), 1);
+}
+
+// 测试第一个请求因为与端点无关的错误失败时，不再向第二个端点发出对冲读
+TEST(EtcdClientShellEndpointTest, HedgedReadError) {
+  auto mock_shell = std::make_unique<MockShellSync>();
+  auto *shell = mock_shell.get();
+  EtcdData etcd_data{"https://10.0.0.1:2379,https://10.0.0.2:2379"};
+  etcd_data.hedge_reads_ = true;
+  EtcdClientShell etcd_client{etcd_data, std::move(mock_shell), std::make_unique<EnvStd>()};
+
+  EXPECT_CALL(*shell, execute(testing::HasSubstr("--endpoints=https://10.0.0.1:2379 "), testing::_,
+                              testing::_))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<2>("Error: etcdserver: permission denied"),
+                               testing::Return(1)));
+  EXPECT_CALL(*shell, execute(testing::HasSubstr("--endpoints=https://10.0.0.2:2379 "), testing::_,
+                              testing::_))
+      .Times(0);
+  std::string value{};
+  EXPECT_FALSE(etcd_client.get("test-key", value));
+
+  // 等待后台线程释放 shell
+  std::this_thread::sleep_for(std::chrono::milliseconds{100});
+}
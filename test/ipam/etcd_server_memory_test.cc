@@ -0,0 +1,196 @@
+// clang-format off
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "gtest/gtest.h"
+#include "src/etcd/etcd_client_shell.h"
+#include "src/etcd/etcd_server_memory.h"
+#include "src/util/env_std.h"
+// clang-format on
+
+using namespace ohno::util;
+using namespace ohno::etcd;
+
+constexpr std::string_view ENDPOINTS{"https://10.0.0.1:2379,https://10.0.0.2:2379"};
+
+static auto makeClient(const std::shared_ptr<EtcdServerMemory> &server,
+                       std::string_view endpoints = ENDPOINTS) -> std::unique_ptr<EtcdClientShell> {
+  return std::make_unique<EtcdClientShell>(
+      EtcdData{endpoints}, std::make_unique<EtcdctlMemory>(server), std::make_unique<EnvStd>());
+}
+
+// 测试 EtcdClientShell 的读写命令在内存 ETCD 上的行为与真实集群一致
+TEST(EtcdServerMemoryTest, KeyValue) {
+  auto server = std::make_shared<EtcdServerMemory>();
+  auto client = makeClient(server);
+  EXPECT_TRUE(client->test());
+
+  // condition 1: put / get / append / list
+  EXPECT_TRUE(client->put("/ohno/a", "1"));
+  EXPECT_TRUE(client->append("/ohno/a", "2"));
+  std::string value{};
+  EXPECT_TRUE(client->get("/ohno/a", value));
+  EXPECT_EQ(value, "1,2");
+  std::vector<std::string> values{};
+  EXPECT_TRUE(client->list("/ohno/a", values));
+  EXPECT_EQ(values, (std::vector<std::string>{"1", "2"}));
+  EXPECT_TRUE(client->get("/ohno/none", value));
+  EXPECT_TRUE(value.empty());
+
+  // condition 2: 前缀读取与删除
+  EXPECT_TRUE(client->put("/ohno/b", "10.244.1.0/24"));
+  EXPECT_TRUE(client->put("/other/c", "3"));
+  std::unordered_map<std::string, std::string> map{};
+  EXPECT_TRUE(client->get("/ohno/", map));
+  EXPECT_EQ(map, (std::unordered_map<std::string, std::string>{{"/ohno/a", "1,2"},
+                                                               {"/ohno/b", "10.244.1.0/24"}}));
+  EXPECT_TRUE(client->del("/ohno/a", "1"));
+  EXPECT_TRUE(client->get("/ohno/a", value));
+  EXPECT_EQ(value, "2");
+  EXPECT_TRUE(client->delPrefix("/ohno/"));
+  EXPECT_EQ(server->size(), 1);
+
+  // condition 3: 每个写请求使 revision 加一
+  EXPECT_EQ(server->getRevision(), 7);
+  EXPECT_EQ(server->getRequests("put"), 5);
+}
+
+// 测试租约与事务
+TEST(EtcdServerMemoryTest, LeaseAndTxn) {
+  auto server = std::make_shared<EtcdServerMemory>();
+  auto client = makeClient(server);
+
+  // condition 1: 租约过期之后绑定的 key 被删除，不能再续约
+  std::string lease_id{};
+  ASSERT_TRUE(client->grantLease(60, lease_id));
+  EXPECT_EQ(lease_id.size(), 16);
+  EXPECT_TRUE(client->put("/ohno/node", "alive", lease_id));
+  EXPECT_TRUE(client->keepAliveLease(lease_id));
+  EXPECT_TRUE(server->expireLease(lease_id));
+  std::string value{};
+  EXPECT_TRUE(client->get("/ohno/node", value));
+  EXPECT_TRUE(value.empty());
+  EXPECT_FALSE(client->keepAliveLease(lease_id));
+  EXPECT_FALSE(client->put("/ohno/node", "alive", lease_id));
+
+  // condition 2: 事务中的所有操作共用一个 revision
+  auto revision = server->getRevision();
+  EtcdTxn txn{};
+  txn.put("/ohno/a", "10.244.1.2,10.244.1.3").put("/ohno/b", "b").del("/ohno/node");
+  EXPECT_EQ(client->commit(txn), TxnResult::committed);
+  EXPECT_EQ(server->getRevision(), revision + 1);
+  EXPECT_TRUE(client->get("/ohno/a", value));
+  EXPECT_EQ(value, "10.244.1.2,10.244.1.3");
+
+  // condition 3: 引用了不存在的租约时整个事务不生效
+  txn.clear();
+  txn.del("/ohno/a").put("/ohno/c", "c", lease_id);
+  EXPECT_EQ(client->commit(txn), TxnResult::failed);
+  EXPECT_TRUE(client->get("/ohno/a", value));
+  EXPECT_FALSE(value.empty());
+
+  // condition 4: 读取之后 key 被其他客户端修改，比较条件不成立，整个事务不生效
+  int64_t mod_revision{0};
+  ASSERT_TRUE(client->get("/ohno/a", value, mod_revision));
+  EXPECT_EQ(mod_revision, revision + 1);
+  EXPECT_TRUE(client->put("/ohno/a", "10.244.1.2"));
+  txn.clear();
+  txn.compare(TxnCmpTarget::mod, "/ohno/a", mod_revision).put("/ohno/a", "lost");
+  EXPECT_EQ(client->commit(txn), TxnResult::conflicted);
+  EXPECT_TRUE(client->get("/ohno/a", value));
+  EXPECT_EQ(value, "10.244.1.2");
+
+  // condition 5: key 不存在时 revision 为 0，只有第一个创建者成功
+  ASSERT_TRUE(client->get("/ohno/d", value, mod_revision));
+  EXPECT_EQ(mod_revision, 0);
+  txn.clear();
+  txn.compare(TxnCmpTarget::create, "/ohno/d", 0).put("/ohno/d", "d");
+  EXPECT_EQ(client->commit(txn), TxnResult::committed);
+  EXPECT_EQ(client->commit(txn), TxnResult::conflicted);
+
+  // condition 6: value 中的引号、反斜杠、换行与 " | " 经过 shell 与 etcdctl 两层转义后原样写入
+  const std::string special{"it's \"quoted\" | a\\b\nnext line"};
+  txn.clear();
+  txn.put("/ohno/e", special);
+  EXPECT_EQ(client->commit(txn), TxnResult::committed);
+  auto kvs = server->range("/ohno/e", false, revision);
+  ASSERT_EQ(kvs.size(), 1);
+  EXPECT_EQ(kvs.front().second.value_, special);
+}
+
+// 测试快照、watch 与压缩
+TEST(EtcdServerMemoryTest, WatchAndCompaction) {
+  auto server = std::make_shared<EtcdServerMemory>();
+  auto client = makeClient(server);
+  ASSERT_TRUE(client->put("/ohno/a", "1"));
+
+  std::unordered_map<std::string, std::string> values{};
+  int64_t revision{0};
+  ASSERT_TRUE(client->snapshot("/ohno/", values, revision));
+  EXPECT_EQ(values.size(), 1);
+
+  // condition 1: 从快照之后的 revision 开始，依次收到前缀下的事件
+  std::vector<WatchEvent> events{};
+  std::thread watcher{[&]() {
+    auto result = client->watch("/ohno/", revision + 1, [&](const std::vector<WatchEvent> &batch) {
+      events.insert(events.end(), batch.begin(), batch.end());
+      return events.size() < 2;
+    });
+    EXPECT_EQ(result, WatchResult::stopped);
+  }};
+  ASSERT_TRUE(client->put("/other/x", "x"));
+  ASSERT_TRUE(client->put("/ohno/b", "2"));
+  ASSERT_TRUE(client->del("/ohno/a"));
+  watcher.join();
+  ASSERT_EQ(events.size(), 2);
+  EXPECT_EQ(events[0].type_, WatchEventType::put);
+  EXPECT_EQ(events[0].key_, "/ohno/b");
+  EXPECT_EQ(events[0].value_, "2");
+  EXPECT_EQ(events[1].type_, WatchEventType::del);
+  EXPECT_EQ(events[1].revision_, server->getRevision());
+
+  // condition 2: 压缩之后从更早的 revision 开始 watch 失败
+  EXPECT_TRUE(server->compact(server->getRevision()));
+  EXPECT_FALSE(server->compact(revision));
+  auto result = client->watch("/ohno/", revision + 1, [](const std::vector<WatchEvent> &) {
+    return true;
+  });
+  EXPECT_EQ(result, WatchResult::compacted);
+
+  // condition 3: 自动压缩只保留最近的 revision
+  server->setAutoCompaction(2);
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(client->put("/ohno/c", std::to_string(i)));
+  }
+  EXPECT_EQ(server->getCompactRevision(), server->getRevision() - 2);
+}
+
+// 测试故障注入：端点不可用时客户端切换端点，请求被拒绝时直接失败，超时的请求可能已经生效
+TEST(EtcdServerMemoryTest, Fault) {
+  auto server = std::make_shared<EtcdServerMemory>(1);
+  auto client = makeClient(server);
+
+  // condition 1: 一个端点不可用
+  server->setFault("https://10.0.0.1:2379", EtcdFault{1, 0, 0});
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(client->put("/ohno/a", std::to_string(i)));
+  }
+  EXPECT_GT(server->getFaults(), 0);
+
+  // condition 2: 请求被拒绝
+  server->setFault({}, EtcdFault{0, 1, 0});
+  server->setFault("https://10.0.0.1:2379", EtcdFault{0, 1, 0});
+  EXPECT_FALSE(client->put("/ohno/a", "x"));
+
+  // condition 3: 客户端超时，但是写入已经生效
+  server->setFault({}, EtcdFault{0, 0, 1});
+  server->setFault("https://10.0.0.1:2379", EtcdFault{0, 0, 1});
+  EXPECT_FALSE(client->put("/ohno/b", "y"));
+  server->setFault({}, EtcdFault{});
+  server->setFault("https://10.0.0.1:2379", EtcdFault{});
+  std::string value{};
+  EXPECT_TRUE(client->get("/ohno/b", value));
+  EXPECT_EQ(value, "y");
+}
@@ -0,0 +1,87 @@
+// clang-format off
+#include "gtest/gtest.h"
+#include "src/ipam/ip_allocator.h"
+// clang-format on
+
+using namespace ohno::ipam;
+using namespace ohno::net;
+
+// 测试 IPv4 分配：跳过网络地址与广播地址
+TEST(IpAllocatorTest, AllocateIpv4) {
+  IpAllocator allocator{*IpPrefix::parse("192.168.1.0/30")};
+
+  EXPECT_EQ(allocator.allocate()->toString(), "192.168.1.1");
+  EXPECT_EQ(allocator.allocate()->toString(), "192.168.1.2");
+  EXPECT_FALSE(allocator.allocate().has_value());
+
+  EXPECT_TRUE(allocator.release(*IpAddr::parse("192.168.1.1")));
+  EXPECT_FALSE(allocator.release(*IpAddr::parse("192.168.1.1")));
+  EXPECT_EQ(allocator.allocate()->toString(), "192.168.1.1");
+}
+
+// 测试预留地址后总是分配最小的空闲地址，相邻区间会被合并
+TEST(IpAllocatorTest, ReserveAndMerge) {
+  IpAllocator allocator{*IpPrefix::parse("10.244.1.0/24")};
+
+  EXPECT_TRUE(allocator.reserve(*IpAddr::parse("10.244.1.1")));
+  EXPECT_TRUE(allocator.reserve(*IpAddr::parse("10.244.1.3")));
+  EXPECT_FALSE(allocator.reserve(*IpAddr::parse("10.244.1.3")));
+  EXPECT_FALSE(allocator.reserve(*IpAddr::parse("10.244.2.1")));  // 不属于子网
+  EXPECT_FALSE(allocator.reserve(*IpAddr::parse("10.244.1.255"))); // 广播地址
+  EXPECT_EQ(allocator.getIntervalSize(), 2);
+
+  EXPECT_EQ(allocator.allocate()->toString(), "10.244.1.2");
+  EXPECT_EQ(allocator.getIntervalSize(), 1);
+  EXPECT_EQ(allocator.allocate()->toString(), "10.244.1.4");
+
+  // 从中间归还会拆分区间
+  EXPECT_TRUE(allocator.release(*IpAddr::parse("10.244.1.2")));
+  EXPECT_EQ(allocator.getIntervalSize(), 2);
+  EXPECT_FALSE(allocator.isReserved(*IpAddr::parse("10.244.1.2")));
+  EXPECT_TRUE(allocator.isReserved(*IpAddr::parse("10.244.1.3")));
+}
+
+// 测试 IPv6 /64 分配
+TEST(IpAllocatorTest, AllocateIpv6) {
+  IpAllocator allocator{*IpPrefix::parse("fd00:10:244:1::/64")};
+
+  EXPECT_TRUE(allocator.reserve(*IpAddr::parse("fd00:10:244:1::1")));
+  EXPECT_EQ(allocator.allocate()->toString(), "fd00:10:244:1::2");
+  EXPECT_FALSE(allocator.reserve(*IpAddr::parse("10.244.1.1"))); // 不同地址族
+
+  // IPv6 没有广播地址，最后一个地址也可以分配
+  EXPECT_TRUE(allocator.reserve(*IpAddr::parse("fd00:10:244:1:ffff:ffff:ffff:ffff")));
+  EXPECT_EQ(allocator.getIntervalSize(), 2);
+}
+
+// 测试在地址块内分配
+TEST(IpAllocatorTest, AllocateInRange) {
+  IpAllocator allocator{*IpPrefix::parse("10.244.1.0/24")};
+
+  // 第一个地址块跳过网络地址，最后一个地址块跳过广播地址
+  EXPECT_EQ(allocator.allocate(*IpPrefix::parse("10.244.1.0/30"))->toString(), "10.244.1.1");
+  EXPECT_EQ(allocator.allocate(*IpPrefix::parse("10.244.1.0/30"))->toString(), "10.244.1.2");
+  EXPECT_EQ(allocator.allocate(*IpPrefix::parse("10.244.1.0/30"))->toString(), "10.244.1.3");
+  EXPECT_FALSE(allocator.allocate(*IpPrefix::parse("10.244.1.0/30")).has_value());
+  EXPECT_EQ(allocator.allocate(*IpPrefix::parse("10.244.1.252/30"))->toString(), "10.244.1.252");
+  EXPECT_EQ(allocator.allocate(*IpPrefix::parse("10.244.1.16/28"))->toString(), "10.244.1.16");
+  EXPECT_FALSE(allocator.allocate(*IpPrefix::parse("10.244.2.0/30")).has_value()); // 不属于子网
+}
+
+// 测试整体预留地址块：与重叠、相邻的区间合并，之后的最小空闲地址落在下一个地址块
+TEST(IpAllocatorTest, ReserveRange) {
+  IpAllocator allocator{*IpPrefix::parse("10.244.1.0/24")};
+
+  EXPECT_TRUE(allocator.reserve(*IpAddr::parse("10.244.1.2")));
+  EXPECT_TRUE(allocator.reserve(*IpAddr::parse("10.244.1.9")));
+  allocator.reserve(*IpPrefix::parse("10.244.1.0/30"));
+  allocator.reserve(*IpPrefix::parse("10.244.1.4/30"));
+  EXPECT_EQ(allocator.getIntervalSize(), 2);
+  EXPECT_EQ(allocator.allocate()->toString(), "10.244.1.8");
+  EXPECT_EQ(allocator.getIntervalSize(), 1);
+
+  allocator.reserve(*IpPrefix::parse("10.244.2.0/30")); // 不属于子网，忽略
+  allocator.reserve(*IpPrefix::parse("10.244.1.252/30"));
+  EXPECT_EQ(allocator.getIntervalSize(), 2);
+  EXPECT_FALSE(allocator.allocate(*IpPrefix::parse("10.244.1.252/30")).has_value());
+}
@@ -1,29 +1,39 @@
 // clang-format off
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
 #include "gtest/gtest.h"
-#include "gmock/gmock.h"
+#include "nlohmann/json.hpp"
+#include "spdlog/fmt/fmt.h"
 #include "src/etcd/etcd_client_shell.h"
+#include "src/ipam/ip_block.h"
 #include "src/ipam/ipam.h"
+#include "test/mock/etcd_client_mock.h"
 // clang-format on
 
 using namespace ohno::etcd;
 using namespace ohno::ipam;
 using namespace ohno::util;
 
-class MockEtcdClient : public EtcdClientIf {
-public:
-  MOCK_METHOD(bool, test, (), (const, override));
-  MOCK_METHOD(bool, put, (std::string_view key, std::string_view value), (const, override));
-  MOCK_METHOD(bool, append, (std::string_view key, std::string_view value), (const, override));
-  MOCK_METHOD(bool, get, (std::string_view key, std::string &value), (const, override));
-  MOCK_METHOD(bool, get,
-              (std::string_view key, (std::unordered_map<std::string, std::string> & value)),
-              (const, override));
-  MOCK_METHOD(bool, del, (std::string_view key), (const, override));
-  MOCK_METHOD(bool, del, (std::string_view key, std::string_view value), (const, override));
-  MOCK_METHOD(bool, list, (std::string_view key, std::vector<std::string> &results),
-              (const, override));
-  MOCK_METHOD(std::string, dump, (std::string_view key), (const, override));
-};
+using EtcdEntries = std::unordered_map<std::string, std::string>;
+
+// 匹配只在地址 key 不存在时写入的事务
+static auto createsAddress(const std::string &key, const std::string &value) {
+  return testing::Truly([key, value](const EtcdTxn &txn) {
+    const auto &cmps = txn.getCmps();
+    return cmps.size() == 1 && cmps[0].target_ == TxnCmpTarget::create && cmps[0].key_ == key &&
+           cmps[0].revision_ == 0 && txn.size() == 1 && txn.find(key) == value;
+  });
+}
+
+// 匹配一次写回 journal 的事务：没有比较条件，只包含给定的操作（value 为空表示删除）
+static auto flushesJournal(const EtcdEntries &ops) {
+  return testing::Truly([ops](const EtcdTxn &txn) {
+    return txn.getCmps().empty() && txn.size() == ops.size() &&
+           std::all_of(ops.begin(), ops.end(),
+                       [&txn](const auto &op) { return txn.find(op.first) == op.second; });
+  });
+}
 
 class IpamTest : public ::testing::Test {
 protected:
@@ -32,19 +42,22 @@ protected:
     auto mock_etcd_client = std::make_unique<MockEtcdClient>();
     mock_etcd_client_ = mock_etcd_client.get();
     ipam_->init(std::move(mock_etcd_client));
+    state_dir_ = testing::TempDir() + "ohno-ipam-state";
+    std::filesystem::remove_all(state_dir_);
+    ipam_->setStateDir(state_dir_);
   }
 
-  void TearDown() override {}
+  void TearDown() override { std::filesystem::remove_all(state_dir_); }
 
   std::unique_ptr<Ipam> ipam_;
   MockEtcdClient *mock_etcd_client_;
+  std::string state_dir_;
 };
 
 TEST_F(IpamTest, ReleaseSubnet) {
   std::string subnet{};
 
-  EXPECT_CALL(*mock_etcd_client_, del(testing::_)).WillOnce(testing::DoAll(testing::Return(true)));
-  EXPECT_CALL(*mock_etcd_client_, del(testing::_, testing::_))
+  EXPECT_CALL(*mock_etcd_client_, del("/ohno/subnets/test-node"))
       .WillOnce(testing::DoAll(testing::Return(true)));
 
   bool result = ipam_->releaseSubnet("test-node", "192.168.1.0/26");
@@ -57,21 +70,331 @@ TEST_F(IpamTest, AllocateIP) {
   EXPECT_CALL(*mock_etcd_client_, get(testing::_, testing::Matcher<std::string &>(testing::_)))
       .WillOnce(testing::DoAll(testing::SetArgReferee<1>("192.168.1.0/26"),
                                testing::Return(true))); // 返回一个子网
-  EXPECT_CALL(*mock_etcd_client_, list(testing::_, testing::_))
-      .WillRepeatedly(testing::DoAll(testing::SetArgReferee<1>(std::vector<std::string>{}),
-                                     testing::Return(true))); // 总是返回空 IP 列表
-  EXPECT_CALL(*mock_etcd_client_, append(testing::_, testing::_))
-      .WillOnce(testing::Return(true)); // 追加操作成功
+  EXPECT_CALL(*mock_etcd_client_, get("/ohno/addresses/test-node", testing::An<EtcdEntries &>()))
+      .WillRepeatedly(testing::Return(true)); // 总是返回空 IP 列表
+  EXPECT_CALL(*mock_etcd_client_,
+              commit(createsAddress("/ohno/addresses/test-node/192.168.1.1", "192.168.1.1/26")))
+      .WillOnce(testing::Return(TxnResult::committed)); // 只写入一个 key
 
   bool result = ipam_->allocateIp("test-node", ip);
   EXPECT_TRUE(result);
   EXPECT_STREQ(ip.c_str(), "192.168.1.1/26");
 }
 
+// 测试并发分配：另一个 CNI 先写入了同一个地址，重新读取之后挑选下一个地址
+TEST_F(IpamTest, AllocateIpConflict) {
+  std::string ip{};
+
+  EXPECT_CALL(*mock_etcd_client_, get(testing::_, testing::Matcher<std::string &>(testing::_)))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>("192.168.1.0/26"),
+                               testing::Return(true)));
+  EtcdEntries used{{"/ohno/addresses/test-node/192.168.1.1", "192.168.1.1/26"}};
+  EXPECT_CALL(*mock_etcd_client_, get("/ohno/addresses/test-node", testing::An<EtcdEntries &>()))
+      .WillOnce(testing::Return(true))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>(used), testing::Return(true)));
+  EXPECT_CALL(*mock_etcd_client_,
+              commit(createsAddress("/ohno/addresses/test-node/192.168.1.1", "192.168.1.1/26")))
+      .WillOnce(testing::Return(TxnResult::conflicted));
+  EXPECT_CALL(*mock_etcd_client_,
+              commit(createsAddress("/ohno/addresses/test-node/192.168.1.2", "192.168.1.2/26")))
+      .WillOnce(testing::Return(TxnResult::committed));
+  EXPECT_CALL(*mock_etcd_client_, put(testing::_, testing::_)).Times(0);
+
+  EXPECT_TRUE(ipam_->allocateIp("test-node", ip));
+  EXPECT_EQ(ip, "192.168.1.2/26");
+}
+
+TEST_F(IpamTest, AllocateDualStackIPs) {
+  std::vector<std::string> ips{};
+
+  EXPECT_CALL(*mock_etcd_client_, get(testing::_, testing::Matcher<std::string &>(testing::_)))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>("192.168.1.0/26,fd00:10:244:1::/64"),
+                               testing::Return(true))); // 返回双栈子网
+  EtcdEntries used{{"/ohno/addresses/test-node/192.168.1.1", "192.168.1.1/26"},
+                   {"/ohno/addresses/test-node/fd00:10:244:1::1", "fd00:10:244:1::1/64"}};
+  EXPECT_CALL(*mock_etcd_client_, get(testing::_, testing::An<EtcdEntries &>()))
+      .WillRepeatedly(testing::DoAll(testing::SetArgReferee<1>(used),
+                                     testing::Return(true))); // 两个地址族各有一个已分配地址
+  EXPECT_CALL(*mock_etcd_client_, commit(testing::_))
+      .Times(2)
+      .WillRepeatedly(testing::Return(TxnResult::committed));
+
+  bool result = ipam_->allocateIps("test-node", ips);
+  EXPECT_TRUE(result);
+  EXPECT_EQ(ips, (std::vector<std::string>{"192.168.1.2/26", "fd00:10:244:1::2/64"}));
+}
+
 TEST_F(IpamTest, ReleaseIp) {
-  EXPECT_CALL(*mock_etcd_client_, del(testing::_, testing::_))
+  // 旧布局的列表只在第一次归还时读取，确认不存在之后留下迁移标记
+  EXPECT_CALL(*mock_etcd_client_, list("/ohno/addresses/test-node", testing::_))
+      .WillOnce(testing::Return(true)); // 没有旧布局的列表
+  EXPECT_CALL(*mock_etcd_client_, del("/ohno/addresses/test-node/192.168.1.1"))
+      .WillOnce(testing::DoAll(testing::Return(true)));
+  EXPECT_CALL(*mock_etcd_client_, del("/ohno/addresses/test-node/192.168.1.2"))
       .WillOnce(testing::DoAll(testing::Return(true)));
 
-  bool result = ipam_->releaseIp("test-node", "192.168.1.1");
-  EXPECT_TRUE(result);
+  EXPECT_TRUE(ipam_->releaseIp("test-node", "192.168.1.1"));
+  EXPECT_TRUE(ipam_->releaseIp("test-node", "192.168.1.2"));
+}
+
+TEST_F(IpamTest, LeaseBlock) {
+  auto state_dir = testing::TempDir() + "ohno-ipam-lease";
+  std::filesystem::remove_all(state_dir);
+  ASSERT_TRUE(ipam_->enableBlockLease(16, 3, state_dir));
+
+  EXPECT_CALL(*mock_etcd_client_, get(testing::_, testing::Matcher<std::string &>(testing::_)))
+      .WillRepeatedly(
+          testing::DoAll(testing::SetArgReferee<1>("192.168.1.0/24"), testing::Return(true)));
+  EXPECT_CALL(*mock_etcd_client_, get(testing::_, testing::An<EtcdEntries &>()))
+      .WillRepeatedly(testing::Return(true));
+  // 多次分配只租用一次地址块，journal 攒满 3 条后一起写回
+  EXPECT_CALL(*mock_etcd_client_, put("/ohno/blocks/test-node/192.168.1.0", "192.168.1.0/28"))
+      .WillOnce(testing::Return(true));
+  EXPECT_CALL(*mock_etcd_client_,
+              commit(flushesJournal({{"/ohno/addresses/test-node/192.168.1.1", "192.168.1.1/24"},
+                                     {"/ohno/addresses/test-node/192.168.1.2", "192.168.1.2/24"},
+                                     {"/ohno/addresses/test-node/192.168.1.3", "192.168.1.3/24"}})))
+      .WillOnce(testing::Return(TxnResult::committed));
+  EXPECT_CALL(*mock_etcd_client_, del(testing::_)).Times(0);
+
+  std::string ip{};
+  for (auto expected : {"192.168.1.1/24", "192.168.1.2/24", "192.168.1.3/24"}) {
+    ASSERT_TRUE(ipam_->allocateIp("test-node", ip));
+    EXPECT_EQ(ip, expected);
+  }
+
+  // 归还与再次分配都只修改本地状态，并且相互抵消
+  EXPECT_TRUE(ipam_->releaseIp("test-node", "192.168.1.2/24"));
+  ASSERT_TRUE(ipam_->allocateIp("test-node", ip));
+  EXPECT_EQ(ip, "192.168.1.2/24");
+
+  std::filesystem::remove_all(state_dir);
+}
+
+// 测试本地状态文件丢失：从 ETCD 重建，Pod 记录引用但没有写回的地址重新记入 journal
+TEST_F(IpamTest, RebuildState) {
+  auto state_dir = testing::TempDir() + "ohno-ipam-rebuild";
+  std::filesystem::remove_all(state_dir);
+  ASSERT_TRUE(ipam_->enableBlockLease(16, 2, state_dir));
+
+  EXPECT_CALL(*mock_etcd_client_, get(testing::_, testing::Matcher<std::string &>(testing::_)))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>("192.168.1.0/24"), testing::Return(true)));
+  EtcdEntries blocks{{"/ohno/blocks/test-node/192.168.1.0", "192.168.1.0/28"}};
+  EXPECT_CALL(*mock_etcd_client_, get("/ohno/blocks/test-node/", testing::An<EtcdEntries &>()))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>(blocks), testing::Return(true)));
+  EtcdEntries addrs{{"/ohno/addresses/test-node/192.168.1.1", "192.168.1.1/24"}};
+  EXPECT_CALL(*mock_etcd_client_, get("/ohno/addresses/test-node", testing::An<EtcdEntries &>()))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>(addrs), testing::Return(true)));
+  EtcdEntries pods{{"/ohno/node/test-node/pod/p1/nic/eth0/addr", "192.168.1.1/24,192.168.1.2/24"},
+                   {"/ohno/node/test-node/pod/p1/nic/eth0/route", "192.168.1.3/32"}};
+  EXPECT_CALL(*mock_etcd_client_, get("/ohno/node/test-node/pod/", testing::An<EtcdEntries &>()))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>(pods), testing::Return(true)));
+  // 丢失的 192.168.1.2 与新分配的 192.168.1.3 在一个事务中写回，地址块不需要重新租用
+  EXPECT_CALL(*mock_etcd_client_,
+              commit(flushesJournal({{"/ohno/addresses/test-node/192.168.1.2", "192.168.1.2/24"},
+                                     {"/ohno/addresses/test-node/192.168.1.3", "192.168.1.3/24"}})))
+      .WillOnce(testing::Return(TxnResult::committed));
+
+  std::string ip{};
+  ASSERT_TRUE(ipam_->allocateIp("test-node", ip));
+  EXPECT_EQ(ip, "192.168.1.3/24");
+
+  std::filesystem::remove_all(state_dir);
+}
+
+// 测试租用地址块：跳过已租用的地址块以及块外已分配的地址，一次读取找到空闲地址块；
+// 节点空闲时归还没有地址的地址块
+TEST_F(IpamTest, LeaseAndReleaseBlocks) {
+  auto state_dir = testing::TempDir() + "ohno-ipam-blocks";
+  std::filesystem::remove_all(state_dir);
+  ASSERT_TRUE(ipam_->enableBlockLease(4, 16, state_dir));
+
+  EXPECT_CALL(*mock_etcd_client_, get(testing::_, testing::Matcher<std::string &>(testing::_)))
+      .WillRepeatedly(
+          testing::DoAll(testing::SetArgReferee<1>("192.168.1.0/24"), testing::Return(true)));
+  EtcdEntries blocks{{"/ohno/blocks/test-node/192.168.1.0", "192.168.1.0/30"},
+                     {"/ohno/blocks/test-node/192.168.1.4", "192.168.1.4/30"}};
+  EXPECT_CALL(*mock_etcd_client_, get("/ohno/blocks/test-node/", testing::An<EtcdEntries &>()))
+      .WillRepeatedly(testing::DoAll(testing::SetArgReferee<1>(blocks), testing::Return(true)));
+  EtcdEntries addrs{};
+  for (auto addr : {"192.168.1.1", "192.168.1.2", "192.168.1.3", "192.168.1.4", "192.168.1.5",
+                    "192.168.1.6", "192.168.1.7", "192.168.1.8"}) {
+    addrs.emplace(fmt::format("/ohno/addresses/test-node/{}", addr), fmt::format("{}/24", addr));
+  }
+  EXPECT_CALL(*mock_etcd_client_, get("/ohno/addresses/test-node", testing::An<EtcdEntries &>()))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>(addrs), testing::Return(true)));
+  EXPECT_CALL(*mock_etcd_client_, get("/ohno/node/test-node/pod/", testing::An<EtcdEntries &>()))
+      .WillOnce(testing::Return(true));
+  EXPECT_CALL(*mock_etcd_client_, put("/ohno/blocks/test-node/192.168.1.8", "192.168.1.8/30"))
+      .WillOnce(testing::Return(true));
+
+  std::string ip{};
+  ASSERT_TRUE(ipam_->allocateIp("test-node", ip));
+  EXPECT_EQ(ip, "192.168.1.9/24");
+
+  // 192.168.1.8/30 中还有块外分配的地址，只归还已经空了的 192.168.1.0/30
+  for (auto addr : {"192.168.1.1/24", "192.168.1.2/24", "192.168.1.3/24", "192.168.1.9/24"}) {
+    EXPECT_TRUE(ipam_->releaseIp("test-node", addr));
+  }
+  EXPECT_CALL(*mock_etcd_client_, del("/ohno/blocks/test-node/192.168.1.0"))
+      .WillOnce(testing::Return(true));
+  EXPECT_TRUE(ipam_->releaseEmptyBlocks("test-node"));
+
+  std::filesystem::remove_all(state_dir);
+}
+
+// 测试读取已租用的地址块失败：不租用新的地址块，分配失败
+TEST_F(IpamTest, LeaseBlockGetFailed) {
+  auto state_dir = testing::TempDir() + "ohno-ipam-lease-failed";
+  std::filesystem::remove_all(state_dir);
+  ASSERT_TRUE(ipam_->enableBlockLease(16, 16, state_dir));
+  std::filesystem::create_directories(state_dir);
+  std::ofstream{state_dir + "/test-node.json"} << "{}";
+
+  EXPECT_CALL(*mock_etcd_client_, get(testing::_, testing::Matcher<std::string &>(testing::_)))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>("192.168.1.0/24"), testing::Return(true)));
+  EXPECT_CALL(*mock_etcd_client_, get("/ohno/blocks/test-node/", testing::An<EtcdEntries &>()))
+      .WillOnce(testing::Return(false));
+  EXPECT_CALL(*mock_etcd_client_, put(testing::_, testing::_)).Times(0);
+
+  std::string ip{};
+  EXPECT_FALSE(ipam_->allocateIp("test-node", ip));
+  EXPECT_TRUE(ip.empty());
+
+  std::filesystem::remove_all(state_dir);
+}
+
+// 测试旧格式的状态文件：地址块内的地址转为位图，块外的地址按原样保留；
+// 分配与尚未写回的归还相互抵消，写回超过一个事务的操作数上限时分多个事务提交
+TEST_F(IpamTest, BlockStateFormat) {
+  auto state_dir = testing::TempDir() + "ohno-ipam-format";
+  std::filesystem::remove_all(state_dir);
+  ASSERT_TRUE(ipam_->enableBlockLease(256, 100, state_dir));
+  std::filesystem::create_directories(state_dir);
+  std::string journal{};
+  for (int i = 2; i < 200; ++i) {
+    journal += fmt::format("{}\"10.0.{}.{}/16\"", journal.empty() ? "" : ",", i / 256, i % 256);
+  }
+  std::ofstream{state_dir + "/test-node.json"}
+      << R"({"blocks":["10.0.0.0/24"],"allocated":["10.0.0.1/16","10.0.9.9/16","10.0.9.10/16",)"
+      << R"("10.0.3.0/16-10.0.3.9"],"journalDel":[)" << journal << "]}";
+
+  EXPECT_CALL(*mock_etcd_client_, get(testing::_, testing::Matcher<std::string &>(testing::_)))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>("10.0.0.0/16"), testing::Return(true)));
+  EXPECT_CALL(*mock_etcd_client_, commit(testing::_))
+      .WillOnce(testing::Invoke([](const EtcdTxn &txn) {
+        EXPECT_EQ(txn.size(), MAX_TXN_OPS);
+        return TxnResult::committed;
+      }))
+      .WillOnce(testing::Invoke([](const EtcdTxn &txn) {
+        EXPECT_EQ(txn.size(), 197 - MAX_TXN_OPS);
+        EXPECT_EQ(txn.find("/ohno/addresses/test-node/10.0.0.199"), "");
+        return TxnResult::committed;
+      }));
+
+  std::string ip{};
+  ASSERT_TRUE(ipam_->allocateIp("test-node", ip));
+  EXPECT_EQ(ip, "10.0.0.2/16");
+
+  std::ifstream file{state_dir + "/test-node.json"};
+  auto state = nlohmann::json::parse(file);
+  EXPECT_EQ(state["blocks"],
+            nlohmann::json::parse(R"([{"cidr":"10.0.0.0/24","used":[6,0,0,0]}])"));
+  EXPECT_EQ(state["allocated"],
+            nlohmann::json::parse(R"(["10.0.3.0/16-10.0.3.9","10.0.9.9/16-10.0.9.10"])"));
+  EXPECT_TRUE(state["journalAdd"].empty());
+  EXPECT_TRUE(state["journalDel"].empty());
+
+  std::filesystem::remove_all(state_dir);
+}
+
+TEST(IpBlockStateTest, OtherRanges) {
+  // 地址块之外的连续地址合并为地址段，归还中间的地址时拆分，租用地址块时块内部分改由位图记录
+  IpBlockState state{};
+  for (int i = 1; i <= 40; ++i) {
+    ASSERT_TRUE(state.use(fmt::format("10.0.0.{}/16", i)));
+  }
+  ASSERT_TRUE(state.use("10.0.1.1/16"));
+  EXPECT_EQ(state.others_.size(), 2U);
+  EXPECT_TRUE(state.release(ohno::net::IpAddr::parse("10.0.0.20").value()));
+  EXPECT_FALSE(state.release(ohno::net::IpAddr::parse("10.0.0.20").value()));
+  EXPECT_FALSE(state.isUsed(ohno::net::IpAddr::parse("10.0.0.20").value()));
+  EXPECT_TRUE(state.isUsed(ohno::net::IpAddr::parse("10.0.0.21").value()));
+  EXPECT_EQ(nlohmann::json(state)["allocated"],
+            nlohmann::json::parse(R"(["10.0.0.1/16-10.0.0.19","10.0.0.21/16-10.0.0.40",
+                                      "10.0.1.1/16"])"));
+
+  auto &block = state.addBlock(state.makeBlock(ohno::net::IpPrefix::parse("10.0.0.32/28").value()));
+  EXPECT_TRUE(block.isUsed(ohno::net::IpAddr::parse("10.0.0.40").value()));
+  EXPECT_FALSE(block.isUsed(ohno::net::IpAddr::parse("10.0.0.41").value()));
+  EXPECT_TRUE(state.release(ohno::net::IpAddr::parse("10.0.0.33").value()));
+  auto json = nlohmann::json(state);
+  EXPECT_EQ(json["allocated"],
+            nlohmann::json::parse(R"(["10.0.0.1/16-10.0.0.19","10.0.0.21/16-10.0.0.31",
+                                      "10.0.1.1/16"])"));
+
+  auto loaded = json.get<IpBlockState>();
+  EXPECT_EQ(nlohmann::json(loaded), json);
+  EXPECT_TRUE(loaded.isUsed(ohno::net::IpAddr::parse("10.0.0.31").value()));
+  EXPECT_FALSE(loaded.isUsed(ohno::net::IpAddr::parse("10.0.0.33").value()));
+}
+
+TEST_F(IpamTest, Migrate) {
+  // 旧布局中以 ',' 分割的列表被拆分为每个条目一个 key
+  EXPECT_CALL(*mock_etcd_client_, list("/ohno/addresses/test-node", testing::_))
+      .WillOnce(testing::DoAll(
+          testing::SetArgReferee<1>(std::vector<std::string>{"192.168.1.1/24", "fd00::1/64"}),
+          testing::Return(true)));
+  EXPECT_CALL(*mock_etcd_client_, list("/ohno/blocks/test-node", testing::_))
+      .WillOnce(testing::Return(true));
+  EXPECT_CALL(*mock_etcd_client_, put("/ohno/addresses/test-node/192.168.1.1", "192.168.1.1/24"))
+      .WillOnce(testing::Return(true));
+  EXPECT_CALL(*mock_etcd_client_, put("/ohno/addresses/test-node/fd00::1", "fd00::1/64"))
+      .WillOnce(testing::Return(true));
+  EXPECT_CALL(*mock_etcd_client_, del("/ohno/addresses/test-node")).WillOnce(testing::Return(true));
+  EXPECT_CALL(*mock_etcd_client_, del("/ohno/subnets")).WillOnce(testing::Return(true));
+
+  EXPECT_TRUE(ipam_->migrate("test-node"));
+}
+
+// 测试 ohnod 迁移之前运行的 CNI：旧布局中的地址视为已占用，并且在第一次使用时迁移
+TEST_F(IpamTest, MigrateLazily) {
+  std::string ip{};
+
+  EXPECT_CALL(*mock_etcd_client_, get(testing::_, testing::Matcher<std::string &>(testing::_)))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>("192.168.1.0/26"),
+                               testing::Return(true)));
+  EtcdEntries used{{"/ohno/addresses/test-node", "192.168.1.1/26,192.168.1.2/26"},
+                   {"/ohno/addresses/test-node/192.168.1.3", "192.168.1.3/26"},
+                   {"/ohno/addresses/test-node1/192.168.1.4", "192.168.1.4/26"}};
+  EXPECT_CALL(*mock_etcd_client_, get("/ohno/addresses/test-node", testing::An<EtcdEntries &>()))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>(used), testing::Return(true)));
+  EXPECT_CALL(*mock_etcd_client_, list("/ohno/addresses/test-node", testing::_))
+      .WillOnce(testing::DoAll(
+          testing::SetArgReferee<1>(std::vector<std::string>{"192.168.1.1/26", "192.168.1.2/26"}),
+          testing::Return(true)));
+  EXPECT_CALL(*mock_etcd_client_, put("/ohno/addresses/test-node/192.168.1.1", "192.168.1.1/26"))
+      .WillOnce(testing::Return(true));
+  EXPECT_CALL(*mock_etcd_client_, put("/ohno/addresses/test-node/192.168.1.2", "192.168.1.2/26"))
+      .WillOnce(testing::Return(true));
+  EXPECT_CALL(*mock_etcd_client_, del("/ohno/addresses/test-node")).WillOnce(testing::Return(true));
+  // 其他节点（test-node1）的地址不影响本节点
+  EXPECT_CALL(*mock_etcd_client_,
+              commit(createsAddress("/ohno/addresses/test-node/192.168.1.4", "192.168.1.4/26")))
+      .WillOnce(testing::Return(TxnResult::committed));
+
+  EXPECT_TRUE(ipam_->allocateIp("test-node", ip));
+  EXPECT_EQ(ip, "192.168.1.4/26");
+}
+
+TEST(IpamInitTest, SkipHealthCheck) {
+  // 不检查健康时不执行 endpoint health，故障留给第一次访问 ETCD 时发现
+  auto mock_etcd_client = std::make_unique<MockEtcdClient>();
+  EXPECT_CALL(*mock_etcd_client, test()).Times(0);
+  Ipam ipam{};
+  EXPECT_TRUE(ipam.init(std::move(mock_etcd_client), false));
+
+  mock_etcd_client = std::make_unique<MockEtcdClient>();
+  EXPECT_CALL(*mock_etcd_client, test()).WillOnce(testing::Return(false));
+  EXPECT_FALSE(ipam.init(std::move(mock_etcd_client)));
 }
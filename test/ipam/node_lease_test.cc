@@ -0,0 +1,160 @@
+// clang-format off
+#include "gtest/gtest.h"
+#include "src/etcd/node_lease.h"
+#include "test/mock/etcd_client_mock.h"
+// clang-format on
+
+using namespace ohno::etcd;
+
+static auto expectGrant(MockEtcdClient *mock, std::string_view lease_id) -> void {
+  EXPECT_CALL(*mock, grantLease(30, testing::_))
+      .WillOnce(
+          testing::DoAll(testing::SetArgReferee<1>(std::string{lease_id}), testing::Return(true)));
+}
+
+static auto expectGet(MockEtcdClient *mock, std::string_view key, std::string_view value)
+    -> void {
+  EXPECT_CALL(*mock, get(key, testing::An<std::string &>()))
+      .WillOnce(testing::DoAll(testing::SetArgReferee<1>(std::string{value}),
+                               testing::Return(true)));
+}
+
+// 测试租约过期后重新申请，并恢复已随旧租约删除的 key
+TEST(NodeLeaseTest, KeepAlive) {
+  auto etcd_client = std::make_unique<MockEtcdClient>();
+  auto *mock = etcd_client.get();
+  std::vector<std::string> keys{"/ohno/subnets/test-node"};
+  NodeLease lease{std::move(etcd_client), "test-node", keys, 30};
+
+  testing::InSequence seq{};
+  // 首次申请：子网仍然存在，直接换绑到租约
+  expectGet(mock, "/ohno/leases/test-node", "");
+  expectGrant(mock, "1");
+  expectGet(mock, "/ohno/subnets/test-node", "10.244.1.0/24");
+  EXPECT_CALL(*mock, put("/ohno/subnets/test-node", "10.244.1.0/24", "1"))
+      .WillOnce(testing::Return(true));
+  EXPECT_CALL(*mock, put("/ohno/leases/test-node", "1", "1")).WillOnce(testing::Return(true));
+  EXPECT_TRUE(lease.keepAlive());
+  EXPECT_EQ(lease.getLeaseId(), "1");
+
+  // 正常续约，每次都重新读取 key
+  EXPECT_CALL(*mock, keepAliveLease("1")).WillOnce(testing::Return(true));
+  expectGet(mock, "/ohno/subnets/test-node", "10.244.1.0/24");
+  EXPECT_TRUE(lease.keepAlive());
+
+  // 租约过期：保存租约 ID 的 key 与子网都已被 ETCD 删除，用缓存恢复
+  EXPECT_CALL(*mock, keepAliveLease("1")).WillOnce(testing::Return(false));
+  expectGet(mock, "/ohno/leases/test-node", "");
+  expectGrant(mock, "2");
+  expectGet(mock, "/ohno/subnets/test-node", "");
+  EXPECT_CALL(*mock, put("/ohno/subnets/test-node", "10.244.1.0/24", "2"))
+      .WillOnce(testing::Return(true));
+  EXPECT_CALL(*mock, put("/ohno/leases/test-node", "2", "2")).WillOnce(testing::Return(true));
+  EXPECT_TRUE(lease.keepAlive());
+  EXPECT_EQ(lease.getLeaseId(), "2");
+}
+
+// 测试租约有效期间被有意删除的 key 在租约过期之后不会恢复
+TEST(NodeLeaseTest, DeletedOnPurpose) {
+  auto etcd_client = std::make_unique<MockEtcdClient>();
+  auto *mock = etcd_client.get();
+  std::vector<std::string> keys{"/ohno/subnets/test-node"};
+  NodeLease lease{std::move(etcd_client), "test-node", keys, 30};
+
+  testing::InSequence seq{};
+  expectGet(mock, "/ohno/leases/test-node", "");
+  expectGrant(mock, "1");
+  expectGet(mock, "/ohno/subnets/test-node", "10.244.1.0/24");
+  EXPECT_CALL(*mock, put("/ohno/subnets/test-node", "10.244.1.0/24", "1"))
+      .WillOnce(testing::Return(true));
+  EXPECT_CALL(*mock, put("/ohno/leases/test-node", "1", "1")).WillOnce(testing::Return(true));
+  EXPECT_TRUE(lease.keepAlive());
+
+  // 续约时子网已经不存在（比如节点被回收），从缓存中去掉
+  EXPECT_CALL(*mock, keepAliveLease("1")).WillOnce(testing::Return(true));
+  expectGet(mock, "/ohno/subnets/test-node", "");
+  EXPECT_TRUE(lease.keepAlive());
+
+  // 之后租约过期，子网不会被恢复
+  EXPECT_CALL(*mock, keepAliveLease("1")).WillOnce(testing::Return(false));
+  expectGet(mock, "/ohno/leases/test-node", "");
+  expectGrant(mock, "2");
+  expectGet(mock, "/ohno/subnets/test-node", "");
+  EXPECT_CALL(*mock, put("/ohno/leases/test-node", "2", "2")).WillOnce(testing::Return(true));
+  EXPECT_TRUE(lease.keepAlive());
+}
+
+// 测试续约只是暂时失败（旧租约仍然有效）时，不存在的 key 不会用缓存恢复
+TEST(NodeLeaseTest, TransientFailure) {
+  auto etcd_client = std::make_unique<MockEtcdClient>();
+  auto *mock = etcd_client.get();
+  std::vector<std::string> keys{"/ohno/subnets/test-node", "/ohno/vteps/test-node"};
+  NodeLease lease{std::move(etcd_client), "test-node", keys, 30};
+
+  testing::InSequence seq{};
+  expectGet(mock, "/ohno/leases/test-node", "");
+  expectGrant(mock, "1");
+  expectGet(mock, "/ohno/subnets/test-node", "10.244.1.0/24");
+  EXPECT_CALL(*mock, put("/ohno/subnets/test-node", "10.244.1.0/24", "1"))
+      .WillOnce(testing::Return(true));
+  expectGet(mock, "/ohno/vteps/test-node", "10.0.0.1,aa:bb:cc:dd:ee:ff");
+  EXPECT_CALL(*mock, put("/ohno/vteps/test-node", "10.0.0.1,aa:bb:cc:dd:ee:ff", "1"))
+      .WillOnce(testing::Return(true));
+  EXPECT_CALL(*mock, put("/ohno/leases/test-node", "1", "1")).WillOnce(testing::Return(true));
+  EXPECT_TRUE(lease.keepAlive());
+
+  // 续约失败但保存租约 ID 的 key 还在：子网换绑，刚被删除的 VTEP 不恢复
+  EXPECT_CALL(*mock, keepAliveLease("1")).WillOnce(testing::Return(false));
+  expectGet(mock, "/ohno/leases/test-node", "1");
+  expectGrant(mock, "2");
+  expectGet(mock, "/ohno/subnets/test-node", "10.244.1.0/24");
+  EXPECT_CALL(*mock, put("/ohno/subnets/test-node", "10.244.1.0/24", "2"))
+      .WillOnce(testing::Return(true));
+  expectGet(mock, "/ohno/vteps/test-node", "");
+  EXPECT_CALL(*mock, put("/ohno/leases/test-node", "2", "2")).WillOnce(testing::Return(true));
+  EXPECT_TRUE(lease.keepAlive());
+}
+
+// 测试 ohnod 停止超过 TTL 之后重启：进程内没有缓存，用持久化状态重建随旧租约删除的 key
+TEST(NodeLeaseTest, RestoreAtStartup) {
+  auto etcd_client = std::make_unique<MockEtcdClient>();
+  auto *mock = etcd_client.get();
+  std::vector<std::string> keys{"/ohno/subnets/test-node", "/ohno/vteps/test-node"};
+  NodeLease lease{std::move(etcd_client), "test-node", keys, 30};
+  int restored{0};
+  lease.setRestorer([&restored]() {
+    ++restored;
+    return std::unordered_map<std::string, std::string>{
+        {"/ohno/subnets/test-node", "10.244.1.0/24"}};
+  });
+
+  testing::InSequence seq{};
+  expectGet(mock, "/ohno/leases/test-node", "");
+  expectGrant(mock, "1");
+  expectGet(mock, "/ohno/subnets/test-node", "");
+  EXPECT_CALL(*mock, put("/ohno/subnets/test-node", "10.244.1.0/24", "1"))
+      .WillOnce(testing::Return(true));
+  expectGet(mock, "/ohno/vteps/test-node", ""); // 持久化状态中没有的 key 不恢复
+  EXPECT_CALL(*mock, put("/ohno/leases/test-node", "1", "1")).WillOnce(testing::Return(true));
+  EXPECT_TRUE(lease.keepAlive());
+  EXPECT_EQ(restored, 1);
+}
+
+// 测试 ohnod 在 TTL 内重启：旧租约仍然有效，不存在的 key 是被有意删除的，不重建
+TEST(NodeLeaseTest, RestartWithinTtl) {
+  auto etcd_client = std::make_unique<MockEtcdClient>();
+  auto *mock = etcd_client.get();
+  std::vector<std::string> keys{"/ohno/subnets/test-node"};
+  NodeLease lease{std::move(etcd_client), "test-node", keys, 30};
+  lease.setRestorer([]() -> std::unordered_map<std::string, std::string> {
+    ADD_FAILURE() << "restorer must not be called while the old lease is alive";
+    return {};
+  });
+
+  testing::InSequence seq{};
+  expectGet(mock, "/ohno/leases/test-node", "1");
+  expectGrant(mock, "2");
+  expectGet(mock, "/ohno/subnets/test-node", "");
+  EXPECT_CALL(*mock, put("/ohno/leases/test-node", "2", "2")).WillOnce(testing::Return(true));
+  EXPECT_TRUE(lease.keepAlive());
+}
@@ -19,8 +19,9 @@ TEST(SubnetTest, Init) {
   // condition 2: IPv6
   {
     EXPECT_NO_THROW(subnet.init("2001:db8::/32"));
-    EXPECT_ANY_THROW(subnet.getSubnet());
-    EXPECT_ANY_THROW(subnet.getPrefix());
+    EXPECT_EQ(subnet.getSubnet(), "2001:db8::/32");
+    EXPECT_EQ(subnet.getPrefix(), 32);
+    EXPECT_EQ(subnet.extractAddr(), "2001:db8::");
   }
 
   // condition 3: 无效
@@ -37,6 +38,24 @@ TEST(SubnetTest, GenerateIP) {
   EXPECT_EQ(subnet.generateIp(1), "192.168.1.1/24");
   EXPECT_EQ(subnet.generateIp(10), "192.168.1.10/24");
   EXPECT_EQ(subnet.generateIp(254), "192.168.1.254/24");
+
+  subnet.init("fd00:10:244:1::/64");
+  EXPECT_EQ(subnet.generateIp(1), "fd00:10:244:1::1/64");
+  EXPECT_TRUE(subnet.isSubnetOf("fd00:10:244::/48"));
+  EXPECT_FALSE(subnet.isSubnetOf("10.244.0.0/16"));
+}
+
+// 测试子网关系是严格的：相同的子网不是彼此的子网
+TEST(SubnetTest, IsSubnetOf) {
+  Subnet subnet;
+  subnet.init("10.244.1.0/24");
+  EXPECT_TRUE(subnet.isSubnetOf("10.244.0.0/16"));
+  EXPECT_FALSE(subnet.isSubnetOf("10.244.1.0/24"));
+  EXPECT_FALSE(subnet.isSubnetOf("10.245.0.0/16"));
+  EXPECT_FALSE(subnet.isSubnetOf("10.244.1.0/25"));
+
+  subnet.init("fd00:10:244:1::/64");
+  EXPECT_FALSE(subnet.isSubnetOf("fd00:10:244:1::/64"));
 }
 
 // 测试获取最大主机数
@@ -45,4 +64,8 @@ TEST(SubnetTest, GetMaxHosts) {
   subnet.init("192.168.1.0/24");
 
   EXPECT_EQ(subnet.getMaxHosts(), 256);
+
+  // IPv6 /64 主机数超出 Prefix 范围
+  subnet.init("fd00:10:244:1::/64");
+  EXPECT_ANY_THROW(subnet.getMaxHosts());
 }
@@ -0,0 +1,105 @@
+// clang-format off
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include "gtest/gtest.h"
+#include "src/metrics/metrics.h"
+#include "src/metrics/metrics_server.h"
+// clang-format on
+
+using namespace ohno::metrics;
+
+namespace {
+
+auto httpGet(uint16_t port, std::string_view path) -> std::string {
+  auto fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in sin{};
+  sin.sin_family = AF_INET;
+  sin.sin_port = htons(port);
+  ::inet_pton(AF_INET, "127.0.0.1", &sin.sin_addr);
+  if (::connect(fd, reinterpret_cast<sockaddr *>(&sin), sizeof(sin)) != 0) {
+    ::close(fd);
+    return {};
+  }
+  auto request = "GET " + std::string{path} + " HTTP/1.0\r\n\r\n";
+  ::send(fd, request.data(), request.size(), 0);
+
+  std::string response{};
+  char buf[512];
+  ssize_t size = 0;
+  while ((size = ::read(fd, buf, sizeof(buf))) > 0) {
+    response.append(buf, static_cast<size_t>(size));
+  }
+  ::close(fd);
+  return response;
+}
+
+} // namespace
+
+TEST(HistogramTest, Buckets) {
+  Histogram histogram{Buckets::latency};
+  const auto &bounds = histogram.getBounds();
+  ASSERT_FALSE(bounds.empty());
+
+  histogram.observe(0);                 // 第一个桶
+  histogram.observe(bounds[0]);         // 上界包含在桶内
+  histogram.observe(bounds[1]);         // 第二个桶
+  histogram.observe(bounds.back() * 2); // +Inf
+  EXPECT_EQ(histogram.getBucket(0), 2);
+  EXPECT_EQ(histogram.getBucket(1), 1);
+  EXPECT_EQ(histogram.getBucket(bounds.size()), 1);
+  EXPECT_EQ(histogram.getCount(), 4);
+  EXPECT_DOUBLE_EQ(histogram.getSum(), bounds[0] + bounds[1] + bounds.back() * 2);
+}
+
+TEST(RegistryTest, Render) {
+  auto &registry = Registry::instance();
+
+  // condition 0: 同名同标签返回同一个指标
+  auto &counter = registry.counter("ohno_test_total", "Test counter", {{"op", "get"}});
+  EXPECT_EQ(&counter, &registry.counter("ohno_test_total", "Test counter", {{"op", "get"}}));
+  counter.inc(3);
+  registry.counter("ohno_test_total", "Test counter", {{"op", "put\"x"}}).inc();
+
+  // condition 1: 同一个名称不能注册成其他类型
+  EXPECT_ANY_THROW(registry.gauge("ohno_test_total", "Test counter"));
+
+  registry.histogram("ohno_test_seconds", "Test histogram", Buckets::latency).observe(0.003);
+
+  auto text = registry.render();
+  EXPECT_NE(text.find("# HELP ohno_test_total Test counter\n# TYPE ohno_test_total counter\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("ohno_test_total{op=\"get\"} 3\n"), std::string::npos);
+  EXPECT_NE(text.find("ohno_test_total{op=\"put\\\"x\"} 1\n"), std::string::npos);
+  EXPECT_NE(text.find("# TYPE ohno_test_seconds histogram\n"), std::string::npos);
+  EXPECT_NE(text.find("ohno_test_seconds_bucket{le=\"0.0025\"} 0\n"), std::string::npos);
+  EXPECT_NE(text.find("ohno_test_seconds_bucket{le=\"0.005\"} 1\n"), std::string::npos);
+  EXPECT_NE(text.find("ohno_test_seconds_bucket{le=\"+Inf\"} 1\n"), std::string::npos);
+  EXPECT_NE(text.find("ohno_test_seconds_count 1\n"), std::string::npos);
+}
+
+TEST(MetricsServerTest, Serve) {
+  Registry::instance().counter("ohno_test_served_total", "Test endpoint").inc();
+
+  // condition 0: 非法地址
+  {
+    MetricsServer server{"localhost"};
+    EXPECT_FALSE(server.start());
+  }
+
+  // condition 1: 随机端口
+  MetricsServer server{"127.0.0.1:0"};
+  ASSERT_TRUE(server.start());
+  ASSERT_NE(server.getPort(), 0);
+
+  auto response = httpGet(server.getPort(), "/metrics");
+  EXPECT_EQ(response.compare(0, 15, "HTTP/1.0 200 OK"), 0);
+  EXPECT_NE(response.find("text/plain; version=0.0.4"), std::string::npos);
+  EXPECT_NE(response.find("ohno_test_served_total 1\n"), std::string::npos);
+
+  response = httpGet(server.getPort(), "/other");
+  EXPECT_EQ(response.compare(0, 22, "HTTP/1.0 404 Not Found"), 0);
+  server.stop();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// clang-format off
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "gmock/gmock.h"
+#include "src/etcd/etcd_client_if.h"
+// clang-format on
+
+namespace ohno {
+namespace etcd {
+
+/**
+ * @brief 所有单元测试共用的 EtcdClientIf mock，接口变化时只需要修改这里
+ *
+ */
+class MockEtcdClient : public EtcdClientIf {
+public:
+  using Entries = std::unordered_map<std::string, std::string>;
+
+  MOCK_METHOD(bool, test, (), (const, override));
+  MOCK_METHOD(bool, put, (std::string_view key, std::string_view value), (const, override));
+  MOCK_METHOD(bool, put, (std::string_view key, std::string_view value, std::string_view lease_id),
+              (const, override));
+  MOCK_METHOD(bool, append, (std::string_view key, std::string_view value), (const, override));
+  MOCK_METHOD(bool, get, (std::string_view key, std::string &value), (const, override));
+  MOCK_METHOD(bool, get, (std::string_view key, std::string &value, int64_t &revision),
+              (const, override));
+  MOCK_METHOD(bool, get, (std::string_view key, Entries &value), (const, override));
+  MOCK_METHOD(bool, del, (std::string_view key), (const, override));
+  MOCK_METHOD(bool, del, (std::string_view key, std::string_view value), (const, override));
+  MOCK_METHOD(bool, delPrefix, (std::string_view prefix), (const, override));
+  MOCK_METHOD(bool, list, (std::string_view key, std::vector<std::string> &results),
+              (const, override));
+  MOCK_METHOD(std::string, dump, (std::string_view key), (const, override));
+  MOCK_METHOD(bool, grantLease, (int64_t ttl, std::string &lease_id), (const, override));
+  MOCK_METHOD(bool, keepAliveLease, (std::string_view lease_id), (const, override));
+  MOCK_METHOD(bool, snapshot, (std::string_view prefix, Entries &results, int64_t &revision),
+              (const, override));
+  MOCK_METHOD(WatchResult, watch,
+              (std::string_view prefix, int64_t revision, const WatchCallback &callback),
+              (const, override));
+  MOCK_METHOD(TxnResult, commit, (const EtcdTxn &txn), (const, override));
+};
+
+} // namespace etcd
+} // namespace ohno
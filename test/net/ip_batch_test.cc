@@ -0,0 +1,58 @@
+// clang-format off
+#include <sys/stat.h>
+#include <filesystem>
+#include <fstream>
+#include "gtest/gtest.h"
+#include "src/net/netlink/ip_batch.h"
+// clang-format on
+
+using namespace ohno::net;
+
+// 模拟 "ip -force -batch -"：失败的命令（包括哨兵）输出 "Command failed -:<行号>"
+constexpr std::string_view FAKE_IP{R"(#!/bin/sh
+n=0
+while IFS= read -r line; do
+  n=$((n+1))
+  case "$line" in
+    *crash*) exit 1 ;;
+    *fail*|*ohno_sentinel*) echo "Error: $line" >&2; echo "Command failed -:$n" >&2 ;;
+  esac
+done
+)"};
+
+class IpBatchTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    path_ = std::filesystem::temp_directory_path() / "ohno_fake_ip";
+    std::ofstream{path_} << FAKE_IP;
+    ::chmod(path_.c_str(), 0755);
+  }
+
+  void TearDown() override { std::filesystem::remove(path_); }
+
+  std::filesystem::path path_;
+};
+
+// 测试每条命令的执行结果与子进程退出后重新拉起
+TEST_F(IpBatchTest, Execute) {
+  IpBatch batch{path_.string()};
+
+  // condition 1: 成功与失败的命令交替执行，结果互不影响
+  EXPECT_TRUE(batch.execute("route add 10.244.1.0/24 via 192.168.1.2"));
+  EXPECT_FALSE(batch.execute("route add fail"));
+  EXPECT_TRUE(batch.execute("neigh add 10.244.1.0 lladdr 00:11:22:33:44:55 dev ohno.1"));
+  EXPECT_FALSE(batch.execute("route add\nfail"));
+  EXPECT_EQ(batch.getRestarts(), 0);
+
+  // condition 2: 子进程退出时当前命令失败，下一条命令重新拉起子进程
+  EXPECT_FALSE(batch.execute("crash"));
+  EXPECT_TRUE(batch.execute("route add 10.244.2.0/24 via 192.168.1.3"));
+  EXPECT_FALSE(batch.execute("route add fail"));
+  EXPECT_EQ(batch.getRestarts(), 1);
+}
+
+// 测试程序不存在
+TEST_F(IpBatchTest, NoProgram) {
+  IpBatch batch{"/nonexistent/ip"};
+  EXPECT_FALSE(batch.execute("route add 10.244.1.0/24 via 192.168.1.2"));
+}
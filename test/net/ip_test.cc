@@ -0,0 +1,58 @@
+// clang-format off
+#include "gtest/gtest.h"
+#include "src/net/ip.h"
+// clang-format on
+
+using namespace ohno::net;
+
+// 测试 IP 地址解析与格式化
+TEST(IpTest, ParseAddr) {
+  // condition 1: IPv4
+  {
+    auto addr = IpAddr::parse("10.244.0.1");
+    ASSERT_TRUE(addr.has_value());
+    EXPECT_EQ(addr->version(), IpVersion::IPv4);
+    EXPECT_EQ(addr->toV4(), 0x0af40001U);
+    EXPECT_EQ(addr->toString(), "10.244.0.1");
+  }
+
+  // condition 2: IPv6，输出遵循 RFC 5952
+  {
+    EXPECT_EQ(IpAddr::parse("2001:DB8:0:0:1:0:0:1")->toString(), "2001:db8::1:0:0:1");
+    EXPECT_EQ(IpAddr::parse("::")->toString(), "::");
+    EXPECT_EQ(IpAddr::parse("fe80::1")->toString(), "fe80::1");
+    EXPECT_EQ(IpAddr::parse("::ffff:1.2.3.4")->toUint(), (Uint128{0xffff} << 32) | 0x01020304U);
+  }
+
+  // condition 3: 无效
+  {
+    EXPECT_FALSE(IpAddr::parse("256.0.0.1").has_value());
+    EXPECT_FALSE(IpAddr::parse("1.2.3").has_value());
+    EXPECT_FALSE(IpAddr::parse("1::2::3").has_value());
+    EXPECT_FALSE(IpAddr::parse("1:2:3:4:5:6:7:8:9").has_value());
+    EXPECT_FALSE(IpAddr::parse("").has_value());
+  }
+}
+
+// 测试 CIDR 解析与网段运算
+TEST(IpTest, Prefix) {
+  auto prefix = IpPrefix::parse("192.168.1.5/24");
+  ASSERT_TRUE(prefix.has_value());
+  EXPECT_EQ(prefix->toString(), "192.168.1.5/24");
+  EXPECT_EQ(prefix->network().toString(), "192.168.1.0/24");
+  EXPECT_EQ(prefix->hostBits(), 8);
+  EXPECT_EQ(prefix->hostAt(10).toString(), "192.168.1.10");
+  EXPECT_EQ(prefix->offsetOf(*IpAddr::parse("192.168.1.200")), 200);
+  EXPECT_TRUE(prefix->contains(*IpAddr::parse("192.168.1.255")));
+  EXPECT_FALSE(prefix->contains(*IpAddr::parse("192.168.2.1")));
+  EXPECT_TRUE(IpPrefix::parse("192.168.0.0/16")->contains(*prefix));
+  EXPECT_FALSE(prefix->contains(*IpPrefix::parse("192.168.0.0/16")));
+
+  auto prefix6 = IpPrefix::parse("fd00:10:244::/64");
+  ASSERT_TRUE(prefix6.has_value());
+  EXPECT_EQ(prefix6->hostAt(1).toString(), "fd00:10:244::1");
+  EXPECT_FALSE(prefix6->contains(*IpAddr::parse("10.244.0.1")));
+
+  EXPECT_FALSE(IpPrefix::parse("10.0.0.0/33").has_value());
+  EXPECT_FALSE(IpPrefix::parse("10.0.0.0").has_value());
+}
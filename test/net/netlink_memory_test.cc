@@ -0,0 +1,188 @@
+// clang-format off
+#include <memory>
+#include "gtest/gtest.h"
+#include "src/net/netlink/netlink_memory.h"
+#include "src/net/addr.h"
+#include "src/net/bridge.h"
+#include "src/net/fdb.h"
+#include "src/net/neigh.h"
+#include "src/net/route.h"
+#include "src/net/veth.h"
+#include "src/net/vxlan.h"
+// clang-format on
+
+using namespace ohno::net;
+
+// 测试网卡的创建、删除、改名与移动网络空间
+TEST(NetlinkMemoryTest, Link) {
+  NetlinkMemory netlink{};
+  EXPECT_TRUE(netlink.linkExist(NAME_LOOPBACK));
+  EXPECT_FALSE(netlink.linkDestory(NAME_LOOPBACK));
+
+  // condition 1: 名称重复、超长或者非法时创建失败
+  EXPECT_TRUE(netlink.bridgeCreate("ohno0"));
+  EXPECT_FALSE(netlink.bridgeCreate("ohno0"));
+  EXPECT_FALSE(netlink.bridgeCreate("ohno0123456789ab"));
+  EXPECT_FALSE(netlink.vethCreate("ohnoq_0", "ohno0"));
+  EXPECT_FALSE(netlink.linkExist("ohnoq_0"));
+  EXPECT_FALSE(netlink.vxlanCreate("ohnov", "192.168.1.2", "eth0")); // 底层网卡不存在
+
+  // condition 2: 删除 veth 任意一端，另一端一起删除
+  EXPECT_TRUE(netlink.vethCreate("ohnoq_0", "ohnop_0"));
+  EXPECT_EQ(netlink.linkList("ohno"), (std::vector<std::string>{"ohno0", "ohnoq_0", "ohnop_0"}));
+  EXPECT_TRUE(netlink.linkDestory("ohnop_0"));
+  EXPECT_FALSE(netlink.linkExist("ohnoq_0"));
+  EXPECT_FALSE(netlink.linkDestory("ohnoq_0"));
+
+  // condition 3: 启用状态的网卡不能改名
+  EXPECT_TRUE(netlink.vethCreate("ohnoq_1", "ohnop_1"));
+  EXPECT_TRUE(netlink.linkSetStatus("ohnoq_1", LinkStatus::UP));
+  EXPECT_FALSE(netlink.linkRename("ohnoq_1", "eth0"));
+  EXPECT_TRUE(netlink.linkSetStatus("ohnoq_1", LinkStatus::DOWN));
+  EXPECT_FALSE(netlink.linkRename("ohnoq_1", "ohnop_1"));
+  EXPECT_TRUE(netlink.linkRename("ohnoq_1", "eth0"));
+
+  // condition 4: 网络空间不存在时移动失败；移动之后地址被清除，删除网络空间时 veth 对端一起删除
+  EXPECT_TRUE(netlink.addressSetEntry("eth0", "10.244.1.2/24", true));
+  EXPECT_FALSE(netlink.linkToNetns("eth0", "pod1"));
+  EXPECT_TRUE(netlink.netnsAdd("pod1"));
+  EXPECT_FALSE(netlink.netnsAdd("pod1"));
+  EXPECT_TRUE(netlink.linkToNetns("eth0", "pod1"));
+  EXPECT_FALSE(netlink.linkExist("eth0"));
+  EXPECT_TRUE(netlink.linkIsInNetns("eth0", "pod1"));
+  EXPECT_FALSE(netlink.addressIsExist("eth0", "10.244.1.2/24", "pod1"));
+  EXPECT_TRUE(netlink.netnsDel("pod1"));
+  EXPECT_FALSE(netlink.linkExist("ohnop_1"));
+  EXPECT_FALSE(netlink.netnsExist("pod1"));
+
+  // condition 5: 插入 bridge 之后可以查到所在的 bridge，删除 bridge 之后网卡被拔出
+  EXPECT_TRUE(netlink.vethCreate("ohnoq_2", "ohnop_2"));
+  EXPECT_TRUE(netlink.linkGetMaster("ohnoq_2").empty());
+  EXPECT_TRUE(netlink.bridgeSetStatus("ohnoq_2", true, "ohno0", BridgeAddrGenMode::reserved));
+  EXPECT_EQ(netlink.linkGetMaster("ohnoq_2"), "ohno0");
+  EXPECT_TRUE(netlink.linkDestory("ohno0"));
+  EXPECT_TRUE(netlink.linkGetMaster("ohnoq_2").empty());
+  EXPECT_TRUE(netlink.linkGetMaster("none").empty());
+
+  // condition 6: 每个网卡的 MAC 地址不同，改名之后不变，loopback 没有 MAC 地址
+  auto mac = netlink.linkGetMac("ohnoq_2");
+  EXPECT_EQ(mac.size(), 17);
+  EXPECT_NE(mac, netlink.linkGetMac("ohnop_2"));
+  EXPECT_TRUE(netlink.linkRename("ohnoq_2", "eth1"));
+  EXPECT_EQ(netlink.linkGetMac("eth1"), mac);
+  EXPECT_TRUE(netlink.linkGetMac(NAME_LOOPBACK).empty());
+  EXPECT_TRUE(netlink.linkGetMac("none").empty());
+}
+
+// 测试地址与路由：重复添加、删除不存在的表项失败，下一跳必须可达，网卡关闭时路由被删除
+TEST(NetlinkMemoryTest, AddressAndRoute) {
+  NetlinkMemory netlink{};
+  ASSERT_TRUE(netlink.bridgeCreate("ohno0"));
+
+  // condition 1: 地址
+  EXPECT_TRUE(netlink.addressSetEntry("ohno0", "10.244.1.1/24", true));
+  EXPECT_FALSE(netlink.addressSetEntry("ohno0", "10.244.1.1/24", true));
+  EXPECT_TRUE(netlink.addressIsExist("ohno0", "10.244.1.1/24"));
+  EXPECT_TRUE(netlink.addressIsExist("ohno0", "10.244.1.1"));
+  EXPECT_FALSE(netlink.addressIsExist("ohno0", "10.244.1.1/16"));
+  EXPECT_FALSE(netlink.addressSetEntry("ohno1", "10.244.1.1/24", true));
+
+  // condition 2: 网卡关闭或者下一跳不在直连网段时添加失败，onlink 不检查网段
+  EXPECT_FALSE(netlink.routeSetEntry("10.244.2.0/24", "10.244.1.2", true, "ohno0"));
+  ASSERT_TRUE(netlink.linkSetStatus("ohno0", LinkStatus::UP));
+  EXPECT_FALSE(netlink.routeSetEntry("10.244.2.0/24", "192.168.1.2", true));
+  EXPECT_FALSE(netlink.routeSetEntry("10.244.2.1/24", "10.244.1.2", true)); // 主机位不为 0
+  EXPECT_TRUE(netlink.routeSetEntry("10.244.2.0/24", "10.244.1.2", true));
+  EXPECT_FALSE(netlink.routeSetEntry("10.244.2.0/24", "10.244.1.3", true));
+  EXPECT_TRUE(netlink.routeSetEntry("10.244.3.0/24", "192.168.1.3", true, "ohno0", {},
+                                    NetlinkIf::RouteNHFlags::onlink));
+  EXPECT_TRUE(netlink.routeSetEntry({}, "10.244.1.1", true));
+  EXPECT_TRUE(netlink.routeIsExist("10.244.2.0/24", "10.244.1.2", "ohno0"));
+  EXPECT_TRUE(netlink.routeIsExist({}, "10.244.1.1"));
+  EXPECT_FALSE(netlink.routeIsExist("10.244.2.0/24", "10.244.1.3"));
+  EXPECT_EQ(netlink.routeCount(), 3);
+
+  // condition 3: 删除
+  EXPECT_FALSE(netlink.routeSetEntry("10.244.2.0/24", "10.244.1.3", false));
+  EXPECT_TRUE(netlink.routeSetEntry("10.244.2.0/24", "10.244.1.2", false));
+  EXPECT_FALSE(netlink.routeSetEntry("10.244.2.0/24", "10.244.1.2", false));
+
+  // condition 4: 网卡关闭时经过它的路由全部删除
+  ASSERT_TRUE(netlink.linkSetStatus("ohno0", LinkStatus::DOWN));
+  EXPECT_EQ(netlink.routeCount(), 0);
+  EXPECT_TRUE(netlink.addressSetEntry("ohno0", "10.244.1.1/24", false));
+  EXPECT_FALSE(netlink.addressSetEntry("ohno0", "10.244.1.1/24", false));
+}
+
+// 测试 ARP 缓存与 FDB 表项
+TEST(NetlinkMemoryTest, NeighAndFdb) {
+  NetlinkMemory netlink{};
+  ASSERT_TRUE(netlink.bridgeCreate("ohno0"));
+  ASSERT_TRUE(netlink.vxlanCreate("ohnov", "192.168.1.2", "ohno0"));
+
+  // condition 1: ARP 缓存必须指定设备，不能重复添加
+  EXPECT_FALSE(netlink.neighSetEntry("10.244.2.0", "02:00:00:00:02:00", true));
+  EXPECT_FALSE(netlink.neighSetEntry("10.244.2.0", "02:00:00", true, "ohnov"));
+  EXPECT_TRUE(netlink.neighSetEntry("10.244.2.0", "02:00:00:00:02:00", true, "ohnov"));
+  EXPECT_FALSE(netlink.neighSetEntry("10.244.2.0", "02:00:00:00:02:00", true, "ohnov"));
+  EXPECT_TRUE(netlink.neighIsExist("10.244.2.0"));
+  EXPECT_FALSE(netlink.neighIsExist("10.244.2.0", "ohno0"));
+
+  // condition 2: FDB 表项只能加在 vxlan 上，删除时远端地址必须相同
+  EXPECT_FALSE(netlink.fdbSetEntry("02:00:00:00:02:00", "192.168.1.3", "ohno0", true));
+  EXPECT_TRUE(netlink.fdbSetEntry("02:00:00:00:02:00", "192.168.1.3", "ohnov", true));
+  EXPECT_FALSE(netlink.fdbSetEntry("02:00:00:00:02:00", "192.168.1.4", "ohnov", true));
+  EXPECT_TRUE(netlink.fdbIsExist("02:00:00:00:02:00", "192.168.1.3", "ohnov"));
+  EXPECT_FALSE(netlink.fdbIsExist("02:00:00:00:02:00", "192.168.1.4", "ohnov"));
+  EXPECT_FALSE(netlink.fdbSetEntry("02:00:00:00:02:00", "192.168.1.4", "ohnov", false));
+
+  // condition 3: 删除网卡时表项一起删除
+  EXPECT_TRUE(netlink.linkDestory("ohnov"));
+  EXPECT_EQ(netlink.neighCount(), 0);
+  EXPECT_EQ(netlink.fdbCount(), 0);
+}
+
+// 测试网卡对象在模型上完成一个 Pod 的网络配置，与 CNI ADD 的步骤相同
+TEST(NetlinkMemoryTest, PodNetwork) {
+  auto netlink = std::make_shared<NetlinkMemory>();
+  ASSERT_TRUE(netlink->netnsAdd("pod1"));
+
+  Bridge bridge{};
+  bridge.setName("ohno0");
+  ASSERT_TRUE(bridge.setup(netlink));
+  ASSERT_TRUE(bridge.setStatus(LinkStatus::UP));
+  ASSERT_TRUE(bridge.addAddr(std::make_unique<Addr>("10.244.1.1/24")));
+
+  Veth veth{"ohnop_1"};
+  veth.setName("ohnoq_1");
+  ASSERT_TRUE(veth.setup(netlink));
+  ASSERT_TRUE(bridge.setMaster(veth.getPeerName(), BridgeAddrGenMode::none));
+  ASSERT_TRUE(veth.setNetns("/var/run/netns/pod1"));
+  ASSERT_TRUE(veth.rename("eth0"));
+  ASSERT_TRUE(veth.setStatus(LinkStatus::UP));
+  ASSERT_TRUE(veth.addAddr(std::make_unique<Addr>("10.244.1.2/24")));
+  EXPECT_TRUE(veth.addRoute(std::make_unique<Route>(std::string{}, "10.244.1.1", "eth0"),
+                            NetlinkIf::RouteNHFlags::NONE));
+  EXPECT_EQ(netlink->routeCount("pod1"), 1);
+
+  // vxlan 插入 bridge，配置对端节点的表项
+  Vxlan vxlan{"192.168.1.2/24", std::string{NAME_LOOPBACK}};
+  vxlan.setName(NAME_VXLAN);
+  ASSERT_TRUE(vxlan.setup(netlink));
+  EXPECT_FALSE(vxlan.setSlave(true, false)); // 还没有插入 bridge
+  ASSERT_TRUE(bridge.setMaster(NAME_VXLAN, BridgeAddrGenMode::none));
+  EXPECT_TRUE(vxlan.setSlave(true, false));
+  ASSERT_TRUE(vxlan.setStatus(LinkStatus::UP));
+  EXPECT_TRUE(vxlan.addRoute(std::make_unique<Route>("10.244.2.0/24", "10.244.2.0", NAME_VXLAN),
+                             NetlinkIf::RouteNHFlags::onlink));
+  EXPECT_TRUE(
+      vxlan.addNeigh(std::make_unique<Neigh>("10.244.2.0", "02:00:00:00:02:00", NAME_VXLAN)));
+  EXPECT_TRUE(
+      vxlan.addFdb(std::make_unique<Fdb>("02:00:00:00:02:00", "192.168.1.3", NAME_VXLAN)));
+  EXPECT_TRUE(vxlan.delFdb("192.168.1.3", "02:00:00:00:02:00", NAME_VXLAN));
+  EXPECT_EQ(netlink->fdbCount(), 0);
+
+  // CNI DEL：删除 Pod 的网络空间，root 网络空间中的 veth 对端随之消失
+  ASSERT_TRUE(netlink->netnsDel("pod1"));
+  EXPECT_FALSE(netlink->linkExist(veth.getPeerName()));
+}
@@ -11,6 +11,12 @@ class MockNetlink : public NetlinkIf {
 public:
   MOCK_METHOD(bool, linkDestory, (std::string_view name, std::string_view netns), (override));
   MOCK_METHOD(bool, linkExist, (std::string_view name, std::string_view netns), (override));
+  MOCK_METHOD(std::vector<std::string>, linkList, (std::string_view prefix, std::string_view netns),
+              (override));
+  MOCK_METHOD(std::string, linkGetMaster, (std::string_view name, std::string_view netns),
+              (override));
+  MOCK_METHOD(std::string, linkGetMac, (std::string_view name, std::string_view netns),
+              (override));
   MOCK_METHOD(bool, linkSetStatus,
               (std::string_view name, LinkStatus status, std::string_view netns), (override));
   MOCK_METHOD(bool, linkIsInNetns, (std::string_view name, std::string_view netns), (override));
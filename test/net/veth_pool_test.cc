@@ -0,0 +1,274 @@
+// clang-format off
+#include <map>
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "src/net/veth_pool.h"
+// clang-format on
+
+using namespace ohno::net;
+
+class MockNetlink : public NetlinkIf {
+public:
+  MOCK_METHOD(bool, linkDestory, (std::string_view name, std::string_view netns), (override));
+  MOCK_METHOD(bool, linkExist, (std::string_view name, std::string_view netns), (override));
+  MOCK_METHOD(std::vector<std::string>, linkList, (std::string_view prefix, std::string_view netns),
+              (override));
+  MOCK_METHOD(std::string, linkGetMaster, (std::string_view name, std::string_view netns),
+              (override));
+  MOCK_METHOD(std::string, linkGetMac, (std::string_view name, std::string_view netns),
+              (override));
+  MOCK_METHOD(bool, linkSetStatus,
+              (std::string_view name, LinkStatus status, std::string_view netns), (override));
+  MOCK_METHOD(bool, linkIsInNetns, (std::string_view name, std::string_view netns), (override));
+  MOCK_METHOD(bool, linkToNetns, (std::string_view name, std::string_view netns), (override));
+  MOCK_METHOD(bool, linkRename,
+              (std::string_view name, std::string_view new_name, std::string_view netns),
+              (override));
+  MOCK_METHOD(bool, vethCreate, (std::string_view name1, std::string_view name2), (override));
+  MOCK_METHOD(bool, bridgeCreate, (std::string_view name), (override));
+  MOCK_METHOD(bool, vxlanCreate,
+              (std::string_view name, std::string_view underlay_addr,
+               std::string_view underlay_dev),
+              (override));
+  MOCK_METHOD(bool, vrfCreate, (std::string_view name, uint32_t table), (override));
+  MOCK_METHOD(bool, bridgeSetStatus,
+              (std::string_view name, bool master, std::string_view bridge, BridgeAddrGenMode mode,
+               std::string_view netns),
+              (override));
+  MOCK_METHOD(bool, vxlanSetSlave,
+              (std::string_view name, bool neigh_suppress, bool learning, std::string_view netns),
+              (override));
+  MOCK_METHOD(bool, addressIsExist,
+              (std::string_view name, std::string_view addr, std::string_view netns), (override));
+  MOCK_METHOD(bool, addressSetEntry,
+              (std::string_view name, std::string_view addr, bool add, std::string_view netns),
+              (override));
+  MOCK_METHOD(bool, routeIsExist,
+              (std::string_view dst, std::string_view via, std::string_view dev,
+               std::string_view netns),
+              (const, override));
+  MOCK_METHOD(bool, routeSetEntry,
+              (std::string_view dst, std::string_view via, bool add, std::string_view dev,
+               std::string_view netns, RouteNHFlags nhflags),
+              (const, override));
+  MOCK_METHOD(bool, neighIsExist,
+              (std::string_view addr, std::string_view dev, std::string_view netns),
+              (const, override));
+  MOCK_METHOD(bool, neighSetEntry,
+              (std::string_view addr, std::string_view mac, bool add, std::string_view dev,
+               std::string_view netns),
+              (const, override));
+  MOCK_METHOD(bool, fdbIsExist,
+              (std::string_view mac, std::string_view underlay_addr, std::string_view dev,
+               std::string_view netns),
+              (const, override));
+  MOCK_METHOD(bool, fdbSetEntry,
+              (std::string_view mac, std::string_view underlay_addr, std::string_view dev, bool add,
+               std::string_view netns),
+              (const, override));
+};
+
+class VethPoolTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    netlink_ = std::make_shared<testing::NiceMock<MockNetlink>>();
+
+    // 用一张网卡表模拟内核：veth 两端互为 peer，删除一端另一端同时消失
+    ON_CALL(*netlink_, linkList(testing::_, testing::_))
+        .WillByDefault([this](std::string_view prefix, std::string_view) {
+          std::vector<std::string> names{};
+          for (const auto &link : links_) {
+            if (link.first.compare(0, prefix.size(), prefix) == 0) {
+              names.emplace_back(link.first);
+            }
+          }
+          return names;
+        });
+    ON_CALL(*netlink_, vethCreate(testing::_, testing::_))
+        .WillByDefault([this](std::string_view name1, std::string_view name2) {
+          links_.emplace(name1, name2);
+          links_.emplace(name2, name1);
+          return true;
+        });
+    ON_CALL(*netlink_, bridgeSetStatus(testing::_, testing::_, testing::_, testing::_, testing::_))
+        .WillByDefault([this](std::string_view name, bool master, std::string_view bridge,
+                              BridgeAddrGenMode, std::string_view) {
+          if (links_.count(std::string{name}) == 0 || links_.count(std::string{bridge}) == 0) {
+            return false;
+          }
+          masters_[std::string{name}] = master ? std::string{bridge} : std::string{};
+          return true;
+        });
+    ON_CALL(*netlink_, linkGetMaster(testing::_, testing::_))
+        .WillByDefault([this](std::string_view name, std::string_view) {
+          auto iter = masters_.find(std::string{name});
+          return iter == masters_.end() ? std::string{} : iter->second;
+        });
+    ON_CALL(*netlink_, linkRename(testing::_, testing::_, testing::_))
+        .WillByDefault([this](std::string_view name, std::string_view new_name, std::string_view) {
+          auto iter = links_.find(std::string{name});
+          if (iter == links_.end() || links_.count(std::string{new_name}) != 0) {
+            return false;
+          }
+          auto peer = iter->second;
+          links_.erase(iter);
+          links_.emplace(new_name, peer);
+          auto master = masters_.extract(std::string{name});
+          if (!master.empty()) {
+            masters_[std::string{new_name}] = master.mapped();
+          }
+          if (!peer.empty()) {
+            links_[peer] = std::string{new_name};
+          }
+          return true;
+        });
+    ON_CALL(*netlink_, linkDestory(testing::_, testing::_))
+        .WillByDefault([this](std::string_view name, std::string_view) {
+          auto iter = links_.find(std::string{name});
+          if (iter == links_.end()) {
+            return false;
+          }
+          // bridge 被删除时插在上面的网卡被拔出
+          for (auto &master : masters_) {
+            if (master.second == iter->first) {
+              master.second.clear();
+            }
+          }
+          masters_.erase(iter->second);
+          masters_.erase(iter->first);
+          links_.erase(iter->second);
+          links_.erase(iter);
+          return true;
+        });
+  }
+
+  auto countPool() const -> size_t {
+    size_t count = 0;
+    for (const auto &link : links_) {
+      count += link.first.compare(0, VETH_POOL_PREFIX.size(), VETH_POOL_PREFIX) == 0 ? 1 : 0;
+    }
+    return count;
+  }
+
+  std::shared_ptr<testing::NiceMock<MockNetlink>> netlink_;
+  std::map<std::string, std::string> links_;   // 网卡名称 -> peer 名称（非 veth 为空）
+  std::map<std::string, std::string> masters_; // 网卡名称 -> 所在 bridge 名称
+};
+
+TEST_F(VethPoolTest, WaitForBridge) {
+  VethPool pool{netlink_, "ohnobr"};
+  EXPECT_CALL(*netlink_, vethCreate(testing::_, testing::_)).Times(0);
+  EXPECT_EQ(pool.refill(), 0);
+}
+
+TEST_F(VethPoolTest, RefillAndClaim) {
+  links_.emplace("ohnobr", "");
+  VethPool pool{netlink_, "ohnobr"};
+  EXPECT_EQ(pool.refill(), VETH_POOL_MIN);
+  EXPECT_EQ(countPool(), VETH_POOL_MIN);
+  EXPECT_EQ(links_.count("ohnop_0"), 1);
+  EXPECT_EQ(links_["ohnop_0"], "ohnoq_0");
+
+  // 领取之后两端都改成 CNI 指定的名称，池中少一对
+  EXPECT_TRUE(VethPool::claim(*netlink_, "ohno_tmp", "veth_pod", "ohnobr"));
+  EXPECT_EQ(links_["ohno_tmp"], "veth_pod");
+  EXPECT_EQ(countPool(), VETH_POOL_MIN - 1);
+
+  // 被领取的槽位对端已经改名，可以重新使用
+  EXPECT_EQ(pool.refill(), VETH_POOL_MIN);
+  EXPECT_EQ(countPool(), VETH_POOL_MIN);
+}
+
+TEST_F(VethPoolTest, ClaimFromEmptyPool) {
+  EXPECT_FALSE(VethPool::claim(*netlink_, "ohno_tmp", "veth_pod", "ohnobr"));
+  EXPECT_TRUE(links_.empty());
+}
+
+TEST_F(VethPoolTest, TargetFollowsAddRate) {
+  links_.emplace("ohnobr", "");
+  VethPool pool{netlink_, "ohnobr"};
+  pool.refill();
+  EXPECT_EQ(pool.getTarget(), VETH_POOL_MIN);
+
+  // 每个周期领取 2 对，池逐渐扩大到能覆盖 LOOKAHEAD 个周期的用量
+  for (int round = 0; round < 30; ++round) {
+    for (int i = 0; i < 2; ++i) {
+      auto name = std::to_string(round * 2 + i);
+      ASSERT_TRUE(VethPool::claim(*netlink_, "ohno_" + name, "veth_" + name, "ohnobr"));
+    }
+    pool.refill();
+  }
+  EXPECT_GT(pool.getTarget(), VETH_POOL_MIN);
+  EXPECT_LE(pool.getTarget(), VETH_POOL_MAX);
+  EXPECT_EQ(countPool(), pool.getTarget());
+
+  // 不再有 ADD 之后目标大小回落
+  for (int round = 0; round < 30; ++round) {
+    pool.refill();
+  }
+  EXPECT_EQ(pool.getTarget(), VETH_POOL_MIN);
+}
+
+TEST_F(VethPoolTest, CleanupStaged) {
+  links_.emplace("ohnobr", "");
+  links_.emplace("ohnos_0", "ohnoq_0");
+  links_.emplace("ohnoq_0", "ohnos_0");
+  VethPool pool{netlink_, "ohnobr"};
+  pool.refill();
+  EXPECT_EQ(links_.count("ohnos_0"), 0);
+  EXPECT_EQ(countPool(), VETH_POOL_MIN);
+}
+
+TEST_F(VethPoolTest, DropWithoutBridge) {
+  links_.emplace("ohnobr", "");
+  VethPool pool{netlink_, "ohnobr"};
+  EXPECT_EQ(pool.refill(), VETH_POOL_MIN);
+
+  // 节点网络设施被回收之后，池中的 veth 已经不在 bridge 上
+  links_.erase("ohnobr");
+  EXPECT_EQ(pool.refill(), 0);
+  EXPECT_EQ(countPool(), 0);
+}
+
+TEST_F(VethPoolTest, ClaimAfterBridgeRecreated) {
+  links_.emplace("ohnobr", "");
+  VethPool pool{netlink_, "ohnobr"};
+  EXPECT_EQ(pool.refill(), VETH_POOL_MIN);
+
+  // 补充之后 bridge 被回收又重新创建，池中的 veth 不在新的 bridge 上，领取时丢弃
+  EXPECT_TRUE(netlink_->linkDestory("ohnobr", {}));
+  links_.emplace("ohnobr", "");
+  EXPECT_FALSE(VethPool::claim(*netlink_, "ohno_tmp", "veth_pod", "ohnobr"));
+  EXPECT_EQ(countPool(), 0);
+  EXPECT_EQ(links_.count("ohno_tmp"), 0);
+
+  // 重新补充的 veth 插在新的 bridge 上（丢弃的也算作被领取，目标大小随之增加）
+  EXPECT_GE(pool.refill(), VETH_POOL_MIN);
+  EXPECT_TRUE(VethPool::claim(*netlink_, "ohno_tmp", "veth_pod", "ohnobr"));
+  EXPECT_EQ(masters_["veth_pod"], "ohnobr");
+}
+
+TEST_F(VethPoolTest, ReapOrphan) {
+  links_.emplace("ohnobr", "");
+  links_.emplace("ohnoq_5", "ohno_dead"); // 领取它的 CNI 进程在两次改名之间退出
+  links_.emplace("ohno_dead", "ohnoq_5");
+
+  // condition 1: 宽限期内保留
+  VethPool patient{netlink_, "ohnobr"};
+  patient.refill();
+  patient.refill();
+  EXPECT_EQ(links_.count("ohnoq_5"), 1);
+
+  // condition 2: 第一次发现时可能正在领取，之后超过宽限期才删除，Pod 一端随之删除
+  VethPool pool{netlink_, "ohnobr", std::chrono::seconds{0}};
+  pool.refill();
+  EXPECT_EQ(links_.count("ohnoq_5"), 1);
+  pool.refill();
+  EXPECT_EQ(links_.count("ohnoq_5"), 0);
+  EXPECT_EQ(links_.count("ohno_dead"), 0);
+
+  // condition 3: 池中的 veth 宿主机一端有 Pod 一端，不会被回收
+  pool.refill();
+  pool.refill();
+  EXPECT_EQ(countPool(), VETH_POOL_MIN);
+}
@@ -0,0 +1,52 @@
+// clang-format off
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include "gtest/gtest.h"
+#include "src/metrics/metrics.h"
+#include "src/util/file_lock.h"
+// clang-format on
+
+using namespace ohno::util;
+
+static auto getContended(std::string_view name) -> uint64_t {
+  ohno::metrics::Labels labels{{"lock", std::string{name}}};
+  return ohno::metrics::Registry::instance()
+      .counter("ohno_lock_contended_total", "File lock acquisitions that had to wait", labels)
+      .get();
+}
+
+TEST(FileLockTest, Exclusive) {
+  auto dir = std::filesystem::temp_directory_path() /
+             ("ohno_file_lock_test_" + std::to_string(::getpid()));
+  auto path = (dir / "sub" / "test.lock").string();
+
+  // condition 0: 锁文件的目录不存在时一并创建
+  auto first = std::make_unique<FileLock>(path, "file_lock_test");
+  ASSERT_TRUE(first->isLocked());
+  EXPECT_TRUE(std::filesystem::exists(path));
+
+  // condition 1: 同一个锁文件的第二个持有者阻塞到第一个释放，记录一次争用
+  auto contended = getContended("file_lock_test");
+  std::atomic<bool> locked{false};
+  std::thread waiter{[&path, &locked]() {
+    FileLock second{path, "file_lock_test"};
+    locked = second.isLocked();
+  }};
+  std::this_thread::sleep_for(std::chrono::milliseconds{100});
+  EXPECT_FALSE(locked);
+  first.reset();
+  waiter.join();
+  EXPECT_TRUE(locked);
+  EXPECT_EQ(getContended("file_lock_test"), contended + 1);
+
+  // condition 2: 锁文件无法创建时不持有锁
+  FileLock invalid{"/proc/ohno_file_lock_test/test.lock", "file_lock_test"};
+  EXPECT_FALSE(invalid.isLocked());
+
+  std::filesystem::remove_all(dir);
+}